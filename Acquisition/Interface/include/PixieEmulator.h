@@ -0,0 +1,145 @@
+///@file PixieEmulator.h
+///@brief A PixieInterface that fills the module FIFOs from a list-mode file or with synthetic hits
+///@date October 17, 2026
+
+#ifndef __PIXIEEMULATOR_H_
+#define __PIXIEEMULATOR_H_
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PixieInterface.h"
+#include "XiaListModeDataEncoder.hpp"
+#include "hribf_buffers.h"
+
+///@brief Emulates the FIFO readout and run control of a crate so that poll2
+/// can be run and load tested without modules. Every module fills its FIFO
+/// with hits that arrive at random at a mean rate. The hits are the events of
+/// a poll2 .ldf or .pld file, which is replayed from the start when it ends,
+/// or synthetic 4 word hits from the XiaListModeDataEncoder. A FIFO holds at
+/// most EXTERNAL_FIFO_LENGTH words. Hits that arrive while it is full are
+/// lost and the module reports a full FIFO, as a crate that is read out too
+/// slowly would. Everything else is accepted and ignored.
+class PixieEmulator : public PixieInterface {
+public:
+    ///Constructor
+    ///@param[in] source : The .ldf or .pld file to replay, or "synthetic"
+    ///@param[in] nModules : The number of modules to emulate
+    ///@param[in] rate : The mean number of hits per second in every module
+    PixieEmulator(const std::string &source, const unsigned short &nModules, const double &rate);
+
+    ///Default Destructor
+    ~PixieEmulator() {}
+
+    ///Sets up the slot map, modules are in slots 2 and up unless the replayed file says otherwise.
+    bool GetSlots(const char *slotF = NULL);
+
+    bool Init(bool offlineMode = false);
+
+    bool Boot(int mode = 0x7f, bool useWorkingSetFile = false);
+
+    bool WriteSglModPar(const char *name, word_t val, int mod);
+
+    bool WriteSglModPar(const char *name, word_t val, int mod, word_t &pval);
+
+    bool ReadSglModPar(const char *name, word_t &val, int mod);
+
+    bool SaveDSPParameters(const char *fn = NULL);
+
+    bool GetStatistics(unsigned short mod);
+
+    ///@return The rate of hits that arrived in the channel since the start of the run
+    double GetInputCountRate(int mod, int chan);
+
+    ///@return The rate of hits that made it into the FIFO since the start of the run
+    double GetOutputCountRate(int mod, int chan);
+
+    bool GetModuleInfo(const unsigned short &mod, unsigned short *rev,
+                       unsigned int *serNum, unsigned short *adcBits,
+                       unsigned short *adcMsps);
+
+    bool StartListModeRun(unsigned short listMode = LIST_MODE_RUN,
+                          unsigned short runMode = NEW_RUN);
+
+    bool StartListModeRun(unsigned short mod, unsigned short listMode,
+                          unsigned short runMode);
+
+    bool CheckRunStatus(void);
+
+    ///@return True while the module runs or still has words to read out
+    bool CheckRunStatus(int mod);
+
+#ifdef PIF_FIFO
+
+    unsigned long CheckFIFOWords(unsigned short mod);
+
+    bool ReadFIFOWords(word_t *buf, unsigned long nWords,
+                       unsigned short mod, bool verbose = false);
+
+#endif
+
+    bool EndRun(void);
+
+    bool EndRun(int mod);
+
+    ///@return The number of hits lost in the module because its FIFO was full
+    unsigned long GetNumLost(const unsigned short &mod) const;
+
+private:
+    static const unsigned int nChannels = 16;
+
+    ///The FIFO of a module and the hits that will go into it.
+    struct Module {
+        std::deque<word_t> fifo; ///< The words waiting to be read
+        std::deque<word_t> source; ///< The replayed words that did not arrive yet
+        double nextHit; ///< The time of the next hit since the start of the run (in s)
+        bool running;
+        bool full; ///< Set when a hit did not fit in the FIFO, cleared when it is read
+        unsigned long arrived[nChannels]; ///< The hits that arrived in each channel
+        unsigned long accepted[nChannels]; ///< The hits that went into the FIFO for each channel
+        unsigned long lost;
+        std::map<std::string, word_t> parameters;
+    };
+
+    ///Opens the replayed file and reads past its header.
+    ///@return True if the file is a .ldf or .pld file that could be opened
+    bool OpenSource();
+
+    ///Reads the next spill of the replayed file into the sources of the modules.
+    ///@return False if the file has no spills
+    bool ReadSpill();
+
+    ///Takes the next hit of the module.
+    ///@param[in] mod : The module
+    ///@param[out] hit : The words of the hit
+    ///@return False if the module has no hits
+    bool NextHit(const unsigned short &mod, std::vector<word_t> &hit);
+
+    ///Moves the hits that arrived since the last call into the FIFO of the module.
+    void Advance(const unsigned short &mod);
+
+    ///@return The time since the start of the run (in s)
+    double Elapsed() const;
+
+    std::string source_; ///< The replayed file or "synthetic"
+    double rate_; ///< The mean number of hits per second in each module
+    bool synthetic_;
+    int format_; ///< 0 for .ldf and 1 for .pld
+    std::ifstream file_;
+    DATA_buffer databuff_; ///< Reads the spills of a .ldf file
+    PLD_data pldData_; ///< Reads the spills of a .pld file
+    std::vector<word_t> spill_; ///< The spill that is read from the file
+    std::vector<Module> modules_;
+    XiaListModeDataEncoder encoder_;
+
+    std::chrono::steady_clock::time_point start_; ///< The start of the run
+    double stop_; ///< The length of the last run (in s), negative while a run is going
+    std::mt19937_64 random_;
+};
+
+#endif // __PIXIEEMULATOR_H_
@@ -98,7 +98,7 @@ public:
 
     PixieInterface(const char *fn);
 
-    ~PixieInterface();
+    virtual ~PixieInterface();
 
 
     bool ReadConfigurationFile(const char *fn);
@@ -106,18 +106,18 @@ public:
     /// @brief Parses the input from configuration file for the ModuleType tag.
     std::string ParseModuleTypeTag(std::string value);
 
-    bool GetSlots(const char *slotF = NULL);
+    virtual bool GetSlots(const char *slotF = NULL);
 
     // wrappers to the pixie-16 app functions
-    bool Init(bool offlineMode = false);
+    virtual bool Init(bool offlineMode = false);
 
-    bool Boot(int mode = 0x7f, bool useWorkingSetFile = false);
+    virtual bool Boot(int mode = 0x7f, bool useWorkingSetFile = false);
 
-    bool WriteSglModPar(const char *name, word_t val, int mod);
+    virtual bool WriteSglModPar(const char *name, word_t val, int mod);
 
-    bool WriteSglModPar(const char *name, word_t val, int mod, word_t &pval);
+    virtual bool WriteSglModPar(const char *name, word_t val, int mod, word_t &pval);
 
-    bool ReadSglModPar(const char *name, word_t &val, int mod);
+    virtual bool ReadSglModPar(const char *name, word_t &val, int mod);
 
     void PrintSglModPar(const char *name, int mod);
 
@@ -134,7 +134,7 @@ public:
 
     void PrintSglChanPar(const char *name, int mod, int chan, double prev);
 
-    bool SaveDSPParameters(const char *fn = NULL);
+    virtual bool SaveDSPParameters(const char *fn = NULL);
 
     bool AcquireTraces(int mod);
 
@@ -143,14 +143,14 @@ public:
                           unsigned short mod, unsigned short chan);
 
     // # #
-    bool GetStatistics(unsigned short mod);
+    virtual bool GetStatistics(unsigned short mod);
 
     // # GetStatistics must be called before calling these #
     stats_t &GetStatisticsData(void) { return statistics; }
 
-    double GetInputCountRate(int mod, int chan);
+    virtual double GetInputCountRate(int mod, int chan);
 
-    double GetOutputCountRate(int mod, int chan);
+    virtual double GetOutputCountRate(int mod, int chan);
 
     double GetLiveTime(int mod, int chan);
 
@@ -158,35 +158,35 @@ public:
 
     double GetProcessedEvents(int mod);
 
-    bool GetModuleInfo(const unsigned short &mod, unsigned short *rev,
-                       unsigned int *serNum, unsigned short *adcBits,
-                       unsigned short *adcMsps);
+    virtual bool GetModuleInfo(const unsigned short &mod, unsigned short *rev,
+                               unsigned int *serNum, unsigned short *adcBits,
+                               unsigned short *adcMsps);
 
     // # #
     bool StartHistogramRun(unsigned short mode = NEW_RUN);
 
     bool StartHistogramRun(unsigned short mod, unsigned short mode);
 
-    bool StartListModeRun(unsigned short listMode = LIST_MODE_RUN,
-                          unsigned short runMode = NEW_RUN);
+    virtual bool StartListModeRun(unsigned short listMode = LIST_MODE_RUN,
+                                  unsigned short runMode = NEW_RUN);
 
-    bool StartListModeRun(unsigned short mod, unsigned short listMode,
-                          unsigned short runMode);
+    virtual bool StartListModeRun(unsigned short mod, unsigned short listMode,
+                                  unsigned short runMode);
 
-    bool CheckRunStatus(void); // check status in all modules
-    bool CheckRunStatus(int mod);
+    virtual bool CheckRunStatus(void); // check status in all modules
+    virtual bool CheckRunStatus(int mod);
 
 #ifdef PIF_FIFO
 
-    unsigned long CheckFIFOWords(unsigned short mod);
+    virtual unsigned long CheckFIFOWords(unsigned short mod);
 
-    bool ReadFIFOWords(word_t *buf, unsigned long nWords,
-                       unsigned short mod, bool verbose = false);
+    virtual bool ReadFIFOWords(word_t *buf, unsigned long nWords,
+                               unsigned short mod, bool verbose = false);
 
 #endif
 
-    bool EndRun(void); // end run in all modules
-    bool EndRun(int mod);
+    virtual bool EndRun(void); // end run in all modules
+    virtual bool EndRun(int mod);
 
     bool RemovePresetRunLength(int mod);
 
@@ -226,10 +226,20 @@ public:
     bool SetProtonCatcherMode(int mod, int chan, CatcherModes mode);
 #endif
 
+protected:
+    /// Constructor for interfaces that do not talk to a crate, no configuration file is read.
+    PixieInterface(const std::string &lockName, const unsigned short &nCards);
+
+    static const size_t MAX_MODULES = 14;
+
+    unsigned short numberCards;
+    unsigned short slotMap[MAX_MODULES];
+
+    stats_t statistics;
+
 private:
     bool ToggleChannelBit(int mod, int chan, const char *parameter, int bit);
 
-    static const size_t MAX_MODULES = 14;
     static const size_t CONFIG_LINE_LENGTH = 80;
     static const size_t TRACE_LENGTH = RANDOMINDICES_LENGTH;
 
@@ -248,11 +258,6 @@ private:
     // checks retval and outputs default OK/ERROR message
     bool CheckError(bool exitOnError = false) const;
 
-    unsigned short numberCards;
-    unsigned short slotMap[MAX_MODULES];
-
-    stats_t statistics;
-
     int retval; // return value from pixie functions
     Lock lock;  // class to prevent simultaneous access to pixies
 
@@ -0,0 +1,395 @@
+///@file PixieEmulator.cpp
+///@brief A PixieInterface that fills the module FIFOs from a list-mode file or with synthetic hits
+///@date October 17, 2026
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+
+#include "Display.h"
+#include "HelperEnumerations.hpp"
+#include "PixieEmulator.h"
+
+using namespace std;
+using namespace Display;
+
+namespace {
+    ///The number of words that fit in the spill buffer, as in the .ldf reader of ScanInterface.
+    const size_t spillWords = 2500000;
+
+    ///The firmware and frequency of the synthetic hits.
+    const DataProcessing::FIRMWARE syntheticFirmware = DataProcessing::R30474;
+    const unsigned int syntheticFrequency = 250;
+
+    ///The time of a clock tick of the synthetic hits (in s).
+    const double syntheticTick = 8e-9;
+
+    ///@return The number of words in the event that starts with the word.
+    unsigned int EventLength(const PixieInterface::word_t &word) {
+        return (word & 0x7FFE0000) >> 17;
+    }
+}
+
+PixieEmulator::PixieEmulator(const string &source, const unsigned short &nModules, const double &rate) :
+        PixieInterface("PixieEmulator", nModules), source_(source), rate_(rate), synthetic_(source == "synthetic"),
+        format_(0), modules_(numberCards), stop_(0), random_(random_device()()) {
+    for (vector<Module>::iterator it = modules_.begin(); it != modules_.end(); ++it) {
+        it->nextHit = 0;
+        it->running = false;
+        it->full = false;
+        fill(it->arrived, it->arrived + nChannels, 0);
+        fill(it->accepted, it->accepted + nChannels, 0);
+        it->lost = 0;
+    }
+    for (unsigned short mod = 0; mod < numberCards; mod++)
+        slotMap[mod] = mod + 2;
+
+    if (nModules > MAX_MODULES)
+        cout << WarningStr("Too many cards") << " : " << nModules << " > " << MAX_MODULES << endl;
+    if (!synthetic_)
+        spill_.resize(spillWords);
+}
+
+bool PixieEmulator::GetSlots(const char *slotF) {
+    // The slots of the replayed file are taken from the first hit of each module.
+    if (!synthetic_ && OpenSource()) {
+        for (unsigned short mod = 0; mod < numberCards; mod++) {
+            for (int tries = 0; modules_[mod].source.empty() && tries < 2; tries++)
+                ReadSpill();
+            if (!modules_[mod].source.empty())
+                slotMap[mod] = (modules_[mod].source.front() & 0xF0) >> 4;
+            else
+                cout << WarningStr("No data for module ") << mod << " in " << source_ << endl;
+        }
+    }
+
+    cout << "Emulating " << InfoStr(synthetic_ ? "synthetic hits" : source_) << " at " << rate_
+         << " hits/s per module" << endl;
+    cout << "  System with " << numberCards << " cards" << endl;
+    cout << "  ";
+    for (int i = 0; i < numberCards; i++)
+        cout << "||  M  S ";
+    cout << "|" << endl << "  ";
+    for (int i = 0; i < numberCards; i++)
+        cout << "|| " << setw(2) << i << " " << setw(2) << slotMap[i] << " ";
+    cout << "|" << endl;
+
+    return true;
+}
+
+bool PixieEmulator::Init(bool offlineMode) {
+    LeaderPrint("Initializing Pixie emulator");
+    bool ok = synthetic_ || file_.is_open() || OpenSource();
+    cout << (ok ? OkayStr() : ErrorStr()) << endl;
+    if (!ok)
+        cout << "|- Unable to open '" << source_ << "', it must be a .ldf or .pld file or 'synthetic'.\n";
+    return ok;
+}
+
+bool PixieEmulator::Boot(int mode, bool useWorkingSetFile) {
+    LeaderPrint("Booting Pixie emulator");
+    cout << OkayStr() << endl;
+    return true;
+}
+
+bool PixieEmulator::WriteSglModPar(const char *name, word_t val, int mod) {
+    word_t dummy;
+    return WriteSglModPar(name, val, mod, dummy);
+}
+
+bool PixieEmulator::WriteSglModPar(const char *name, word_t val, int mod, word_t &pval) {
+    if (mod < 0 || mod >= numberCards)
+        return false;
+    ReadSglModPar(name, pval, mod);
+    modules_[mod].parameters[name] = val;
+    return true;
+}
+
+bool PixieEmulator::ReadSglModPar(const char *name, word_t &val, int mod) {
+    if (mod < 0 || mod >= numberCards)
+        return false;
+    map<string, word_t>::const_iterator found = modules_[mod].parameters.find(name);
+    val = found != modules_[mod].parameters.end() ? found->second : 0;
+    return true;
+}
+
+bool PixieEmulator::SaveDSPParameters(const char *fn) {
+    return true;
+}
+
+bool PixieEmulator::GetStatistics(unsigned short mod) {
+    if (mod >= numberCards)
+        return false;
+    Advance(mod);
+    return true;
+}
+
+double PixieEmulator::GetInputCountRate(int mod, int chan) {
+    double elapsed = Elapsed();
+    if (mod < 0 || mod >= numberCards || chan < 0 || chan >= (int) nChannels || elapsed <= 0)
+        return 0;
+    return modules_[mod].arrived[chan] / elapsed;
+}
+
+double PixieEmulator::GetOutputCountRate(int mod, int chan) {
+    double elapsed = Elapsed();
+    if (mod < 0 || mod >= numberCards || chan < 0 || chan >= (int) nChannels || elapsed <= 0)
+        return 0;
+    return modules_[mod].accepted[chan] / elapsed;
+}
+
+bool PixieEmulator::GetModuleInfo(const unsigned short &mod, unsigned short *rev, unsigned int *serNum,
+                                  unsigned short *adcBits, unsigned short *adcMsps) {
+    if (mod >= numberCards)
+        return false;
+    if (rev) *rev = 15;
+    if (serNum) *serNum = 1000 + mod;
+    if (adcBits) *adcBits = 12;
+    if (adcMsps) *adcMsps = syntheticFrequency;
+    return true;
+}
+
+bool PixieEmulator::StartListModeRun(unsigned short listMode, unsigned short runMode) {
+    LeaderPrint("Starting list mode run");
+    for (unsigned short mod = 0; mod < numberCards; mod++)
+        StartListModeRun(mod, listMode, runMode);
+    cout << OkayStr() << endl;
+    return true;
+}
+
+bool PixieEmulator::StartListModeRun(unsigned short mod, unsigned short listMode, unsigned short runMode) {
+    if (mod >= numberCards)
+        return false;
+
+    if (stop_ >= 0) {
+        start_ = chrono::steady_clock::now();
+        stop_ = -1;
+    }
+
+    Module &module = modules_[mod];
+    module.fifo.clear();
+    module.running = true;
+    module.full = false;
+    fill(module.arrived, module.arrived + nChannels, 0);
+    fill(module.accepted, module.accepted + nChannels, 0);
+    module.lost = 0;
+    module.nextHit = rate_ > 0 ? exponential_distribution<double>(rate_)(random_) : 0;
+    return true;
+}
+
+bool PixieEmulator::CheckRunStatus() {
+    for (unsigned short mod = 0; mod < numberCards; mod++) {
+        if (!CheckRunStatus((int) mod))
+            return false;
+    }
+    return true;
+}
+
+bool PixieEmulator::CheckRunStatus(int mod) {
+    if (mod < 0 || mod >= numberCards)
+        return false;
+    return modules_[mod].running || modules_[mod].fifo.size() >= MIN_FIFO_READ;
+}
+
+#ifdef PIF_FIFO
+
+unsigned long PixieEmulator::CheckFIFOWords(unsigned short mod) {
+    if (mod >= numberCards)
+        return 0;
+    Advance(mod);
+    // A module whose FIFO overflowed looks full until it is read out.
+    if (modules_[mod].full)
+        return max(modules_[mod].fifo.size(), (size_t) EXTERNAL_FIFO_LENGTH);
+    return modules_[mod].fifo.size();
+}
+
+bool PixieEmulator::ReadFIFOWords(word_t *buf, unsigned long nWords, unsigned short mod, bool verbose) {
+    if (mod >= numberCards)
+        return false;
+
+    Module &module = modules_[mod];
+    if (nWords > module.fifo.size()) {
+        cout << ErrorStr() << " Not enough words available in module " << mod << "'s FIFO for read! ("
+             << module.fifo.size() << "/" << nWords << ")\n";
+        return false;
+    }
+
+    copy(module.fifo.begin(), module.fifo.begin() + nWords, buf);
+    module.fifo.erase(module.fifo.begin(), module.fifo.begin() + nWords);
+    module.full = false;
+    if (verbose)
+        cout << "mod " << mod << " nWords " << nWords << " left " << module.fifo.size() << endl;
+    return true;
+}
+
+#endif
+
+bool PixieEmulator::EndRun() {
+    LeaderPrint("Ending run");
+    for (unsigned short mod = 0; mod < numberCards; mod++)
+        EndRun((int) mod);
+    cout << OkayStr() << endl;
+    return true;
+}
+
+bool PixieEmulator::EndRun(int mod) {
+    if (mod < 0 || mod >= numberCards)
+        return false;
+    Advance(mod);
+    modules_[mod].running = false;
+    if (stop_ < 0)
+        stop_ = Elapsed();
+    return true;
+}
+
+unsigned long PixieEmulator::GetNumLost(const unsigned short &mod) const {
+    return mod < numberCards ? modules_[mod].lost : 0;
+}
+
+bool PixieEmulator::OpenSource() {
+    string::size_type dot = source_.find_last_of('.');
+    string extension = dot == string::npos ? "" : source_.substr(dot + 1);
+    if (extension == "ldf")
+        format_ = 0;
+    else if (extension == "pld")
+        format_ = 1;
+    else
+        return false;
+
+    if (file_.is_open())
+        file_.close();
+    file_.clear();
+    file_.open(source_.c_str(), ios::binary);
+    if (!file_.is_open() || !file_.good())
+        return false;
+
+    // Every poll2 .ldf file starts with a DIR buffer followed by a HEAD buffer.
+    databuff_.Reset();
+    if (format_ == 0) {
+        DIR_buffer dirbuff;
+        HEAD_buffer headbuff;
+        return dirbuff.Read(&file_) && headbuff.Read(&file_);
+    }
+
+    PLD_header pldHead;
+    if (!pldHead.Read(&file_))
+        return false;
+    if (pldHead.GetMaxSpillSize() > spill_.size())
+        spill_.resize(pldHead.GetMaxSpillSize());
+    return true;
+}
+
+bool PixieEmulator::ReadSpill() {
+    // Start over at the end of the file, giving up if there is not a single spill in it.
+    unsigned int nBytes = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        bool read = false;
+        if (format_ == 0) {
+            bool full_spill, bad_spill;
+            while (!(read = databuff_.Read(&file_, (char *) &spill_[0], nBytes, 4 * spill_.size(), full_spill,
+                                          bad_spill))) {
+                // Skip the EOF buffer at the end of a run and anything else that is not the end of the file.
+                if (databuff_.GetRetval() == 2 || !file_.good())
+                    break;
+            }
+        } else {
+            read = pldData_.Read(&file_, (char *) &spill_[0], nBytes, 4 * spill_.size());
+        }
+        if (read)
+            break;
+        if (pass == 1 || !OpenSource())
+            return false;
+    }
+
+    // The spill is made of records of the length, the module and its words.
+    size_t nWords = nBytes / 4;
+    for (size_t pos = 0; pos + 1 < nWords;) {
+        word_t lenRec = spill_[pos];
+        word_t vsn = spill_[pos + 1];
+        if (lenRec < 2 || pos + lenRec > nWords)
+            break;
+        if (vsn < numberCards)
+            modules_[vsn].source.insert(modules_[vsn].source.end(), spill_.begin() + pos + 2,
+                                        spill_.begin() + pos + lenRec);
+        pos += lenRec;
+    }
+    return true;
+}
+
+bool PixieEmulator::NextHit(const unsigned short &mod, vector<word_t> &hit) {
+    if (synthetic_) {
+        unsigned long long ticks = (unsigned long long) (modules_[mod].nextHit / syntheticTick);
+
+        // A falling background with a peak on top of it.
+        double energy = uniform_real_distribution<double>(0, 1)(random_) < 0.3 ?
+                        normal_distribution<double>(1332, 20)(random_) :
+                        exponential_distribution<double>(1. / 500)(random_);
+
+        XiaData data;
+        data.SetSlotNumber(slotMap[mod]);
+        data.SetChannelNumber(uniform_int_distribution<unsigned int>(0, nChannels - 1)(random_));
+        data.SetEnergy(min(max(energy, 1.), 32767.));
+        data.SetEventTimeLow((unsigned int) (ticks & 0xFFFFFFFF));
+        data.SetEventTimeHigh((unsigned int) (ticks >> 32));
+        hit = encoder_.EncodeXiaData(data, syntheticFirmware, syntheticFrequency);
+        return true;
+    }
+
+    // Drop whatever is left of a module whose replayed data does not parse.
+    deque<word_t> &source = modules_[mod].source;
+    for (int tries = 0; tries < 2; tries++) {
+        if (source.empty() && !ReadSpill())
+            return false;
+        if (source.empty())
+            continue;
+        unsigned int length = EventLength(source.front());
+        if (length == 0 || length > source.size()) {
+            source.clear();
+            continue;
+        }
+        hit.assign(source.begin(), source.begin() + length);
+        source.erase(source.begin(), source.begin() + length);
+        return true;
+    }
+    return false;
+}
+
+void PixieEmulator::Advance(const unsigned short &mod) {
+    Module &module = modules_[mod];
+    if (!module.running || rate_ <= 0)
+        return;
+
+    exponential_distribution<double> interval(rate_);
+    double now = Elapsed();
+    vector<word_t> hit;
+    while (module.nextHit <= now) {
+        if (!NextHit(mod, hit)) { // There are no hits for this module in the replayed file.
+            module.nextHit = numeric_limits<double>::infinity();
+            break;
+        }
+
+        unsigned int channel = hit[0] & 0xF;
+        module.arrived[channel]++;
+        if (module.fifo.size() + hit.size() > EXTERNAL_FIFO_LENGTH) {
+            // Skip ahead when the FIFO is full so that a long stall does not replay every lost hit.
+            unsigned long skipped = (unsigned long) ((now - module.nextHit) * rate_);
+            module.lost += 1 + skipped;
+            for (unsigned int i = 0; i < nChannels; i++)
+                module.arrived[i] += skipped / nChannels;
+            module.arrived[channel] += skipped % nChannels;
+            module.full = true;
+            module.nextHit = now + interval(random_);
+            break;
+        }
+
+        module.fifo.insert(module.fifo.end(), hit.begin(), hit.end());
+        module.accepted[channel]++;
+        module.nextHit += interval(random_);
+    }
+}
+
+double PixieEmulator::Elapsed() const {
+    if (stop_ >= 0)
+        return stop_;
+    return chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+}
@@ -131,6 +131,13 @@ PixieInterface::PixieInterface(const char *fn) : lock("PixieInterface") {
 
 }
 
+PixieInterface::PixieInterface(const std::string &lockName, const unsigned short &nCards) :
+        numberCards(nCards < MAX_MODULES ? nCards : MAX_MODULES), doneInit(false), retval(0), lock(lockName) {
+    SetColorTerm();
+    bzero(slotMap, sizeof(slotMap));
+    bzero(statistics, sizeof(statistics));
+}
+
 PixieInterface::~PixieInterface() {
     if (!doneInit)
         return;
@@ -18,6 +18,10 @@
 #ifndef POLL2_CORE_H
 #define POLL2_CORE_H
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "PixieInterface.h"
@@ -98,6 +102,9 @@ struct data_pack{
 class StatsHandler;
 class Client;
 class Server;
+class SpillSender;
+class SpillRingWriter;
+class SpillPool;
 class Terminal;
 
 class Poll{
@@ -113,6 +120,37 @@ private:
 
     Client *client; /// UDP client for network access
     Server *server; /// UDP server to listen for pacman commands
+    SpillSender *stream; /// Spill stream to the scanners
+    SpillRingWriter *ring; /// Shared-memory ring for the scanners on this host
+
+    /// Notices about the output file that the broadcaster thread sends to the scanners.
+    enum FileNotice { OPEN_FILE_NOTICE, CLOSE_FILE_NOTICE };
+
+    /// What the status command shows about the scanners, copied by the broadcaster thread between spills.
+    struct BroadcastStats {
+        size_t stream_consumers; ///< Scanners connected to the spill stream
+        unsigned long stream_spills; ///< Spills handed to the spill stream
+        unsigned long stream_dropped; ///< Spills the spill stream dropped, summed over the scanners
+        size_t stream_queued; ///< Bytes waiting in the queues of the spill stream
+        unsigned long ring_spills; ///< Spills published into the shared-memory ring
+        unsigned long ring_dropped; ///< Spills that did not fit in the shared-memory ring
+
+        BroadcastStats() : stream_consumers(0), stream_spills(0), stream_dropped(0), stream_queued(0),
+                           ring_spills(0), ring_dropped(0) {}
+    };
+
+    /// Only the broadcaster thread talks to the scanners while it runs. The
+    /// other threads leave it notices and settings, so a scanner that is slow
+    /// to read never holds up the writer or the command line.
+    std::mutex broadcast_mutex; /// Guards the notices, the stream policy and the stats shared with the broadcaster thread. Never held while sending.
+    std::deque<FileNotice> file_notices; /// Notices waiting for the broadcaster thread
+    bool stream_policy_changed; /// Set when the broadcaster thread has to apply stream_block to the spill stream
+    BroadcastStats broadcast_stats; /// The stats at the end of the last broadcast
+    std::mutex output_mutex; /// Guards the output file, which the writer, broadcaster and run control threads share. Never held while taking broadcast_mutex.
+
+    SpillPool *spill_pool; /// Spill buffers handed from the FIFO readout to the writer and broadcaster threads
+    std::thread writer_thread; /// Writes the spills to disk
+    std::thread broadcast_thread; /// Broadcasts the spills to the scanners
 
     PixieInterface *pif; /// The main pixie interface pointer
 
@@ -127,7 +165,7 @@ private:
     bool acq_running; /// Set to true when run_command is recieving data from PIXIE
     bool run_ctrl_exit; /// Set to true when run_command exits
     bool had_error;
-    bool file_open;
+    std::atomic<bool> file_open; /// Set to true when an output file is open. Only changed while holding output_mutex.
     time_t raw_time;
 
     // System MCA flags
@@ -144,6 +182,14 @@ private:
     bool debug_mode; //
     bool shm_mode; /// New style shared-memory mode.
     bool pac_mode; /// Pacman shared-memory mode.
+    std::atomic<bool> stream_mode; /// Send whole spills to the scanners over the spill stream.
+    bool stream_block; /// Wait for slow scanners instead of dropping spills for them.
+    std::string stream_address; /// Address on which the spill stream listens.
+    std::atomic<bool> ring_mode; /// Publish whole spills into the shared-memory ring.
+    std::string ring_name; /// Name of the shared-memory ring.
+    std::string emulate_source; /// File replayed by the crate emulator, or "synthetic". Empty to use the crate.
+    unsigned short emulate_modules; /// Number of modules to emulate.
+    double emulate_rate; /// Hits per second in every emulated module.
     bool init; //
     double runTime; /// Time to run the acquisition, in seconds.
 
@@ -240,6 +286,18 @@ private:
     /// Broadcast a data spill onto the network in the classic pacman format.
     void broadcast_pac_data();
 
+    /// Write the spills from the spill pool to disk until the pool is stopped.
+    void WriterControl();
+
+    /// Broadcast the spills from the spill pool until the pool is stopped.
+    void BroadcastControl();
+
+    /// Queue a notice about the output file for the broadcaster thread.
+    void QueueFileNotice(const FileNotice &notice_);
+
+    /// Send the queued file notices and apply a new stream policy. Only called from the thread that broadcasts.
+    void SendFileNotices();
+
     /// @brief Splits the arguments to pread and pwrite on a colon delimeter.
     /// @param[in] arg The argument to be split.
     /// @param[out] start The first value in the string indicating the first mod / ch.
@@ -285,6 +343,22 @@ public:
 
     void SetPacmanMode(bool input_=true){ pac_mode = input_; }
 
+    void SetStreamMode(bool input_=true){ stream_mode = input_; }
+
+    void SetStreamAddress(const std::string &input_){ stream_address = input_; }
+
+    void SetStreamBlocking(bool input_=true){ stream_block = input_; }
+
+    void SetRingMode(bool input_=true){ ring_mode = input_; }
+
+    void SetRingName(const std::string &input_){ ring_name = input_; }
+
+    void SetEmulateSource(const std::string &input_){ emulate_source = input_; }
+
+    void SetEmulateModules(const unsigned short &input_){ emulate_modules = input_; }
+
+    void SetEmulateRate(const double &input_){ emulate_rate = input_; }
+
     void SetNcards(const size_t &n_cards_){ n_cards = n_cards_; }
 
     void SetThreshWords(const size_t &thresh_){ threshWords = thresh_; }
@@ -313,6 +387,12 @@ public:
 
     bool GetPacmanMode(){ return pac_mode; }
 
+    bool GetStreamMode(){ return stream_mode; }
+
+    bool GetRingMode(){ return ring_mode; }
+
+    bool GetEmulateMode(){ return !emulate_source.empty(); }
+
     size_t GetNcards(){ return n_cards; }
 
     size_t GetThreshWords(){ return threshWords; }
@@ -20,6 +20,8 @@
 #include <sys/stat.h> //For directory manipulation
 
 #include "poll2_core.h"
+#include "poll2_shm_ring.h"
+#include "poll2_stream.h"
 #include "Display.h"
 #include "CTerminal.h"
 
@@ -35,6 +37,15 @@ void help(const char *progName_) {
     std::cout << "  --zero                | Zero clocks on each START_ACQ (false by default)\n";
     std::cout << "  --debug (-d)          | Set debug mode to true (false by default)\n";
     std::cout << "  --pacman (-p)         | Use classic poll operation for use with Pacman.\n";
+    std::cout << "  --stream [address]    | Send whole spills to the scanners on a Unix socket path or TCP port\n";
+    std::cout << "                        |  (default=" << POLL2_STREAM_DEFAULT_ADDRESS << ")\n";
+    std::cout << "  --stream-block        | Wait for slow scanners instead of dropping spills for them\n";
+    std::cout << "                        |  (no spill is dropped, a stalled scanner holds up the readout)\n";
+    std::cout << "  --ring [name]         | Publish whole spills into a shared-memory ring for the scanners on this host\n";
+    std::cout << "                        |  (default=" << POLL2_SHM_RING_DEFAULT_NAME << ")\n";
+    std::cout << "  --emulate <file>      | Emulate the crate, replaying a .ldf or .pld file or \"synthetic\" hits\n";
+    std::cout << "  --emulate-modules <n> | Number of modules to emulate (default=1)\n";
+    std::cout << "  --emulate-rate <rate> | Hits per second in every emulated module (default=1000)\n";
     std::cout << "  --help (-h)           | Display this help dialogue.\n\n";
 }
 
@@ -61,6 +72,12 @@ int main(int argc, char *argv[]) {
             {"zero",          no_argument,       NULL, 0},
             {"debug",         no_argument,       NULL, 'd'},
             {"pacman",        no_argument,       NULL, 'p'},
+            {"stream",        optional_argument, NULL, 0},
+            {"stream-block",  no_argument,       NULL, 0},
+            {"ring",          optional_argument, NULL, 0},
+            {"emulate",       required_argument, NULL, 0},
+            {"emulate-modules", required_argument, NULL, 0},
+            {"emulate-rate",  required_argument, NULL, 0},
             {"help",          no_argument,       NULL, 'h'},
             {"prefix",        no_argument,       NULL, 0},
             {"?",             no_argument,       NULL, 0},
@@ -121,6 +138,30 @@ int main(int argc, char *argv[]) {
                     poll.SetShowRates();
                 } else if (strcmp("zero", longOpts[idx].name) == 0) { // --zero
                     poll.SetZeroClocks();
+                } else if (strcmp("stream", longOpts[idx].name) == 0) { // --stream
+                    poll.SetStreamMode();
+                    if (optarg != 0) poll.SetStreamAddress(optarg);
+                } else if (strcmp("stream-block", longOpts[idx].name) == 0) { // --stream-block
+                    poll.SetStreamBlocking();
+                } else if (strcmp("ring", longOpts[idx].name) == 0) { // --ring
+                    poll.SetRingMode();
+                    if (optarg != 0) poll.SetRingName(optarg);
+                } else if (strcmp("emulate", longOpts[idx].name) == 0) { // --emulate
+                    poll.SetEmulateSource(optarg);
+                } else if (strcmp("emulate-modules", longOpts[idx].name) == 0) { // --emulate-modules
+                    if (atoi(optarg) <= 0) {
+                        std::cout << Display::ErrorStr() << " Failed to set the number of emulated modules to ("
+                                  << optarg << ")!\n";
+                        return 1;
+                    }
+                    poll.SetEmulateModules(atoi(optarg));
+                } else if (strcmp("emulate-rate", longOpts[idx].name) == 0) { // --emulate-rate
+                    if (atof(optarg) <= 0) {
+                        std::cout << Display::ErrorStr() << " Failed to set the emulated hit rate to ("
+                                  << optarg << ")!\n";
+                        return 1;
+                    }
+                    poll.SetEmulateRate(atof(optarg));
                 }
                 break;
             case '?' :
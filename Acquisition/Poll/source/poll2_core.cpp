@@ -35,11 +35,15 @@
 
 #include "poll2_core.h"
 #include "poll2_socket.h"
+#include "poll2_shm_ring.h"
+#include "poll2_spill_pool.h"
+#include "poll2_stream.h"
 #include "poll2_stats.h"
 
 #include "CTerminal.h"
 
 // Interface for the PIXIE-16
+#include "PixieEmulator.h"
 #include "PixieSupport.h"
 #include "Utility.h"
 #include "Display.h"
@@ -54,6 +58,16 @@
 // 2 GB. Maximum allowable .ldf file size in bytes
 #define MAX_FILE_SIZE 2147483648ll
 
+// 256 MB. Size of the spill data in the shared-memory ring (in bytes)
+#define RING_CAPACITY 268435456ul
+
+// Number of spill buffers between the FIFO readout and the writer and broadcaster threads
+#define SPILL_BUFFERS 8
+
+// Consumers of the spill buffers
+#define WRITER_THREAD 0
+#define BROADCAST_THREAD 1
+
 // Length of shm packet header (in bytes)
 #define PKT_HEAD_LEN 8
 
@@ -81,7 +95,7 @@ std::vector<std::string> chan_params = {"TRIGGER_RISETIME", "TRIGGER_FLATTOP", "
 std::vector<std::string> mod_params = {"MODULE_CSRA", "MODULE_CSRB", "MODULE_FORMAT", "MAX_EVENTS", "SYNCH_WAIT", "IN_SYNCH", "SLOW_FILTER_RANGE", "FAST_FILTER_RANGE", "MODULE_NUMBER", "TrigConfig0", "TrigConfig1", "TrigConfig2","TrigConfig3"};
 
 const std::vector<std::string> Poll::runControlCommands_ ({"run", "stop",
-                                                           "startacq", "startvme", "stopacq", "stopvme", "timedrun", "acq", "shm", "spill",
+                                                           "startacq", "startvme", "stopacq", "stopvme", "timedrun", "acq", "shm", "stream", "ring", "spill",
                                                            "hup", "prefix", "fdir", "title", "runnum", "oform", "close", "reboot", "stats",
                                                            "mca"});
 
@@ -189,6 +203,14 @@ Poll::Poll() :
         debug_mode(false),
         shm_mode(false),
         pac_mode(false),
+        stream_mode(false),
+        stream_block(false),
+        stream_address(POLL2_STREAM_DEFAULT_ADDRESS),
+        ring_mode(false),
+        ring_name(POLL2_SHM_RING_DEFAULT_NAME),
+        emulate_source(""),
+        emulate_modules(1),
+        emulate_rate(1000),
         init(false),
         runTime(-1.0),
         // Options relating to output data file
@@ -202,7 +224,8 @@ Poll::Poll() :
         udp_sequence(0),
         total_spill_chunks(0)
 {
-    pif = new PixieInterface("pixie.cfg");
+    pif = NULL; // Created by Initialize, once the crate or the emulator is chosen.
+    stream_policy_changed = false;
 
     // Check the scheduler (kernel priority)
     Display::LeaderPrint("Checking scheduler");
@@ -216,7 +239,10 @@ Poll::Poll() :
     else{ std::cout << Display::WarningStr("UNEXPECTED") << std::endl; }
 
     client = new Client();
-
+    server = NULL;
+    stream = new SpillSender();
+    ring = new SpillRingWriter();
+    spill_pool = NULL;
 }
 
 Poll::~Poll(){
@@ -225,6 +251,8 @@ Poll::~Poll(){
     }
 
     delete pif;
+    delete stream;
+    delete ring;
 }
 
 void Poll::PrintModuleInfo() {
@@ -252,6 +280,8 @@ bool Poll::Initialize(){
     }
 
     // Initialize the pixie interface and boot
+    if(!emulate_source.empty()){ pif = new PixieEmulator(emulate_source, emulate_modules, emulate_rate); }
+    else{ pif = new PixieInterface("pixie.cfg"); }
     pif->GetSlots();
     if(!pif->Init()){ return false; }
 
@@ -283,6 +313,27 @@ bool Poll::Initialize(){
         //Initialize Cory's shm port
         // This port number is used to avoid tying up udptoipc's port
         client->Init("127.0.0.1", 5555);
+
+        //Listen for scanners on the spill stream
+        if(stream_mode){
+            Display::LeaderPrint("Opening spill stream " + stream_address);
+            if(!stream->Init(stream_address)){
+                std::cout << Display::ErrorStr() << std::endl;
+                return false;
+            }
+            stream->SetPolicy(stream_block ? SpillSender::BLOCK : SpillSender::DROP_NEWEST);
+            std::cout << Display::OkayStr() << std::endl;
+        }
+
+        //Create the shared-memory ring for the scanners on this host
+        if(ring_mode){
+            Display::LeaderPrint("Creating shared-memory ring " + ring_name);
+            if(!ring->Init(ring_name, RING_CAPACITY)){
+                std::cout << Display::ErrorStr() << std::endl;
+                return false;
+            }
+            std::cout << Display::OkayStr() << std::endl;
+        }
     }
 
     //Allocate an array of vectors to store partial events from the FIFO.
@@ -292,6 +343,15 @@ bool Poll::Initialize(){
     statsHandler = new StatsHandler(n_cards);
     statsHandler->SetDumpInterval(statsInterval_);
 
+    //Allocate the spill buffers and start the threads that write and broadcast
+    // them, so that a slow disk or network never holds up the FIFO readout.
+    // A stalled broadcast drops spills rather than use up the buffers, unless
+    // the spill stream was told to wait for slow scanners.
+    spill_pool = new SpillPool(SPILL_BUFFERS, (EXTERNAL_FIFO_LENGTH + 2) * n_cards, 2);
+    spill_pool->SetDepthLimit(BROADCAST_THREAD, stream_block ? 0 : SPILL_BUFFERS / 2);
+    writer_thread = std::thread(&Poll::WriterControl, this);
+    broadcast_thread = std::thread(&Poll::BroadcastControl, this);
+
     //Build the list of commands
     commands_.insert(commands_.begin(), pollStatusCommands_.begin(), pollStatusCommands_.end());
     commands_.insert(commands_.begin(), paramControlCommands_.begin(), paramControlCommands_.end());
@@ -312,6 +372,15 @@ bool Poll::Close(){
     //We return if the class has not been initialized.
     if(!init){ return false; }
 
+    //Let the writer and broadcaster threads finish the spills that were read.
+    spill_pool->Stop();
+    writer_thread.join();
+    broadcast_thread.join();
+
+    // Close any open files. The broadcaster is gone, so we send the notice ourselves.
+    if(output_file.IsOpen()) CloseOutputFile();
+    SendFileNotices();
+
     //Send message to Cory's SHM that we are closing.
     if(!pac_mode){ client->SendMessage((char *)"$KILL_SOCKET", 13); }
         //Close the pacman command port.
@@ -319,8 +388,12 @@ bool Poll::Close(){
     //Close the UDP data / SHM port.
     client->Close();
 
-    // Close any open files.
-    if(output_file.IsOpen()) CloseOutputFile();
+    //Tell the scanners on the spill stream that we are closing.
+    stream->SendControl(SpillStream::KILL_SOCKET);
+    stream->Close();
+
+    //Tell the scanners on the shared-memory ring that we are closing.
+    ring->Close();
 
     //Delete the array of partial event vectors.
     delete[] partialEvents;
@@ -329,6 +402,9 @@ bool Poll::Close(){
     delete statsHandler;
     statsHandler = NULL;
 
+    delete spill_pool;
+    spill_pool = NULL;
+
     // We are no longer initialized.
     init = false;
 
@@ -344,6 +420,7 @@ bool Poll::Close(){
  */
 bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
     Display::LeaderPrint("Closing output file");
+    std::unique_lock<std::mutex> fileGuard(output_mutex);
 
     //No file was open.
     if(!output_file.IsOpen()){
@@ -361,17 +438,18 @@ bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
 
     output_file.CloseFile();
 
-    //Broadcast to Cory's SHM that the file is now closed.
-    if(!pac_mode){ client->SendMessage((char *)"$CLOSE_FILE", 12); }
-
     //Set the flag that no file is open.
     file_open = false;
-    std::cout << Display::OkayStr() << std::endl;
 
     //We call get next file name to update the run number.
     if (!continueRun) {
         output_file.GetNextFileName(next_run_num,filename_prefix,output_directory);
     }
+    fileGuard.unlock();
+
+    //Broadcast to Cory's SHM that the file is now closed.
+    QueueFileNotice(CLOSE_FILE_NOTICE);
+    std::cout << Display::OkayStr() << std::endl;
 
     return true;
 }
@@ -390,10 +468,13 @@ bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
  */
 bool Poll::OpenOutputFile(bool continueRun){
     Display::LeaderPrint("Opening output file");
+    std::unique_lock<std::mutex> fileGuard(output_mutex);
+
     //A file was already open
     if(output_file.IsOpen()){
         std::cout << Display::ErrorStr() << std::endl;
         std::cout << "|- A file is already open!\n";
+        fileGuard.unlock();
         CloseOutputFile();
 
         had_error = true;
@@ -417,15 +498,18 @@ bool Poll::OpenOutputFile(bool continueRun){
     }
     std::cout <<Display::OkayStr() <<std::endl;
     std::cout << "|- Filename: '" << output_file.GetCurrentFilename() << "'.\n";
+    file_open = true;
+    fileGuard.unlock();
 
-    //Clear the stats
-    statsHandler->Clear();
-    statsHandler->Dump();
+    //Clear the stats. A continuation file is opened by the writer thread
+    // while the readout keeps adding to the stats, so they are kept.
+    if (!continueRun){
+        statsHandler->Clear();
+        statsHandler->Dump();
+    }
 
     //When using Cory's SHM send a message that the file is open.
-    if(!pac_mode){ client->SendMessage((char *)"$OPEN_FILE", 12); }
-
-    file_open = true;
+    QueueFileNotice(OPEN_FILE_NOTICE);
 
     return true;
 }
@@ -455,6 +539,8 @@ bool Poll::synch_mods(){
 }
 
 int Poll::write_data(word_t *data, unsigned int nWords){
+    std::unique_lock<std::mutex> fileGuard(output_mutex);
+
     // Open an output file if needed
     if(!output_file.IsOpen()){
         std::cout << Display::ErrorStr() << " Recording data, but no file is open!\n";
@@ -471,8 +557,10 @@ int Poll::write_data(word_t *data, unsigned int nWords){
         // Open a new output file instead
         std::cout << sys_message_head << "Maximum ifile size reached. New output file will be created.\n";
         std::cout << sys_message_head << "Current filesize is " << current_filesize + (std::streampos)65552 << " bytes.\n";
+        fileGuard.unlock();
         CloseOutputFile(true);
         OpenOutputFile(true);
+        fileGuard.lock();
     }
 
     if (!is_quiet) std::cout << "Writing " << nWords << " words.\n";
@@ -480,11 +568,92 @@ int Poll::write_data(word_t *data, unsigned int nWords){
     return output_file.Write((char*)data, nWords);
 }
 
+void Poll::WriterControl(){
+    SpillPool::Buffer *spill;
+    while((spill = spill_pool->Next(WRITER_THREAD, 1000)) || !spill_pool->IsStopped()){
+        if(!spill){ continue; }
+        write_data(&spill->data[0], spill->nWords);
+        spill_pool->Release(WRITER_THREAD, spill);
+    }
+}
+
+void Poll::BroadcastControl(){
+    SpillPool::Buffer *spill;
+    BroadcastStats stats;
+    while((spill = spill_pool->Next(BROADCAST_THREAD, 100)) || !spill_pool->IsStopped()){
+        //A file notice goes out before the spills that follow it.
+        SendFileNotices();
+        if(spill){
+            broadcast_data(&spill->data[0], spill->nWords);
+            spill_pool->Release(BROADCAST_THREAD, spill);
+        }
+
+        //Keep the scanners on the spill stream fed between spills.
+        if(stream_mode){ stream->Flush(); }
+
+        //The stream and the ring may be set up by the command thread while they are off.
+        if(stream_mode){
+            stats.stream_consumers = stream->GetNumConsumers();
+            stats.stream_spills = stream->GetNumSpills();
+            stats.stream_dropped = stream->GetNumDropped();
+            stats.stream_queued = stream->GetNumQueued();
+        }
+        if(ring_mode){
+            stats.ring_spills = ring->GetNumSpills();
+            stats.ring_dropped = ring->GetNumDropped();
+        }
+
+        std::lock_guard<std::mutex> guard(broadcast_mutex);
+        broadcast_stats = stats;
+    }
+    SendFileNotices();
+}
+
+void Poll::QueueFileNotice(const FileNotice &notice_){
+    std::lock_guard<std::mutex> guard(broadcast_mutex);
+    file_notices.push_back(notice_);
+}
+
+void Poll::SendFileNotices(){
+    std::unique_lock<std::mutex> guard(broadcast_mutex);
+    std::deque<FileNotice> notices;
+    notices.swap(file_notices);
+    bool policyChanged = stream_policy_changed;
+    stream_policy_changed = false;
+    guard.unlock();
+
+    if(policyChanged){ stream->SetPolicy(stream_block ? SpillSender::BLOCK : SpillSender::DROP_NEWEST); }
+
+    for(std::deque<FileNotice>::iterator it = notices.begin(); it != notices.end(); it++){
+        if(*it == OPEN_FILE_NOTICE){
+            if(!pac_mode){ client->SendMessage((char *)"$OPEN_FILE", 12); }
+            if(stream_mode){ stream->SendControl(SpillStream::OPEN_FILE); }
+        }
+        else{
+            if(!pac_mode){ client->SendMessage((char *)"$CLOSE_FILE", 12); }
+            if(stream_mode){ stream->SendControl(SpillStream::CLOSE_FILE); }
+        }
+    }
+}
+
 void Poll::broadcast_data(word_t *data, unsigned int nWords) {
     // Maximum size of the shared memory buffer
     static const unsigned int maxShmSizeL = 4050; // in pixie words
     static const unsigned int maxShmSize  = maxShmSizeL * sizeof(word_t); // in bytes
 
+    // Send the whole spill to the scanners on the spill stream. This does not
+    // replace the UDP modes below, so older scanners keep working.
+    if(stream_mode){
+        stream->SendSpill(data, nWords);
+        if (debug_mode) std::cout << "Streamed spill of " << nWords << " words to " << stream->GetNumConsumers() << " scanners.\n";
+    }
+
+    // Copy the whole spill into the shared-memory ring. The scanners on this
+    // host read it from there at their own pace.
+    if(ring_mode && !ring->Publish(data, nWords)){
+        std::cout << Display::WarningStr("Warning") << ": Spill of " << nWords << " words does not fit in the shared-memory ring!\n";
+    }
+
     if(pac_mode){ // Broadcast the spill onto the network using the classic pacman shm style
         unsigned int nBufs = nWords / maxShmSizeL;
         unsigned int wordsLeft = nWords % maxShmSizeL;
@@ -564,6 +733,7 @@ void Poll::broadcast_data(word_t *data, unsigned int nWords) {
         }
     }
     else{ // Broadcast a spill notification to the network
+        std::lock_guard<std::mutex> fileGuard(output_mutex);
         output_file.SendPacket(client);
     }
 }
@@ -635,6 +805,9 @@ void Poll::help(){
         std::cout << "   stopacq (stopvme)   - Stop data acquisition\n";
         std::cout << "   timedrun <seconds>  - Run for the specified number of seconds\n";
         std::cout << "   acq (shm)           - Run in \"shared-memory\" mode\n";
+        std::cout << "   stream [drop|block] - Toggle the spill stream or set what to do when a scanner falls behind\n";
+        std::cout << "                         Blocking never drops a spill, a stalled scanner holds up the readout\n";
+        std::cout << "   ring                - Toggle publishing spills into the shared-memory ring\n";
         std::cout << "   spill (hup)         - Force dump of current spill\n";
         std::cout << "   prefix [name]       - Set the output filename prefix (default='run_#.ldf')\n";
         std::cout << "   fdir [path]         - Set the output file directory (default='./')\n";
@@ -754,8 +927,48 @@ void Poll::show_status(){
     std::cout << "   Acq running     - " << yesno(acq_running) << std::endl;
     if(!pac_mode){
         std::cout << "   Shared memory   - " << yesno(shm_mode) << std::endl;
+        //The broadcaster may be waiting for a slow scanner, so we only look at what it copied for us.
+        std::unique_lock<std::mutex> guard(broadcast_mutex);
+        BroadcastStats stats = broadcast_stats;
+        bool streamBlock = stream_block;
+        guard.unlock();
+
+        std::cout << "   Spill stream    - " << yesno(stream_mode);
+        if(stream->GetAddress() != ""){
+            std::cout << " (" << stream->GetAddress() << ", " << (streamBlock ? "block" : "drop")
+                      << ", " << stats.stream_consumers << " scanners, " << stats.stream_spills
+                      << " spills, " << stats.stream_dropped << " dropped, "
+                      << humanReadable(stats.stream_queued) << " queued)";
+        }
+        std::cout << std::endl;
+        std::cout << "   Spill ring      - " << yesno(ring_mode);
+        if(ring->GetCapacity() > 0){
+            std::cout << " (" << ring->GetName() << ", " << humanReadable(ring->GetCapacity()) << ", "
+                      << stats.ring_spills << " spills, " << stats.ring_dropped << " dropped)";
+        }
+        std::cout << std::endl;
+        if(spill_pool){
+            std::cout << "   Spill buffers   - " << spill_pool->GetNumFree() << " of " << spill_pool->GetNumBuffers()
+                      << " free, readout waited " << spill_pool->GetNumWaits() << " times\n";
+            std::cout << "   Disk writer     - " << spill_pool->GetDepth(WRITER_THREAD) << " queued (max "
+                      << spill_pool->GetPeakDepth(WRITER_THREAD) << "), " << spill_pool->GetLatency(WRITER_THREAD)
+                      << " ms latency (max " << spill_pool->GetPeakLatency(WRITER_THREAD) << " ms)\n";
+            std::cout << "   Broadcaster     - " << spill_pool->GetDepth(BROADCAST_THREAD) << " queued (max "
+                      << spill_pool->GetPeakDepth(BROADCAST_THREAD) << "), " << spill_pool->GetLatency(BROADCAST_THREAD)
+                      << " ms latency (max " << spill_pool->GetPeakLatency(BROADCAST_THREAD) << " ms), "
+                      << spill_pool->GetNumDropped(BROADCAST_THREAD) << " dropped\n";
+        }
+        std::cout << "   Emulated crate  - " << yesno(!emulate_source.empty());
+        PixieEmulator *emulator = dynamic_cast<PixieEmulator *>(pif);
+        if(emulator){
+            unsigned long lost = 0;
+            for(unsigned short mod = 0; mod < emulator->GetNumberCards(); mod++){ lost += emulator->GetNumLost(mod); }
+            std::cout << " (" << emulate_source << ", " << emulate_rate << " hits/s per module, " << lost
+                      << " hits lost)";
+        }
+        std::cout << std::endl;
         std::cout << "   Write to disk   - " << yesno(record_data) << std::endl;
-        std::cout << "   File open       - " << yesno(output_file.IsOpen()) << std::endl;
+        std::cout << "   File open       - " << yesno(file_open) << std::endl;
         std::cout << "   Rebooting       - " << yesno(do_reboot) << std::endl;
         std::cout << "   Force Spill     - " << yesno(force_spill) << std::endl;
         std::cout << "   Do MCA run      - " << yesno(do_MCA_run) << std::endl;
@@ -1557,6 +1770,48 @@ void Poll::CommandControl(){
                     shm_mode = true;
                 }
             }
+            else if(cmd == "stream"){ // Toggle the spill stream or set its policy
+                //The broadcaster applies the policy, it may be in the middle of sending a spill.
+                std::unique_lock<std::mutex> guard(broadcast_mutex);
+                if(p_args > 0 && (arguments.at(0) == "drop" || arguments.at(0) == "block")){
+                    stream_block = (arguments.at(0) == "block");
+                    stream_policy_changed = true;
+                    guard.unlock();
+
+                    //Spills dropped by the pool would never reach the stream, so blocking lifts the limit.
+                    spill_pool->SetDepthLimit(BROADCAST_THREAD, stream_block ? 0 : SPILL_BUFFERS / 2);
+                    std::cout << sys_message_head << "Spill stream will " << (stream_block ? "wait for" : "drop spills for") << " slow scanners\n";
+                }
+                else if(p_args > 0){
+                    std::cout << sys_message_head << "Invalid spill stream policy '" << arguments.at(0) << "'\n";
+                    std::cout << sys_message_head << " -SYNTAX- stream [drop|block]\n";
+                }
+                else if(stream_mode){
+                    std::cout << sys_message_head << "Toggling spill stream OFF\n";
+                    stream_mode = false;
+                }
+                else if(stream->GetAddress() == "" && !stream->Init(stream_address)){ // The broadcaster leaves the stream alone while it is off
+                    std::cout << sys_message_head << "Failed to open spill stream " << stream_address << "\n";
+                }
+                else{
+                    std::cout << sys_message_head << "Toggling spill stream ON (" << stream_address << ")\n";
+                    stream_policy_changed = true;
+                    stream_mode = true;
+                }
+            }
+            else if(cmd == "ring"){ // Toggle the shared-memory ring. The broadcaster leaves the ring alone while it is off.
+                if(ring_mode){
+                    std::cout << sys_message_head << "Toggling shared-memory ring OFF\n";
+                    ring_mode = false;
+                }
+                else if(ring->GetCapacity() == 0 && !ring->Init(ring_name, RING_CAPACITY)){
+                    std::cout << sys_message_head << "Failed to create shared-memory ring " << ring_name << "\n";
+                }
+                else{
+                    std::cout << sys_message_head << "Toggling shared-memory ring ON (" << ring_name << ")\n";
+                    ring_mode = true;
+                }
+            }
             else if(cmd == "reboot"){ // Tell POLL to attempt a PIXIE crate reboot
                 if(do_MCA_run){ std::cout << sys_message_head << "Warning! Cannot reboot while MCA is running\n"; }
                 else if(acq_running || do_MCA_run){ std::cout << sys_message_head << "Warning! Cannot reboot while acquisition running\n"; }
@@ -1744,6 +1999,7 @@ void Poll::RunControl(){
             if (!acq_running) {
                 if(record_data){
                     //Close a file if open
+                    spill_pool->Drain();
                     if(output_file.IsOpen()){
                         std::cout << Display::WarningStr() << " Unexpected output file open!\n";
                         CloseOutputFile();
@@ -1842,7 +2098,8 @@ void Poll::RunControl(){
                 statsHandler->Dump();
                 statsHandler->ClearTotals();
 
-                //Close the output file
+                //Wait for the last spills to be written and broadcast, then close the output file
+                spill_pool->Drain();
                 if(output_file.IsOpen()) CloseOutputFile();
 
                 //Reset status flags
@@ -1872,7 +2129,20 @@ void Poll::UpdateStatus() {
     else if (do_MCA_run) status << Display::OkayStr("[MCA]");
     else status << Display::InfoStr("[IDLE]");
 
-    if (file_open) status << " Run " << output_file.GetRunNumber();
+    //The writer thread may be rolling over to a new file.
+    std::unique_lock<std::mutex> fileGuard(output_mutex);
+    bool fileOpen = file_open;
+    unsigned int runNumber = 0;
+    std::streampos fileSize = 0;
+    std::string fileName;
+    if (fileOpen) {
+        runNumber = output_file.GetRunNumber();
+        fileSize = output_file.GetFilesize();
+        fileName = output_file.GetCurrentFilename();
+    }
+    fileGuard.unlock();
+
+    if (fileOpen) status << " Run " << runNumber;
 
     if(do_MCA_run){
         status << " " << (int)mca_args.GetMCA()->GetRunTime() << "s";
@@ -1885,11 +2155,11 @@ void Poll::UpdateStatus() {
         status << " " << humanReadable(statsHandler->GetTotalDataRate()) << "/s";
     }
 
-    if (file_open) {
+    if (fileOpen) {
         if (acq_running && !record_data) status << TermColors::DkYellow;
         //Add file size to status
-        status << " " << humanReadable(output_file.GetFilesize());
-        status << " " << output_file.GetCurrentFilename();
+        status << " " << humanReadable(fileSize);
+        status << " " << fileName;
         if (acq_running && !record_data) status << TermColors::Reset;
     }
 
@@ -1914,8 +2184,6 @@ void Poll::ReadScalers() {
     }
 }
 bool Poll::ReadFIFO() {
-    static word_t *fifoData = new word_t[(EXTERNAL_FIFO_LENGTH + 2) * n_cards];
-
     if (!acq_running) return false;
 
     //Number of words in the FIFO of each module.
@@ -1937,6 +2205,15 @@ bool Poll::ReadFIFO() {
     //We need to read the data out of the FIFO
     if (*maxWords > threshWords || force_spill) {
         force_spill = false;
+
+        //Take a free spill buffer. We only wait if the writer and broadcaster threads hold all of them.
+        unsigned long waits = spill_pool->GetNumWaits();
+        SpillPool::Buffer *spill = spill_pool->Acquire();
+        if (!spill) return false;
+        if (spill_pool->GetNumWaits() != waits)
+            std::cout << Display::WarningStr("Warning") << ": Waited for a free spill buffer, the disk is not keeping up!\n";
+        word_t *fifoData = &spill->data[0];
+
         //Number of data words read from the FIFO
         size_t dataWords = 0;
 
@@ -1966,6 +2243,7 @@ bool Poll::ReadFIFO() {
                           << EXTERNAL_FIFO_LENGTH << Display::ErrorStr(" ABORTING!") << std::endl;
                 had_error = true;
                 do_stop_acq = true;
+                spill_pool->Submit(spill, 0);
                 return false;
             }
 
@@ -1983,6 +2261,7 @@ bool Poll::ReadFIFO() {
                 std::cout << Display::ErrorStr() << " Unable to read " << nWords[mod] << " from module " << mod << "\n";
                 had_error = true;
                 do_stop_acq = true;
+                spill_pool->Submit(spill, 0);
                 return false;
             }
 
@@ -2110,6 +2389,7 @@ bool Poll::ReadFIFO() {
 
                 do_stop_acq = true;
                 had_error = true;
+                spill_pool->Submit(spill, 0);
                 return false;
             }
 
@@ -2133,9 +2413,11 @@ bool Poll::ReadFIFO() {
         }
 
         if (!is_quiet || debug_mode) std::cout << "Writing/Broadcasting " << dataWords << " words.\n";
-        //We have read the FIFO now we write the data
-        if (record_data && !pac_mode) write_data(fifoData, dataWords);
-        broadcast_data(fifoData, dataWords);
+        //We have read the FIFO now we hand it to the writer and broadcaster threads
+        spill->nWords = dataWords;
+        unsigned int consumers = 1u << BROADCAST_THREAD;
+        if (record_data && !pac_mode) consumers |= 1u << WRITER_THREAD;
+        spill_pool->Submit(spill, consumers);
 
     } //If we had exceeded the threshold or forced a flush
 
@@ -0,0 +1,83 @@
+/// @file TemplateFitter.hpp
+/// @brief A fitter that finds the phase of a waveform by matching it to a
+/// tabulated timing function and refining the best match with Newton steps.
+/// @date October 17, 2026
+#ifndef PIXIESUITE_TEMPLATEFITTER_HPP
+#define PIXIESUITE_TEMPLATEFITTER_HPP
+
+#include <utility>
+#include <vector>
+
+#include "TimingDriver.hpp"
+
+///@brief Fits the same functions as the GslFitter without setting up a
+/// solver for every waveform. The timing function is tabulated once for each
+/// set of fitting parameters. The phase is first found on the grid of the
+/// table, where the best amplitude of every candidate has a closed form, and
+/// is then refined with a few Gauss-Newton steps on the exact function. The
+/// workspaces belong to the instance, so every thread needs its own fitter.
+class TemplateFitter : public TimingDriver {
+public:
+    ///Default Constructor
+    TemplateFitter() : TimingDriver(), amp_(0), chi_(0), dof_(0) {
+        isFastSiPm_ = false;
+        qdc_ = 0;
+    }
+
+    ///Default Destructor
+    ~TemplateFitter() {}
+
+    ///The ever important phase calculation
+    /// @param[in] data The baseline subtracted data for the fitting
+    /// @param[in] pars The beta and gamma of the timing function
+    /// @param[in] max : Information about the maximum position and value
+    /// @param[in] baseline : The average and standard deviation of the baseline
+    /// @return The phase in samples from the start of the data
+    double CalculatePhase(const std::vector<double> &data, const std::pair<double, double> &pars,
+                          const std::pair<unsigned int, double> &max, const std::pair<double, double> baseline);
+
+    /// @return The amplitude of the fit in units of the QDC
+    double GetAmplitude(void) { return amp_; }
+
+    /// @return The chi^2 of the fit using the baseline deviation as the error
+    double GetChiSq(void) { return chi_; }
+
+    /// @return The chi^2 per degree of freedom of the fit
+    double GetChiSqPerDof(void) { return dof_ > 0 ? chi_ / dof_ : 0.0; }
+
+    ///The number of table entries per sample, which is the step of the phase search.
+    static const unsigned int binsPerSample = 8;
+
+private:
+    ///The timing function tabulated for one set of parameters
+    struct Template {
+        std::pair<double, double> pars; ///< The beta and gamma of the table
+        bool isFastSiPm; ///< True if this is the SiPM function
+        size_t length; ///< The longest data that the table covers
+        int offset; ///< The bin of the table that holds the function at zero
+        double peak; ///< The position of the maximum of the function in samples
+        std::vector<double> values; ///< The function in steps of 1/binsPerSample
+    };
+
+    ///@return The table for the parameters, building it if it cannot cover
+    /// data of the given length.
+    const Template &GetTemplate(const std::pair<double, double> &pars, const size_t &length);
+
+    ///@return The timing function and its derivative at d samples after the phase.
+    std::pair<double, double> Evaluate(const double &d, const std::pair<double, double> &pars) const;
+
+    ///@return The squared residuals for the phase and amplitude, the model
+    /// and its derivatives are left in the workspaces.
+    double CalculateResiduals(const std::vector<double> &data, const std::pair<double, double> &pars,
+                              const double &phase, const double &amplitude);
+
+    double amp_; ///< The amplitude of the last fit
+    double chi_; ///< The chi^2 of the last fit
+    double dof_; ///< The degrees of freedom of the last fit
+
+    std::vector<Template> templates_; ///< The tables for the parameters seen so far
+    std::vector<double> model_; ///< The unit amplitude function at each sample
+    std::vector<double> derivative_; ///< The derivative of the function with the phase at each sample
+};
+
+#endif //PIXIESUITE_TEMPLATEFITTER_HPP
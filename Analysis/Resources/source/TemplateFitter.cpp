@@ -0,0 +1,212 @@
+/// @file TemplateFitter.cpp
+/// @brief A fitter that finds the phase of a waveform by matching it to a
+/// tabulated timing function and refining the best match with Newton steps.
+/// @date October 17, 2026
+#include <limits>
+#include <stdexcept>
+
+#include <cmath>
+
+#include "TemplateFitter.hpp"
+
+using namespace std;
+
+namespace {
+    ///The number of samples on either side of the expected phase that we search
+    const int searchWidth = 2;
+    ///The maximum number of Newton steps that we take
+    const unsigned int maxIterations = 50;
+    ///The change of the phase at which we consider the fit converged
+    const double tolerance = 1e-6;
+}
+
+double TemplateFitter::CalculatePhase(const std::vector<double> &data, const std::pair<double, double> &pars,
+                                      const std::pair<unsigned int, double> &max,
+                                      const std::pair<double, double> baseline) {
+    if (data.size() == 0)
+        throw range_error("TemplateFitter::CalculatePhase - The data vector was empty!");
+
+    const size_t n = data.size();
+    const Template &table = GetTemplate(pars, n);
+
+    size_t maxPosition = 0;
+    for (size_t i = 1; i < n; i++)
+        if (data[i] > data[maxPosition])
+            maxPosition = i;
+
+    //Match the table to the data for every phase on the grid of the table near the expected phase. The amplitude
+    // of the PMT function is free, and its best value for each phase is sum(y*f) / sum(f*f). The SiPM function
+    // is normalized to the QDC.
+    const int center = (int) floor((maxPosition - table.peak) * binsPerSample + 0.5);
+    double bestScore = numeric_limits<double>::max();
+    int best = center;
+    double amplitude = 0.0;
+    for (int k = center - searchWidth * (int) binsPerSample; k <= center + searchWidth * (int) binsPerSample; k++) {
+        double sumYf = 0.0, sumFf = 0.0;
+        const double *values = &table.values[table.offset - k];
+        for (size_t i = 0; i < n; i++) {
+            double f = values[i * binsPerSample];
+            sumYf += data[i] * f;
+            sumFf += f * f;
+        }
+
+        double score;
+        if (isFastSiPm_)
+            score = qdc_ * qdc_ * sumFf - 2 * qdc_ * sumYf;
+        else if (sumYf > 0)
+            score = -sumYf * sumYf / sumFf;
+        else
+            continue;
+
+        if (score < bestScore) {
+            bestScore = score;
+            best = k;
+            amplitude = isFastSiPm_ ? qdc_ : sumYf / sumFf;
+        }
+    }
+
+    if (!isFastSiPm_ && amplitude == 0.0)
+        amplitude = data[maxPosition] / table.values[table.offset + (int) (table.peak * binsPerSample + 0.5)];
+
+    //Refine the phase and amplitude with Gauss-Newton steps on the exact function. A step that makes the fit
+    // worse is halved until it does not.
+    double phase = (double) best / binsPerSample;
+    double chi = CalculateResiduals(data, pars, phase, amplitude);
+    for (unsigned int iteration = 0; iteration < maxIterations; iteration++) {
+        double jpp = 0.0, jpa = 0.0, jaa = 0.0, rp = 0.0, ra = 0.0;
+        const double scale = isFastSiPm_ ? qdc_ : amplitude;
+        for (size_t i = 0; i < n; i++) {
+            double jp = -scale * derivative_[i];
+            double r = data[i] - scale * model_[i];
+            jpp += jp * jp;
+            jpa += jp * model_[i];
+            jaa += model_[i] * model_[i];
+            rp += jp * r;
+            ra += model_[i] * r;
+        }
+
+        double stepPhase, stepAmplitude = 0.0;
+        if (isFastSiPm_) {
+            if (jpp == 0)
+                break;
+            stepPhase = rp / jpp;
+        } else {
+            double det = jpp * jaa - jpa * jpa;
+            if (det == 0)
+                break;
+            stepPhase = (rp * jaa - ra * jpa) / det;
+            stepAmplitude = (ra * jpp - rp * jpa) / det;
+        }
+
+        if (fabs(stepPhase) > 1.0) {
+            stepAmplitude /= fabs(stepPhase);
+            stepPhase = stepPhase > 0 ? 1.0 : -1.0;
+        }
+
+        bool accepted = false;
+        for (unsigned int halving = 0; halving < 10 && !accepted; halving++) {
+            double trial = CalculateResiduals(data, pars, phase + stepPhase, amplitude + stepAmplitude);
+            if (trial <= chi) {
+                phase += stepPhase;
+                amplitude += stepAmplitude;
+                chi = trial;
+                accepted = true;
+            } else {
+                stepPhase *= 0.5;
+                stepAmplitude *= 0.5;
+            }
+        }
+
+        if (!accepted || fabs(stepPhase) < tolerance)
+            break;
+    }
+
+    if (baseline.second > 0)
+        chi /= baseline.second * baseline.second;
+    chi_ = chi;
+    dof_ = n - (isFastSiPm_ ? 1. : 2.);
+    amp_ = isFastSiPm_ ? 0.0 : (qdc_ != 0 ? amplitude / qdc_ : amplitude);
+
+    return phase;
+}
+
+const TemplateFitter::Template &TemplateFitter::GetTemplate(const std::pair<double, double> &pars,
+                                                           const size_t &length) {
+    vector<Template>::iterator it = templates_.begin();
+    for (; it != templates_.end(); it++)
+        if (it->pars == pars && it->isFastSiPm == isFastSiPm_)
+            break;
+
+    if (it != templates_.end() && it->length >= length)
+        return *it;
+
+    if (it == templates_.end()) {
+        Template table;
+        table.pars = pars;
+        table.isFastSiPm = isFastSiPm_;
+        table.length = 0;
+        table.offset = 0;
+        table.peak = 0.0;
+
+        //The PMT function rises from zero, so we look for its maximum. The SiPM function is centered on the phase.
+        if (!isFastSiPm_) {
+            double peakValue = 0.0;
+            for (unsigned int bin = 0; bin < 10000 * binsPerSample; bin++) {
+                double value = Evaluate((double) bin / binsPerSample, pars).first;
+                if (value > peakValue) {
+                    peakValue = value;
+                    table.peak = (double) bin / binsPerSample;
+                } else if (value < 0.5 * peakValue)
+                    break;
+            }
+        }
+        templates_.push_back(table);
+        it = templates_.end() - 1;
+    }
+
+    //The search puts the phase within searchWidth samples of the expected phase, so the samples are never further
+    // than the length of the data plus the peak position from it.
+    const int before = (int) (length + searchWidth + 2) * binsPerSample;
+    const int after = (int) (length + it->peak + searchWidth + 2) * binsPerSample;
+    it->offset = before;
+    it->values.resize(before + after + 1);
+    for (int bin = -before; bin <= after; bin++)
+        it->values[bin + before] = Evaluate((double) bin / binsPerSample, pars).first;
+    it->length = length;
+
+    return *it;
+}
+
+std::pair<double, double> TemplateFitter::Evaluate(const double &d, const std::pair<double, double> &pars) const {
+    const double beta = pars.first, gamma = pars.second;
+    if (isFastSiPm_) {
+        double value = exp(-d * d / (2 * gamma * gamma)) / (gamma * sqrt(2 * M_PI));
+        return make_pair(value, -d / (gamma * gamma) * value);
+    }
+
+    if (d <= 0)
+        return make_pair(0.0, 0.0);
+
+    double decay = exp(-beta * d);
+    double rise = gamma * d * gamma * d;
+    rise *= rise;
+    double gauss = exp(-rise);
+    return make_pair(decay * (1 - gauss), -beta * decay * (1 - gauss) + 4 * rise / d * decay * gauss);
+}
+
+double TemplateFitter::CalculateResiduals(const std::vector<double> &data, const std::pair<double, double> &pars,
+                                          const double &phase, const double &amplitude) {
+    const double scale = isFastSiPm_ ? qdc_ : amplitude;
+    model_.resize(data.size());
+    derivative_.resize(data.size());
+
+    double chi = 0.0;
+    for (size_t i = 0; i < data.size(); i++) {
+        pair<double, double> value = Evaluate(i - phase, pars);
+        model_[i] = value.first;
+        derivative_[i] = value.second;
+        double r = data[i] - scale * value.first;
+        chi += r * r;
+    }
+    return chi;
+}
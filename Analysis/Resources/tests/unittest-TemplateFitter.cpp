@@ -0,0 +1,64 @@
+///@file unittest-TemplateFitter.cpp
+///@brief A small code to test the functionality of the TemplateFitter
+///@date October 17, 2026
+#include <iostream>
+#include <stdexcept>
+
+#include <cmath>
+
+#include <UnitTest++.h>
+
+#include "TemplateFitter.hpp"
+#include "UnitTestSampleData.hpp"
+
+using namespace std;
+using namespace unittest_trace_variables;
+using namespace unittest_fit_variables;
+
+TEST_FIXTURE(TemplateFitter, TestTemplateFitter) {
+    //We need to set the QDC before the fit
+    SetQdc(21329.85714285);
+
+    //The least squares minimum of this waveform is at -0.581124, the GslFitter gives -0.0826487 for it.
+    double phase = CalculatePhase(waveform, fitting_parameters, max_pair, baseline_pair);
+    CHECK_CLOSE(-0.581124, phase, 1e-5);
+    CHECK(GetAmplitude() > 0);
+
+    CHECK_THROW(CalculatePhase(empty_vector_double, fitting_parameters, max_pair, baseline_pair), range_error);
+}
+
+TEST_FIXTURE(TemplateFitter, TestTemplateFitterExact) {
+    const double beta = fitting_parameters.first, gamma = fitting_parameters.second;
+    const double qdc = 1000.;
+    SetQdc(qdc);
+
+    //A waveform made from the function itself has to give back its phase and amplitude.
+    for (double expected = 2.0; expected < 4.0; expected += 0.173) {
+        vector<double> data;
+        for (unsigned int i = 0; i < 30; i++) {
+            double d = i - expected;
+            data.push_back(d < 0 ? 0 : qdc * 2.5 * exp(-beta * d) * (1 - exp(-pow(gamma * d, 4.))));
+        }
+        CHECK_CLOSE(expected, CalculatePhase(data, fitting_parameters, max_pair, baseline_pair), 1e-5);
+        CHECK_CLOSE(2.5, GetAmplitude(), 1e-5);
+    }
+}
+
+TEST_FIXTURE(TemplateFitter, TestTemplateFitterSiPm) {
+    const double gamma = 1.7, qdc = 5000.;
+    SetQdc(qdc);
+    SetIsFastSiPm(true);
+
+    for (double expected = 5.0; expected < 7.0; expected += 0.31) {
+        vector<double> data;
+        for (unsigned int i = 0; i < 15; i++) {
+            double d = i - expected;
+            data.push_back(qdc / (gamma * sqrt(2 * M_PI)) * exp(-d * d / (2 * gamma * gamma)));
+        }
+        CHECK_CLOSE(expected, CalculatePhase(data, make_pair(0., gamma), max_pair, baseline_pair), 1e-5);
+    }
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,84 @@
+///@file BoundedQueue.hpp
+///@brief A first-in first-out queue with a fixed capacity that is used to hand
+/// work from one thread of the scan to the next.
+///@date October 17, 2026
+#ifndef PIXIESUITE_BOUNDEDQUEUE_HPP
+#define PIXIESUITE_BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+///A queue that blocks the producer while it is full and the consumer while it
+/// is empty. The full queue is what applies the back-pressure to the stage
+/// in front of it. Any number of threads may push and pop.
+template<typename T>
+class BoundedQueue {
+public:
+    ///Constructor that sets the capacity of the queue
+    ///@param[in] capacity : The maximum number of items in the queue
+    explicit BoundedQueue(const size_t &capacity = 1) : capacity_(capacity) {}
+
+    ///Adds an item to the back of the queue, waiting for room if the queue
+    /// is full.
+    ///@param[in] item : The item to add
+    void Push(const T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (queue_.size() >= capacity_)
+            notFull_.wait(lock);
+        queue_.push_back(item);
+        notEmpty_.notify_one();
+    }
+
+    ///Removes the item at the front of the queue, waiting for one if the
+    /// queue is empty.
+    ///@return The item at the front of the queue
+    T Pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (queue_.empty())
+            notEmpty_.wait(lock);
+        T item = queue_.front();
+        queue_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    ///Removes the item at the front of the queue if there is one.
+    ///@param[out] item : The item at the front of the queue
+    ///@return True if an item was removed and false if the queue was empty
+    bool TryPop(T &item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty())
+            return false;
+        item = queue_.front();
+        queue_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    ///@return The number of items in the queue
+    size_t GetSize() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    ///@return The maximum number of items in the queue
+    size_t GetCapacity() const { return capacity_; }
+
+    ///Sets the capacity of the queue. This should only be done while no
+    /// other thread is using the queue.
+    ///@param[in] capacity : The maximum number of items in the queue
+    void SetCapacity(const size_t &capacity) { capacity_ = capacity; }
+
+private:
+    BoundedQueue(const BoundedQueue &); ///< Queues cannot be copied
+    BoundedQueue &operator=(const BoundedQueue &); ///< Queues cannot be assigned
+
+    size_t capacity_; ///< The maximum number of items in the queue
+    std::deque<T> queue_; ///< The items in the queue
+    std::mutex mutex_; ///< Protects the items in the queue
+    std::condition_variable notEmpty_; ///< Signalled when an item is pushed
+    std::condition_variable notFull_; ///< Signalled when an item is popped
+};
+
+#endif //PIXIESUITE_BOUNDEDQUEUE_HPP
@@ -20,11 +20,23 @@ public:
     ///Constructor taking the base class as an argument so that we can set
     /// the trace information properly
     ///@param[in] evt : The event that we are going to assign here.
-    ProcessedXiaData(XiaData &evt) : XiaData(evt) {
-        trace_ = evt.GetTrace();
+    ProcessedXiaData(const XiaData &evt) { Assign(evt); }
+
+    ///Makes this object hold the event, as if it were constructed from it.
+    /// The samples are converted straight from the spill buffer or the trace
+    /// of the event into the storage of our trace, and the storage of a
+    /// recycled object is reused.
+    ///@param[in] evt : The event that we are going to assign here.
+    void Assign(const XiaData &evt) {
+        XiaData::AssignSansTrace(evt);
+        if (evt.HasTraceView())
+            trace_.AssignPacked(evt.GetTraceView(), evt.GetTraceLength());
+        else
+            trace_.Assign(evt.GetOwnedTrace());
         trace_.SetIsSaturated(evt.IsSaturated());
-        walkCorrectedTime_ = 0;
-    };
+        isIgnored_ = isValidData_ = false;
+        calibratedEnergy_ = highResTimeInNs_ = walkCorrectedTime_ = 0;
+    }
 
     /// Default Destructor.
     ~ProcessedXiaData() {}
@@ -22,12 +22,15 @@
 #include <getopt.h>
 
 #include "hribf_buffers.h"
+#include "SpillIndex.hpp"
 #include "XiaData.hpp"
 
 #define SCAN_VERSION "1.2.29"
 #define SCAN_DATE "Aug. 11th, 2016"
 
 class Server;
+class SpillReceiver;
+class SpillRingReader;
 
 class Terminal;
 
@@ -106,6 +109,12 @@ public:
     /// Return true if shared memory mode is enabled.
     bool ShmMode() { return shm_mode; }
 
+    /// Return true if the shared memory spills come from the poll2 spill stream.
+    bool StreamMode() { return stream_mode; }
+
+    /// Return true if the shared memory spills come from the poll2 shared-memory ring.
+    bool RingMode() { return ring_mode; }
+
     /// Return true if batch processing mode is enabled.
     bool BatchMode() { return batch_mode; }
 
@@ -288,6 +297,9 @@ private:
 
     unsigned long num_spills_recvd; /// The total number of good spills received from either the input file or shared memory.
     unsigned long file_start_offset; /// The first word in the file at which to start scanning.
+    unsigned long first_spill; /// The first spill in the file to scan.
+    unsigned long last_spill; /// The last spill in the file to scan.
+    unsigned long current_spill; /// The number of the next spill to be read from the input file.
 
     bool write_counts; /// Set to true if raw channel counts are to be written to file.
 
@@ -297,17 +309,34 @@ private:
     bool debug_mode; /// Set to true if the user wishes to display debug information.
     bool dry_run_mode; /// Set to true if a dry run is to be performed i.e. data is to be read but not processed.
     bool shm_mode; /// Set to true if shared memory mode is to be used.
+    bool stream_mode; /// Set to true if the shared memory spills are read from the poll2 spill stream instead of UDP.
+    bool ring_mode; /// Set to true if the shared memory spills are read from the poll2 shared-memory ring instead of UDP.
     bool batch_mode; /// Set to true if the program is to be run with no interactive command line.
     bool scan_init; /// Set to true when ScanInterface is initialized properly and is ready to scan.
     bool file_open; /// Set to true when an input binary file is successfully opened for reading.
+    bool mmap_mode; /// Set to true if .ldf and .pld input files are to be read through a memory mapping.
 
     bool kill_all; /// Set to true when user has sent kill command.
     bool run_ctrl_exit; /// Set to true when run control thread has exited.
 
     Server *poll_server; /// Poll2 shared memory server.
+    SpillReceiver *spill_stream; /// Poll2 spill stream, used instead of poll_server in stream mode.
+    std::string stream_address; /// Address of the poll2 spill stream.
+    SpillRingReader *spill_ring; /// Poll2 shared-memory ring, used instead of poll_server in ring mode.
+    std::string ring_name; /// Name of the poll2 shared-memory ring.
 
     std::ifstream input_file; /// Main input binary data file.
     std::streampos file_length; /// Main input file length (in bytes).
+    MappedFile mapped_file; /// Memory mapping of the main input file, used in place of input_file in mmap mode.
+
+    SpillIndex spill_index; /// Index of the spills in the main input file.
+    std::string index_filename; /// Name of the spill index file of the main input file.
+    std::vector<XiaListModeDataMask> module_masks; /// Data masks used to find the times of the spills in the index.
+    bool index_ready; /// Set to true when the spill index describes the whole input file.
+    bool building_index; /// Set to true while the spill index is built from a scan of the whole file.
+    bool reset_reader; /// Set to true when the file reader is to start over at the current position in the file.
+    unsigned long long reader_start; /// The position in the file (in bytes) where the file reader last started over.
+    unsigned long long skip_before; /// Spills starting before this position (in bytes) are skipped after a jump.
 
     fileInformation finfo; /// Data structure for storing binary file header information.
 
@@ -335,6 +364,27 @@ private:
     /// Open a new binary input file for reading.
     bool open_input_file(const std::string &fname_);
 
+    /// Return the current position in the input file (in bytes).
+    std::streampos input_position();
+
+    /// Move to the start of a spill using the spill index.
+    bool seek_spill(const unsigned long &spill_);
+
+    /// Count a spill read from the input file and add it to the spill index while it is being built.
+    void count_spill(const unsigned long long &offset_, unsigned int *spill_, const unsigned int &nWords_,
+                     const bool &good_);
+
+    /// Write the spill index once it describes the whole input file.
+    void write_spill_index();
+
+    /** Wait for the next spill from the poll2 spill stream or shared-memory
+      * ring. Returns false if there was none, with the reason in waiting_ or
+      * an empty waiting_ for a poll2 notification. */
+    bool read_local_spill(std::vector<unsigned int> &spill_, std::string &waiting_);
+
+    /// Return the number of spills the spill stream or shared-memory ring lost for us.
+    unsigned long local_spills_missed();
+
     ///Sets output Filename and path that were passed using the -o flag.
     ///@param[in] a : The parameter that we are going to set
     void SetOutputInformation(const std::string &a);
@@ -0,0 +1,101 @@
+///@file SpillIndex.hpp
+///@brief An index of the spills in a .ldf or .pld file that is stored beside
+/// the file so that a scan can jump straight to a spill.
+///@date October 17, 2026
+#ifndef PIXIESUITE_SPILLINDEX_HPP
+#define PIXIESUITE_SPILLINDEX_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "XiaListModeDataMask.hpp"
+
+///Where one spill is in the file and what it holds.
+struct SpillIndexEntry {
+    unsigned long long offset; ///< Position of the spill in the file in bytes
+    unsigned int nWords; ///< The number of words in the spill
+    unsigned int moduleMask; ///< Bit N is set if module N has events in the spill
+    unsigned long long firstTime; ///< The earliest event time in the spill in clock ticks
+    unsigned long long lastTime; ///< The latest event time in the spill in clock ticks
+    bool good; ///< False if the spill is a fragment or was flagged as corrupt
+};
+
+///The index holds one entry for every spill that the file readers return, in
+/// the order that they return them, so that a spill number means the same
+/// thing to every scan of the file. The index is written to a file named
+/// after the data file with ".idx" appended. The length of the data file is
+/// kept in the index so that an index that no longer matches its data file is
+/// not used.
+class SpillIndex {
+public:
+    ///Default constructor
+    SpillIndex() : fileLength_(0) {}
+
+    ///@param[in] dataFile : The name of a .ldf or .pld file
+    ///@return The name of the index file for the data file
+    static std::string GetIndexFilename(const std::string &dataFile) {
+        return dataFile + ".idx";
+    }
+
+    ///Looks through the module buffers of a spill and fills in the module
+    /// mask and the times of the entry. Modules without a mask for their
+    /// firmware are left out of the times.
+    ///@param[in] data : The spill, ending with the end of spill words
+    ///@param[in] nWords : The number of words in the spill
+    ///@param[in] masks : The data mask of each module, indexed by module number
+    ///@param[out] entry : The entry to fill in
+    static void Summarize(unsigned int *data, const unsigned int &nWords,
+                          const std::vector<XiaListModeDataMask> &masks,
+                          SpillIndexEntry &entry);
+
+    ///Adds the next spill of the file to the index.
+    ///@param[in] entry : The spill to add
+    void Add(const SpillIndexEntry &entry) { spills_.push_back(entry); }
+
+    ///Removes all of the spills from the index.
+    void Clear() { spills_.clear(); }
+
+    ///@return The number of spills in the index
+    size_t GetNumSpills() const { return spills_.size(); }
+
+    ///@param[in] spill : The number of the spill, starting from zero
+    ///@return The entry for the spill
+    ///@throw out_of_range if there is no such spill
+    const SpillIndexEntry &GetSpill(const size_t &spill) const;
+
+    ///@return The length of the data file that the index describes in bytes
+    unsigned long long GetFileLength() const { return fileLength_; }
+
+    ///@param[in] length : The length of the data file in bytes
+    void SetFileLength(const unsigned long long &length) { fileLength_ = length; }
+
+    ///Finds the first good spill that holds events at or after a time.
+    ///@param[in] time : The time in clock ticks
+    ///@return The number of the spill, or the number of spills if there is none
+    size_t FindTime(const unsigned long long &time) const;
+
+    ///Splits the index into ranges of consecutive spills holding roughly the
+    /// same number of words, so that each range can be scanned by a separate
+    /// process.
+    ///@param[in] parts : The number of ranges to make
+    ///@return The first and last spill of each range. There are fewer ranges
+    /// than requested if there are fewer spills than parts.
+    std::vector<std::pair<size_t, size_t> > Partition(const unsigned int &parts) const;
+
+    ///Reads an index from a file.
+    ///@param[in] filename : The name of the index file
+    ///@return False if the file could not be read or is not a spill index
+    bool Read(const std::string &filename);
+
+    ///Writes the index to a file.
+    ///@param[in] filename : The name of the index file
+    ///@return False if the file could not be written
+    bool Write(const std::string &filename) const;
+
+private:
+    unsigned long long fileLength_; ///< The length of the data file in bytes
+    std::vector<SpillIndexEntry> spills_; ///< The spills in the order that they are read
+};
+
+#endif //PIXIESUITE_SPILLINDEX_HPP
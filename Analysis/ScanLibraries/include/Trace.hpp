@@ -6,28 +6,202 @@
 #define __TRACE_HPP__
 
 #include <iostream>
+#include <limits>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <cmath>
 
 /// @brief This defines a more extensible implementation of a digitized trace.
-/// The class is derived from a vector of unsigned integers. This is the basic
-/// form of a trace from most digitizers. The Trace class enables processed
-/// information about the trace (such as the baseline, integral, etc.).
+/// The class is derived from a vector of 16-bit samples, which holds the
+/// output of every Pixie-16 ADC at half the size of an unsigned int. The
+/// Trace class enables processed information about the trace (such as the
+/// baseline, integral, etc.).
 ///
 /// We also store information about the Waveform. The waveform is the part
 /// of the trace that actually contains information about the signal that
 /// was captured. This excludes the baseline.
-class Trace : public std::vector<unsigned int> {
+///
+/// The baseline subtracted trace and waveform are only computed when they are
+/// first asked for, into buffers that are kept with the trace. They are
+/// computed again after the baseline, the waveform range or the samples
+/// change. Every member of the vector that can change the samples, including
+/// the non-const element access, is wrapped here so that the buffers are
+/// marked out of date.
+class Trace : public std::vector<unsigned short> {
 public:
+    typedef std::vector<unsigned short> Samples; ///< The container of the samples
+
     ///Default constructor
-    Trace() : std::vector<unsigned int>() {}
+    Trace() : Samples() { Initialize(); }
 
-    ///An automatic conversion for the trace
+    ///An automatic conversion for the trace. Samples that do not fit in 16
+    /// bits are clamped to the largest 16-bit value.
     ///@param [in] x : the trace to store in the class
-    Trace(const std::vector<unsigned int> &x) : std::vector<unsigned int>(x) {}
+    Trace(const std::vector<unsigned int> &x) : Samples() {
+        Initialize();
+        AssignClamped(x);
+    }
+
+    ///Constructs the trace from the samples in a spill buffer
+    ///@param [in] data : The first sample
+    ///@param [in] length : The number of samples
+    Trace(const unsigned short *data, const size_t &length) : std::vector<unsigned short>(data, data + length) {
+        Initialize();
+    }
+
+    ///Replaces the samples and forgets the results of any analysis. The
+    /// storage of the trace and its buffers is reused, so a recycled trace
+    /// does not allocate unless it grows.
+    ///@param [in] data : The first sample
+    ///@param [in] length : The number of samples
+    void Assign(const unsigned short *data, const size_t &length) {
+        assign(data, data + length);
+        Reset();
+    }
+
+    ///Replaces the samples with the packed trace words of list mode data and
+    /// forgets the results of any analysis. Every word holds two samples, the
+    /// earlier one in the low 16 bits, which are taken out with shifts so
+    /// that the samples do not depend on the byte order of the host.
+    ///@param [in] words : The first word of the trace
+    ///@param [in] length : The number of samples
+    void AssignPacked(const unsigned int *words, const size_t &length) {
+        Samples::resize(length);
+        for (size_t k = 0; k < length; k++)
+            Samples::operator[](k) = (unsigned short) ((words[k / 2] >> (16 * (k % 2))) & 0xFFFF);
+        Reset();
+    }
+
+    ///Replaces the samples and forgets the results of any analysis. Samples
+    /// that do not fit in 16 bits are clamped to the largest 16-bit value.
+    ///@param [in] x : The samples as the digitizers give them
+    void Assign(const std::vector<unsigned int> &x) {
+        AssignClamped(x);
+        Reset();
+    }
+
+    using Samples::operator[];
+    using Samples::at;
+    using Samples::begin;
+    using Samples::end;
+    using Samples::rbegin;
+    using Samples::rend;
+    using Samples::front;
+    using Samples::back;
+    using Samples::data;
+
+    ///@return A writable reference to a sample, the derived buffers are out of date afterwards.
+    reference operator[](size_type n) {
+        Invalidate();
+        return Samples::operator[](n);
+    }
+
+    ///@return A writable reference to a sample, the derived buffers are out of date afterwards.
+    reference at(size_type n) {
+        Invalidate();
+        return Samples::at(n);
+    }
+
+    ///@return A writable iterator to the first sample, the derived buffers are out of date afterwards.
+    iterator begin() {
+        Invalidate();
+        return Samples::begin();
+    }
+
+    ///@return A writable iterator past the last sample, the derived buffers are out of date afterwards.
+    iterator end() {
+        Invalidate();
+        return Samples::end();
+    }
+
+    ///@return A writable reverse iterator to the last sample, the derived buffers are out of date afterwards.
+    reverse_iterator rbegin() {
+        Invalidate();
+        return Samples::rbegin();
+    }
+
+    ///@return A writable reverse iterator before the first sample, the derived buffers are out of date afterwards.
+    reverse_iterator rend() {
+        Invalidate();
+        return Samples::rend();
+    }
+
+    ///@return A writable reference to the first sample, the derived buffers are out of date afterwards.
+    reference front() {
+        Invalidate();
+        return Samples::front();
+    }
+
+    ///@return A writable reference to the last sample, the derived buffers are out of date afterwards.
+    reference back() {
+        Invalidate();
+        return Samples::back();
+    }
+
+    ///@return A writable pointer to the samples, the derived buffers are out of date afterwards.
+    unsigned short *data() {
+        Invalidate();
+        return Samples::data();
+    }
+
+    ///Replaces the samples, see std::vector::assign.
+    template<typename... Args>
+    void assign(Args &&... args) {
+        Invalidate();
+        Samples::assign(std::forward<Args>(args)...);
+    }
+
+    ///Adds a sample to the end of the trace.
+    void push_back(const unsigned short &a) {
+        Invalidate();
+        Samples::push_back(a);
+    }
+
+    ///Removes the last sample of the trace.
+    void pop_back() {
+        Invalidate();
+        Samples::pop_back();
+    }
+
+    ///Inserts samples into the trace, see std::vector::insert.
+    template<typename... Args>
+    iterator insert(Args &&... args) {
+        Invalidate();
+        return Samples::insert(std::forward<Args>(args)...);
+    }
+
+    ///Removes samples from the trace, see std::vector::erase.
+    template<typename... Args>
+    iterator erase(Args &&... args) {
+        Invalidate();
+        return Samples::erase(std::forward<Args>(args)...);
+    }
+
+    ///Changes the number of samples, see std::vector::resize.
+    template<typename... Args>
+    void resize(Args &&... args) {
+        Invalidate();
+        Samples::resize(std::forward<Args>(args)...);
+    }
+
+    ///Removes every sample.
+    void clear() {
+        Invalidate();
+        Samples::clear();
+    }
+
+    ///Exchanges the samples with another container.
+    void swap(Samples &a) {
+        Invalidate();
+        Samples::swap(a);
+    }
+
+    ///@return A copy of the samples as unsigned integers for code that
+    /// expects the trace as the digitizers give it.
+    operator std::vector<unsigned int>() const { return std::vector<unsigned int>(begin(), end()); }
 
     ///@return Returns a std::pair<double,double> containing the average and
     /// standard deviation of the baseline as the .first and .second
@@ -35,7 +209,7 @@ public:
     std::pair<double, double> GetBaselineInfo() const { return baseline_; }
 
     ///@return Returns the energy sums that were set.
-    std::vector<double> GetEnergySums() const { return esums_; }
+    const std::vector<double> &GetEnergySums() const { return esums_; }
 
     ///@return Returns a std::pair<unsigned int, double> containing the
     /// position of the maximum value in the trace and the amplitude of the
@@ -47,7 +221,7 @@ public:
     double GetFilteredBaseline() const { return filteredBaseline_; }
 
     ///@return The energies found by filtering the trace.
-    std::vector<double> GetFilteredEnergies() const { return filteredEnergies_; }
+    const std::vector<double> &GetFilteredEnergies() const { return filteredEnergies_; }
 
     ///@return Returns a std::pair<unsigned int, double> containing the
     /// position of the maximum value in the trace and the amplitude of the
@@ -73,26 +247,43 @@ public:
     ///@return The value of tau that was calculated from the trace.
     double GetTau() const { return tau_; }
 
-    ///@return Returns the waveform sans baseline
-    std::vector<double> GetTraceSansBaseline() const { return traceSansBaseline_; }
+    ///@return Returns the trace sans baseline, which is computed from the
+    /// baseline that was set the first time that it's asked for. It is empty
+    /// until a baseline has been set.
+    const std::vector<double> &GetTraceSansBaseline() const {
+        if (!hasBaseline_)
+            return EmptyBuffer();
+        if (!hasTraceSansBaseline_) {
+            SubtractBaseline(0, size(), traceSansBaseline_);
+            hasTraceSansBaseline_ = true;
+        }
+        return traceSansBaseline_;
+    }
 
     ///@return Returns the Trigger Filter that was set.
-    std::vector<double> GetTriggerFilter() const { return trigFilter_; }
+    const std::vector<double> &GetTriggerFilter() const { return trigFilter_; }
 
     ///@return Returns a vector containing all of the found triggers
-    std::vector<unsigned int> GetTriggerPositions() const { return triggerPositions_; }
-
-    ///@return Returns the baseline subtracted waveform found inside the trace.
-    std::vector<double> GetWaveform() {
-        return std::vector<double>(traceSansBaseline_.begin() + waveformRange_.first,
-                                   traceSansBaseline_.begin() + waveformRange_.second);
+    const std::vector<unsigned int> &GetTriggerPositions() const { return triggerPositions_; }
+
+    ///@return Returns the baseline subtracted waveform found inside the
+    /// trace. Only the samples of the waveform are computed. It is empty
+    /// until a baseline has been set.
+    const std::vector<double> &GetWaveform() const {
+        if (!hasBaseline_)
+            return EmptyBuffer();
+        if (!hasWaveform_) {
+            SubtractBaseline(waveformRange_.first, waveformRange_.second, waveform_);
+            hasWaveform_ = true;
+        }
+        return waveform_;
     }
 
     ///@return The bounds of the waveform in the trace
     std::pair<unsigned int, unsigned int> GetWaveformRange() const { return waveformRange_; }
 
     ///@return Returns the waveform with the baseline
-    std::vector<unsigned int> GetWaveformWithBaseline() {
+    std::vector<unsigned int> GetWaveformWithBaseline() const {
         return std::vector<unsigned int>(begin() + waveformRange_.first, begin() + waveformRange_.second);
     }
     
@@ -112,7 +303,11 @@ public:
     /// deviation)
     ///@param[in] a : The pair<double,double> containing the average and
     /// standard deviation.
-    void SetBaseline(const std::pair<double, double> &a) { baseline_ = a; }
+    void SetBaseline(const std::pair<double, double> &a) {
+        baseline_ = a;
+        hasBaseline_ = true;
+        Invalidate();
+    }
 
     ///sets the energy sums vector if we are using the TriggerFilterAnalyzer
     ///@param [in] a : the vector of energy sums
@@ -163,10 +358,6 @@ public:
     ///@param[in] a : The value that we are going to set
     void SetQdc(const double &a) { qdc_ = a; }
 
-    ///Sets the baseline subtracted trace.
-    ///@param[in] a : The vector that we are going to assign.
-    void SetTraceSansBaseline(const std::vector<double> &a) { traceSansBaseline_ = a; }
-
     ///Sets the value of the tail-ratio method used for doing discrimination
     /// on signals that have a varying decay constant. This is generally
     /// defined as the integral of the "tail" of the waveform divided by the
@@ -189,9 +380,62 @@ public:
 
     ///Sets the bounds for the waveform
     ///@param[in] a : the range we want to set
-    void SetWaveformRange(const std::pair<unsigned int, unsigned int> &a) { waveformRange_ = a; }
+    void SetWaveformRange(const std::pair<unsigned int, unsigned int> &a) {
+        waveformRange_ = a;
+        hasWaveform_ = false;
+    }
 
 private:
+    ///Sets every value to the state of a trace that hasn't been analyzed.
+    void Initialize() {
+        isSaturated_ = hasValidWaveformAnalysis_ = hasValidTimingAnalysis_ = false;
+        hasBaseline_ = hasTraceSansBaseline_ = hasWaveform_ = false;
+        phase_ = qdc_ = tailRatio_ = tau_ = filteredBaseline_ = 0;
+        numTriggers_ = 0;
+        baseline_ = std::make_pair(0., 0.);
+        max_ = extrapolatedMax_ = std::make_pair(0u, 0.);
+        waveformRange_ = std::make_pair(0u, 0u);
+    }
+
+    ///Sets every value to the state of a trace that hasn't been analyzed and
+    /// empties the buffers without giving back their memory.
+    void Reset() {
+        Initialize();
+        traceSansBaseline_.clear();
+        waveform_.clear();
+        filteredEnergies_.clear();
+        trigFilter_.clear();
+        esums_.clear();
+        triggerPositions_.clear();
+    }
+
+    ///@return The buffer handed out for the products that need a baseline before one is set.
+    static const std::vector<double> &EmptyBuffer() {
+        static const std::vector<double> empty;
+        return empty;
+    }
+
+    ///Marks the baseline subtracted trace and waveform as out of date.
+    void Invalidate() { hasTraceSansBaseline_ = hasWaveform_ = false; }
+
+    ///Replaces the samples, clamping those that do not fit in 16 bits.
+    void AssignClamped(const std::vector<unsigned int> &x) {
+        static const unsigned int maxSample = std::numeric_limits<unsigned short>::max();
+        Invalidate();
+        Samples::resize(x.size());
+        for (size_t i = 0; i < x.size(); i++)
+            Samples::operator[](i) = (unsigned short) (x[i] > maxSample ? maxSample : x[i]);
+    }
+
+    ///Fills a buffer with the samples in [low, high) minus the baseline.
+    void SubtractBaseline(const size_t &low, size_t high, std::vector<double> &result) const {
+        if (high > size())
+            high = size();
+        result.resize(high > low ? high - low : 0);
+        for (size_t i = 0; i < result.size(); i++)
+            result[i] = (*this)[low + i] - baseline_.first;
+    }
+
     bool isSaturated_; ///< True if the trace was flagged as saturated.
     bool hasValidWaveformAnalysis_;///< True if the analysis of the waveform was successful (no fitting)
     bool hasValidTimingAnalysis_;///< True if the fit/cfd of the trace was completed
@@ -209,8 +453,13 @@ private:
     std::pair<unsigned int, double> extrapolatedMax_; ///< Max position and extrapolated value
     std::pair<unsigned int, unsigned int> waveformRange_; ///< Waveform Range
 
+    bool hasBaseline_; ///< True once a baseline has been set
+    mutable bool hasTraceSansBaseline_; ///< True if traceSansBaseline_ holds the current baseline
+    mutable bool hasWaveform_; ///< True if waveform_ holds the current baseline and range
+    mutable std::vector<double> traceSansBaseline_; ///< Baseline subtracted trace
+    mutable std::vector<double> waveform_; ///< Baseline subtracted waveform
+
     std::vector<double> filteredEnergies_; ///< Energies from filtering the trc.
-    std::vector<double> traceSansBaseline_; ///< Baseline subtracted trace
     std::vector<double> trigFilter_; ///< The trigger filter for the trace
     std::vector<double> esums_; ///< The Energy sums calculated from the trace
 
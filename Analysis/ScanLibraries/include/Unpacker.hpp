@@ -13,11 +13,18 @@
 #ifndef UNPACKER_HPP
 #define UNPACKER_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
 #include <deque>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "BoundedQueue.hpp"
+#include "XiaDataPool.hpp"
 #include "XiaListModeDataMask.hpp"
 
 #ifndef MAX_PIXIE_MOD
@@ -33,6 +40,12 @@ class ScanMain;
 
 class Unpacker {
 public:
+    /// The algorithms that can be used to build raw events from a spill.
+    enum EventBuilder {
+        LINEAR_SCAN, ///< Sort each module and scan the front of every module for each raw event.
+        KWAY_MERGE ///< Merge the time ordered channel streams with a min-heap.
+    };
+
     /// Default constructor.
     Unpacker();
 
@@ -45,6 +58,24 @@ public:
     /// Return the number of raw events read from the file.
     unsigned int GetNumRawEvents() { return numRawEvt; }
 
+    /// Return the algorithm used to build the raw events.
+    EventBuilder GetEventBuilder() { return eventBuilder_; }
+
+    /// Return the name of the algorithm used to build the raw events.
+    std::string GetEventBuilderName() { return eventBuilder_ == KWAY_MERGE ? "merge" : "linear"; }
+
+    /// Return the wall time in seconds spent sorting the spills and building raw events.
+    double GetEventBuildTime() { return buildTime_; }
+
+    /// Return the number of raw events built per second of event building wall time.
+    double GetEventBuildRate() { return buildTime_ > 0 ? numRawEvt / buildTime_ : 0; }
+
+    /// Return the number of threads used to unpack the spills.
+    unsigned int GetNumThreads() { return numThreads_; }
+
+    /// Return the number of time streams that were out of order and had to be sorted.
+    unsigned long GetNumSortedStreams() { return numSortedStreams_; }
+
     /// Return the width of the raw event window in pixie16 clock ticks.
     double GetEventWidth() { return eventWidth_; }
 
@@ -66,14 +97,72 @@ public:
     /// Return true if the scan is running and false otherwise.
     bool IsRunning() { return running; }
 
+    /// Return true if the hits at the end of a spill are carried into the next spill.
+    bool IsCarryingOver() { return carryOver_; }
+
+    /// Return true if the spills are decoded into the recycled XiaData pool.
+    bool IsPooledDecoding() { return pooledDecoding_; }
+
     /// Toggle debug mode on / off.
     bool SetDebugMode(bool state_ = true) { return (debug_mode = state_); }
 
+    /** Select the algorithm used to build raw events. The linear scan keeps
+      * one stream per module, sorts every module and scans the front of every
+      * module for each raw event. The merge keeps one stream per channel,
+      * only sorts the streams that are out of order and pulls the hits out
+      * in time order using a min-heap of the stream fronts. The linear scan is
+      * the default, the merge can order coincident hits differently within a
+      * raw event. This must be set before the first spill.
+      */
+    void SetEventBuilder(const EventBuilder &builder) { eventBuilder_ = builder; }
+
+    /** Toggle carrying the end of each spill into the next one. A module can
+      * only deliver hits later than the last hit it delivered, so once every
+      * module has reported past t, no raw event starting before t - eventWidth
+      * can receive any more hits. Hits after that horizon are kept and built
+      * together with the next spill so that coincidences straddling the spill
+      * boundary are not split. The remaining hits are built by FlushEventList.
+      */
+    bool SetCarryOver(bool state_ = true) { return (carryOver_ = state_); }
+
+    /** Set the number of threads used to unpack the spills. With more than one
+      * thread ReadSpill only copies the spill into a pipeline and returns. A
+      * decoder thread locates the module buffers and decodes them, a builder
+      * thread builds the raw events and a processing thread calls RawStats and
+      * ProcessRawEvent in the original order. Every thread beyond these three
+      * helps decoding the module buffers, so two threads give the same
+      * pipeline as three. This must be set before the first spill and
+      * FlushEventList must be called once the data ends.
+      * \param[in]  threads The number of threads, one to unpack in the calling thread.
+      * \return Nothing.
+      */
+    void SetNumThreads(const unsigned int &threads) { numThreads_ = threads > 0 ? threads : 1; }
+
     /// Set the width of events in pixie16 clock ticks.
     void SetEventWidth(double width) { eventWidth_ = width; }
 
+    /** Toggle decoding into a pool of XiaData objects that are recycled from
+      * spill to spill. The traces are kept as views into the spill buffer, so
+      * events are only valid until ReadSpill returns. Derived classes that
+      * take events out of the rawEvent must hand them back with ReleaseEvent
+      * instead of deleting them. This must be set before the first spill.
+      */
+    bool SetPooledDecoding(bool state_ = true) { return (pooledDecoding_ = state_); }
+
     void InitializeDataMask(const std::string &firmware, const unsigned int &frequency = 0);
 
+    /** Get the data mask used to decode a module.
+      * \param[in]  vsn The module number.
+      * \return The data mask of the module.
+      */
+    XiaListModeDataMask GetDataMask(const unsigned int &vsn) const;
+
+    /** Get the data masks of all of the modules. Modules that are missing
+      * from the configuration get a mask with an unknown firmware.
+      * \return The data mask of each module, indexed by module number.
+      */
+    std::vector<XiaListModeDataMask> GetDataMasks() const;
+
     /** ReadSpill is responsible for constructing a list of pixie16 events from
       * a raw data spill. This method performs sanity checks on the spill and
       * calls ReadBuffer in order to construct the event list.
@@ -84,6 +173,31 @@ public:
       */
     bool ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose = true);
 
+    /** Build and process all of the hits that have been carried over from
+      * previous spills. This should be called at the end of the data. When
+      * unpacking with several threads this also waits for every queued spill
+      * to be processed.
+      * \return Nothing.
+      */
+    void FlushEventList();
+
+    /** Discard the hits that have been carried over from previous spills and
+      * forget the latest hit time of every module. This must be called when
+      * the input is moved, otherwise the carried hits are built together with
+      * hits from an unrelated part of the data. When unpacking with several
+      * threads this first waits for every queued spill to be processed.
+      * \return Nothing.
+      */
+    void Reset();
+
+    /** Process every spill that is still in the pipeline and join its
+      * threads. The processing thread calls ProcessRawEvent, so this must be
+      * called before the derived class is destroyed. Hits that are carried
+      * over are not built, use FlushEventList for that.
+      * \return Nothing.
+      */
+    void StopPipeline();
+
     /** Write all recorded channel counts to a file.
       * \return Nothing.
       */
@@ -101,13 +215,22 @@ public:
 
 protected:
     bool debug_mode; ///< True if debug mode is set.
-    std::vector<std::deque<XiaData *>> eventList; ///< The list of all events in a spill.
+    std::vector<std::deque<XiaData *>> eventList; ///< The list of all events in a spill, one deque per stream.
     double eventWidth_; ///< The width of the raw event in pixie clock ticks
     XiaListModeDataMask mask_; ///< Object providing the masks necessary to decode the data.
     std::map<unsigned int, std::pair<std::string, unsigned int> > maskMap_;///< Maps firmware/frequency to module number
     unsigned int maxModuleNumberInFile_; ///< The maximum module number that we've encountered in the data file.
     std::deque<XiaData *> rawEvent; ///< The list of all events in the event window.
     bool running; ///< True if the scan is running.
+    bool pooledDecoding_; ///< True if events are decoded into the XiaData pool.
+    bool carryOver_; ///< True if the hits at the end of a spill are carried into the next spill.
+
+    /** Free an event that was handed out by the Unpacker. The event is
+      * returned to the pool when using pooled decoding and deleted otherwise.
+      * \param[in]  event_ The event to free.
+      * \return Nothing.
+      */
+    void ReleaseEvent(XiaData *event_);
 
     /** Process all events in the event list.
       * \param[in]  addr_ Pointer to a ScanInterface object. Unused by default.
@@ -122,38 +245,196 @@ protected:
       */
     virtual void RawStats(XiaData *event_) {}
 
-    /** Called form ReadSpill. Scan the current spill and construct a list of
-      * events which fired by obtaining the module, channel, trace, etc. of the
-      * timestamped event. This method will construct the event list for
-      * later processing.
+    /** Called once every raw event that was built by FlushEventList has been
+      * passed to ProcessRawEvent. It is called from the thread that runs
+      * ProcessRawEvent. Unused by default.
+      * \return Nothing.
+      */
+    virtual void FinishRawEvents() {}
+
+    /** Called form ReadSpill. Decode a module buffer from the current spill
+      * by obtaining the module, channel, trace, etc. of every timestamped
+      * event. The events are added to the event list once the whole spill
+      * was read. This may be called from several threads at once.
       * \param[in]  buf    Pointer to an array of unsigned ints containing raw buffer data.
-      * \param[out] bufLen The number of words in the buffer.
+      * \param[in]  vsn    The module number of the buffer.
+      * \param[out] events The XiaDatas read from the buffer.
       * \return The number of XiaDatas read from the buffer.
       */
-    int ReadBuffer(unsigned int *buf, const unsigned int &vsn);
+    int ReadBuffer(unsigned int *buf, const unsigned int &vsn, std::vector<XiaData *> &events);
 
 private:
+    /// The location of a raw event in a RawEventBatch along with its times.
+    struct BuiltEvent {
+        size_t begin; ///< The index of the first hit of the raw event.
+        size_t end; ///< One past the index of the last hit of the raw event.
+        unsigned long long startTime; ///< The start time of the raw event.
+        unsigned long long realStartTime; ///< The time of the first xia event in the raw event.
+        unsigned long long realStopTime; ///< The time of the last xia event in the raw event.
+    };
+
+    /// Raw events that have been built but not processed yet.
+    struct RawEventBatch {
+        std::vector<XiaData *> hits; ///< The hits of all of the raw events.
+        std::vector<BuiltEvent> events; ///< The raw events in the order they were built.
+    };
+
+    /// A spill on its way through the Unpacker.
+    struct PendingSpill {
+        std::vector<unsigned int> words; ///< A copy of the spill when it is queued in the pipeline.
+        unsigned int *data; ///< The spill data.
+        unsigned int nWords; ///< The number of words in the spill.
+        bool verbose; ///< The verbosity flag for this spill.
+        bool flush; ///< True if this is not a spill but a request to build every remaining hit.
+        bool good; ///< True if the spill passed the sanity checks.
+        bool fullSpill; ///< True if the spill ended with the end of spill vsn.
+        time_t wallTime; ///< The wall clock time inserted by poll, if any.
+        std::vector<std::pair<unsigned int, unsigned int> > modules; ///< The offset and vsn of each module buffer.
+        std::vector<std::vector<XiaData *> > decoded; ///< The hits decoded from each module buffer.
+        std::atomic<unsigned int> remaining; ///< The number of module buffers still being decoded.
+        RawEventBatch batch; ///< The raw events built from the spill.
+    };
+
     unsigned int TOTALREAD; /// Maximum number of data words to read.
     unsigned int maxWords; /// Maximum number of data words for revision D.
     unsigned int numRawEvt; /// The total count of raw events read from file.
 
     unsigned int channel_counts[MAX_PIXIE_MOD + 1][MAX_PIXIE_CHAN + 1]; /// Counters for each channel in each module.
 
-    double firstTime; /// The first recorded event time.
-    double eventStartTime; /// The start time of the current raw event.
-    double realStartTime; /// The time of the first xia event in the raw event.
-    double realStopTime; /// The time of the last xia event in the raw event.
-
-    /** Scan the event list and sort it by timestamp.
+    XiaDataPool pool_; /// Recycled XiaData objects used for pooled decoding.
+
+    EventBuilder eventBuilder_; /// The algorithm used to build the raw events.
+    std::vector<std::pair<unsigned long long, unsigned int> > mergeHeap_; /// Min-heap of (front time, stream) for the merge.
+    PendingSpill spill_; /// The spill that is being read when unpacking in the calling thread.
+    RawEventBatch batch_; /// The raw event that is being built when unpacking in the calling thread.
+
+    unsigned int numThreads_; /// The number of threads used to unpack the spills.
+    std::vector<std::thread> pipelineThreads_; /// The decoder, builder and processing threads.
+    std::vector<PendingSpill *> pipelineSpills_; /// Every spill object used by the pipeline.
+    BoundedQueue<PendingSpill *> freeSpills_; /// Spill objects that may be filled by ReadSpill.
+    BoundedQueue<PendingSpill *> decodeQueue_; /// Spills waiting to be decoded.
+    BoundedQueue<std::pair<PendingSpill *, unsigned int> > moduleQueue_; /// Module buffers waiting to be decoded.
+    BoundedQueue<PendingSpill *> buildQueue_; /// Decoded spills waiting for the event builder.
+    BoundedQueue<PendingSpill *> processQueue_; /// Built spills waiting to be processed.
+    std::mutex pipelineMutex_; /// Protects the count of spills in the pipeline and the decoding signal.
+    std::condition_variable pipelineIdle_; /// Signalled when a spill leaves the pipeline.
+    std::condition_variable spillDecoded_; /// Signalled when the last module buffer of a spill is decoded.
+    unsigned int spillsInPipeline_; /// The number of spills that have been queued but not processed.
+
+    unsigned long long windowTicks_; /// The event width in whole clock ticks used while building.
+    unsigned long long buildHorizon_; /// Raw events starting at or after this time are left for the next spill.
+    unsigned long long moduleLastTime_[MAX_PIXIE_MOD + 1]; /// The latest hit time of each module in this spill, the maximum if none.
+    double buildTime_; /// Wall time in seconds spent sorting and building raw events.
+    unsigned long numSortedStreams_; /// The number of streams that were out of order.
+
+    unsigned long long firstTime; /// The first recorded event time.
+    unsigned long long eventStartTime; /// The start time of the current raw event.
+    unsigned long long realStartTime; /// The time of the first xia event in the raw event.
+    unsigned long long realStopTime; /// The time of the last xia event in the raw event.
+
+    /** Scan the event list and sort any stream that is not already ordered by timestamp.
       * \return Nothing.
       */
     void TimeSort();
 
+    /** Sort the spill and build the raw events using the selected algorithm.
+      * Hits after the build horizon are kept in the event list when carrying
+      * over, otherwise the event list is emptied.
+      * \param[in]  flush    True to build every hit regardless of the horizon.
+      * \param[out] batch    The batch receiving the raw events.
+      * \param[in]  dispatch True to process every raw event as soon as it is built.
+      * \return Nothing.
+      */
+    void BuildEvents(const bool &flush, RawEventBatch &batch, const bool &dispatch);
+
+    /** Make a built raw event the current raw event and process it.
+      * \param[in]  batch The batch holding the raw event.
+      * \param[in]  event The raw event to process.
+      * \return Nothing.
+      */
+    void DispatchRawEvent(const RawEventBatch &batch, const BuiltEvent &event);
+
+    /** Locate the module buffers in a spill and perform the sanity checks on it.
+      * \param[in,out] spill The spill to check.
+      * \return True if the spill passed the checks and false otherwise.
+      */
+    bool LocateModuleBuffers(PendingSpill &spill);
+
+    /** Decode one of the module buffers located in a spill.
+      * \param[in,out] spill  The spill holding the module buffer.
+      * \param[in]     module The index of the module buffer in the spill.
+      * \return Nothing.
+      */
+    void DecodeModuleBuffer(PendingSpill &spill, const unsigned int &module);
+
+    /** Add the decoded hits of a spill to the event list and build them.
+      * \param[in,out] spill    The decoded spill.
+      * \param[in]     dispatch True to process every raw event as soon as it is built.
+      * \return True if the spill was built and false if it was thrown away.
+      */
+    bool BuildSpill(PendingSpill &spill, const bool &dispatch);
+
+    /** Copy a spill into the pipeline, waiting for a free spill object.
+      * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
+      * \param[in]  nWords     The number of words in the array.
+      * \param[in]  is_verbose Toggle the verbosity flag on/off.
+      * \return True. The spill is only checked once the decoder thread gets to it.
+      */
+    bool QueueSpill(unsigned int *data, const unsigned int &nWords, const bool &is_verbose);
+
+    /// Start the pipeline threads if they are not running yet.
+    void StartPipeline();
+
+    /// Wait until every queued spill has been processed.
+    void WaitForPipeline();
+
+    /// Thread that locates the module buffers of the queued spills and decodes them.
+    void DecodeSpills();
+
+    /// Thread that helps decoding the module buffers of a spill.
+    void DecodeModules();
+
+    /// Thread that builds the raw events of the decoded spills.
+    void BuildSpills();
+
+    /// Thread that processes the raw events of the built spills.
+    void ProcessSpills();
+
+    /** Compute the time after which raw events may still receive hits from
+      * the next spill and reset the module times for the next spill.
+      * \return The build horizon in system clock ticks.
+      */
+    unsigned long long GetBuildHorizon();
+
     /** Scan the time sorted event list and package the events into a raw
       * event with a size governed by the event width.
+      * \param[out] batch The batch receiving the raw event.
       * \return True if the event list is not empty and false otherwise.
       */
-    bool BuildRawEvent();
+    bool BuildRawEvent(RawEventBatch &batch);
+
+    /** Fill the merge heap with the front of every time sorted stream.
+      * \return Nothing.
+      */
+    void InitializeMerge();
+
+    /** Restore the ordering of the merge heap after its top entry was replaced.
+      * \return Nothing.
+      */
+    void SiftDownMerge();
+
+    /** Pull the hits from the merge heap in time order and package them into
+      * a raw event with a size governed by the event width.
+      * \param[out] batch The batch receiving the raw event.
+      * \return True if the event list is not empty and false otherwise.
+      */
+    bool MergeRawEvent(RawEventBatch &batch);
+
+    /** Get the index of the stream in the event list that holds an event.
+      * \param[in]  event_ The XiaData to locate.
+      * \return The module number for the linear scan and the channel index for the merge.
+      */
+    unsigned int GetStreamIndex(XiaData *event_);
 
     /** Push an event into the event list.
       * \param[in]  event_ The XiaData to push onto the back of the event list.
@@ -161,6 +442,12 @@ private:
       */
     bool AddEvent(XiaData *event_);
 
+    /** Free all of the events in a deque and empty it.
+      * \param[in]  list The deque to clear.
+      * \return Nothing.
+      */
+    void ClearDeque(std::deque<XiaData *> &list);
+
     /** Clear all events in the spill event list. WARNING! This method will delete all events in the
       * event list. This could cause seg faults if the events are used elsewhere.
       * \return Nothing.
@@ -177,7 +464,7 @@ private:
       * \param[out] time The minimum time from the event list in system clock ticks.
       * \return True if the event list is not empty and false otherwise.
       */
-    bool GetFirstTime(double &time);
+    bool GetFirstTime(unsigned long long &time);
 
     /** Check whether or not the eventList is empty.
       * \return True if the eventList is empty, and false otherwise.
@@ -6,6 +6,10 @@
 
 #include <vector>
 
+#include <cstddef>
+
+#include "XiaTimestamp.hpp"
+
 /*! \brief A pixie16 channel event
  *
  * All data is grouped together into channels.  For each pixie16 channel that
@@ -27,7 +31,7 @@ public:
     /// channel (i.e. the ID and Time are identical)
     ///@param[in] rhs : The right hand side of the comparison
     ///@return True if the two XiaData classes are equal.
-    bool operator==(const XiaData &rhs) const { return GetId() == rhs.GetId() && GetTime() == rhs.GetTime(); }
+    bool operator==(const XiaData &rhs) const { return GetId() == rhs.GetId() && time_ == rhs.time_; }
 
     ///@brief The conjugate of the equality operator
     ///@param[in] rhs : The right hand side for the comparison
@@ -38,7 +42,7 @@ public:
     /// class is less than the time of the comparison class.
     ///@param[in] rhs : The right hand side for the comparison
     ///@return True if this instance arrived earlier than the right hand side.
-    bool operator<(const XiaData &rhs) const { return GetTime() < rhs.GetTime(); }
+    bool operator<(const XiaData &rhs) const { return time_ < rhs.time_; }
 
     ///@brief The conjugate of the less than operator
     ///@param[in] rhs : The right hand side for the comparison
@@ -52,7 +56,7 @@ public:
     ///@param[in] rhs : A pointer to the right hand side of the comparison
     ///@return True if the time of arrival for right hand side is later than
     /// that of the left hand side.
-    static bool CompareTime(const XiaData *lhs, const XiaData *rhs) { return lhs->GetTime() < rhs->GetTime(); }
+    static bool CompareTime(const XiaData *lhs, const XiaData *rhs) { return lhs->time_ < rhs->time_; }
 
     ///@brief A method that will compare the unique ID of two XiaData classes
     ///@param[in] lhs : A pointer to the left hand side of the comparison
@@ -86,12 +90,21 @@ public:
     double GetEnergy() const { return energy_; }
 
     ///@return The time for the channel including all of the CFD information
-    /// when available.
-    double GetTime() const { return time_; }
+    /// when available. This converts the timestamp to a double, the
+    /// ordering of channels should use GetTimestamp.
+    double GetTime() const { return time_.ToDouble(); }
 
     ///@return The arrival time of the signal without any CFD information in
     /// the calculation
-    double GetTimeSansCfd() const { return timeSansCfd_; }
+    double GetTimeSansCfd() const { return (double) ticksSansCfd_; }
+
+    ///@return The time for the channel including all of the CFD information
+    /// when available as whole ADC ticks and a fraction of a tick.
+    const XiaTimestamp &GetTimestamp() const { return time_; }
+
+    ///@return The arrival time of the signal without any CFD information in
+    /// whole filter clock ticks
+    unsigned long long GetTicksSansCfd() const { return ticksSansCfd_; }
 
     ///@return The CFD fractional time in clockticks
     unsigned int GetCfdFractionalTime() const { return cfdTime_; }
@@ -138,8 +151,30 @@ public:
     ///@return the QDC recorded on the module
     std::vector<unsigned int> GetQdc() const { return qdc_; }
 
-    ///@return The trace that was sampled on the module
-    std::vector<unsigned int> GetTrace() const { return trace_; }
+    ///@return The trace that was sampled on the module. If the trace is only
+    /// held as a view into the spill buffer then a copy of the samples is made.
+    std::vector<unsigned int> GetTrace() const {
+        if (!traceView_)
+            return trace_;
+        std::vector<unsigned int> trace;
+        UnpackTrace(traceView_, traceViewLength_, trace);
+        return trace;
+    }
+
+    ///@return The trace owned by this object without making a copy. This is
+    /// empty if the trace is held as a view into the spill buffer.
+    const std::vector<unsigned int> &GetOwnedTrace() const { return trace_; }
+
+    ///@return The number of samples in the trace regardless of how it's stored.
+    unsigned int GetTraceLength() const { return traceView_ ? traceViewLength_ : (unsigned int) trace_.size(); }
+
+    ///@return A pointer to the packed trace words in the spill buffer, or
+    /// NULL if the trace is owned by this object. The pointer is only valid
+    /// as long as the buffer that the data was decoded from.
+    const unsigned int *GetTraceView() const { return traceView_; }
+
+    ///@return True if the trace is a non-owning view into the spill buffer.
+    bool HasTraceView() const { return traceView_ != NULL; }
 
     ///@brief Sets the baseline recorded on the module if the energy sums
     /// were recorded in the data stream
@@ -203,6 +238,12 @@ public:
     ///@param[in] a : The value to set
     void SetQdc(const std::vector<unsigned int> &a) { qdc_ = a; }
 
+    ///@brief Sets the QDCs from a range of words in the data buffer. This
+    /// reuses the existing storage so that recycled objects do not allocate.
+    ///@param[in] begin : Pointer to the first QDC word
+    ///@param[in] end : Pointer to one past the last QDC word
+    void SetQdc(const unsigned int *begin, const unsigned int *end) { qdc_.assign(begin, end); }
+
     ///@brief Sets the saturation flag
     ///@param[in] a : True if we found a saturation on board
     void SetSaturation(const bool &a) { isSaturated_ = a; }
@@ -213,21 +254,80 @@ public:
 
     ///@brief Sets the calculated arrival time of the signal
     ///@param[in] a : The value to set
-    void SetTime(const double &a) { time_ = a; }
+    void SetTime(const double &a) { time_ = XiaTimestamp::FromDouble(a); }
 
     ///@brief Sets the calculated arrival time of the signal sans the CFD
-    /// fractional time components.
+    /// fractional time components. The time is truncated to whole ticks.
+    ///@param[in] a : The value to set
+    void SetTimeSansCfd(const double &a) { ticksSansCfd_ = a > 0 ? (unsigned long long) a : 0; }
+
+    ///@brief Sets the calculated arrival time of the signal
     ///@param[in] a : The value to set
-    void SetTimeSansCfd(const double &a) { timeSansCfd_ = a; }
+    void SetTimestamp(const XiaTimestamp &a) { time_ = a; }
+
+    ///@brief Sets the arrival time of the signal sans the CFD fractional
+    /// time components in whole filter clock ticks.
+    ///@param[in] a : The value to set
+    void SetTicksSansCfd(const unsigned long long &a) { ticksSansCfd_ = a; }
 
     ///@brief Sets the trace recorded on board
     ///@param[in] a : The value to set
-    void SetTrace(const std::vector<unsigned int> &a) { trace_ = a; }
+    void SetTrace(const std::vector<unsigned int> &a) {
+        trace_ = a;
+        ClearTraceView();
+    }
+
+    ///@brief Sets the trace as a non-owning view of the packed trace words in
+    /// the spill buffer. No copy of the samples is made, the caller guarantees
+    /// that the buffer outlives this object or that DetachTrace is called
+    /// before the buffer is reused.
+    ///@param[in] a : Pointer to the first word of the trace
+    ///@param[in] len : The number of samples in the trace
+    void SetTraceView(const unsigned int *a, const unsigned int &len) {
+        trace_.clear();
+        traceView_ = a;
+        traceViewLength_ = len;
+    }
+
+    ///@brief Drops the trace view without copying the samples.
+    void ClearTraceView() {
+        traceView_ = NULL;
+        traceViewLength_ = 0;
+    }
+
+    ///@brief Copies the samples of a trace view into storage owned by this
+    /// object. Needed when the object has to outlive the spill buffer.
+    void DetachTrace() {
+        if (!traceView_)
+            return;
+        UnpackTrace(traceView_, traceViewLength_, trace_);
+        ClearTraceView();
+    }
+
+    ///@brief Unpacks the 16-bit trace samples of list mode data. Every word
+    /// holds two samples, the earlier one in the low 16 bits. The samples are
+    /// taken out with shifts so that the result does not depend on the byte
+    /// order of the host.
+    ///@param[in] words : The packed trace words
+    ///@param[in] len : The number of samples
+    ///@param[out] trace : The samples
+    static void UnpackTrace(const unsigned int *words, const unsigned int &len, std::vector<unsigned int> &trace) {
+        trace.resize(len);
+        for (unsigned int k = 0; k < len; k++)
+            trace[k] = (words[k / 2] >> (16 * (k % 2))) & 0xFFFF;
+    }
 
     ///@brief Sets the flag for channels generated on-board
     ///@param[in] a : True if we this channel was generated on-board
     void SetVirtualChannel(const bool &a) { isVirtualChannel_ = a; }
 
+    ///@brief Copies everything but the trace from another object. The
+    /// vectors reuse the storage of this object and the trace is left empty,
+    /// so that a recycled object can take over the samples in whatever form
+    /// it needs them.
+    ///@param[in] rhs : The object to copy from
+    void AssignSansTrace(const XiaData &rhs);
+
     ///@brief Clear all variables and set them to some default values.
     void Clear();
 
@@ -240,9 +340,9 @@ private:
 
     double energy_; /// Raw pixie energy.
     double baseline_;///Baseline that was recorded with the energy sums
-    double time_; ///< The time of arrival using all parts of the time
+    XiaTimestamp time_; ///< The time of arrival using all parts of the time
     unsigned long long externalTimeStamp_; ///< The time of arrival using all parts of the time
-    double timeSansCfd_; ///< The time of arrival of the signal sans CFD time.
+    unsigned long long ticksSansCfd_; ///< The time of arrival of the signal sans CFD time.
 
     unsigned int cfdTime_; /// CFD trigger time
     unsigned int chanNum_; /// Channel number.
@@ -256,6 +356,9 @@ private:
     std::vector<unsigned int> eSums_;///Energy sums recorded by the module
     std::vector<unsigned int> qdc_; ///QDCs recorded by the module
     std::vector<unsigned int> trace_; /// ADC trace capture.
+
+    const unsigned int *traceView_; /// Non-owning view of the packed trace words in the spill buffer.
+    unsigned int traceViewLength_; /// Number of samples in the trace view.
 };
 
 #endif
@@ -0,0 +1,64 @@
+///@file XiaDataPool.hpp
+///@brief A recycling pool of XiaData objects used to decode spills without
+/// going through the allocator for every hit.
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIADATAPOOL_HPP
+#define PIXIESUITE_XIADATAPOOL_HPP
+
+#include <mutex>
+#include <vector>
+
+class XiaData;
+
+///A pool that owns all of the XiaData objects handed out by it. Objects that
+/// are released go back on a free list and are handed out again by the next
+/// call to Acquire. Since XiaData::Clear keeps the capacity of its vectors a
+/// pool that has reached its high water mark decodes a spill without any heap
+/// allocations.
+class XiaDataPool {
+public:
+    ///Default constructor
+    XiaDataPool() : threadSafe_(false) {}
+
+    ///Destructor that frees every object that the pool has ever created.
+    ~XiaDataPool();
+
+    ///@return A cleared XiaData object. A new object is only created if the
+    /// free list is empty.
+    XiaData *Acquire();
+
+    ///Returns an object to the pool so that it can be recycled. The object
+    /// must have been obtained from this pool.
+    ///@param[in] data : The object to recycle
+    void Release(XiaData *data);
+
+    ///Makes sure that the pool holds at least the requested number of
+    /// objects.
+    ///@param[in] size : The number of objects to preallocate.
+    void Reserve(const unsigned int &size);
+
+    ///Toggles locking of the pool so that objects can be acquired and
+    /// released from several threads at once.
+    ///@param[in] state : True if the pool is shared between threads
+    void SetThreadSafe(const bool &state = true) { threadSafe_ = state; }
+
+    ///@return The number of objects currently handed out by the pool.
+    unsigned int GetNumberInUse() const { return (unsigned int) (storage_.size() - free_.size()); }
+
+    ///@return The total number of objects that the pool has created.
+    unsigned int GetCapacity() const { return (unsigned int) storage_.size(); }
+
+private:
+    XiaDataPool(const XiaDataPool &); ///< Pools cannot be copied
+    XiaDataPool &operator=(const XiaDataPool &); ///< Pools cannot be assigned
+
+    std::vector<XiaData *> storage_; ///< Every object created by the pool
+    std::vector<XiaData *> free_; ///< The objects ready to be handed out
+    bool threadSafe_; ///< True if Acquire and Release need to lock the pool
+    std::mutex mutex_; ///< Protects the free list when the pool is shared
+
+    ///@return A cleared XiaData object without locking the pool.
+    XiaData *AcquireUnlocked();
+};
+
+#endif //PIXIESUITE_XIADATAPOOL_HPP
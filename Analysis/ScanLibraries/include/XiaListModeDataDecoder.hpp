@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "XiaData.hpp"
+#include "XiaDataPool.hpp"
 #include "XiaListModeDataMask.hpp"
 
 ///Class to decode Xia List mode Data
@@ -27,6 +28,18 @@ public:
     std::vector<XiaData *> DecodeBuffer(unsigned int *buf,
                                         const XiaListModeDataMask &mask);
 
+    ///Decoding method that does not allocate once the pool and the output
+    /// vector have grown to the size of a spill. The XiaData objects are taken
+    /// from the pool and the traces are stored as views into the buffer, so
+    /// the buffer must outlive the decoded events.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] mask : The mask set that we need to decode the data
+    ///@param[in] pool : The pool that provides the XiaData objects.
+    ///@param[out] events : The vector that the decoded events are appended to.
+    ///@return The number of events that were appended to the vector.
+    unsigned int DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask,
+                              XiaDataPool &pool, std::vector<XiaData *> &events);
+
     ///Method to calculate the arrival time of the signal in samples
     ///@param[in] mask : The data mask containing the necessary information
     /// to calculate the time.
@@ -38,6 +51,18 @@ public:
     static std::pair<double, double> CalculateTimeInSamples(
             const XiaListModeDataMask &mask, const XiaData &data);
 
+    ///Method to calculate the arrival time of the signal with integer
+    /// arithmetic. This is what the decoder stores in the XiaData.
+    ///@param[in] mask : The data mask containing the necessary information
+    /// to calculate the time.
+    ///@param[in] data : The data that we will use to calculate the time
+    ///@return A pair where the first element is the time in filter clock
+    /// ticks calculated just using the trapezoidal filter (no CFD) and the
+    /// second element is the time in ADC clock ticks including all of the
+    /// available CFD information.
+    static std::pair<unsigned long long, XiaTimestamp> CalculateTimestamp(
+            const XiaListModeDataMask &mask, const XiaData &data);
+
     ///Method to calculate the arrival time of the signal in nanoseconds
     ///@param[in] mask : The data mask containing the necessary information
     /// to calculate the time.
@@ -55,6 +80,30 @@ public:
     unsigned long long CalculateExternalTimeStamp(const XiaData &data);
 
     private:
+    ///Decodes all of the events in a module buffer.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] mask : The mask set that we need to decode the data
+    ///@param[in] pool : The pool providing the objects, NULL if we should
+    /// allocate the objects and copy the traces.
+    ///@param[out] events : The vector that the decoded events are appended to.
+    ///@return The number of events that were appended to the vector.
+    unsigned int DecodeModuleBuffer(unsigned int *buf, const XiaListModeDataMask &mask,
+                                    XiaDataPool *pool, std::vector<XiaData *> &events);
+
+    ///Decodes a single event from the buffer.
+    ///@param[in] buf : Pointer to the first word of the event.
+    ///@param[in] data : The XiaData object that we are going to fill.
+    ///@param[out] isStatsBlock : True if the event was a statistics block
+    /// inserted by poll instead of a channel event.
+    ///@param[in] mask : The data mask to decode the data
+    ///@param[in] useTraceView : True if the trace should be left in the buffer.
+    ///@param[in] modNum : The module number for error messages.
+    ///@param[in] bufLen : The buffer length for error messages.
+    ///@return The number of words in the event, or zero if it was corrupt.
+    unsigned int DecodeEvent(unsigned int *buf, XiaData &data, bool &isStatsBlock,
+                             const XiaListModeDataMask &mask, const bool &useTraceView,
+                             const unsigned int &modNum, const unsigned int &bufLen);
+
     ///Method to decode word zero from the header.
     ///@param[in] word : The word that we need to decode
     ///@param[in] data : The XiaData object that we are going to fill.
@@ -0,0 +1,93 @@
+///@file XiaTimestamp.hpp
+///@brief A fixed point time of arrival made of whole clock ticks and the CFD
+/// fraction of a tick.
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIATIMESTAMP_HPP
+#define PIXIESUITE_XIATIMESTAMP_HPP
+
+///A time of arrival kept as whole ADC clock ticks plus a fraction of a tick in
+/// units of 1 / FRACTION_SCALE. The CFD sizes of every Pixie-16 revision are
+/// powers of two no larger than FRACTION_SCALE, so the CFD fraction is stored
+/// exactly. Sorting, merging and event building compare integers and keep
+/// their precision at any time in the run, a double only holds the CFD
+/// fraction until the time reaches roughly 2^37 ticks. The conversion to
+/// double is left to the code that plots or fits the time.
+class XiaTimestamp {
+public:
+    static const unsigned int FRACTION_BITS = 16; ///< The bits of the fraction of a tick
+    static const unsigned int FRACTION_SCALE = 1u << FRACTION_BITS; ///< The number of fractions in a tick
+
+    ///Default constructor that sets the time to zero
+    XiaTimestamp() : ticks_(0), fraction_(0) {}
+
+    ///Constructor taking whole ticks and a fraction of a tick. A fraction of
+    /// a full tick or more is carried into the ticks.
+    ///@param[in] ticks : The whole clock ticks
+    ///@param[in] fraction : The fraction of a tick in units of 1 / FRACTION_SCALE
+    explicit XiaTimestamp(const unsigned long long &ticks, const unsigned int &fraction = 0) :
+            ticks_(ticks + (fraction >> FRACTION_BITS)), fraction_(fraction & (FRACTION_SCALE - 1)) {}
+
+    ///@brief Converts a time in clock ticks to a timestamp. The fraction is
+    /// truncated to 1 / FRACTION_SCALE and negative times are set to zero.
+    ///@param[in] time : The time in clock ticks
+    ///@return The timestamp closest to the time but not later than it
+    static XiaTimestamp FromDouble(const double &time) {
+        if (time <= 0)
+            return XiaTimestamp();
+        unsigned long long ticks = (unsigned long long) time;
+        return XiaTimestamp(ticks, (unsigned int) ((time - ticks) * FRACTION_SCALE));
+    }
+
+    ///@return The whole clock ticks
+    unsigned long long GetTicks() const { return ticks_; }
+
+    ///@return The fraction of a tick in units of 1 / FRACTION_SCALE
+    unsigned int GetFraction() const { return fraction_; }
+
+    ///@return The time in clock ticks as a double, which rounds the fraction
+    /// away once the ticks are large.
+    double ToDouble() const { return ticks_ + fraction_ / (double) FRACTION_SCALE; }
+
+    ///@brief Moves the time by a signed number of fractions of a tick. A time
+    /// that would become negative is set to zero.
+    ///@param[in] fractions : The shift in units of 1 / FRACTION_SCALE
+    ///@return A reference to this timestamp
+    XiaTimestamp &Shift(const long long &fractions) {
+        long long total = (long long) fraction_ + fractions;
+        long long ticks = total >> FRACTION_BITS; // Floors for negative totals as well.
+        if (ticks < 0 && (unsigned long long) -ticks > ticks_) {
+            ticks_ = 0;
+            fraction_ = 0;
+            return *this;
+        }
+        ticks_ += ticks;
+        fraction_ = (unsigned int) (total & (FRACTION_SCALE - 1));
+        return *this;
+    }
+
+    ///@return True if both timestamps are the same
+    bool operator==(const XiaTimestamp &rhs) const { return ticks_ == rhs.ticks_ && fraction_ == rhs.fraction_; }
+
+    ///@return True if the timestamps differ
+    bool operator!=(const XiaTimestamp &rhs) const { return !operator==(rhs); }
+
+    ///@return True if this timestamp is earlier than the right hand side
+    bool operator<(const XiaTimestamp &rhs) const {
+        return ticks_ < rhs.ticks_ || (ticks_ == rhs.ticks_ && fraction_ < rhs.fraction_);
+    }
+
+    ///@return True if this timestamp is later than the right hand side
+    bool operator>(const XiaTimestamp &rhs) const { return rhs.operator<(*this); }
+
+    ///@return True if this timestamp is not later than the right hand side
+    bool operator<=(const XiaTimestamp &rhs) const { return !rhs.operator<(*this); }
+
+    ///@return True if this timestamp is not earlier than the right hand side
+    bool operator>=(const XiaTimestamp &rhs) const { return !operator<(rhs); }
+
+private:
+    unsigned long long ticks_; ///< The whole clock ticks
+    unsigned int fraction_; ///< The fraction of a tick in units of 1 / FRACTION_SCALE
+};
+
+#endif //PIXIESUITE_XIATIMESTAMP_HPP
@@ -12,6 +12,7 @@
  */
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <thread>
 
@@ -22,6 +23,8 @@
 
 #include "Unpacker.hpp"
 #include "poll2_socket.h"
+#include "poll2_shm_ring.h"
+#include "poll2_stream.h"
 #include "CTerminal.h"
 
 #include "ScanInterface.hpp"
@@ -120,9 +123,9 @@ void fileInformation::clear() {
 void ScanInterface::start_scan() {
     if (!(file_open || shm_mode))
         cout << " No input file loaded.\n";
-    else if (!input_file.good())
+    else if (mapped_file.is_open() ? !mapped_file.good() : !input_file.good())
         cout << " Error reading from input file!\n";
-    else if (input_file.eof())
+    else if (mapped_file.is_open() ? mapped_file.eof() : input_file.eof())
         cout << " Physical end-of-file reached.\n";
     else if (is_running)
         cout << " Already running.\n";
@@ -196,7 +199,19 @@ bool ScanInterface::rewind(const unsigned long &offset_/*=0*/) {
     // Move to the first word in the file.
     cout << " Seeking to word no. " << offset_ << " in file\n";
     input_file.seekg(offset_ * 4, input_file.beg);
-    cout << " Input file is now at " << input_file.tellg() << " bytes\n";
+    if (mapped_file.is_open())
+        mapped_file.seekg(offset_ * 4);
+    cout << " Input file is now at " << input_position() << " bytes\n";
+
+    // Hits carried over from before the seek do not belong with the new data.
+    if (unpacker_)
+        unpacker_->Reset();
+
+    // The spills are counted from here and can no longer be indexed.
+    building_index = false;
+    reset_reader = true;
+    current_spill = 0;
+    skip_before = 0;
 
     // Notify that the user has rewound to the start of the file.
     Notify("REWIND_FILE");
@@ -204,6 +219,93 @@ bool ScanInterface::rewind(const unsigned long &offset_/*=0*/) {
     return true;
 }
 
+/** Move to the start of a spill using the spill index. A .ldf file can only
+  * be read from the start of a buffer, so the reader is moved to the buffer
+  * where the spill begins and skips whatever comes before the spill.
+  * \param[in]  spill_ The number of the spill, starting from zero.
+  * \return True upon success and false otherwise.
+  */
+bool ScanInterface::seek_spill(const unsigned long &spill_) {
+    if (!file_open || (file_format != 0 && file_format != 1)) {
+        cout << " A spill index is only available for ldf and pld input files.\n";
+        return false;
+    } else if (!index_ready) {
+        cout << " No spill index has been loaded for this file. Scan the whole file once to build one.\n";
+        return false;
+    } else if (spill_ >= spill_index.GetNumSpills()) {
+        cout << " Cannot move to spill " << spill_ << ", the file only holds " << spill_index.GetNumSpills()
+             << " spills!\n";
+        return false;
+    }
+
+    unsigned long long offset = spill_index.GetSpill(spill_).offset;
+    unsigned long long start = offset;
+    if (file_format == 0)
+        start -= offset % (ACTUAL_BUFF_SIZE * 4);
+
+    input_file.clear();
+    input_file.seekg(start, input_file.beg);
+    if (mapped_file.is_open())
+        mapped_file.seekg(start);
+
+    building_index = false;
+    reset_reader = true;
+    current_spill = spill_;
+    skip_before = offset;
+
+    cout << " Moved to spill " << spill_ << " at byte " << offset << " of the input file\n";
+
+    // Hits carried over from the previous position do not belong with the target spill.
+    if (unpacker_)
+        unpacker_->Reset();
+
+    // Notify that the user has moved to another position in the file.
+    Notify("REWIND_FILE");
+
+    return true;
+}
+
+/** Count a spill read from the input file. While the spill index is being
+  * built the spill is added to it, together with its times if it is good.
+  * \param[in]  offset_ The position of the spill in the file (in bytes).
+  * \param[in]  spill_  Pointer to the spill, or NULL if it was not read.
+  * \param[in]  nWords_ The number of words in the spill.
+  * \param[in]  good_   False if the spill is a fragment or is corrupt.
+  * \return Nothing.
+  */
+void ScanInterface::count_spill(const unsigned long long &offset_, unsigned int *spill_, const unsigned int &nWords_,
+                                const bool &good_) {
+    if (building_index) {
+        SpillIndexEntry entry;
+        entry.offset = offset_;
+        entry.nWords = nWords_;
+        entry.moduleMask = 0;
+        entry.firstTime = entry.lastTime = 0;
+        entry.good = good_;
+        if (good_ && spill_)
+            SpillIndex::Summarize(spill_, nWords_, module_masks, entry);
+        spill_index.Add(entry);
+    }
+    current_spill++;
+}
+
+/** Write the spill index beside the input file once the whole file has been
+  * scanned. A failure to write it only costs the next scan the chance to seek.
+  * \return Nothing.
+  */
+void ScanInterface::write_spill_index() {
+    if (!building_index)
+        return;
+    building_index = false;
+
+    if (spill_index.Write(index_filename)) {
+        index_ready = true;
+        cout << msgHeader << "Wrote the index of " << spill_index.GetNumSpills() << " spills to "
+             << index_filename << ".\n";
+    } else
+        cout << msgHeader << "WARNING! Failed to write the spill index to " << index_filename << ".\n";
+}
+
 /** Open a new binary input file for reading.
   * \param[in]  fname_ Input filename to open for reading.
   * \return True upon successfully opening the file and false otherwise.
@@ -242,6 +344,7 @@ bool ScanInterface::open_input_file(const string &fname_) {
     if (file_open) {
         cout << " Note: Closing previously opened file.\n";
         input_file.close();
+        mapped_file.close();
     }
 
     file_open = true;
@@ -301,6 +404,35 @@ bool ScanInterface::open_input_file(const string &fname_) {
         } else if (file_format == 3) {
             // just skip "header" information for now...
         }
+
+        // Use the spill index beside the file if it matches the file, otherwise
+        // build one while the file is scanned.
+        if (file_format == 0 || file_format == 1) {
+            index_filename = SpillIndex::GetIndexFilename(fname_);
+            index_ready = spill_index.Read(index_filename) &&
+                          spill_index.GetFileLength() == (unsigned long long) file_length;
+            if (index_ready) {
+                cout << " Loaded the index of " << spill_index.GetNumSpills() << " spills from " << index_filename
+                     << "\n";
+            } else {
+                spill_index.Clear();
+                spill_index.SetFileLength(file_length);
+            }
+            building_index = !index_ready && !dry_run_mode;
+            if (building_index)
+                module_masks = unpacker_->GetDataMasks();
+        }
+        reset_reader = true;
+        current_spill = 0;
+        skip_before = 0;
+
+        // Map the file and pick up the spills where the header left off.
+        if (mmap_mode && (file_format == 0 || file_format == 1)) {
+            if (mapped_file.open(fname_.c_str()))
+                mapped_file.seekg(input_file.tellg());
+            else
+                cout << " WARNING! Failed to map input file into memory, reading it as a stream instead.\n";
+        }
     }
 
     // Notify that the user has loaded a new file.
@@ -309,6 +441,16 @@ bool ScanInterface::open_input_file(const string &fname_) {
     return true;
 }
 
+/** Return the current position in the input file. In mmap mode this is the
+  * position in the mapping, since the stream is only used to read the header.
+  * \return The position with respect to the start of the file (in bytes).
+  */
+streampos ScanInterface::input_position() {
+    if (mapped_file.is_open())
+        return mapped_file.tellg();
+    return input_file.tellg();
+}
+
 /** Add a command line option to the option list.
   * \param[in]  opt_ The option to add to the list.
   * \return Nothing.
@@ -379,6 +521,9 @@ ScanInterface::ScanInterface() {
     file_format = -1;
 
     file_start_offset = 0;
+    first_spill = 0;
+    last_spill = numeric_limits<unsigned long>::max();
+    current_spill = 0;
     num_spills_recvd = 0;
 
     total_stopped = true;
@@ -388,9 +533,18 @@ ScanInterface::ScanInterface() {
     debug_mode = false;
     dry_run_mode = false;
     shm_mode = false;
+    stream_mode = false;
+    ring_mode = false;
     batch_mode = false;
     scan_init = false;
     file_open = false;
+    mmap_mode = false;
+
+    index_ready = false;
+    building_index = false;
+    reset_reader = true;
+    reader_start = 0;
+    skip_before = 0;
 
     //Initialize the setup and output file names and path
     outputFilename_ = "";
@@ -401,11 +555,17 @@ ScanInterface::ScanInterface() {
     run_ctrl_exit = false;
 
     poll_server = NULL;
+    spill_stream = NULL;
+    stream_address = POLL2_STREAM_DEFAULT_ADDRESS;
+    spill_ring = NULL;
+    ring_name = POLL2_SHM_RING_DEFAULT_NAME;
     term = NULL;
 
     //Setup all the arguments that are known to the program.
     baseOpts = {
             optionExt("batch", no_argument, NULL, 'b', "", "Run in batch mode (i.e. with no command line)"),
+            optionExt("builder", required_argument, NULL, 0, "<linear|merge>",
+                      "Select the raw event builder (default=linear)"),
             optionExt("config", required_argument, NULL, 'c', "<path>", "Specify path to setup to use for scan"),
             optionExt("counts", no_argument, NULL, 0, "", "Write all recorded channel counts to a file"),
             optionExt("debug", no_argument, NULL, 0, "", "Enable readout debug mode"),
@@ -418,10 +578,22 @@ ScanInterface::ScanInterface() {
                       "Specifies the sampling frequency used to collect the data."),
             optionExt("help", no_argument, NULL, 'h', "", "Display this dialogue"),
             optionExt("input", required_argument, NULL, 'i', "<filename>", "Specifies the input file to analyze"),
+            optionExt("mmap", no_argument, NULL, 0, "",
+                      "Read .ldf and .pld input files through a memory mapping instead of a stream"),
             optionExt("output", required_argument, NULL, 'o', "<filename>",
                       "Specifies the name of the output file. Default is \"out\""),
             optionExt("quiet", no_argument, NULL, 'q', "", "Toggle off verbosity flag"),
+            optionExt("ring", optional_argument, NULL, 0, "[name]",
+                      "Read spills from the poll2 shared-memory ring (default=" POLL2_SHM_RING_DEFAULT_NAME ")"),
             optionExt("shm", no_argument, NULL, 's', "", "Enable shared memory readout"),
+            optionExt("spills", required_argument, NULL, 0, "<first>:<last>",
+                      "Only scan this range of spills of the input file, using its spill index"),
+            optionExt("stream", optional_argument, NULL, 0, "[address]",
+                      "Read spills from the poll2 spill stream (default=" POLL2_STREAM_DEFAULT_ADDRESS ")"),
+            optionExt("split-spills", no_argument, NULL, 0, "",
+                      "Build raw events within each spill instead of carrying the end of a spill into the next one"),
+            optionExt("threads", required_argument, NULL, 0, "<N>",
+                      "Unpack the spills in a pipeline of N threads, at least three when N > 1 (default=1)"),
             optionExt("version", no_argument, NULL, 'v', "", "Display version information")
     };
 
@@ -436,6 +608,9 @@ ScanInterface::ScanInterface() {
     knownArgumentMap_.insert(make_pair("rewind", "Usage : rewind [offset] | Rewind to the beginning of the file or to the "
             "requested number of words"));
     knownArgumentMap_.insert(make_pair("sync", "Wait for the current run to finish"));
+    knownArgumentMap_.insert(make_pair("spill", "Usage : spill <number> | Move to a spill of the file using its spill index"));
+    knownArgumentMap_.insert(make_pair("time", "Usage : time <clock ticks> | Move to the first spill of the file with "
+            "events at or after a time using its spill index"));
 
     optstr = "bc:f:hi:o:qsv";
 
@@ -472,6 +647,57 @@ void ScanInterface::RunControl() {
             IdleTask();
             usleep(1);
             continue;
+        } else if (stream_mode || ring_mode) {
+            cout << endl;
+            // The spill grows to fit the largest spill that poll2 sends, so we only allocate for the first few.
+            vector<unsigned int> spill;
+            unsigned long lastMissed = 0;
+
+            while (true) {
+                if (kill_all == true) {
+                    break;
+                } else if (!is_running) {
+                    IdleTask();
+                    usleep(100000); //0.1 seconds
+                    continue;
+                }
+
+                string waiting;
+                if (!read_local_spill(spill, waiting)) {
+                    if (waiting.empty()) // Poll2 file and socket notifications
+                        continue;
+                    if (!batch_mode) {
+                        term->SetStatus("\033[0;33m[IDLE]\033[0m " + waiting);
+                    } else {
+                        cout << "\r\033[0;33m[IDLE]\033[0m " << waiting;
+                    }
+                    IdleTask();
+                    continue;
+                }
+
+                if (local_spills_missed() != lastMissed) {
+                    cout << msgHeader << "Poll2 sent " << local_spills_missed() - lastMissed
+                         << " spills that we missed while we were busy!\n";
+                    lastMissed = local_spills_missed();
+                }
+
+                unsigned int nTotalWords = spill.size();
+                stringstream message;
+                message << "\033[0;32m" << "[RECV] " << "\033[0m" << nTotalWords << " words";
+                if (!batch_mode) { term->SetStatus(message.str()); }
+                else { cout << "\r" << message.str(); }
+
+                if (debug_mode) {
+                    cout << "debug: Retrieved spill of " << nTotalWords << " words (" << nTotalWords * 4 << " bytes)\n";
+                }
+                if (!dry_run_mode) {
+                    spill.push_back(2);
+                    spill.push_back(9999);
+                    unpacker_->ReadSpill(spill.data(), nTotalWords + 2, is_verbose);
+                    IdleTask();
+                }
+                num_spills_recvd++;
+            }
         } else if (shm_mode) {
             cout << endl;
             unsigned int data[250000]; // Array for storing spill data. Larger than any RevF spill should be.
@@ -598,8 +824,9 @@ void ScanInterface::RunControl() {
             const unsigned dataSize = 2500000;
             if (!dry_run_mode) { data = new unsigned int[dataSize]; }
 
-            // Reset the buffer reader to default values.
-            databuff.Reset();
+            // Spills which fit in a single chunk of a mapped file are left where they are.
+            unsigned int *spill = data;
+            bool end_of_file = false;
 
             while (true) {
                 if (kill_all == true) {
@@ -610,7 +837,22 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
-                if (!databuff.Read(&input_file, (char *) data, nBytes, 1000000, full_spill, bad_spill, dry_run_mode)) {
+                // Reset the buffer reader to default values.
+                if (reset_reader) {
+                    databuff.Reset();
+                    reader_start = input_position();
+                    reset_reader = false;
+                }
+
+                bool spill_read;
+                if (mapped_file.is_open())
+                    spill_read = databuff.Read(&mapped_file, (char *) data, spill, nBytes, 1000000, full_spill,
+                                               bad_spill, dry_run_mode);
+                else
+                    spill_read = databuff.Read(&input_file, (char *) data, nBytes, 1000000, full_spill, bad_spill,
+                                               dry_run_mode);
+
+                if (!spill_read) {
                     if (databuff.GetRetval() == 1) {
                         if (debug_mode) {
                             cout << "debug: Encountered single EOF buffer (end of run).\n";
@@ -619,6 +861,7 @@ void ScanInterface::RunControl() {
                         if (debug_mode) {
                             cout << "debug: Encountered double EOF buffer (end of file).\n";
                         }
+                        end_of_file = true;
                         break;
                     } else if (databuff.GetRetval() == 3) {
                         if (debug_mode) {
@@ -636,14 +879,23 @@ void ScanInterface::RunControl() {
                         if (debug_mode) {
                             cout << "debug: Failed to read buffer from input file.\n";
                         }
+                        end_of_file = true;
                         break;
                     }
                     continue;
                 }
 
+                // Skip what is left of the spills in front of the one that was jumped to.
+                unsigned long long spill_offset = reader_start + 4ull * databuff.GetSpillStart();
+                if (spill_offset < skip_before)
+                    continue;
+                if (current_spill > last_spill)
+                    break;
+                count_spill(spill_offset, spill, nBytes / 4, full_spill && !bad_spill);
+
                 stringstream status;
                 status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
-                       << 100 * input_file.tellg() / file_length << "%), ";
+                       << 100 * input_position() / file_length << "%), ";
                 status << "GOOD = " << databuff.GetNumChunks() << ", LOST = " << databuff.GetNumMissing();
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
@@ -651,24 +903,27 @@ void ScanInterface::RunControl() {
                 if (full_spill) {
                     if (debug_mode) {
                         cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                        cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                        cout << "debug: Read up to word number " << input_position() / 4 << " in input file\n";
                     }
                     if (!dry_run_mode) {
                         if (!bad_spill) {
-                            unpacker_->ReadSpill(data, nBytes / 4, is_verbose);
+                            unpacker_->ReadSpill(spill, nBytes / 4, is_verbose);
                             IdleTask();
                         } else {
-                            cout << " WARNING: Spill has been flagged as corrupt, skipping (at word " << input_file.tellg() / 4
+                            cout << " WARNING: Spill has been flagged as corrupt, skipping (at word " << input_position() / 4
                                  << " in file)!\n";
                         }
                     }
                 } else if (debug_mode) {
                     cout << "debug: Retrieved spill fragment of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                    cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                    cout << "debug: Read up to word number " << input_position() / 4 << " in input file\n";
                 }
                 num_spills_recvd++;
             }
 
+            if (end_of_file)
+                write_spill_index();
+
             if (!dry_run_mode) { delete[] data; }
 
             if (!batch_mode) {
@@ -682,10 +937,11 @@ void ScanInterface::RunControl() {
 
             if (!dry_run_mode) { data = new unsigned int[max_spill_size + 2]; }
 
-            // Reset the buffer reader to default values.
-            pldData.Reset();
+            // Spills read from a mapped file are left where they are.
+            unsigned int *spill = data;
+            bool end_of_file = false;
 
-            while (pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode)) {
+            while (true) {
                 if (kill_all == true) {
                     break;
                 } else if (!is_running) {
@@ -694,31 +950,59 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
+                // Reset the buffer reader to default values.
+                if (reset_reader) {
+                    pldData.Reset();
+                    reset_reader = false;
+                }
+
+                unsigned long long spill_offset = input_position();
+                bool spill_read;
+                if (mapped_file.is_open())
+                    spill_read = pldData.Read(&mapped_file, (char *) data, spill, nBytes, 4 * max_spill_size,
+                                              dry_run_mode);
+                else
+                    spill_read = pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode);
+
+                if (!spill_read) {
+                    end_of_file = true;
+                    break;
+                }
+                if (current_spill > last_spill)
+                    break;
+
                 stringstream status;
                 status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
-                       << 100 * input_file.tellg() / file_length << "%)";
+                       << 100 * input_position() / file_length << "%)";
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
 
                 if (debug_mode) {
                     cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                    cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                    cout << "debug: Read up to word number " << input_position() / 4 << " in input file\n";
                 }
 
-                if (!dry_run_mode) {
+                // The mapped reader has already placed the end of spill words.
+                if (!dry_run_mode && !mapped_file.is_open()) {
                     int word1 = 2, word2 = 9999;
                     memcpy(&data[(nBytes / 4)], (char *) &word1, 4);
                     memcpy(&data[(nBytes / 4) + 1], (char *) &word2, 4);
-                    unpacker_->ReadSpill(data, nBytes / 4 + 2, is_verbose);
+                }
+                count_spill(spill_offset, spill, nBytes / 4 + 2, true);
+                if (!dry_run_mode) {
+                    unpacker_->ReadSpill(spill, nBytes / 4 + 2, is_verbose);
                     IdleTask();
                 }
                 num_spills_recvd++;
             }
 
-            if (eofbuff.ReadHeader(&input_file)) {
-                cout << msgHeader << "Encountered EOF buffer.\n";
-            } else {
-                cout << msgHeader << "Failed to find end of file buffer!\n";
+            if (end_of_file) {
+                if (mapped_file.is_open() ? eofbuff.ReadHeader(&mapped_file) : eofbuff.ReadHeader(&input_file)) {
+                    cout << msgHeader << "Encountered EOF buffer.\n";
+                } else {
+                    cout << msgHeader << "Failed to find end of file buffer!\n";
+                }
+                write_spill_index();
             }
 
             if (!dry_run_mode) { delete[] data; }
@@ -874,6 +1158,10 @@ void ScanInterface::RunControl() {
             } else { cout << endl << endl; }
         }
 
+        // Build the hits that were carried over from the last spill.
+        if (!dry_run_mode)
+            unpacker_->FlushEventList();
+
         // Notify that the scan has completed.
         Notify("SCAN_COMPLETE");
 
@@ -990,6 +1278,21 @@ void ScanInterface::CmdControl() {
             if (p_args > 0) {
                 rewind(strtoul(arguments.at(0).c_str(), NULL, 0));
             } else { rewind(); }
+        } else if (cmd == "spill" || cmd == "time") { // Move to a spill using the spill index
+            if (p_args == 0) {
+                cout << msgHeader << "Invalid number of parameters to '" << cmd << "'\n";
+                cout << msgHeader << " -SYNTAX- " << (cmd == "spill" ? "spill <number>" : "time <clock ticks>") << "\n";
+            } else if (is_running) {
+                cout << " Cannot change file position while scan is running!\n";
+            } else if (cmd == "spill") {
+                seek_spill(strtoul(arguments.at(0).c_str(), NULL, 0));
+            } else {
+                size_t spill = spill_index.FindTime(strtoull(arguments.at(0).c_str(), NULL, 0));
+                if (index_ready && spill == spill_index.GetNumSpills())
+                    cout << msgHeader << "No spill holds events at or after this time.\n";
+                else
+                    seek_spill(spill);
+            }
         } else if (cmd == "sync") { // Wait until the current run is completed.
             if (is_running) {
                 cout << msgHeader
@@ -1027,9 +1330,14 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     debug_mode = false;
     dry_run_mode = false;
     shm_mode = false;
+    stream_mode = false;
+    ring_mode = false;
     num_spills_recvd = 0;
     unsigned int samplingFrequency = 0;
     string firmware = "";
+    string eventBuilder = "";
+    bool split_spills = false;
+    unsigned int numThreads = 1;
     string input_filename = "";
 
     // Add derived class options to the option list.
@@ -1058,7 +1366,9 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     while ((retval = getopt_long(argc, argv, optstr.c_str(), longOpts.data(),
                                  &idx)) != -1) {
         if (retval == 0x0) { // Long option
-            if (strcmp("config", longOpts[idx].name) == 0) {
+            if (strcmp("builder", longOpts[idx].name) == 0) {
+                eventBuilder = optarg;
+            } else if (strcmp("config", longOpts[idx].name) == 0) {
                 setup_filename = optarg;
             } else if (strcmp("counts", longOpts[idx].name) == 0) {
                 write_counts = true;
@@ -1066,8 +1376,36 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
                 debug_mode = true;
             } else if (strcmp("dry-run", longOpts[idx].name) == 0) {
                 dry_run_mode = true;
+            } else if (strcmp("mmap", longOpts[idx].name) == 0) {
+                mmap_mode = true;
             } else if (strcmp("fast-fwd", longOpts[idx].name) == 0) {
                 file_start_offset = atoll(optarg);
+            } else if (strcmp("spills", longOpts[idx].name) == 0) {
+                string range = optarg;
+                size_t colon = range.find(':');
+                if (colon == string::npos)
+                    throw invalid_argument("ScanInterface::Setup - The spill range \"" + range
+                                           + "\" is not of the form <first>:<last>.");
+                if (colon > 0)
+                    first_spill = stoul(range.substr(0, colon));
+                if (colon + 1 < range.size())
+                    last_spill = stoul(range.substr(colon + 1));
+            } else if (strcmp("ring", longOpts[idx].name) == 0) {
+                file_format = 0;
+                shm_mode = true;
+                ring_mode = true;
+                if (optarg)
+                    ring_name = optarg;
+            } else if (strcmp("stream", longOpts[idx].name) == 0) {
+                file_format = 0;
+                shm_mode = true;
+                stream_mode = true;
+                if (optarg)
+                    stream_address = optarg;
+            } else if (strcmp("split-spills", longOpts[idx].name) == 0) {
+                split_spills = true;
+            } else if (strcmp("threads", longOpts[idx].name) == 0) {
+                numThreads = (unsigned int) stoi(optarg);
             } else if (strcmp("frequency", longOpts[idx].name) == 0)
                 samplingFrequency = (unsigned int) stoi(optarg);
             else if (strcmp("firmware", longOpts[idx].name) == 0)
@@ -1152,6 +1490,19 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     if (debug_mode)
         unpacker_->SetDebugMode();
 
+    if (eventBuilder == "linear")
+        unpacker_->SetEventBuilder(Unpacker::LINEAR_SCAN);
+    else if (eventBuilder == "merge")
+        unpacker_->SetEventBuilder(Unpacker::KWAY_MERGE);
+    else if (eventBuilder != "")
+        throw invalid_argument("ScanInterface::Setup - Unknown event builder \"" + eventBuilder
+                               + "\". Use \"linear\" or \"merge\".");
+
+    if (split_spills)
+        unpacker_->SetCarryOver(false);
+
+    unpacker_->SetNumThreads(numThreads);
+
     // Parse for any extra arguments that are known to the derived class.
     ExtraArguments();
 
@@ -1164,7 +1515,33 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     }
 
 #ifndef USE_HRIBF
-    if (shm_mode) {
+    if (ring_mode && stream_mode) {
+        cout << " FATAL ERROR! Select either the poll2 spill stream or the shared-memory ring, not both!\n"
+             << "\nCleaning up...\n";
+        return false;
+    } else if (ring_mode) {
+        spill_ring = new SpillRingReader();
+        if (!spill_ring->Init(ring_name)) {
+            cout << " FATAL ERROR! Invalid poll2 shared-memory ring name " << ring_name << "!\n"
+                 << "\nCleaning up...\n";
+            return false;
+        }
+        if (batch_mode) {
+            cout << msgHeader << "Unable to enable batch mode for shared-memory mode!\n";
+            batch_mode = false;
+        }
+    } else if (stream_mode) {
+        spill_stream = new SpillReceiver();
+        if (!spill_stream->Init(stream_address)) {
+            cout << " FATAL ERROR! Invalid poll2 spill stream address " << stream_address << "!\n"
+                 << "\nCleaning up...\n";
+            return false;
+        }
+        if (batch_mode) {
+            cout << msgHeader << "Unable to enable batch mode for shared-memory mode!\n";
+            batch_mode = false;
+        }
+    } else if (shm_mode) {
         poll_server = new Server();
         if (!poll_server->Init(5555, 1)) {
             cout << " FATAL ERROR! Failed to open shm socket 5555!\n" << "\nCleaning up...\n";
@@ -1191,7 +1568,13 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
 
     if (debug_mode) { cout << msgHeader << "Using debug mode.\n\n"; }
     if (dry_run_mode) { cout << msgHeader << "Doing a dry run.\n\n"; }
-    if (shm_mode) {
+    if (ring_mode) {
+        cout << msgHeader << "Using shared-memory mode.\n\n";
+        cout << msgHeader << "Reading the poll2 shared-memory ring " << ring_name << "\n\n";
+    } else if (stream_mode) {
+        cout << msgHeader << "Using shared-memory mode.\n\n";
+        cout << msgHeader << "Reading the poll2 spill stream at " << stream_address << "\n\n";
+    } else if (shm_mode) {
         cout << msgHeader << "Using shared-memory mode.\n\n";
         cout << msgHeader << "Listening on poll2 SHM port 5555\n\n";
     }
@@ -1233,6 +1616,10 @@ int ScanInterface::Execute() {
     if (file_start_offset != 0)
         rewind();
 
+    // Move to the first spill of the requested range.
+    if (first_spill != 0 && !seek_spill(first_spill))
+        return 1;
+
     // Process the file.
     if (!batch_mode) {
         // Start the run control thread
@@ -1258,6 +1645,12 @@ int ScanInterface::Execute() {
 bool ScanInterface::Close() {
     if (!scan_init)
         return false;
+
+    // The pipeline threads call back into the derived unpacker, so they have
+    // to be joined before anything is torn down.
+    if (unpacker_)
+        unpacker_->StopPipeline();
+
 #ifndef USE_HRIBF
     // Close the socket and restore the terminal
     if (!batch_mode) {
@@ -1266,14 +1659,23 @@ bool ScanInterface::Close() {
 
     // Only close the server if this is shared memory mode. Otherwise
     // the server would never have been initialized.
-    if (shm_mode) { poll_server->Close(); }
+    if (ring_mode) { spill_ring->Close(); }
+    else if (stream_mode) { spill_stream->Close(); }
+    else if (shm_mode) { poll_server->Close(); }
 
     //Reprint the leader as the carriage was returned
     cout << "Running " << progName << " v" << SCAN_VERSION << " (" << SCAN_DATE << ")\n";
     cout << msgHeader << "Retrieved " << num_spills_recvd << " spills!\n";
+    if (stream_mode || ring_mode)
+        cout << msgHeader << "Missed " << local_spills_missed() << " spills that poll2 sent while we were busy.\n";
+    cout << msgHeader << "Built " << unpacker_->GetNumRawEvents() << " raw events with the "
+         << unpacker_->GetEventBuilderName() << " builder in " << unpacker_->GetEventBuildTime() << " s ("
+         << unpacker_->GetEventBuildRate() << " events/s, " << unpacker_->GetNumSortedStreams()
+         << " streams out of order).\n";
 
     if (input_file.good())
         input_file.close();
+    mapped_file.close();
 
     // Clean up detector driver
     cout << "\n" << msgHeader << "Cleaning up...\n";
@@ -1286,12 +1688,41 @@ bool ScanInterface::Close() {
         unpacker_->Write();
 
     if (poll_server) { delete poll_server; }
+    if (spill_stream) { delete spill_stream; }
+    if (spill_ring) { delete spill_ring; }
     if (term) { delete term; }
 #endif
     scan_init = false;
     return true;
 }
 
+bool ScanInterface::read_local_spill(std::vector<unsigned int> &spill_, std::string &waiting_) {
+    waiting_ = "";
+    if (ring_mode) {
+        SpillRingReader::Status status = spill_ring->Read(spill_, 1000);
+        if (status == SpillRingReader::SPILL)
+            return true;
+        waiting_ = status == SpillRingReader::TIMEOUT ? "Waiting for a spill..." :
+                   "Waiting for the poll2 ring " + ring_name + "...";
+        return false;
+    }
+
+    SpillReceiver::Status status = spill_stream->Read(spill_, 1000);
+    if (status == SpillReceiver::SPILL)
+        return true;
+    if (status == SpillReceiver::TIMEOUT)
+        waiting_ = "Waiting for a spill...";
+    else if (status == SpillReceiver::DISCONNECTED)
+        waiting_ = "Waiting for poll2 at " + stream_address + "...";
+    return false;
+}
+
+unsigned long ScanInterface::local_spills_missed() {
+    if (ring_mode)
+        return spill_ring->GetNumMissed();
+    return spill_stream->GetNumMissed();
+}
+
 /** Get the file extension from an input filename string.
   * \param[in]  filename_ The full input filename path.
   * \param[out] prefix	The input filename path without the file extension.
@@ -0,0 +1,181 @@
+///@file SpillIndex.cpp
+///@brief An index of the spills in a .ldf or .pld file that is stored beside
+/// the file so that a scan can jump straight to a spill.
+///@date October 17, 2026
+#include <fstream>
+#include <stdexcept>
+
+#include "SpillIndex.hpp"
+
+using namespace std;
+using namespace DataProcessing;
+
+namespace {
+    const unsigned int INDEX_MAGIC = 0x58495053; ///< "SPIX"
+    const unsigned int INDEX_VERSION = 1;
+    const unsigned int END_OF_SPILL = 9999; ///< The vsn of the end of spill words
+    const unsigned int MAX_MASK_MODULE = 31; ///< The highest module that fits in the module mask
+}
+
+void SpillIndex::Summarize(unsigned int *data, const unsigned int &nWords, const vector<XiaListModeDataMask> &masks,
+                           SpillIndexEntry &entry) {
+    entry.moduleMask = 0;
+    entry.firstTime = entry.lastTime = 0;
+    bool hasTime = false;
+
+    unsigned int pos = 0;
+    while (pos + 1 < nWords) {
+        if (data[pos] == 0xFFFFFFFF) { // Skip the delimiters between module buffers.
+            pos++;
+            continue;
+        }
+
+        unsigned int lenRec = data[pos];
+        unsigned int vsn = data[pos + 1];
+        if (vsn == END_OF_SPILL || lenRec < 2 || pos + lenRec > nWords)
+            break;
+
+        if (vsn <= MAX_MASK_MODULE && lenRec > 2) {
+            pair<unsigned int, unsigned int> lengthMask(0, 0);
+            if (vsn < masks.size()) {
+                try {
+                    lengthMask = masks[vsn].GetEventLengthMask();
+                } catch (invalid_argument &) {
+                    // Modules of an unknown firmware are only marked as present.
+                }
+            }
+
+            if (lengthMask.first == 0) {
+                entry.moduleMask |= 1u << vsn;
+            } else {
+                const XiaListModeDataMask &mask = masks[vsn];
+                unsigned int *buf = &data[pos + 2];
+                unsigned int *end = &data[pos + lenRec];
+                while (buf + 2 < end) {
+                    unsigned int eventLength = (buf[0] & lengthMask.first) >> lengthMask.second;
+                    unsigned int headerLength = (buf[0] & mask.GetHeaderLengthMask().first) >>
+                                                mask.GetHeaderLengthMask().second;
+                    if (eventLength == 0)
+                        break;
+
+                    if (headerLength != STATS_BLOCK) {
+                        unsigned long long time = buf[1] |
+                                                  ((unsigned long long) (buf[2] & mask.GetEventTimeHighMask().first)
+                                                          << 32);
+                        if (!hasTime || time < entry.firstTime)
+                            entry.firstTime = time;
+                        if (!hasTime || time > entry.lastTime)
+                            entry.lastTime = time;
+                        hasTime = true;
+                        entry.moduleMask |= 1u << vsn;
+                    }
+                    buf += eventLength;
+                }
+            }
+        }
+        pos += lenRec;
+    }
+}
+
+const SpillIndexEntry &SpillIndex::GetSpill(const size_t &spill) const {
+    if (spill >= spills_.size())
+        throw out_of_range("SpillIndex::GetSpill - Spill " + to_string(spill) + " is past the last of the "
+                           + to_string(spills_.size()) + " spills in the index.");
+    return spills_[spill];
+}
+
+///The times of the spills are not assumed to increase, since a module may
+/// have been reset part way through the run, so every spill is looked at.
+size_t SpillIndex::FindTime(const unsigned long long &time) const {
+    for (size_t i = 0; i < spills_.size(); i++)
+        if (spills_[i].good && spills_[i].moduleMask != 0 && spills_[i].lastTime >= time)
+            return i;
+    return spills_.size();
+}
+
+vector<pair<size_t, size_t> > SpillIndex::Partition(const unsigned int &parts) const {
+    vector<pair<size_t, size_t> > ranges;
+    if (parts == 0 || spills_.empty())
+        return ranges;
+
+    unsigned long long totalWords = 0;
+    for (vector<SpillIndexEntry>::const_iterator it = spills_.begin(); it != spills_.end(); it++)
+        totalWords += it->nWords;
+
+    // Close a range once it has passed its share of the words, leaving at
+    // least one spill for each of the ranges that are still to come.
+    size_t first = 0;
+    unsigned long long words = 0;
+    for (size_t i = 0; i < spills_.size(); i++) {
+        words += spills_[i].nWords;
+        size_t rangesLeft = parts - ranges.size() - 1;
+        bool full = words * parts >= totalWords * (ranges.size() + 1);
+        if (rangesLeft > 0 && (full || spills_.size() - i - 1 == rangesLeft)) {
+            ranges.push_back(make_pair(first, i));
+            first = i + 1;
+        }
+    }
+    if (first < spills_.size())
+        ranges.push_back(make_pair(first, spills_.size() - 1));
+
+    return ranges;
+}
+
+bool SpillIndex::Read(const string &filename) {
+    ifstream file(filename.c_str(), ios::binary);
+    if (!file.is_open())
+        return false;
+
+    unsigned int magic = 0, version = 0;
+    unsigned long long numSpills = 0;
+    file.read((char *) &magic, sizeof(magic));
+    file.read((char *) &version, sizeof(version));
+    file.read((char *) &fileLength_, sizeof(fileLength_));
+    file.read((char *) &numSpills, sizeof(numSpills));
+    if (!file.good() || magic != INDEX_MAGIC || version != INDEX_VERSION)
+        return false;
+
+    spills_.clear();
+    spills_.reserve(numSpills);
+    for (unsigned long long i = 0; i < numSpills; i++) {
+        SpillIndexEntry entry;
+        unsigned int good = 0;
+        file.read((char *) &entry.offset, sizeof(entry.offset));
+        file.read((char *) &entry.nWords, sizeof(entry.nWords));
+        file.read((char *) &entry.moduleMask, sizeof(entry.moduleMask));
+        file.read((char *) &entry.firstTime, sizeof(entry.firstTime));
+        file.read((char *) &entry.lastTime, sizeof(entry.lastTime));
+        file.read((char *) &good, sizeof(good));
+        if (!file.good()) {
+            spills_.clear();
+            return false;
+        }
+        entry.good = good != 0;
+        spills_.push_back(entry);
+    }
+
+    return true;
+}
+
+bool SpillIndex::Write(const string &filename) const {
+    ofstream file(filename.c_str(), ios::binary);
+    if (!file.is_open())
+        return false;
+
+    unsigned long long numSpills = spills_.size();
+    file.write((const char *) &INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.write((const char *) &INDEX_VERSION, sizeof(INDEX_VERSION));
+    file.write((const char *) &fileLength_, sizeof(fileLength_));
+    file.write((const char *) &numSpills, sizeof(numSpills));
+    for (vector<SpillIndexEntry>::const_iterator it = spills_.begin(); it != spills_.end(); it++) {
+        unsigned int good = it->good ? 1 : 0;
+        file.write((const char *) &it->offset, sizeof(it->offset));
+        file.write((const char *) &it->nWords, sizeof(it->nWords));
+        file.write((const char *) &it->moduleMask, sizeof(it->moduleMask));
+        file.write((const char *) &it->firstTime, sizeof(it->firstTime));
+        file.write((const char *) &it->lastTime, sizeof(it->lastTime));
+        file.write((const char *) &good, sizeof(good));
+    }
+
+    return file.good();
+}
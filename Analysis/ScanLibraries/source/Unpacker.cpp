@@ -10,7 +10,9 @@
  * \date February 12, 2016
  */
 #include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
 
@@ -24,44 +26,261 @@
 
 using namespace std;
 
-void clearDeque(deque<XiaData *> &list) {
+/** Free an event that was handed out by the Unpacker.
+  * \param[in]  event_ The event to free.
+  * \return Nothing. */
+void Unpacker::ReleaseEvent(XiaData *event_) {
+    if (pooledDecoding_)
+        pool_.Release(event_);
+    else
+        delete event_;
+}
+
+/** Free all of the events in a deque and empty it.
+  * \param[in]  list The deque to clear.
+  * \return Nothing. */
+void Unpacker::ClearDeque(deque<XiaData *> &list) {
     while (!list.empty()) {
-        delete list.front();
+        ReleaseEvent(list.front());
         list.pop_front();
     }
 }
 
-///Scan the event list and sort it by timestamp.
+///Scan the event list and sort any stream that is not already ordered by timestamp.
 /// @return Nothing.
 void Unpacker::TimeSort() {
-    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
+    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
+        if (is_sorted(iter->begin(), iter->end(), &XiaData::CompareTime))
+            continue;
         sort(iter->begin(), iter->end(), &XiaData::CompareTime);
+        numSortedStreams_++;
+    }
+}
+
+///Sort the spill and build the raw events using the selected algorithm. Only the sorting and building is included
+/// in the event building time, the processing of the raw events is not.
+///@param[in] flush : True to build every hit regardless of the build horizon.
+///@param[out] batch : The batch receiving the raw events.
+///@param[in] dispatch : True to process every raw event as soon as it is built.
+///@return Nothing.
+void Unpacker::BuildEvents(const bool &flush, RawEventBatch &batch, const bool &dispatch) {
+    typedef chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+
+    // The hits are compared in whole filter ticks, so a window of a fractional width holds the same hits as
+    // one of its whole part.
+    windowTicks_ = eventWidth_ > 0 ? (unsigned long long) eventWidth_ : 0;
+    buildHorizon_ = carryOver_ && !flush ? GetBuildHorizon() : numeric_limits<unsigned long long>::max();
+
+    TimeSort();
+    if (eventBuilder_ == KWAY_MERGE)
+        InitializeMerge();
+
+    while (true) {
+        bool built = eventBuilder_ == KWAY_MERGE ? MergeRawEvent(batch) : BuildRawEvent(batch);
+        clock::time_point stop = clock::now();
+        buildTime_ += chrono::duration<double>(stop - start).count();
+        if (!built)
+            break;
+        if (dispatch) {
+            DispatchRawEvent(batch, batch.events.back());
+            batch.hits.clear();
+            batch.events.clear();
+        }
+        start = clock::now();
+    }
+
+    if (buildHorizon_ == numeric_limits<unsigned long long>::max()) {
+        ClearEventList();
+        return;
+    }
+
+    // The carried hits outlive the spill buffer that their traces point into.
+    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
+        for (deque<XiaData *>::iterator it = iter->begin(); it != iter->end(); it++)
+            (*it)->DetachTrace();
+}
+
+///Make a built raw event the current raw event and process it. The raw event is freed afterwards.
+///@param[in] batch : The batch holding the raw event.
+///@param[in] event : The raw event to process.
+///@return Nothing.
+void Unpacker::DispatchRawEvent(const RawEventBatch &batch, const BuiltEvent &event) {
+    rawEvent.assign(batch.hits.begin() + event.begin, batch.hits.begin() + event.end);
+    eventStartTime = event.startTime;
+    realStartTime = event.realStartTime;
+    realStopTime = event.realStopTime;
+
+    // Update raw stats output with the new events before processing them.
+    for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+        RawStats(*it);
+
+    ProcessRawEvent();
+    ClearRawEvent();
+}
+
+///Compute the time after which raw events may still receive hits from the next spill. Every module only delivers
+/// hits later than its last one, so the slowest module bounds what can still arrive. Modules that did not deliver
+/// anything in this spill do not hold back the horizon. The module times are reset for the next spill.
+/// @return The build horizon in system clock ticks.
+unsigned long long Unpacker::GetBuildHorizon() {
+    unsigned long long slowest = numeric_limits<unsigned long long>::max();
+    for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++) {
+        if (moduleLastTime_[i] < slowest)
+            slowest = moduleLastTime_[i];
+        moduleLastTime_[i] = numeric_limits<unsigned long long>::max();
+    }
+    if (slowest == numeric_limits<unsigned long long>::max())
+        return slowest;
+    return slowest > windowTicks_ ? slowest - windowTicks_ : 0;
+}
+
+///Build and process all of the hits that have been carried over from previous spills.
+/// @return Nothing.
+void Unpacker::FlushEventList() {
+    if (numThreads_ > 1) {
+        if (pipelineThreads_.empty())
+            return;
+        PendingSpill *spill = freeSpills_.Pop();
+        spill->flush = true;
+        {
+            lock_guard<mutex> lock(pipelineMutex_);
+            spillsInPipeline_++;
+        }
+        decodeQueue_.Push(spill);
+        WaitForPipeline();
+    } else {
+        if (!IsEmpty())
+            BuildEvents(true, batch_, true);
+        FinishRawEvents();
+    }
+}
+
+///Discard the hits that have been carried over from previous spills. The pipeline is drained first so that none of
+/// its threads touch the event list while it is cleared.
+/// @return Nothing.
+void Unpacker::Reset() {
+    if (!pipelineThreads_.empty())
+        WaitForPipeline();
+    ClearRawEvent();
+    ClearEventList();
+    buildHorizon_ = 0;
+}
+
+///Fill the merge heap with the front of every time sorted stream.
+/// @return Nothing.
+void Unpacker::InitializeMerge() {
+    mergeHeap_.clear();
+    for (unsigned int i = 0; i < eventList.size(); i++)
+        if (!eventList[i].empty())
+            mergeHeap_.push_back(make_pair(eventList[i].front()->GetTicksSansCfd(), i));
+    make_heap(mergeHeap_.begin(), mergeHeap_.end(), greater<pair<unsigned long long, unsigned int> >());
+}
+
+///Restore the heap ordering after the top of the merge heap was replaced. This does a single pass down the heap,
+/// which is half the work of a pop_heap followed by a push_heap.
+/// @return Nothing.
+void Unpacker::SiftDownMerge() {
+    const size_t size = mergeHeap_.size();
+    if (size < 2)
+        return;
+
+    pair<unsigned long long, unsigned int> top = mergeHeap_.front();
+    size_t pos = 0, child = 1;
+    while (child < size) {
+        if (child + 1 < size && mergeHeap_[child + 1] < mergeHeap_[child])
+            child++;
+        if (!(mergeHeap_[child] < top))
+            break;
+        mergeHeap_[pos] = mergeHeap_[child];
+        pos = child;
+        child = 2 * pos + 1;
+    }
+    mergeHeap_[pos] = top;
+}
+
+///Pull the hits from the merge heap in time order and package them into a raw event with a size governed by the
+/// event width. Each stream is time ordered, so the heap always holds the earliest remaining hit of the spill.
+/// @return True if the event list is not empty and false otherwise.
+bool Unpacker::MergeRawEvent(RawEventBatch &batch) {
+    if (mergeHeap_.empty() || mergeHeap_.front().first >= buildHorizon_)
+        return false;
+
+    BuiltEvent event;
+    event.begin = batch.hits.size();
+    event.startTime = mergeHeap_.front().first;
+    if (numRawEvt == 0) {
+        firstTime = event.startTime;
+        std::cout << "BuildRawEvent: First event time is " << firstTime << " clock ticks.\n";
+    }
+
+    event.realStartTime = event.startTime;
+    event.realStopTime = event.startTime;
+
+    while (!mergeHeap_.empty() && mergeHeap_.front().first - event.startTime <= windowTicks_) {
+        unsigned long long currtime = mergeHeap_.front().first;
+        deque<XiaData *> &stream = eventList[mergeHeap_.front().second];
+        XiaData *current_event = stream.front();
+        stream.pop_front();
+
+        // Replace the top of the heap with the next hit from the same stream, or with the last
+        // entry of the heap if the stream is exhausted, and let it sink to its place.
+        if (stream.empty()) {
+            mergeHeap_.front() = mergeHeap_.back();
+            mergeHeap_.pop_back();
+        } else
+            mergeHeap_.front().first = stream.front()->GetTicksSansCfd();
+        SiftDownMerge();
+
+        if (current_event->GetModuleNumber() > MAX_PIXIE_MOD || current_event->GetChannelNumber() > MAX_PIXIE_CHAN) {
+            cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = " << current_event->GetModuleNumber()
+                 << ", chan = " << current_event->GetChannelNumber() << ")\n";
+            ReleaseEvent(current_event);
+            continue;
+        }
+
+        event.realStopTime = currtime;
+        batch.hits.push_back(current_event);
+    }
+
+    event.end = batch.hits.size();
+    batch.events.push_back(event);
+    numRawEvt++;
+
+    return true;
+}
+
+///Get the index of the stream in the event list that holds an event.
+///@param[in] event_ : The XiaData to locate.
+///@return The module number for the linear scan and the channel index for the merge.
+unsigned int Unpacker::GetStreamIndex(XiaData *event_) {
+    if (eventBuilder_ == KWAY_MERGE)
+        return event_->GetModuleNumber() * (MAX_PIXIE_CHAN + 1) + event_->GetChannelNumber();
+    return event_->GetModuleNumber();
 }
 
 /** Scan the time sorted event list and package the events into a raw
   * event with a size governed by the event width.
   * \return True if the event list is not empty and false otherwise.
   */
-bool Unpacker::BuildRawEvent() {
-    if (!rawEvent.empty())
-        ClearRawEvent();
+bool Unpacker::BuildRawEvent(RawEventBatch &batch) {
+    // Move the event window forward to the next valid channel fire. The eventList is time sorted by module.
+    // The first component of each deque will be the earliest time from that module.
+    // The start time will be the minimum of these first components.
+    unsigned long long startTime;
+    if (!GetFirstTime(startTime) || startTime >= buildHorizon_)
+        return false;
 
     if (numRawEvt == 0) {// This is the first rawEvent. Do some special processing.
-        // Find the first XiaData event. The eventList is time sorted by module.
-        // The first component of each deque will be the earliest time from that module.
-        // The first event time will be the minimum of these first components.
-        if (!GetFirstTime(firstTime))
-            return false;
+        firstTime = startTime;
         std::cout << "BuildRawEvent: First event time is " << firstTime << " clock ticks.\n";
-        eventStartTime = firstTime;
-    } else {
-        // Move the event window forward to the next valid channel fire.
-        if (!GetFirstTime(eventStartTime))
-            return false;
     }
 
-    realStartTime = eventStartTime + eventWidth_;
-    realStopTime = eventStartTime;
+    BuiltEvent event;
+    event.begin = batch.hits.size();
+    event.startTime = startTime;
+    event.realStartTime = startTime + windowTicks_;
+    event.realStopTime = startTime;
 
     unsigned int mod, chan;
     string type, subtype, tag;
@@ -82,37 +301,34 @@ bool Unpacker::BuildRawEvent() {
                 chan > MAX_PIXIE_CHAN) { // Skip this channel
                 cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = "
                      << mod << ", chan = " << chan << ")\n";
-                delete current_event;
+                ReleaseEvent(current_event);
                 iter->pop_front();
                 continue;
             }
 
-            double currtime = current_event->GetTimeSansCfd();
+            unsigned long long currtime = current_event->GetTicksSansCfd();
 
             // Check for backwards time-skip. This is un-handled currently and needs fixed CRT!!!
-            if (currtime < eventStartTime)
-                cout << "BuildRawEvent: Detected backwards time-skip from start=" << eventStartTime << " to "
-                     << current_event->GetTimeSansCfd() << "???\n";
+            if (currtime < event.startTime)
+                cout << "BuildRawEvent: Detected backwards time-skip from start=" << event.startTime << " to "
+                     << currtime << "???\n";
 
             // If the time difference between the current and previous event is
             // larger than the event width, finalize the current event, otherwise
             // treat this as part of the current event
-            if ((currtime - eventStartTime) > eventWidth_)
+            if (currtime > event.startTime && currtime - event.startTime > windowTicks_)
                 break;
 
             // Check for the minimum time in this raw event.
-            if (currtime < realStartTime)
-                realStartTime = currtime;
+            if (currtime < event.realStartTime)
+                event.realStartTime = currtime;
 
             // Check for the maximum time in this raw event.
-            if (currtime > realStopTime)
-                realStopTime = currtime;
-
-            // Update raw stats output with the new event before adding it to the raw event.
-            RawStats(current_event);
+            if (currtime > event.realStopTime)
+                event.realStopTime = currtime;
 
-            // Push this channel event into the rawEvent.
-            rawEvent.push_back(current_event);
+            // Push this channel event into the raw event.
+            batch.hits.push_back(current_event);
 
             // Remove this event from the event list but do not delete it yet.
             // Deleting of the channel events will be handled by clearing the rawEvent.
@@ -120,6 +336,8 @@ bool Unpacker::BuildRawEvent() {
         }
     }
 
+    event.end = batch.hits.size();
+    batch.events.push_back(event);
     numRawEvt++;
 
     return true;
@@ -132,12 +350,18 @@ bool Unpacker::AddEvent(XiaData *event_) {
     if (event_->GetModuleNumber() > MAX_PIXIE_MOD)
         return false;
 
+    unsigned int stream = GetStreamIndex(event_);
+
+    unsigned long long &lastTime = moduleLastTime_[event_->GetModuleNumber()];
+    if (lastTime == numeric_limits<unsigned long long>::max() || event_->GetTicksSansCfd() > lastTime)
+        lastTime = event_->GetTicksSansCfd();
+
     // Check for the need to add a new deque to the event list.
-    if (event_->GetModuleNumber() + 1 > (unsigned int) eventList.size())
-        while (eventList.size() < event_->GetModuleNumber() + 1)
+    if (stream + 1 > (unsigned int) eventList.size())
+        while (eventList.size() < stream + 1)
             eventList.push_back(std::deque<XiaData *>());
 
-    eventList.at(event_->GetModuleNumber()).push_back(event_);
+    eventList.at(stream).push_back(event_);
 
     return true;
 }
@@ -147,29 +371,32 @@ bool Unpacker::AddEvent(XiaData *event_) {
   * \return Nothing. */
 void Unpacker::ClearEventList() {
     for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        clearDeque((*iter));
+        ClearDeque((*iter));
+    mergeHeap_.clear();
+    for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++)
+        moduleLastTime_[i] = numeric_limits<unsigned long long>::max();
 }
 
 /** Clear all events in the raw event list. WARNING! This method will delete all events in the
   * event list. This could cause seg faults if the events are used elsewhere.
   * \return Nothing. */
 void Unpacker::ClearRawEvent() {
-    clearDeque(rawEvent);
+    ClearDeque(rawEvent);
 }
 
 /** Get the minimum channel time from the event list.
   * \param[out] time The minimum time from the event list in system clock ticks.
   * \return True if the event list is not empty and false otherwise. */
-bool Unpacker::GetFirstTime(double &time) {
+bool Unpacker::GetFirstTime(unsigned long long &time) {
     if (IsEmpty())
         return false;
 
-    time = std::numeric_limits<double>::max();
+    time = std::numeric_limits<unsigned long long>::max();
     for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
         if (iter->empty())
             continue;
-        if (iter->front()->GetTimeSansCfd() < time)
-            time = iter->front()->GetTimeSansCfd();
+        if (iter->front()->GetTicksSansCfd() < time)
+            time = iter->front()->GetTicksSansCfd();
     }
 
     return true;
@@ -189,44 +416,197 @@ void Unpacker::ProcessRawEvent() {
     ClearRawEvent();
 }
 
-///Called form ReadSpill. Scan the current spill and construct a list of events which fired by obtaining the module,
-/// channel, trace, etc. of the timestamped event. This method will construct the event list for later processing.
+///Called form ReadSpill. Decode a module buffer from the current spill by obtaining the module, channel, trace, etc.
+/// of every timestamped event. This may be called from several threads at once, so the data mask for the module is
+/// looked up without touching mask_.
 ///@param[in] buf : Pointer to an array of unsigned ints containing raw buffer data.
+///@param[in] vsn : The module number of the buffer.
+///@param[out] events : The XiaDatas read from the buffer.
 ///@return The number of XiaDatas read from the buffer.
-int Unpacker::ReadBuffer(unsigned int *buf, const unsigned int &vsn) {
-    static XiaListModeDataDecoder decoder;
-
-    if (maskMap_.size() != 0) {
-        auto found = maskMap_.find(vsn);
-        if(found == maskMap_.end())
-            throw invalid_argument("Unpacker::ReadBuffer - Unable to locate VSN = " + to_string(vsn)
-                                   + " in the maskMap. Ensure that it's defined in your configuration file!");
-        mask_.SetFirmware((*found).second.first);
-        mask_.SetFrequency((*found).second.second);
-    }
-
-    std::vector<XiaData *> decodedList = decoder.DecodeBuffer(buf, mask_);
-    for (vector<XiaData *>::iterator it = decodedList.begin(); it != decodedList.end(); it++)
-        AddEvent(*it);
-    return (int) decodedList.size();
+int Unpacker::ReadBuffer(unsigned int *buf, const unsigned int &vsn, vector<XiaData *> &events) {
+    XiaListModeDataDecoder decoder;
+    XiaListModeDataMask mask = GetDataMask(vsn);
+
+    // In pooled mode the decoder fills the list with objects from the
+    // pool and leaves the traces in the spill buffer.
+    events.clear();
+    if (pooledDecoding_)
+        decoder.DecodeBuffer(buf, mask, pool_, events);
+    else
+        events = decoder.DecodeBuffer(buf, mask);
+
+    return (int) events.size();
 }
 
-Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), running(true),
+Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), maxModuleNumberInFile_(0), running(true),
+                       pooledDecoding_(false), carryOver_(true),
                        TOTALREAD(1000000), // Maximum number of data words to read.
                        maxWords(131072), // Maximum number of data words for revision D.
                        numRawEvt(0), // Count of raw events read from file.
+                       eventBuilder_(LINEAR_SCAN), numThreads_(1), spillsInPipeline_(0),
+                       windowTicks_(62), buildHorizon_(0), buildTime_(0), numSortedStreams_(0),
                        firstTime(0), eventStartTime(0), realStartTime(0), realStopTime(0) {
 
-    for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++)
+    for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++) {
+        moduleLastTime_[i] = numeric_limits<unsigned long long>::max();
         for (unsigned int j = 0; j <= MAX_PIXIE_CHAN; j++)
             channel_counts[i][j] = 0;
+    }
 }
 
 Unpacker::~Unpacker() {
+    StopPipeline();
     ClearRawEvent();
     ClearEventList();
 }
 
+///Copy a spill into the pipeline. This blocks while every spill object is in use, which keeps the reader from
+/// running away from the rest of the pipeline.
+///@param[in] data : Pointer to an array of unsigned ints containing the spill data.
+///@param[in] nWords : The number of words in the array.
+///@param[in] is_verbose : Toggle the verbosity flag on/off.
+///@return True. The spill is only checked once the decoder thread gets to it.
+bool Unpacker::QueueSpill(unsigned int *data, const unsigned int &nWords, const bool &is_verbose) {
+    StartPipeline();
+
+    PendingSpill *spill = freeSpills_.Pop();
+
+    // ReadSpill may look at the word following the spill while searching for delimiters.
+    spill->words.assign(data, data + nWords);
+    spill->words.resize(nWords + 2, 0);
+    spill->data = spill->words.data();
+    spill->nWords = nWords;
+    spill->verbose = is_verbose;
+    spill->flush = false;
+
+    {
+        lock_guard<mutex> lock(pipelineMutex_);
+        spillsInPipeline_++;
+    }
+    decodeQueue_.Push(spill);
+    return true;
+}
+
+///Start the pipeline threads if they are not running yet. Every queue can hold all of the spill objects, so the
+/// only place that blocks on a full pipeline is QueueSpill.
+void Unpacker::StartPipeline() {
+    if (!pipelineThreads_.empty())
+        return;
+
+    static const unsigned int numPipelineSpills = 6;
+    freeSpills_.SetCapacity(numPipelineSpills);
+    decodeQueue_.SetCapacity(numPipelineSpills + 1);
+    buildQueue_.SetCapacity(numPipelineSpills + 1);
+    processQueue_.SetCapacity(numPipelineSpills + 1);
+    moduleQueue_.SetCapacity(numPipelineSpills * (MAX_PIXIE_MOD + 2));
+
+    for (unsigned int i = 0; i < numPipelineSpills; i++) {
+        pipelineSpills_.push_back(new PendingSpill());
+        freeSpills_.Push(pipelineSpills_.back());
+    }
+
+    // The hits are acquired by the decoder threads and released by the builder and processing threads.
+    pool_.SetThreadSafe();
+
+    pipelineThreads_.push_back(thread(&Unpacker::DecodeSpills, this));
+    pipelineThreads_.push_back(thread(&Unpacker::BuildSpills, this));
+    pipelineThreads_.push_back(thread(&Unpacker::ProcessSpills, this));
+    for (unsigned int i = 3; i < numThreads_; i++)
+        pipelineThreads_.push_back(thread(&Unpacker::DecodeModules, this));
+}
+
+///Process everything that is still in the pipeline and join its threads. The end of the data is signalled by
+/// pushing a NULL spill that each stage passes on to the next one.
+void Unpacker::StopPipeline() {
+    if (pipelineThreads_.empty())
+        return;
+
+    decodeQueue_.Push(NULL);
+    for (vector<thread>::iterator it = pipelineThreads_.begin(); it != pipelineThreads_.end(); it++)
+        it->join();
+    pipelineThreads_.clear();
+
+    for (vector<PendingSpill *>::iterator it = pipelineSpills_.begin(); it != pipelineSpills_.end(); it++)
+        delete *it;
+    pipelineSpills_.clear();
+    while (freeSpills_.GetSize() > 0)
+        freeSpills_.Pop();
+}
+
+///Wait until every queued spill has been processed.
+void Unpacker::WaitForPipeline() {
+    unique_lock<mutex> lock(pipelineMutex_);
+    while (spillsInPipeline_ > 0)
+        pipelineIdle_.wait(lock);
+}
+
+///Thread that locates the module buffers of the queued spills and decodes them. The module buffers of a spill are
+/// handed to the helper threads and this thread decodes them as well until none are left.
+void Unpacker::DecodeSpills() {
+    PendingSpill *spill;
+    while ((spill = decodeQueue_.Pop()) != NULL) {
+        spill->good = spill->flush || LocateModuleBuffers(*spill);
+        if (spill->good && !spill->flush && !spill->modules.empty()) {
+            spill->decoded.resize(spill->modules.size());
+            spill->remaining = (unsigned int) spill->modules.size();
+            for (unsigned int i = 0; i < spill->modules.size(); i++)
+                moduleQueue_.Push(make_pair(spill, i));
+
+            pair<PendingSpill *, unsigned int> task;
+            while (moduleQueue_.TryPop(task))
+                DecodeModuleBuffer(*task.first, task.second);
+
+            unique_lock<mutex> lock(pipelineMutex_);
+            while (spill->remaining > 0)
+                spillDecoded_.wait(lock);
+        }
+        buildQueue_.Push(spill);
+    }
+
+    for (unsigned int i = 3; i < numThreads_; i++)
+        moduleQueue_.Push(make_pair((PendingSpill *) NULL, 0u));
+    buildQueue_.Push(NULL);
+}
+
+///Thread that helps decoding the module buffers of a spill.
+void Unpacker::DecodeModules() {
+    pair<PendingSpill *, unsigned int> task;
+    while ((task = moduleQueue_.Pop()).first != NULL)
+        DecodeModuleBuffer(*task.first, task.second);
+}
+
+///Thread that builds the raw events of the decoded spills. This is the only thread that touches the event list.
+void Unpacker::BuildSpills() {
+    PendingSpill *spill;
+    while ((spill = buildQueue_.Pop()) != NULL) {
+        if (spill->flush)
+            BuildEvents(true, spill->batch, false);
+        else if (spill->good)
+            BuildSpill(*spill, false);
+        processQueue_.Push(spill);
+    }
+    processQueue_.Push(NULL);
+}
+
+///Thread that processes the raw events of the built spills in the order they were built and returns the spill
+/// objects to ReadSpill.
+void Unpacker::ProcessSpills() {
+    PendingSpill *spill;
+    while ((spill = processQueue_.Pop()) != NULL) {
+        for (vector<BuiltEvent>::iterator it = spill->batch.events.begin(); it != spill->batch.events.end(); it++)
+            DispatchRawEvent(spill->batch, *it);
+        spill->batch.hits.clear();
+        spill->batch.events.clear();
+        if (spill->flush)
+            FinishRawEvents();
+
+        freeSpills_.Push(spill);
+        lock_guard<mutex> lock(pipelineMutex_);
+        spillsInPipeline_--;
+        pipelineIdle_.notify_all();
+    }
+}
+
 void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned int &frequency) {
     if (frequency == 0) {
         unsigned int modCounter = 0;
@@ -258,35 +638,78 @@ void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned in
     }
 }
 
+///Looks up the data mask of a module without touching mask_, so that it may be called from several threads at once.
+///@param[in] vsn : The module number.
+///@return The data mask of the module.
+XiaListModeDataMask Unpacker::GetDataMask(const unsigned int &vsn) const {
+    XiaListModeDataMask mask = mask_;
+
+    if (maskMap_.size() != 0) {
+        auto found = maskMap_.find(vsn);
+        if(found == maskMap_.end())
+            throw invalid_argument("Unpacker::GetDataMask - Unable to locate VSN = " + to_string(vsn)
+                                   + " in the maskMap. Ensure that it's defined in your configuration file!");
+        mask.SetFirmware((*found).second.first);
+        mask.SetFrequency((*found).second.second);
+    }
+
+    return mask;
+}
+
+vector<XiaListModeDataMask> Unpacker::GetDataMasks() const {
+    vector<XiaListModeDataMask> masks(MAX_PIXIE_MOD + 1);
+    for (unsigned int vsn = 0; vsn <= MAX_PIXIE_MOD; vsn++)
+        if (maskMap_.empty() || maskMap_.find(vsn) != maskMap_.end())
+            masks[vsn] = GetDataMask(vsn);
+    return masks;
+}
+
 /** ReadSpill is responsible for constructing a list of pixie16 events from
   * a raw data spill. This method performs sanity checks on the spill and
-  * calls ReadBuffer in order to construct the event list.
+  * calls ReadBuffer in order to construct the event list. When unpacking with
+  * several threads the spill is only copied into the pipeline.
   * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
   * \param[in]  nWords     The number of words in the array.
   * \param[in]  is_verbose Toggle the verbosity flag on/off.
   * \return True if the spill was read successfully and false otherwise.
   */
 bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose/*=true*/) {
-    const unsigned int maxVsn = 14; // No more than 14 pixie modules per crate
-    unsigned int nWords_read = 0;
+    if (numThreads_ > 1)
+        return QueueSpill(data, nWords, is_verbose);
 
-    int retval = 0; // return value from various functions
+    spill_.data = data;
+    spill_.nWords = nWords;
+    spill_.verbose = is_verbose;
 
-    // Various event counters
-    unsigned long numEvents = 0;
-    static int counter = 0; // the number of times this function is called
-    static int evCount;     // the number of times data is passed to ScanList
-    unsigned int lastVsn = 0xFFFFFFFF; // the last vsn read from the data
-    time_t theTime = 0;
+    if (!LocateModuleBuffers(spill_))
+        return false;
 
-    if (counter == 0)
-        maxModuleNumberInFile_ = 0;
+    spill_.decoded.resize(spill_.modules.size());
+    for (unsigned int i = 0; i < spill_.modules.size(); i++)
+        DecodeModuleBuffer(spill_, i);
 
-    counter++;
+    return BuildSpill(spill_, true);
+}
 
+/** Locate the module buffers in a spill and perform the sanity checks on it.
+  * A missing module buffer throws away the module buffers located before it.
+  * \param[in,out] spill The spill to check.
+  * \return True if the spill passed the checks and false otherwise.
+  */
+bool Unpacker::LocateModuleBuffers(PendingSpill &spill) {
+    const unsigned int maxVsn = 14; // No more than 14 pixie modules per crate
+    unsigned int *data = spill.data;
+    unsigned int nWords = spill.nWords;
+    bool is_verbose = spill.verbose;
+    unsigned int nWords_read = 0;
+
+    unsigned int lastVsn = 0xFFFFFFFF; // the last vsn read from the data
     unsigned int lenRec = 0xFFFFFFFF;
     unsigned int vsn = 0xFFFFFFFF;
-    bool fullSpill = false; // True if spill had all vsn's
+
+    spill.modules.clear();
+    spill.fullSpill = false; // True if spill had all vsn's
+    spill.wallTime = 0;
 
     // While the current location in the buffer has not gone beyond the end
     // of the buffer (ignoring the last three delimiters, continue reading
@@ -325,42 +748,19 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
                 if (is_verbose)
                     cout << "ReadSpill: MISSING BUFFER " << lastVsn + 1 << ", lastVsn = " << lastVsn << ", vsn = "
                          << vsn << ", lenrec = " << lenRec << endl;
-                ClearEventList();
-                fullSpill = false; // WHY WAS THIS TRUE!?!? CRT
+                spill.modules.clear();
+                spill.fullSpill = false; // WHY WAS THIS TRUE!?!? CRT
             }
 
-            // Read the buffer.	After read, the vector eventList will
-            //contain pointers to all channels that fired in this buffer
-            retval = ReadBuffer(&data[nWords_read], vsn);
-
-            // If the return value is less than the error code,
-            //reading the buffer failed for some reason.
-            //Print error message and reset variables if necessary
-            if (retval <= -100) {
-                if (is_verbose)
-                    cout << "ReadSpill: READOUT PROBLEM " << retval << " in event " << counter << endl;
-                if (retval == -100) {
-                    if (is_verbose)
-                        cout << "ReadSpill:  Remove list " << lastVsn << " " << vsn << endl;
-                    ClearEventList();
-                }
-                return false;
-            } else if (retval > 0) {
-                // Increment the total number of events observed
-                numEvents += retval;
-            }
+            // Remember the buffer. It is read by ReadBuffer once the whole spill was checked.
+            spill.modules.push_back(make_pair(nWords_read, vsn));
 
             // Update the variables that are keeping track of what has been
             // analyzed and increment the location in the current buffer
             lastVsn = vsn;
             nWords_read += lenRec;
         } else if (vsn == 1000) { // Buffer with vsn 1000 was inserted with the time for superheavy exp't
-            memcpy(&theTime, &data[nWords_read + 2], sizeof(time_t));
-            if (is_verbose) {
-                /*struct tm * timeinfo;
-                timeinfo = localtime (&theTime);
-                cout << "ReadSpill: Read wall clock time of " << asctime(timeinfo);*/
-            }
+            memcpy(&spill.wallTime, &data[nWords_read + 2], sizeof(time_t));
             nWords_read += lenRec;
             continue;
         } else if (vsn == 9999) {
@@ -383,51 +783,81 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
     // If the vsn is 9999 this is the end of a spill, signal this buffer
     // for processing and determine if the buffer is split between spills.
     if (vsn == 9999 || vsn == 1000) {
-        fullSpill = true;
+        spill.fullSpill = true;
         nWords_read += 2; // Skip it
-        lastVsn = 0xFFFFFFFF;
     }
 
     // Check the number of read words
     if (is_verbose && nWords_read != nWords)
         cout << "ReadSpill: Received spill of " << nWords << " words, but read " << nWords_read << " words\n";
 
-    // If there are events to process, continue
-    if (numEvents > 0) {
-        if (fullSpill) { // if full spill process events
-            // Sort the vector of pointers eventlist according to time
-            //double lastTimestamp = (*(eventList.rbegin()))->time;
+    return true;
+}
+
+/** Decode one of the module buffers located in a spill. When the last module
+  * buffer of a spill is done the thread waiting for the spill is woken up.
+  * \param[in,out] spill  The spill holding the module buffer.
+  * \param[in]     module The index of the module buffer in the spill.
+  * \return Nothing.
+  */
+void Unpacker::DecodeModuleBuffer(PendingSpill &spill, const unsigned int &module) {
+    ReadBuffer(&spill.data[spill.modules[module].first], spill.modules[module].second, spill.decoded[module]);
+
+    if (numThreads_ > 1 && --spill.remaining == 0) {
+        lock_guard<mutex> lock(pipelineMutex_);
+        spillDecoded_.notify_all();
+    }
+}
+
+/** Add the decoded hits of a spill to the event list and build them. The hits
+  * are thrown away if the spill was split between buffers.
+  * \param[in,out] spill    The decoded spill.
+  * \param[in]     dispatch True to process every raw event as soon as it is built.
+  * \return True if the spill was built and false if it was thrown away.
+  */
+bool Unpacker::BuildSpill(PendingSpill &spill, const bool &dispatch) {
+    static int evCount = 0; // the number of times data is passed to ScanList
 
-            // Sort the event list in time
-            TimeSort();
+    // Various event counters
+    unsigned long numEvents = 0;
+    for (vector<vector<XiaData *> >::iterator it = spill.decoded.begin(); it != spill.decoded.end(); it++)
+        numEvents += it->size();
 
-            // Once the vector of pointers eventlist is sorted based on time,
-            // begin the event processing in ScanList().
-            // ScanList will also clear the event list for us.
-            while (BuildRawEvent())
-                ProcessRawEvent();
+    // If there are events to process, continue
+    if (numEvents > 0) {
+        if (spill.fullSpill) { // if full spill process events
+            for (vector<vector<XiaData *> >::iterator it = spill.decoded.begin(); it != spill.decoded.end(); it++) {
+                for (vector<XiaData *>::iterator evt = it->begin(); evt != it->end(); evt++)
+                    if (!AddEvent(*evt))
+                        ReleaseEvent(*evt);
+                it->clear();
+            }
 
-            ClearEventList();
+            // Sort the event list in time and build the raw events from it. This
+            // clears the event list, except for the hits carried into the next spill.
+            BuildEvents(false, spill.batch, dispatch);
 
-            // Once the eventlist has been scanned, reset the number
-            // of events to zero and update the event counter
-            numEvents = 0;
+            // Once the eventlist has been scanned, update the event counter
             evCount++;
 
             // Every once in a while (when evcount is a multiple of 1000)
             // print the time elapsed doing the analysis
-            if ((evCount % 1000 == 0 || evCount == 1) && theTime != 0)
-                cout << endl << "ReadSpill: Data read up to poll status time " << ctime(&theTime);
+            if ((evCount % 1000 == 0 || evCount == 1) && spill.wallTime != 0)
+                cout << endl << "ReadSpill: Data read up to poll status time " << ctime(&spill.wallTime);
         } else {
-            if (is_verbose)
+            if (spill.verbose)
                 cout << "ReadSpill: Spill split between buffers" << endl;
-            ClearEventList(); // This tosses out all events read into the deque so far
+            // This tosses out all events read from the spill so far
+            for (vector<vector<XiaData *> >::iterator it = spill.decoded.begin(); it != spill.decoded.end(); it++) {
+                for (vector<XiaData *>::iterator evt = it->begin(); evt != it->end(); evt++)
+                    ReleaseEvent(*evt);
+                it->clear();
+            }
             return false;
         }
-    } else if (retval != -10) {
-        if (is_verbose)
+    } else {
+        if (spill.verbose)
             cout << "ReadSpill: bad buffer, numEvents = " << numEvents << endl;
-        ClearEventList(); // This tosses out all events read into the deque so far
         return false;
     }
 
@@ -16,8 +16,42 @@ void XiaData::Clear() {
 
     chanNum_ = crateNum_ = slotNum_ = cfdTime_ = 0;
     eventTimeHigh_ = eventTimeLow_ = externalTimeLow_ = externalTimeHigh_ = 0;
+    time_ = XiaTimestamp();
+    ticksSansCfd_ = externalTimeStamp_ = 0;
 
     eSums_.clear();
     qdc_.clear();
     trace_.clear();
-}
\ No newline at end of file
+    ClearTraceView();
+}
+
+void XiaData::AssignSansTrace(const XiaData &rhs) {
+    if (this == &rhs)
+        return;
+
+    cfdForceTrig_ = rhs.cfdForceTrig_;
+    cfdTrigSource_ = rhs.cfdTrigSource_;
+    isPileup_ = rhs.isPileup_;
+    isSaturated_ = rhs.isSaturated_;
+    isVirtualChannel_ = rhs.isVirtualChannel_;
+
+    energy_ = rhs.energy_;
+    baseline_ = rhs.baseline_;
+    time_ = rhs.time_;
+    externalTimeStamp_ = rhs.externalTimeStamp_;
+    ticksSansCfd_ = rhs.ticksSansCfd_;
+
+    cfdTime_ = rhs.cfdTime_;
+    chanNum_ = rhs.chanNum_;
+    crateNum_ = rhs.crateNum_;
+    eventTimeHigh_ = rhs.eventTimeHigh_;
+    eventTimeLow_ = rhs.eventTimeLow_;
+    externalTimeHigh_ = rhs.externalTimeHigh_;
+    externalTimeLow_ = rhs.externalTimeLow_;
+    slotNum_ = rhs.slotNum_;
+
+    eSums_.assign(rhs.eSums_.begin(), rhs.eSums_.end());
+    qdc_.assign(rhs.qdc_.begin(), rhs.qdc_.end());
+    trace_.clear();
+    ClearTraceView();
+}
@@ -0,0 +1,55 @@
+///@file XiaDataPool.cpp
+///@brief A recycling pool of XiaData objects used to decode spills without
+/// going through the allocator for every hit.
+///@date October 17, 2026
+#include "XiaData.hpp"
+#include "XiaDataPool.hpp"
+
+using namespace std;
+
+XiaDataPool::~XiaDataPool() {
+    for (vector<XiaData *>::iterator it = storage_.begin(); it != storage_.end(); it++)
+        delete *it;
+}
+
+XiaData *XiaDataPool::Acquire() {
+    if (threadSafe_) {
+        lock_guard<mutex> lock(mutex_);
+        return AcquireUnlocked();
+    }
+    return AcquireUnlocked();
+}
+
+XiaData *XiaDataPool::AcquireUnlocked() {
+    if (free_.empty())
+        Reserve((unsigned int) (storage_.empty() ? 1024 : 2 * storage_.size()));
+
+    XiaData *data = free_.back();
+    free_.pop_back();
+    return data;
+}
+
+///The free list always has enough capacity to hold every object in the pool
+/// so releasing never needs to allocate.
+void XiaDataPool::Release(XiaData *data) {
+    if (!data)
+        return;
+    data->Clear();
+    if (threadSafe_) {
+        lock_guard<mutex> lock(mutex_);
+        free_.push_back(data);
+    } else
+        free_.push_back(data);
+}
+
+void XiaDataPool::Reserve(const unsigned int &size) {
+    if (size <= storage_.size())
+        return;
+
+    storage_.reserve(size);
+    free_.reserve(size);
+    while (storage_.size() < size) {
+        storage_.push_back(new XiaData());
+        free_.push_back(storage_.back());
+    }
+}
@@ -3,6 +3,7 @@
 /// modules.
 /// @author S. V. Paulauskas
 /// @date December 23, 2016
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -18,9 +19,23 @@ using namespace std;
 using namespace DataProcessing;
 
 vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask) {
+    vector<XiaData *> events;
+    DecodeModuleBuffer(buf, mask, NULL, events);
+    return events;
+}
 
-    unsigned int *bufStart = buf;
+unsigned int XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask,
+                                                  XiaDataPool &pool, std::vector<XiaData *> &events) {
+    return DecodeModuleBuffer(buf, mask, &pool, events);
+}
 
+///When a pool is provided the XiaData objects come from the pool and the
+/// traces are left in the buffer as views. Otherwise every event is allocated
+/// and owns a copy of its trace. If any event in the buffer cannot be decoded
+/// we discard everything that we decoded from this buffer.
+unsigned int XiaListModeDataDecoder::DecodeModuleBuffer(unsigned int *buf, const XiaListModeDataMask &mask,
+                                                        XiaDataPool *pool, std::vector<XiaData *> &events) {
+    unsigned int *bufStart = buf;
 
     ///@NOTE : These two pieces here are the Pixie Module Data Header. They
     /// tell us the number of words read from the module (bufLen) and the VSN
@@ -32,194 +47,168 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
     if (bufLen == 0)
         throw length_error("Unpacker::ReadBuffer - The buffer length was sized 0. This is a huge issue.");
 
-    //For empty buffers we just return an empty vector.
+    //For empty buffers we just return without adding any events.
     static const unsigned int emptyBufferLength = 2;
     if (bufLen == emptyBufferLength)
-        return vector<XiaData *>();
+        return 0;
 
-    stringstream msg;
-    vector<XiaData *> events;
-    static unsigned int numSkippedBuffers = 0;
+    size_t firstEvent = events.size();
 
+    while (buf < bufStart + bufLen) {
+        XiaData *data = pool ? pool->Acquire() : new XiaData();
+        bool isStatsBlock = false;
 
+        unsigned int eventLength = DecodeEvent(buf, *data, isStatsBlock, mask, pool != NULL, modNum, bufLen);
 
-    while (buf < bufStart + bufLen) {
-        XiaData *data = new XiaData();
-        bool hasExternalTimestamp = false;
-        bool hasQdc = false;
-        bool hasEnergySums = false;
-
-
-        pair<unsigned int, unsigned int> lengths =
-                DecodeWordZero(buf[0], *data, mask);
-        unsigned int headerLength = lengths.first;
-        unsigned int eventLength = lengths.second;
-
-        data->SetEventTimeLow(buf[1]);
-        DecodeWordTwo(buf[2], *data, mask);
-        unsigned int traceLength = DecodeWordThree(buf[3], *data, mask);
-
-        // We check the header length here to set the appropriate flags for
-        // processing the rest of the header words. If we encounter a header
-        // length that we do not know we will throw an error as this
-        // generally indicates an issue with the data file or processing at a
-        // higher level.
-        switch (headerLength) {
-            case STATS_BLOCK : // Manual statistics block inserted by poll
-                // this is a manual statistics block inserted by the poll program
-                //stats.DoStatisticsBlock(&buf[1], modNum);
-                buf += eventLength;
-                //numEvents = -10;
-                continue;
-            case HEADER :
-                break;
-            case HEADER_W_ETS :
-                hasExternalTimestamp = true;
-                break;
-            case HEADER_W_QDC :
-                hasQdc = true;
-                break;
-            case HEADER_W_ESUM :
-                hasEnergySums = true;
-                break;
-            case HEADER_W_ESUM_ETS :
-                hasExternalTimestamp = hasEnergySums = true;
-                break;
-            case HEADER_W_ESUM_QDC :
-                hasEnergySums = hasQdc = true;
-                break;
-            case HEADER_W_ESUM_QDC_ETS :
-                hasEnergySums = hasExternalTimestamp = hasQdc = true;
-                break;
-            case HEADER_W_QDC_ETS :
-                hasQdc = hasExternalTimestamp = true;
-                break;
-            default:
-                numSkippedBuffers++;
-                cerr << "XiaListModeDataDecoder::ReadBuffer : We encountered "
-                        "an unrecognized header length (" << headerLength
-                     << "). " << endl
-                     << "Skipped " << numSkippedBuffers
-                     << " buffers in the file." << endl
-                     << "Unexpected header length: " << headerLength << endl
-                     << "ReadBuffer:   Buffer " << modNum << " of length "
-                     << bufLen << endl
-                     << "ReadBuffer:   CRATE:SLOT(MOD):CHAN "
-                     << data->GetCrateNumber() << ":"
-                     << data->GetSlotNumber() << "(" << modNum << "):"
-                     << data->GetChannelNumber() << endl;
-                return vector<XiaData *>();
+        if (eventLength == 0 || isStatsBlock) {
+            if (pool)
+                pool->Release(data);
+            else
+                delete data;
         }
 
-
-        if (hasQdc) {
-            static const unsigned int numQdcs = 8;
-            vector<unsigned int> tmp;
-            unsigned int offset = headerLength - numQdcs;
-            for (unsigned int i = 0; i < numQdcs; i++) {
-                tmp.push_back(buf[offset + i]);
+        if (eventLength == 0) {
+            for (size_t i = firstEvent; i < events.size(); i++) {
+                if (pool)
+                    pool->Release(events[i]);
+                else
+                    delete events[i];
             }
-            data->SetQdc(tmp);
+            events.resize(firstEvent);
+            return 0;
         }
 
+        buf += eventLength;
 
-        // printf("bufLen %u \n", bufLen);
-        // printf("headerLength %u \n", headerLength);
-
-        if (hasExternalTimestamp) {
-          /// set least significant 32 bits of 48 bit external time stamp
-
-          // data->SetExternalTimeLow(buf[4]);
-          data->SetExternalTimeLow(buf[headerLength-2]);
-          /// set most significant 16 bits of 48 bit external time stamp
-          // if (buf[headerLength-2]!=buf[4])
-          // {
-          //   printf("\n");
-          //   printf("headerLength-2  = %u \n", headerLength-2);
-          //   printf("SetExternalTimeLow %u \n", buf[headerLength-2]);
-          //   printf("SetExternalTimeLow %u \n", buf[4]);
-          // }
-
-          // data->SetExternalTimeHigh(DecodeExternalTimeHigh(buf[5], *data, mask));
-          data->SetExternalTimeHigh(DecodeExternalTimeHigh(buf[headerLength-1], *data, mask));
-          /// stores 48 bit external time stamp as an XiaData member -> double externalTimeStamp_
-          // if (buf[headerLength-1]!=buf[5])
-          // {
-          //   printf("\n");
-          //   printf("headerLength-1  = %u \n", headerLength-1);
-          //   printf("SetExternalTimeHigh %u \n", buf[headerLength-1]);
-          //   printf("SetExternalTimeHigh %u \n", buf[5]);
-          // }
-
-        //   printf("\n");
-        //   printf("header length (1 counting) = %u \n", headerLength);
-        //   printf("ETS Word1 (Last Buf Word - 1;ETS_low) = %u \n", buf[headerLength - 2]);
-        //   cout << "ETS Word1 Binary= " << std::bitset<32>(buf[headerLength - 2]) << endl
-        //        << endl;
-
-        //   if (data->GetExternalTimeLow() > 4000000000) {
-        //       cout << "Approching UInt max" << endl
-        //            << endl;
-        //   }
-
-        //   printf("ETS Word2 (Last Buf Word; CCI_ETS_HIGH)=                    %u \n", buf[headerLength - 1]);
-        //   cout << "ETS Word2 Binary= " << std::bitset<32>(buf[headerLength - 1]) << endl<<endl;
-
-        //   printf("Header Word4 (Trace ORF, Trace Len, EVT En)= %u \n", buf[headerLength - 3]);
-        //   cout << "Header Word4 Binary= " << std::bitset<32>(buf[headerLength - 3]) << endl;
-
-        //   printf("\n");
-
-          data->SetExternalTimeStamp(CalculateExternalTimeStamp(*data));
-          if(headerLength);
-          // printf("headerLength %u, ", headerLength);
-          // printf("ExternalTimeHigh %u,", data->GetExternalTimeHigh());
-          // printf("ExternalTimeLow %u,", data->GetExternalTimeLow());
-          // printf("ExternalTimeStamp %llu \n", data->GetExternalTimeStamp());
+        if (!isStatsBlock)
+            events.push_back(data);
+    }// while(buf < bufStart + bufLen)
 
-        }
+    return (unsigned int) (events.size() - firstEvent);
+}
 
-        if (hasEnergySums) {
-            // Skip the onboard partial sums for now
-            // trailing, leading, gap, baseline
-        }
+unsigned int XiaListModeDataDecoder::DecodeEvent(unsigned int *buf, XiaData &data, bool &isStatsBlock,
+                                                 const XiaListModeDataMask &mask, const bool &useTraceView,
+                                                 const unsigned int &modNum, const unsigned int &bufLen) {
+    static atomic<unsigned int> numSkippedBuffers(0);
+    bool hasExternalTimestamp = false;
+    bool hasQdc = false;
+    bool hasEnergySums = false;
+
+    pair<unsigned int, unsigned int> lengths = DecodeWordZero(buf[0], data, mask);
+    unsigned int headerLength = lengths.first;
+    unsigned int eventLength = lengths.second;
+
+    data.SetEventTimeLow(buf[1]);
+    DecodeWordTwo(buf[2], data, mask);
+    unsigned int traceLength = DecodeWordThree(buf[3], data, mask);
+
+    // We check the header length here to set the appropriate flags for
+    // processing the rest of the header words. If we encounter a header
+    // length that we do not know we will throw an error as this
+    // generally indicates an issue with the data file or processing at a
+    // higher level.
+    switch (headerLength) {
+        case STATS_BLOCK : // Manual statistics block inserted by poll
+            // this is a manual statistics block inserted by the poll program
+            //stats.DoStatisticsBlock(&buf[1], modNum);
+            isStatsBlock = true;
+            return eventLength;
+        case HEADER :
+            break;
+        case HEADER_W_ETS :
+            hasExternalTimestamp = true;
+            break;
+        case HEADER_W_QDC :
+            hasQdc = true;
+            break;
+        case HEADER_W_ESUM :
+            hasEnergySums = true;
+            break;
+        case HEADER_W_ESUM_ETS :
+            hasExternalTimestamp = hasEnergySums = true;
+            break;
+        case HEADER_W_ESUM_QDC :
+            hasEnergySums = hasQdc = true;
+            break;
+        case HEADER_W_ESUM_QDC_ETS :
+            hasEnergySums = hasExternalTimestamp = hasQdc = true;
+            break;
+        case HEADER_W_QDC_ETS :
+            hasQdc = hasExternalTimestamp = true;
+            break;
+        default:
+            numSkippedBuffers++;
+            cerr << "XiaListModeDataDecoder::ReadBuffer : We encountered "
+                    "an unrecognized header length (" << headerLength
+                 << "). " << endl
+                 << "Skipped " << numSkippedBuffers
+                 << " buffers in the file." << endl
+                 << "Unexpected header length: " << headerLength << endl
+                 << "ReadBuffer:   Buffer " << modNum << " of length "
+                 << bufLen << endl
+                 << "ReadBuffer:   CRATE:SLOT(MOD):CHAN "
+                 << data.GetCrateNumber() << ":"
+                 << data.GetSlotNumber() << "(" << modNum << "):"
+                 << data.GetChannelNumber() << endl;
+            return 0;
+    }
 
+    if (hasQdc) {
+        static const unsigned int numQdcs = 8;
+        unsigned int offset = headerLength - numQdcs;
+        data.SetQdc(&buf[offset], &buf[offset + numQdcs]);
+    }
 
-        ///@TODO Figure out where to put this...
-        //channel_counts[modNum][chanNum]++;
+    if (hasExternalTimestamp) {
+        /// set least significant 32 bits of 48 bit external time stamp
+        data.SetExternalTimeLow(buf[headerLength - 2]);
+        /// set most significant 16 bits of 48 bit external time stamp
+        data.SetExternalTimeHigh(DecodeExternalTimeHigh(buf[headerLength - 1], data, mask));
+        /// stores 48 bit external time stamp as an XiaData member
+        data.SetExternalTimeStamp(CalculateExternalTimeStamp(data));
+    }
 
-        ///@TODO This needs to be revised to take into account the bit
-        /// resolution of the modules. I've currently set it to 10 more than maximum
-        /// bit resolution of any module (16-bit).
-        if (data->IsSaturated())
-            data->SetEnergy(65546);
+    if (hasEnergySums) {
+        // Skip the onboard partial sums for now
+        // trailing, leading, gap, baseline
+    }
 
-        //We set the time according to the revision and firmware.
-        pair<double, double> times = CalculateTimeInSamples(mask, *data);
-        data->SetTimeSansCfd(times.first);
-        data->SetTime(times.second);
+    ///@TODO Figure out where to put this...
+    //channel_counts[modNum][chanNum]++;
+
+    ///@TODO This needs to be revised to take into account the bit
+    /// resolution of the modules. I've currently set it to 10 more than maximum
+    /// bit resolution of any module (16-bit).
+    if (data.IsSaturated())
+        data.SetEnergy(65546);
+
+    //We set the time according to the revision and firmware.
+    pair<unsigned long long, XiaTimestamp> times = CalculateTimestamp(mask, data);
+    data.SetTicksSansCfd(times.first);
+    data.SetTimestamp(times.second);
+
+    // One last check to ensure event length matches what we think it
+    // should be.
+    if (traceLength / 2 + headerLength != eventLength) {
+        numSkippedBuffers++;
+        cerr << "XiaListModeDataDecoder::ReadBuffer : Event"
+                "length (" << eventLength << ") does not correspond to "
+                     "header length (" << headerLength
+             << ") and trace length ("
+             << traceLength / 2 << "). Skipped a total of "
+             << numSkippedBuffers << " buffers in this file." << endl;
+        return 0;
+    }
 
-        // One last check to ensure event length matches what we think it
-        // should be.
-        if (traceLength / 2 + headerLength != eventLength) {
-            numSkippedBuffers++;
-            cerr << "XiaListModeDataDecoder::ReadBuffer : Event"
-                    "length (" << eventLength << ") does not correspond to "
-                         "header length (" << headerLength
-                 << ") and trace length ("
-                 << traceLength / 2 << "). Skipped a total of "
-                 << numSkippedBuffers << " buffers in this file." << endl;
-            return vector<XiaData *>();
-        } else //Advance the buffer past the header and to the trace
-            buf += headerLength;
-
-        if (traceLength > 0) {
-            DecodeTrace(buf, *data, traceLength);
-            buf += traceLength / 2;
-        }
-        events.push_back(data);
-    }// while(buf < bufStart + bufLen)
-    return events;
+    if (traceLength > 0) {
+        if (useTraceView)
+            data.SetTraceView(&buf[headerLength], traceLength);
+        else
+            DecodeTrace(&buf[headerLength], data, traceLength);
+    }
+
+    return eventLength;
 }
 
 std::pair<unsigned int, unsigned int> XiaListModeDataDecoder::DecodeWordZero(const unsigned int &word, XiaData &data,
@@ -282,43 +271,51 @@ unsigned int XiaListModeDataDecoder::DecodeWordThree(const unsigned int &word, X
 }
 
 void XiaListModeDataDecoder::DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength) {
-    vector<unsigned int> tmp;
-    // sbuf points to the beginning of trace data
-    unsigned short *sbuf = (unsigned short *) buf;
-
     // Read the trace data (2-bytes per sample, i.e. 2 samples per word)
-    for (unsigned int k = 0; k < traceLength; k++)
-        tmp.push_back((unsigned int &&) sbuf[k]);
-
+    vector<unsigned int> tmp;
+    XiaData::UnpackTrace(buf, traceLength, tmp);
     data.SetTrace(tmp);
 }
 
 pair<double, double> XiaListModeDataDecoder::CalculateTimeInSamples(const XiaListModeDataMask &mask,
                                                                     const XiaData &data) {
-    double filterTime = data.GetEventTimeLow() + data.GetEventTimeHigh() * pow(2., 32);
+    pair<unsigned long long, XiaTimestamp> times = CalculateTimestamp(mask, data);
+    return make_pair((double) times.first, times.second.ToDouble());
+}
+
+pair<unsigned long long, XiaTimestamp> XiaListModeDataDecoder::CalculateTimestamp(const XiaListModeDataMask &mask,
+                                                                                 const XiaData &data) {
+    unsigned long long filterTime = (unsigned long long) data.GetEventTimeHigh() << 32 | data.GetEventTimeLow();
+
+    //The CFD sizes are powers of two, so the fractional time is an exact number of timestamp fractions.
+    unsigned int cfdSize = (unsigned int) mask.GetCfdSize();
+    long long scale = cfdSize != 0 ? XiaTimestamp::FRACTION_SCALE / cfdSize : 0;
+    long long one = XiaTimestamp::FRACTION_SCALE;
 
-    double cfdTime = 0, multiplier = 1;
+    long long cfdTime = 0;
+    unsigned long long multiplier = 1;
     if (mask.GetFrequency() == 100)
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize();
+        cfdTime = data.GetCfdFractionalTime() * scale;
 
     if (mask.GetFrequency() == 250) {
         multiplier = 2;
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize() - data.GetCfdTriggerSourceBit();
+        cfdTime = data.GetCfdFractionalTime() * scale - data.GetCfdTriggerSourceBit() * one;
         }
 
     if (mask.GetFrequency() == 500) {
         multiplier = 10; // This appears to be wrong based on the documentation in V3.07 of the Pixie Manual (T.T. King Feb,7 2019)
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize() + data.GetCfdTriggerSourceBit() - 1; 
+        cfdTime = data.GetCfdFractionalTime() * scale + (data.GetCfdTriggerSourceBit() - 1) * one;
         //From the Pixie Manual v 3.07 it seems that the 500Mhz has 4 interlaced ADCs so its list mode has a 2bit CfdTriggerSource.
         //These methods will need to be updated to account for this, and soon. (T.T. King Feb,7 2019)
     }
     
     //Moved here so we can use the multiplier to adjust the clock tick units. So GetTime() returns the ADC ticks and GetTimeSansCfd() returns Filter Ticks
     //(For 250MHZ) This way GetTime() always returns 4ns clock ticks, and GetTimeSansCfd() returns the normal 8ns ticks  
+    XiaTimestamp time(filterTime * multiplier);
     if (data.GetCfdFractionalTime() == 0 || data.GetCfdForcedTriggerBit())
-        return make_pair(filterTime, filterTime * multiplier);
-    
-    return make_pair(filterTime, filterTime * multiplier + cfdTime);
+        return make_pair(filterTime, time);
+
+    return make_pair(filterTime, time.Shift(cfdTime));
 }
 
 double XiaListModeDataDecoder::CalculateTimeInNs(const XiaListModeDataMask &mask, const XiaData &data) {
@@ -0,0 +1,56 @@
+///@file unittest-BoundedQueue.cpp
+///@brief A program that will execute unit tests on BoundedQueue
+///@date October 17, 2026
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "BoundedQueue.hpp"
+
+using namespace std;
+
+TEST(Test_FirstInFirstOut) {
+    BoundedQueue<int> queue(3);
+    queue.Push(1);
+    queue.Push(2);
+    queue.Push(3);
+    CHECK_EQUAL((size_t) 3, queue.GetSize());
+    CHECK_EQUAL(1, queue.Pop());
+    CHECK_EQUAL(2, queue.Pop());
+    CHECK_EQUAL(3, queue.Pop());
+
+    int item = 0;
+    CHECK(!queue.TryPop(item));
+    queue.Push(4);
+    CHECK(queue.TryPop(item));
+    CHECK_EQUAL(4, item);
+}
+
+///Push far more items than fit in the queue from one thread and check that
+/// the consumer receives all of them in order.
+TEST(Test_BackPressure) {
+    BoundedQueue<int> queue(2);
+    const int numItems = 10000;
+
+    thread producer([&queue, numItems]() {
+        for (int i = 0; i < numItems; i++)
+            queue.Push(i);
+    });
+
+    vector<int> received;
+    for (int i = 0; i < numItems; i++) {
+        CHECK(queue.GetSize() <= queue.GetCapacity());
+        received.push_back(queue.Pop());
+    }
+    producer.join();
+
+    bool inOrder = true;
+    for (int i = 0; i < numItems; i++)
+        inOrder &= received[i] == i;
+    CHECK(inOrder);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
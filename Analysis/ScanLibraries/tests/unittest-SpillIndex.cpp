@@ -0,0 +1,155 @@
+///@file unittest-SpillIndex.cpp
+///@brief A program that will execute unit tests on SpillIndex
+///@date October 17, 2026
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "SpillIndex.hpp"
+
+using namespace std;
+using namespace DataProcessing;
+
+namespace {
+    ///Appends a four word header without a trace to a module buffer.
+    void AddEvent(vector<unsigned int> &spill, const unsigned int &channel, const unsigned long long &time) {
+        spill.push_back(channel | (HEADER << 12) | (4 << 17));
+        spill.push_back((unsigned int) (time & 0xFFFFFFFF));
+        spill.push_back((unsigned int) (time >> 32));
+        spill.push_back(1000);
+    }
+
+    SpillIndexEntry MakeEntry(const unsigned long long &offset, const unsigned int &nWords,
+                              const unsigned long long &first, const unsigned long long &last) {
+        SpillIndexEntry entry;
+        entry.offset = offset;
+        entry.nWords = nWords;
+        entry.moduleMask = 1;
+        entry.firstTime = first;
+        entry.lastTime = last;
+        entry.good = true;
+        return entry;
+    }
+}
+
+///Build a spill with an empty module 0, two events in module 1 and a
+/// statistics block in module 2, and check the times and modules found.
+TEST(Test_Summarize) {
+    vector<unsigned int> spill;
+    spill.push_back(2);
+    spill.push_back(0);
+
+    spill.push_back(10);
+    spill.push_back(1);
+    AddEvent(spill, 3, 0x100000005ull);
+    AddEvent(spill, 4, 0x000000007ull);
+
+    spill.push_back(6);
+    spill.push_back(2);
+    spill.push_back(STATS_BLOCK << 12 | 4 << 17);
+    spill.push_back(1);
+    spill.push_back(2);
+    spill.push_back(3);
+
+    spill.push_back(2);
+    spill.push_back(9999);
+
+    vector<XiaListModeDataMask> masks(3, XiaListModeDataMask("R30474", 250));
+    SpillIndexEntry entry = MakeEntry(0, 0, 0, 0);
+    SpillIndex::Summarize(spill.data(), (unsigned int) spill.size(), masks, entry);
+
+    CHECK_EQUAL(0x2u, entry.moduleMask);
+    CHECK_EQUAL(0x000000007ull, entry.firstTime);
+    CHECK_EQUAL(0x100000005ull, entry.lastTime);
+
+    //A module without a known firmware is only marked as present.
+    masks[1] = XiaListModeDataMask();
+    SpillIndex::Summarize(spill.data(), (unsigned int) spill.size(), masks, entry);
+    CHECK_EQUAL(0x2u, entry.moduleMask);
+    CHECK_EQUAL(0ull, entry.firstTime);
+    CHECK_EQUAL(0ull, entry.lastTime);
+}
+
+TEST(Test_FindTime) {
+    SpillIndex index;
+    index.Add(MakeEntry(0, 10, 0, 100));
+    index.Add(MakeEntry(40, 10, 101, 200));
+    SpillIndexEntry bad = MakeEntry(80, 10, 0, 0);
+    bad.good = false;
+    index.Add(bad);
+    index.Add(MakeEntry(120, 10, 201, 300));
+
+    CHECK_EQUAL((size_t) 0, index.FindTime(50));
+    CHECK_EQUAL((size_t) 1, index.FindTime(200));
+    CHECK_EQUAL((size_t) 3, index.FindTime(201));
+    CHECK_EQUAL((size_t) 4, index.FindTime(301));
+
+    CHECK_THROW(index.GetSpill(4), out_of_range);
+}
+
+///Check that the ranges cover every spill exactly once and split the words
+/// evenly.
+TEST(Test_Partition) {
+    SpillIndex index;
+    CHECK(index.Partition(3).empty());
+
+    for (unsigned int i = 0; i < 6; i++)
+        index.Add(MakeEntry(i * 40, 10, i, i));
+
+    vector<pair<size_t, size_t> > ranges = index.Partition(3);
+    CHECK_EQUAL((size_t) 3, ranges.size());
+    CHECK_EQUAL((size_t) 0, ranges[0].first);
+    CHECK_EQUAL((size_t) 1, ranges[0].second);
+    CHECK_EQUAL((size_t) 2, ranges[1].first);
+    CHECK_EQUAL((size_t) 3, ranges[1].second);
+    CHECK_EQUAL((size_t) 4, ranges[2].first);
+    CHECK_EQUAL((size_t) 5, ranges[2].second);
+
+    //One big spill at the front still leaves a spill for every range.
+    SpillIndex uneven;
+    uneven.Add(MakeEntry(0, 1000, 0, 0));
+    uneven.Add(MakeEntry(4000, 10, 0, 0));
+    uneven.Add(MakeEntry(4040, 10, 0, 0));
+    ranges = uneven.Partition(3);
+    CHECK_EQUAL((size_t) 3, ranges.size());
+    CHECK_EQUAL((size_t) 0, ranges[0].second);
+    CHECK_EQUAL((size_t) 1, ranges[1].second);
+    CHECK_EQUAL((size_t) 2, ranges[2].second);
+
+    //There cannot be more ranges than spills.
+    CHECK_EQUAL((size_t) 3, uneven.Partition(5).size());
+}
+
+TEST(Test_ReadWrite) {
+    SpillIndex index;
+    index.SetFileLength(123456);
+    index.Add(MakeEntry(0, 10, 5, 0x1FFFFFFFFFFFull));
+    SpillIndexEntry bad = MakeEntry(40, 20, 0, 0);
+    bad.good = false;
+    bad.moduleMask = 0x1004;
+    index.Add(bad);
+
+    const string filename = "unittest-SpillIndex.idx";
+    CHECK(index.Write(filename));
+
+    SpillIndex read;
+    CHECK(read.Read(filename));
+    remove(filename.c_str());
+
+    CHECK_EQUAL(123456ull, read.GetFileLength());
+    CHECK_EQUAL((size_t) 2, read.GetNumSpills());
+    CHECK_EQUAL(0x1FFFFFFFFFFFull, read.GetSpill(0).lastTime);
+    CHECK(read.GetSpill(0).good);
+    CHECK_EQUAL(40ull, read.GetSpill(1).offset);
+    CHECK_EQUAL(20u, read.GetSpill(1).nWords);
+    CHECK_EQUAL(0x1004u, read.GetSpill(1).moduleMask);
+    CHECK(!read.GetSpill(1).good);
+
+    CHECK(!read.Read("a-file-that-does-not-exist.idx"));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
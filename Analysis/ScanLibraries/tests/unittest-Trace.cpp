@@ -61,19 +61,19 @@ GetWaveformRange()
 
 .second);
 
-SetTraceSansBaseline(trace_sans_baseline);
-CHECK_ARRAY_EQUAL(trace_sans_baseline, GetTraceSansBaseline(),
+assign(trace.begin(), trace.end());
+CHECK_ARRAY_CLOSE(trace_sans_baseline, GetTraceSansBaseline(),
         trace_sans_baseline
 .
 
-size()
+size(), 0.01
 
 );
 
-CHECK_ARRAY_EQUAL(waveform, GetWaveform(), waveform
+CHECK_ARRAY_CLOSE(waveform, GetWaveform(), waveform
 .
 
-size()
+size(), 0.01
 
 );
 
@@ -125,6 +125,76 @@ CHECK_EQUAL(double_input, GetTau()
 );
 }
 
+TEST_FIXTURE(Trace, TestingLazyProducts) {
+    assign(trace.begin(), trace.end());
+    CHECK_EQUAL(trace.size(), size());
+    vector<unsigned int> samples = *this;
+    CHECK_ARRAY_EQUAL(trace, samples, trace.size());
+
+    //Nothing has been analyzed yet, so there is no baseline to subtract.
+    CHECK(GetTraceSansBaseline().empty());
+    CHECK(GetWaveform().empty());
+
+    SetBaseline(baseline_pair);
+    CHECK_EQUAL(trace[10] - baseline_pair.first, GetTraceSansBaseline()[10]);
+
+    SetWaveformRange(waveform_range);
+    CHECK_EQUAL(waveform_range.second - waveform_range.first, GetWaveform().size());
+    CHECK_EQUAL(trace[waveform_range.first] - baseline_pair.first, GetWaveform()[0]);
+
+    SetBaseline(make_pair(400., 1.));
+    CHECK_EQUAL(trace[waveform_range.first] - 400., GetWaveform()[0]);
+    CHECK_EQUAL(trace[10] - 400., GetTraceSansBaseline()[10]);
+
+    //Changing the samples through the vector interface computes the products again.
+    (*this)[10] += 5;
+    CHECK_EQUAL(trace[10] + 5 - 400., GetTraceSansBaseline()[10]);
+    push_back(1000);
+    CHECK_EQUAL(trace.size() + 1, GetTraceSansBaseline().size());
+    CHECK_EQUAL(600., GetTraceSansBaseline().back());
+    assign(trace.begin(), trace.end());
+    CHECK_EQUAL(trace.size(), GetTraceSansBaseline().size());
+    CHECK_EQUAL(trace[10] - 400., GetTraceSansBaseline()[10]);
+    *(begin() + waveform_range.first) = 500;
+    CHECK_EQUAL(100., GetWaveform()[0]);
+}
+
+TEST_FIXTURE(Trace, TestingAssign) {
+    Assign(trace);
+    SetBaseline(baseline_pair);
+    SetPhase(100.);
+    SetTriggerFilter(vector<double>(10, 1.));
+    CHECK(!GetTraceSansBaseline().empty());
+    const unsigned short *storage = &(*this)[0];
+
+    //Assigning new samples forgets the analysis but keeps the storage.
+    vector<unsigned short> samples(trace.begin(), trace.end());
+    samples.resize(samples.size() / 2);
+    Assign(&samples[0], samples.size());
+    CHECK_EQUAL(samples.size(), size());
+    CHECK_ARRAY_EQUAL(samples, *this, samples.size());
+    CHECK_EQUAL(storage, &(*this)[0]);
+    CHECK_EQUAL(0.0, GetPhase());
+    CHECK_EQUAL(0.0, GetBaselineInfo().first);
+    CHECK(GetTriggerFilter().empty());
+    CHECK(GetTraceSansBaseline().empty());
+
+    //Packed words hold two samples each, the earlier one in the low 16 bits.
+    vector<unsigned int> words((samples.size() + 1) / 2, 0);
+    for (unsigned int k = 0; k < samples.size(); k++)
+        words[k / 2] |= (unsigned int) samples[k] << (16 * (k % 2));
+    AssignPacked(&words[0], samples.size());
+    CHECK_ARRAY_EQUAL(samples, *this, samples.size());
+
+    //Samples that do not fit in 16 bits are clamped.
+    vector<unsigned int> wide(3, 5);
+    wide[1] = 70000;
+    Assign(wide);
+    CHECK_EQUAL(65535, (*this)[1]);
+    CHECK_EQUAL(5, (*this)[2]);
+    CHECK_EQUAL(65535, Trace(wide)[1]);
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
\ No newline at end of file
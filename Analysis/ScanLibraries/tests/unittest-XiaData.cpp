@@ -227,6 +227,46 @@ TEST(Test_LessThanOperator) {
         CHECK(lhs < rhs);
 }
 
+TEST(Test_TraceView) {
+        //Two samples per word, the earlier one in the low 16 bits.
+        vector<unsigned int> samples((trace.size() + 1) / 2, 0);
+        for (unsigned int k = 0; k < trace.size(); k++)
+            samples[k / 2] |= trace[k] << (16 * (k % 2));
+        lhs.Clear();
+        lhs.SetTraceView(&samples[0], (unsigned int) trace.size());
+        CHECK(lhs.HasTraceView());
+        CHECK_EQUAL(trace.size(), lhs.GetTraceLength());
+        CHECK_ARRAY_EQUAL(trace, lhs.GetTrace(), trace.size());
+
+        lhs.DetachTrace();
+        samples.assign(samples.size(), 0);
+        CHECK(!lhs.HasTraceView());
+        CHECK_ARRAY_EQUAL(trace, lhs.GetTrace(), trace.size());
+
+        lhs.Clear();
+        CHECK_EQUAL((unsigned int) 0, lhs.GetTraceLength());
+}
+
+TEST(Test_AssignSansTrace) {
+        lhs.Clear();
+        lhs.SetEnergy(energy);
+        lhs.SetTime(ts);
+        lhs.SetChannelNumber(3);
+        lhs.SetSlotNumber(slotId);
+        lhs.SetQdc(qdc);
+        lhs.SetTrace(trace);
+
+        rhs.Clear();
+        rhs.SetTrace(trace);
+        rhs.AssignSansTrace(lhs);
+        CHECK(lhs == rhs);
+        CHECK_EQUAL(energy, rhs.GetEnergy());
+        CHECK_ARRAY_EQUAL(qdc, rhs.GetQdc(), qdc.size());
+        CHECK_EQUAL((unsigned int) 0, rhs.GetTraceLength());
+        CHECK(rhs.GetOwnedTrace().empty());
+        CHECK_EQUAL(trace.size(), lhs.GetOwnedTrace().size());
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
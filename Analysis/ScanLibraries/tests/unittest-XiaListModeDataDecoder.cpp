@@ -151,6 +151,33 @@ GetTime(),
 1e-5);
 }
 
+//Test that decoding into a pool gives the same results as the allocating
+// decoder and leaves the trace in the buffer.
+TEST_FIXTURE(XiaListModeDataDecoder, TestPooledDecoding) {
+    XiaDataPool pool;
+    vector<XiaData *> events;
+
+    CHECK_EQUAL((unsigned int) 1, DecodeBuffer(&header_N_trace[0], mask, pool, events));
+    CHECK_EQUAL((unsigned int) 1, pool.GetNumberInUse());
+    CHECK(events.front()->HasTraceView());
+    CHECK_EQUAL(unittest_trace_variables::trace.size(), events.front()->GetTraceLength());
+    CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, events.front()->GetTrace(),
+                      unittest_trace_variables::trace.size());
+
+    //A corrupt buffer hands its events back to the pool.
+    CHECK_EQUAL((unsigned int) 0, DecodeBuffer(&header_w_bad_eventlen[0], mask, pool, events));
+    CHECK_EQUAL((unsigned int) 1, events.size());
+    CHECK_EQUAL((unsigned int) 1, pool.GetNumberInUse());
+
+    //Released objects are recycled instead of growing the pool.
+    unsigned int capacity = pool.GetCapacity();
+    pool.Release(events.front());
+    events.clear();
+    DecodeBuffer(&header_N_qdc[0], mask, pool, events);
+    CHECK_EQUAL(capacity, pool.GetCapacity());
+    CHECK(!events.front()->HasTraceView());
+    CHECK_ARRAY_EQUAL(qdc, events.front()->GetQdc(), qdc.size());
+}
 
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
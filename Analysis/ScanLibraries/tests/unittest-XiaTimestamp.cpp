@@ -0,0 +1,53 @@
+///@file unittest-XiaTimestamp.cpp
+///@brief A program that will execute unit tests on XiaTimestamp
+///@date October 17, 2026
+#include <UnitTest++.h>
+
+#include "XiaTimestamp.hpp"
+
+TEST(Test_CarryAndOrdering) {
+    XiaTimestamp time(10, XiaTimestamp::FRACTION_SCALE + 5);
+    CHECK_EQUAL(11ull, time.GetTicks());
+    CHECK_EQUAL(5u, time.GetFraction());
+
+    CHECK(XiaTimestamp(10, 5) < XiaTimestamp(10, 6));
+    CHECK(XiaTimestamp(10, 65535) < XiaTimestamp(11));
+    CHECK(XiaTimestamp(11) > XiaTimestamp(10, 65535));
+    CHECK(XiaTimestamp(10, 5) <= XiaTimestamp(10, 5));
+    CHECK(XiaTimestamp(10, 5) == XiaTimestamp(10, 5));
+}
+
+///The CFD fraction is not lost at times where a double can no longer hold it.
+TEST(Test_LargeTimesKeepTheFraction) {
+    const unsigned long long ticks = 223347136240170ull;
+    XiaTimestamp early(ticks, 1), late(ticks, 2);
+    CHECK(early < late);
+    CHECK_EQUAL(early.ToDouble(), late.ToDouble());
+}
+
+TEST(Test_Shift) {
+    XiaTimestamp time(100);
+    time.Shift(-(long long) XiaTimestamp::FRACTION_SCALE / 4);
+    CHECK_EQUAL(99ull, time.GetTicks());
+    CHECK_EQUAL(3 * XiaTimestamp::FRACTION_SCALE / 4, time.GetFraction());
+    CHECK_CLOSE(99.75, time.ToDouble(), 1e-12);
+
+    time.Shift(XiaTimestamp::FRACTION_SCALE / 2);
+    CHECK_EQUAL(100ull, time.GetTicks());
+    CHECK_EQUAL(XiaTimestamp::FRACTION_SCALE / 4, time.GetFraction());
+
+    XiaTimestamp zero(0, 10);
+    zero.Shift(-(long long) XiaTimestamp::FRACTION_SCALE);
+    CHECK(zero == XiaTimestamp());
+}
+
+TEST(Test_FromDouble) {
+    XiaTimestamp time = XiaTimestamp::FromDouble(123.5);
+    CHECK_EQUAL(123ull, time.GetTicks());
+    CHECK_EQUAL(XiaTimestamp::FRACTION_SCALE / 2, time.GetFraction());
+    CHECK(XiaTimestamp::FromDouble(-1) == XiaTimestamp());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,505 @@
+///@file listModeGenerator.cpp
+///@brief A program that writes .ldf or .pld runs of synthetic Pixie-16 list
+/// mode data at a given rate, to benchmark the scan codes without beam time.
+///@date October 17, 2026
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <string.h>
+#include <stdlib.h>
+
+#include "CrystalBallFunction.hpp"
+#include "DefaultConfigurationValues.hpp"
+#include "HelperEnumerations.hpp"
+#include "VandleTimingFunction.hpp"
+#include "XiaListModeDataEncoder.hpp"
+#include "hribf_buffers.h"
+
+namespace {
+    ///The largest file that is written before the run continues in a new one, as in poll2.
+    const long long maxFileSize = 2147483648ll;
+
+    ///Half of the 131072 word FIFO of a module, poll2 reads out the modules at this level by default.
+    const unsigned int defaultSpillWords = 65536;
+
+    ///The number of words that the .ldf reader of ScanInterface takes in one spill.
+    const unsigned int maxSpillWords = 2500000;
+
+    ///The baseline and the largest sample of the traces.
+    const double traceBaseline = 400.;
+    const double traceMaximum = 16383.;
+
+    ///The fraction of the hits in the full energy peak, the rest follow an exponential.
+    const double peakFraction = 0.3;
+    const double peakEnergy = 1332.;
+    const double peakSigma = 20.;
+    const double meanEnergy = 500.;
+}
+
+///The settings of the generated run.
+struct Settings {
+    std::string prefix; ///< The prefix of the output files
+    std::string directory; ///< The directory of the output files
+    std::string title; ///< The title in the file headers
+    unsigned int format; ///< 0 for .ldf and 1 for .pld
+    unsigned int runNumber;
+
+    unsigned int modules;
+    unsigned int channels; ///< The channels that fire in each module
+    std::string firmware;
+    unsigned int frequency; ///< The sampling frequency in MHz
+
+    double rate; ///< The mean number of events per second
+    double multiplicity; ///< The mean number of channels (or pairs) that fire in an event
+    double window; ///< The time over which the hits of an event are spread (in ns)
+    bool pairs; ///< Every channel fires with its neighbour, as the two ends of a bar
+
+    double duration; ///< The length of the run (in s)
+    double size; ///< The largest amount of data to write (in MB), 0 for no limit
+    unsigned int spillWords; ///< The words in a module that end the spill
+
+    unsigned int traceLength; ///< The number of samples in the traces, 0 for no traces
+    bool crystalBall; ///< Use the CrystalBallFunction instead of the VandleTimingFunction
+    double noise; ///< The standard deviation of the noise on the traces
+    double beta, gamma; ///< The decay and rise of the VandleTimingFunction
+    double sigma, alpha, power; ///< The width, tail start and tail power of the CrystalBallFunction
+
+    unsigned long seed;
+};
+
+///One channel firing, before it is encoded.
+struct Hit {
+    double time; ///< The time of the hit since the start of the run (in ns)
+    unsigned int module;
+    unsigned int channel;
+};
+
+void help(char *name_) {
+    std::cout << "  SYNTAX: " << name_ << " [options]\n";
+    std::cout << "   Available options:\n";
+    std::cout << "    --output <prefix>        | Prefix of the output files (default=synthetic).\n";
+    std::cout << "    --dir <path>             | Directory of the output files (default=./).\n";
+    std::cout << "    --format <ldf|pld>       | Format of the output files (default=ldf).\n";
+    std::cout << "    --run <N>                | Run number (default=1).\n";
+    std::cout << "    --title <title>          | Title of the run.\n";
+    std::cout << "    --modules <N>            | Number of modules, in slots 2 and up (default=1).\n";
+    std::cout << "    --channels <N>           | Number of channels that fire in each module (default=16).\n";
+    std::cout << "    --firmware <firmware>    | Firmware revision of the modules (default=R30474).\n";
+    std::cout << "    --frequency <frequency>  | Sampling frequency of the modules in MHz (default=250).\n";
+    std::cout << "    --rate <events/s>        | Mean number of events per second (default=10000).\n";
+    std::cout << "    --multiplicity <mean>    | Mean number of channels that fire in an event, at least 1 (default=1).\n";
+    std::cout << "                             |  With --pairs it counts pairs, --multiplicity 3 gives about 6 hits.\n";
+    std::cout << "    --window <ns>            | Time over which the hits of an event are spread (default=100).\n";
+    std::cout << "    --pairs                  | Channels fire with their neighbour, as the two ends of a bar.\n";
+    std::cout << "                             |  Doubles the hits in an event, see --multiplicity.\n";
+    std::cout << "    --duration <s>           | Length of the run (default=10).\n";
+    std::cout << "    --size <MB>              | Stop once this much data was written (default=no limit).\n";
+    std::cout << "    --spill <words>          | Words in a module that end a spill (default=" << defaultSpillWords << ").\n";
+    std::cout << "    --trace <samples>        | Length of the traces (default=0, no traces).\n";
+    std::cout << "    --shape <vandle|crystal> | Pulse shape of the traces (default=vandle).\n";
+    std::cout << "    --noise <sigma>          | Standard deviation of the noise on the traces (default=3).\n";
+    std::cout << "    --beta <beta>            | Decay of the vandle pulse.\n";
+    std::cout << "    --gamma <gamma>          | Rise of the vandle pulse.\n";
+    std::cout << "    --sigma <samples>        | Width of the crystal ball pulse (default=2).\n";
+    std::cout << "    --alpha <alpha>          | Start of the tail of the crystal ball pulse (default=-1).\n";
+    std::cout << "    --power <n>              | Power of the tail of the crystal ball pulse (default=2).\n";
+    std::cout << "    --seed <N>               | Seed of the random numbers, the same seed gives the same run (default=12345).\n";
+}
+
+///Draws the pulses of the traces with the VandleTimingFunction or the CrystalBallFunction. The shape is
+/// tabulated once in steps of a hundredth of a sample, so that drawing a trace does not evaluate it.
+class PulseShape {
+public:
+    ///Tabulates the shape over the trace, with its peak scaled to one.
+    PulseShape(const Settings &settings) : crystalBall_(settings.crystalBall) {
+        if (crystalBall_) {
+            pars_[0] = 0;
+            pars_[1] = 1;
+            pars_[2] = settings.alpha;
+            pars_[3] = settings.power;
+            pars_[4] = settings.sigma;
+            pars_[5] = 0;
+        } else {
+            pars_[0] = 0;
+            pars_[1] = 1;
+            pars_[2] = settings.beta;
+            pars_[3] = settings.gamma;
+            pars_[4] = 0;
+        }
+
+        //The pulse is placed at a quarter of the trace, so the table covers the samples before and after that.
+        double peak = 0;
+        table_.resize((size_t) (settings.traceLength * steps) + 1);
+        for (size_t i = 0; i < table_.size(); i++) {
+            double x = (double) i / steps - settings.traceLength / 4.;
+            table_[i] = crystalBall_ ? crystalBallFunction_(&x, pars_) : vandleFunction_(&x, pars_);
+            peak = std::max(peak, table_[i]);
+        }
+        if (settings.traceLength == 0)
+            return;
+        if (peak <= 0)
+            throw std::invalid_argument("The pulse shape has no positive peak, check its parameters.");
+        for (std::vector<double>::iterator it = table_.begin(); it != table_.end(); it++)
+            *it /= peak;
+    }
+
+    ///Fills the trace with a pulse of the given height that is placed a fraction of a sample after a quarter
+    /// of the trace.
+    void Draw(std::vector<unsigned int> &trace_, const double &fraction_, const double &height_,
+              std::normal_distribution<double> &noise_, std::mt19937_64 &random_) {
+        size_t shift = (size_t) (fraction_ * steps + 0.5);
+        for (unsigned int i = 0; i < trace_.size(); i++) {
+            double shape = i * steps >= shift ? table_[i * steps - shift] : table_[0];
+            double value = traceBaseline + height_ * shape + noise_(random_);
+            trace_[i] = (unsigned int) std::min(traceMaximum, std::max(0., floor(value + 0.5)));
+        }
+    }
+
+private:
+    static const size_t steps = 100; ///< The entries in the table for each sample
+
+    bool crystalBall_;
+    double pars_[6];
+    std::vector<double> table_; ///< The shape from a quarter of the trace before the pulse to the end of the trace
+    CrystalBallFunction crystalBallFunction_;
+    VandleTimingFunction vandleFunction_;
+};
+
+///Encodes the hits into the module records of poll2 spills and writes them with the PollOutputFile.
+class RunWriter {
+public:
+    RunWriter(const Settings &settings) : settings_(settings), output_(), records_(settings.modules),
+                                          shape_(settings), random_(settings.seed), noise_(0., settings.noise),
+                                          energy_(1. / meanEnergy), peak_(peakEnergy, peakSigma),
+                                          uniform_(0., 1.), bytes_(0), spills_(0), files_(0) {
+        firmware_ = XiaListModeDataMask(settings_.firmware, settings_.frequency).GetFirmware();
+        XiaListModeDataMask mask(firmware_, settings_.frequency);
+        cfdSize_ = (unsigned int) mask.GetCfdSize();
+
+        //The timestamps count the filter clock, the same way that the XiaListModeDataDecoder reads them back.
+        unsigned int multiplier = settings_.frequency == 250 ? 2 : (settings_.frequency == 500 ? 10 : 1);
+        tick_ = 1.e3 * multiplier / settings_.frequency;
+
+        if (settings_.traceLength > 0)
+            trace_.resize(settings_.traceLength);
+        output_.SetFileFormat(settings_.format);
+    }
+
+    ///Opens the first file of the run.
+    bool Open() {
+        unsigned int runNumber = settings_.runNumber;
+        if (!output_.OpenNewFile(settings_.title, runNumber, settings_.prefix, settings_.directory))
+            return false;
+        files_++;
+        std::cout << "Writing " << output_.GetCurrentFilename() << std::endl;
+        return true;
+    }
+
+    ///Adds the hit to the record of its module and writes the spill once the record is full.
+    bool Add(const Hit &hit_) {
+        XiaData data;
+        double ticks = hit_.time / tick_;
+        unsigned long long timestamp = (unsigned long long) ticks;
+        data.SetCrateNumber(0);
+        data.SetSlotNumber(hit_.module + 2);
+        data.SetChannelNumber(hit_.channel);
+        data.SetEventTimeLow((unsigned int) (timestamp & 0xFFFFFFFF));
+        data.SetEventTimeHigh((unsigned int) (timestamp >> 32));
+        data.SetCfdFractionalTime((unsigned int) ((ticks - timestamp) * cfdSize_));
+        data.SetCfdTriggerSourceBit(settings_.frequency == 500);
+
+        double energy = uniform_(random_) < peakFraction ? peak_(random_) : energy_(random_);
+        data.SetEnergy(std::min(65535., std::max(1., floor(energy))));
+
+        if (!trace_.empty()) {
+            shape_.Draw(trace_, ticks - timestamp, energy, noise_, random_);
+            data.SetTrace(trace_);
+        }
+
+        std::vector<unsigned int> words = encoder_.EncodeXiaData(data, firmware_, settings_.frequency);
+        std::vector<unsigned int> &record = records_[hit_.module];
+        record.insert(record.end(), words.begin(), words.end());
+
+        if (record.size() >= settings_.spillWords)
+            return WriteSpill();
+        return true;
+    }
+
+    ///Writes the records of every module as one spill, modules without hits get an empty record.
+    bool WriteSpill() {
+        spill_.clear();
+        for (unsigned int mod = 0; mod < records_.size(); mod++) {
+            spill_.push_back(records_[mod].size() + 2);
+            spill_.push_back(mod);
+            spill_.insert(spill_.end(), records_[mod].begin(), records_[mod].end());
+            records_[mod].clear();
+        }
+
+        //Continue the run in a new file before this one grows too large, as poll2 does.
+        if (output_.GetFilesize() + (std::streampos) (4 * spill_.size() + 65552) > maxFileSize) {
+            unsigned int runNumber = settings_.runNumber;
+            if (!output_.OpenNewFile(settings_.title, runNumber, settings_.prefix, settings_.directory, true))
+                return false;
+            files_++;
+            std::cout << "Writing " << output_.GetCurrentFilename() << std::endl;
+        }
+
+        if (output_.Write((char *) spill_.data(), spill_.size()) < 0)
+            return false;
+        bytes_ += 4. * spill_.size();
+        spills_++;
+        return true;
+    }
+
+    ///Writes the last spill and closes the file.
+    bool Close(const double &runTime_) {
+        bool hasHits = false;
+        for (unsigned int mod = 0; mod < records_.size(); mod++)
+            hasHits |= !records_[mod].empty();
+        bool good = !hasHits || WriteSpill();
+        output_.CloseFile(runTime_);
+        return good;
+    }
+
+    double GetBytes() const { return bytes_; }
+
+    unsigned long GetNumSpills() const { return spills_; }
+
+    unsigned int GetNumFiles() const { return files_; }
+
+    std::mt19937_64 &GetRandom() { return random_; }
+
+private:
+    const Settings &settings_;
+    PollOutputFile output_;
+    XiaListModeDataEncoder encoder_;
+    DataProcessing::FIRMWARE firmware_;
+    unsigned int cfdSize_; ///< The number of fractions of a clock tick in the CFD time
+    double tick_; ///< The length of a clock tick (in ns)
+
+    std::vector<std::vector<unsigned int> > records_; ///< The words of each module in the current spill
+    std::vector<unsigned int> spill_;
+    std::vector<unsigned int> trace_;
+    PulseShape shape_;
+
+    std::mt19937_64 random_;
+    std::normal_distribution<double> noise_;
+    std::exponential_distribution<double> energy_;
+    std::normal_distribution<double> peak_;
+    std::uniform_real_distribution<double> uniform_;
+
+    double bytes_;
+    unsigned long spills_;
+    unsigned int files_;
+};
+
+///Draws the events of the run and hands their hits to the writer in time order of the events.
+bool generate(const Settings &settings_, RunWriter &writer_) {
+    std::mt19937_64 &generator = writer_.GetRandom();
+    std::exponential_distribution<double> interval(settings_.rate);
+    std::poisson_distribution<unsigned int> extra(settings_.multiplicity > 1 ? settings_.multiplicity - 1 : 1);
+    std::uniform_real_distribution<double> spread(0., settings_.window);
+
+    //The channels that can fire on their own. With pairs only the first channel of each pair is drawn.
+    std::vector<std::pair<unsigned int, unsigned int> > sources;
+    for (unsigned int mod = 0; mod < settings_.modules; mod++)
+        for (unsigned int chan = 0; chan < settings_.channels; chan += settings_.pairs ? 2 : 1)
+            sources.push_back(std::make_pair(mod, chan));
+
+    if (!writer_.Open()) {
+        std::cout << " Error: Failed to open the output file in " << settings_.directory << ".\n";
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double maxBytes = settings_.size > 0 ? settings_.size * 1.e6 : std::numeric_limits<double>::infinity();
+    unsigned long events = 0, hits = 0;
+    double time = 0;
+    std::vector<Hit> event;
+    while (true) {
+        time += interval(generator);
+        if (time >= settings_.duration || writer_.GetBytes() >= maxBytes)
+            break;
+
+        //Draw distinct sources with a partial shuffle, the multiplicity is one plus a poisson number.
+        unsigned int multiplicity = std::min<size_t>(1 + (settings_.multiplicity > 1 ? extra(generator) : 0),
+                                                     sources.size());
+        event.clear();
+        for (unsigned int i = 0; i < multiplicity; i++) {
+            std::uniform_int_distribution<size_t> pick(i, sources.size() - 1);
+            std::swap(sources[i], sources[pick(generator)]);
+            Hit hit;
+            hit.module = sources[i].first;
+            hit.channel = sources[i].second;
+            hit.time = time * 1.e9 + spread(generator);
+            event.push_back(hit);
+            //The other end of a bar fires within a tenth of the window.
+            if (settings_.pairs && hit.channel + 1 < settings_.channels) {
+                hit.channel++;
+                hit.time += spread(generator) * 0.1;
+                event.push_back(hit);
+            }
+        }
+
+        for (std::vector<Hit>::iterator it = event.begin(); it != event.end(); it++) {
+            if (!writer_.Add(*it)) {
+                std::cout << " Error: Failed to write to the output file.\n";
+                return false;
+            }
+        }
+        events++;
+        hits += event.size();
+    }
+
+    time = std::min(time, settings_.duration);
+    if (!writer_.Close(time)) {
+        std::cout << " Error: Failed to write to the output file.\n";
+        return false;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Events : " << events << " (" << (double) hits / std::max(events, 1ul) << " hits per event)\n";
+    std::cout << "Hits   : " << hits << " in " << time << " s of data\n";
+    std::cout << "Spills : " << writer_.GetNumSpills() << " in " << writer_.GetNumFiles() << " files\n";
+    std::cout << "Data   : " << writer_.GetBytes() / 1.e6 << " MB written in " << elapsed.count() << " s ("
+              << writer_.GetBytes() / 1.e6 / elapsed.count() << " MB/s)\n";
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Settings settings;
+    settings.prefix = "synthetic";
+    settings.directory = "./";
+    settings.title = "Synthetic list mode data";
+    settings.format = 0;
+    settings.runNumber = 1;
+    settings.modules = 1;
+    settings.channels = 16;
+    settings.firmware = "R30474";
+    settings.frequency = 250;
+    settings.rate = 10000;
+    settings.multiplicity = 1;
+    settings.window = 100;
+    settings.pairs = false;
+    settings.duration = 10;
+    settings.size = 0;
+    settings.spillWords = defaultSpillWords;
+    settings.traceLength = 0;
+    settings.crystalBall = false;
+    settings.noise = 3;
+    settings.beta = DefaultConfig::fitBeta;
+    settings.gamma = DefaultConfig::fitGamma;
+    settings.sigma = 2;
+    settings.alpha = -1;
+    settings.power = 2;
+    settings.seed = 12345;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            settings.prefix = argv[++i];
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            settings.directory = argv[++i];
+            if (settings.directory.back() != '/')
+                settings.directory += '/';
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "ldf" && format != "pld") {
+                std::cout << " Error: Unknown format '" << format << "'.\n";
+                return 1;
+            }
+            settings.format = format == "ldf" ? 0 : 1;
+        } else if (strcmp(argv[i], "--run") == 0 && i + 1 < argc)
+            settings.runNumber = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--title") == 0 && i + 1 < argc)
+            settings.title = argv[++i];
+        else if (strcmp(argv[i], "--modules") == 0 && i + 1 < argc)
+            settings.modules = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--channels") == 0 && i + 1 < argc)
+            settings.channels = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--firmware") == 0 && i + 1 < argc)
+            settings.firmware = argv[++i];
+        else if (strcmp(argv[i], "--frequency") == 0 && i + 1 < argc)
+            settings.frequency = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            settings.rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--multiplicity") == 0 && i + 1 < argc)
+            settings.multiplicity = atof(argv[++i]);
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+            settings.window = atof(argv[++i]);
+        else if (strcmp(argv[i], "--pairs") == 0)
+            settings.pairs = true;
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc)
+            settings.duration = atof(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            settings.size = atof(argv[++i]);
+        else if (strcmp(argv[i], "--spill") == 0 && i + 1 < argc)
+            settings.spillWords = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            settings.traceLength = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            std::string shape = argv[++i];
+            if (shape != "vandle" && shape != "crystal") {
+                std::cout << " Error: Unknown pulse shape '" << shape << "'.\n";
+                return 1;
+            }
+            settings.crystalBall = shape == "crystal";
+        } else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+            settings.noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "--beta") == 0 && i + 1 < argc)
+            settings.beta = atof(argv[++i]);
+        else if (strcmp(argv[i], "--gamma") == 0 && i + 1 < argc)
+            settings.gamma = atof(argv[++i]);
+        else if (strcmp(argv[i], "--sigma") == 0 && i + 1 < argc)
+            settings.sigma = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc)
+            settings.alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--power") == 0 && i + 1 < argc)
+            settings.power = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            settings.seed = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--help") == 0) {
+            help(argv[0]);
+            return 0;
+        } else {
+            std::cout << " Error: Unknown option '" << argv[i] << "'.\n";
+            help(argv[0]);
+            return 1;
+        }
+    }
+
+    if (settings.modules == 0 || settings.modules > 14 || settings.channels == 0 || settings.channels > 16) {
+        std::cout << " Error: There can be 1 to 14 modules with 1 to 16 channels each.\n";
+        return 1;
+    }
+    if (settings.frequency != 100 && settings.frequency != 250 && settings.frequency != 500) {
+        std::cout << " Error: The frequency must be 100, 250 or 500 MHz.\n";
+        return 1;
+    }
+    if (settings.rate <= 0 || settings.duration <= 0 || settings.multiplicity < 1 || settings.window < 0) {
+        std::cout << " Error: The rate and the duration must be positive and the multiplicity at least 1.\n";
+        return 1;
+    }
+    //A spill ends once a module passes the threshold, so it holds at most one more event in every module.
+    unsigned int eventWords = 4 + (settings.traceLength + 1) / 2;
+    if (settings.spillWords == 0 ||
+        (unsigned long long) settings.modules * (settings.spillWords + eventWords + 2) > maxSpillWords) {
+        std::cout << " Error: The spills would be larger than the " << maxSpillWords
+                  << " words that the scan codes read at once, use fewer --spill words.\n";
+        return 1;
+    }
+
+    try {
+        RunWriter writer(settings);
+        return generate(settings, writer) ? 0 : 1;
+    } catch (std::exception &ex) {
+        std::cout << " Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
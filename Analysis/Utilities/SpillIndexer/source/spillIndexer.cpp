@@ -0,0 +1,185 @@
+///@file spillIndexer.cpp
+///@brief A program that builds the spill index of .ldf and .pld files without
+/// scanning them, and splits the spills into ranges for parallel scans.
+///@date October 17, 2026
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hribf_buffers.h"
+#include "ScanInterface.hpp"
+#include "SpillIndex.hpp"
+#include "Unpacker.hpp"
+
+void help(char *name_) {
+    std::cout << "  SYNTAX: " << name_ << " [options] <files ...>\n";
+    std::cout << "   Available options:\n";
+    std::cout << "    --config <path>          | Take the firmware and frequency of the modules from a setup file.\n";
+    std::cout << "    --firmware <firmware>    | Firmware revision of the modules.\n";
+    std::cout << "    --frequency <frequency>  | Sampling frequency of the modules in MHz.\n";
+    std::cout << "    --ranges <N>             | Print N ranges of spills to hand to separate scans with --spills.\n";
+}
+
+///Reads every spill of a file in the same order as ScanInterface and adds it
+/// to the index.
+bool build_index(const char *filename_, const std::vector<XiaListModeDataMask> &masks_, SpillIndex &index_) {
+    std::string prefix;
+    std::string extension = get_extension(filename_, prefix);
+    int file_format = -1;
+    if (extension == "ldf") // List data format file
+        file_format = 0;
+    else if (extension == "pld") // Pixie list data file format
+        file_format = 1;
+    else {
+        std::cout << " ERROR! Invalid file extension '" << extension << "'.\n";
+        return false;
+    }
+
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file.is_open() || !file.good()) {
+        std::cout << " ERROR! Failed to open input file! Check that the path is correct.\n";
+        return false;
+    }
+
+    // The spills start after the DIR and HEAD buffers of a .ldf file and after
+    // the HEAD buffer of a .pld file.
+    DIR_buffer ldfDir;
+    HEAD_buffer ldfHead;
+    PLD_header pldHead;
+    if (file_format == 0) {
+        ldfDir.Read(&file);
+        ldfHead.Read(&file);
+    } else
+        pldHead.Read(&file);
+    std::streampos start = file.tellg();
+    file.seekg(0, file.end);
+    index_.Clear();
+    index_.SetFileLength(file.tellg());
+    file.close();
+
+    MappedFile mapped;
+    if (!mapped.open(filename_)) {
+        std::cout << " ERROR! Failed to map input file into memory.\n";
+        return false;
+    }
+    mapped.seekg(start);
+
+    std::vector<unsigned int> data(file_format == 0 ? 2500000 : pldHead.GetMaxSpillSize() + 2);
+    unsigned int *spill;
+    unsigned int nBytes;
+
+    if (file_format == 0) {
+        DATA_buffer databuff;
+        bool full_spill, bad_spill;
+        while (true) {
+            if (!databuff.Read(&mapped, (char *) data.data(), spill, nBytes, 1000000, full_spill, bad_spill)) {
+                if (databuff.GetRetval() == 2 || databuff.GetRetval() == 6)
+                    break;
+                continue;
+            }
+            SpillIndexEntry entry;
+            entry.offset = (unsigned long long) start + 4ull * databuff.GetSpillStart();
+            entry.nWords = nBytes / 4;
+            entry.good = full_spill && !bad_spill;
+            entry.moduleMask = 0;
+            entry.firstTime = entry.lastTime = 0;
+            if (entry.good)
+                SpillIndex::Summarize(spill, entry.nWords, masks_, entry);
+            index_.Add(entry);
+        }
+    } else {
+        PLD_data pldData;
+        while (true) {
+            unsigned long long offset = mapped.tellg();
+            if (!pldData.Read(&mapped, (char *) data.data(), spill, nBytes, 4 * pldHead.GetMaxSpillSize()))
+                break;
+            SpillIndexEntry entry;
+            entry.offset = offset;
+            entry.nWords = nBytes / 4 + 2;
+            entry.good = true;
+            SpillIndex::Summarize(spill, entry.nWords, masks_, entry);
+            index_.Add(entry);
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << " Error: Invalid number of arguments to " << argv[0]
+                  << ". Expected 1, received " << argc - 1 << ".\n";
+        help(argv[0]);
+        return 1;
+    }
+
+    std::string config, firmware;
+    unsigned int frequency = 0;
+    unsigned int ranges = 0;
+    std::vector<char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+            config = argv[++i];
+        else if (strcmp(argv[i], "--firmware") == 0 && i + 1 < argc)
+            firmware = argv[++i];
+        else if (strcmp(argv[i], "--frequency") == 0 && i + 1 < argc)
+            frequency = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ranges") == 0 && i + 1 < argc)
+            ranges = (unsigned int) atoi(argv[++i]);
+        else if (strncmp(argv[i], "--", 2) == 0) {
+            std::cout << " Error: Unknown option " << argv[i] << ".\n";
+            help(argv[0]);
+            return 1;
+        } else
+            files.push_back(argv[i]);
+    }
+
+    // The data masks are needed to find the times of the events in each spill.
+    Unpacker unpacker;
+    try {
+        if (!firmware.empty() && frequency != 0)
+            unpacker.InitializeDataMask(firmware, frequency);
+        else if (!config.empty())
+            unpacker.InitializeDataMask(config);
+        else {
+            std::cout << " Error: Either --config or both --firmware and --frequency are needed.\n";
+            help(argv[0]);
+            return 1;
+        }
+    } catch (std::exception &ex) {
+        std::cout << " Error: " << ex.what() << "\n";
+        return 1;
+    }
+    std::vector<XiaListModeDataMask> masks = unpacker.GetDataMasks();
+
+    int retval = 0;
+    for (std::vector<char *>::iterator it = files.begin(); it != files.end(); it++) {
+        std::cout << "File: " << *it << std::endl;
+
+        SpillIndex index;
+        if (!build_index(*it, masks, index)) {
+            retval = 1;
+            continue;
+        }
+
+        std::string indexName = SpillIndex::GetIndexFilename(*it);
+        if (!index.Write(indexName)) {
+            std::cout << " ERROR! Failed to write the spill index to " << indexName << ".\n";
+            retval = 1;
+            continue;
+        }
+        std::cout << " Wrote the index of " << index.GetNumSpills() << " spills to " << indexName << "\n";
+
+        if (ranges != 0) {
+            std::vector<std::pair<size_t, size_t> > parts = index.Partition(ranges);
+            for (std::vector<std::pair<size_t, size_t> >::iterator part = parts.begin(); part != parts.end(); part++)
+                std::cout << "  --spills " << part->first << ":" << part->second << std::endl;
+        }
+    }
+
+    return retval;
+}
@@ -0,0 +1,235 @@
+///@file timingBenchmark.cpp
+///@brief A program that compares the phase resolution and the speed of the
+/// GslFitter and the TemplateFitter on recorded or simulated traces.
+///@date October 17, 2026
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <string.h>
+#include <stdlib.h>
+
+#include "DefaultConfigurationValues.hpp"
+#include "GslFitter.hpp"
+#include "HelperFunctions.hpp"
+#include "TemplateFitter.hpp"
+
+///The waveform of one trace, prepared the way the WaveformAnalyzer does it.
+struct Waveform {
+    std::vector<double> data; ///< The baseline subtracted samples around the maximum
+    std::pair<unsigned int, double> max; ///< The maximum of the trace
+    std::pair<double, double> baseline; ///< The baseline of the trace
+    double qdc; ///< The QDC of the waveform
+};
+
+///The phases that a driver found and the time that it took.
+struct Result {
+    std::vector<double> phases; ///< The phase of every waveform
+    double microseconds; ///< The time per waveform
+};
+
+void help(char *name_) {
+    std::cout << "  SYNTAX: " << name_ << " [options] [file]\n";
+    std::cout << "   The file holds one trace per line as whitespace separated samples. Without a file the traces are\n";
+    std::cout << "   simulated with the timing function, a random phase and gaussian noise.\n";
+    std::cout << "   Available options:\n";
+    std::cout << "    --beta <beta>     | The beta of the timing function.\n";
+    std::cout << "    --gamma <gamma>   | The gamma of the timing function.\n";
+    std::cout << "    --low <samples>   | The number of samples before the maximum in the waveform.\n";
+    std::cout << "    --high <samples>  | The number of samples after the maximum in the waveform.\n";
+    std::cout << "    --traces <N>      | The number of traces to simulate.\n";
+    std::cout << "    --noise <sigma>   | The standard deviation of the noise of the simulated traces.\n";
+    std::cout << "    --sipm            | Fit the SiPM fast output function instead of the PMT function.\n";
+}
+
+///Cuts the waveform out of a trace. Returns false if the trace is too short.
+bool prepare(const std::vector<unsigned int> &trace_, const unsigned int &low_, const unsigned int &high_,
+             Waveform &waveform_) {
+    if (trace_.size() < (unsigned int) TraceFunctions::minimum_baseline_length + low_ + high_ + 1)
+        return false;
+
+    unsigned int maxPosition = TraceFunctions::minimum_baseline_length + low_;
+    for (unsigned int i = maxPosition; i + high_ < trace_.size(); i++)
+        if (trace_[i] > trace_[maxPosition])
+            maxPosition = i;
+
+    waveform_.baseline = TraceFunctions::CalculateBaseline(trace_, std::make_pair(0, maxPosition - low_));
+    waveform_.max = std::make_pair(maxPosition, trace_[maxPosition] - waveform_.baseline.first);
+    waveform_.data.clear();
+    for (unsigned int i = maxPosition - low_; i <= maxPosition + high_; i++)
+        waveform_.data.push_back(trace_[i] - waveform_.baseline.first);
+    waveform_.qdc = TraceFunctions::CalculateQdc(waveform_.data, std::make_pair(0, waveform_.data.size()));
+    return true;
+}
+
+///Reads the traces from a file with one trace per line.
+std::vector<std::vector<unsigned int> > read_traces(const char *filename_) {
+    std::ifstream file(filename_);
+    if (!file.good())
+        throw std::invalid_argument(std::string("Unable to open ") + filename_);
+
+    std::vector<std::vector<unsigned int> > traces;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream stream(line);
+        std::vector<unsigned int> trace;
+        unsigned int sample;
+        while (stream >> sample)
+            trace.push_back(sample);
+        if (!trace.empty())
+            traces.push_back(trace);
+    }
+    return traces;
+}
+
+///Simulates traces with the timing function on a baseline with noise. The phase is stored with the trace.
+std::vector<std::vector<unsigned int> > simulate(const unsigned int &count_, const std::pair<double, double> &pars_,
+                                                 const bool &isFastSiPm_, const double &noise_,
+                                                 std::vector<double> &phases_) {
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<double> phase(60., 61.);
+    std::uniform_real_distribution<double> amplitude(500., 3000.);
+    std::normal_distribution<double> gauss(0., noise_);
+
+    std::vector<std::vector<unsigned int> > traces;
+    for (unsigned int i = 0; i < count_; i++) {
+        double phi = phase(generator), amp = amplitude(generator);
+        std::vector<unsigned int> trace;
+        for (unsigned int j = 0; j < 124; j++) {
+            double d = j - phi, value;
+            if (isFastSiPm_)
+                value = amp * exp(-d * d / (2 * pars_.second * pars_.second));
+            else
+                value = d < 0 ? 0 : amp * exp(-pars_.first * d) * (1 - exp(-pow(pars_.second * d, 4.)));
+            trace.push_back((unsigned int) std::max(0., floor(400. + value + gauss(generator) + 0.5)));
+        }
+        traces.push_back(trace);
+        phases_.push_back(phi);
+    }
+    return traces;
+}
+
+///Runs a driver on every waveform. The phase is moved from the start of the waveform to the start of the trace.
+Result run(TimingDriver &driver_, const std::vector<Waveform> &waveforms_, const std::pair<double, double> &pars_,
+           const unsigned int &low_) {
+    Result result;
+    result.phases.reserve(waveforms_.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::vector<Waveform>::const_iterator it = waveforms_.begin(); it != waveforms_.end(); it++) {
+        driver_.SetQdc(it->qdc);
+        result.phases.push_back(driver_.CalculatePhase(it->data, pars_, it->max, it->baseline) + it->max.first -
+                                low_);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    result.microseconds = waveforms_.empty() ? 0 : elapsed.count() / waveforms_.size();
+    return result;
+}
+
+///@return The mean and standard deviation of the difference of two sets of phases
+std::pair<double, double> compare(const std::vector<double> &a_, const std::vector<double> &b_) {
+    double sum = 0, squares = 0;
+    for (unsigned int i = 0; i < a_.size(); i++) {
+        sum += a_[i] - b_[i];
+        squares += (a_[i] - b_[i]) * (a_[i] - b_[i]);
+    }
+    double mean = sum / a_.size();
+    return std::make_pair(mean, sqrt(std::max(0., squares / a_.size() - mean * mean)));
+}
+
+int main(int argc, char *argv[]) {
+    std::pair<double, double> pars(DefaultConfig::fitBeta, DefaultConfig::fitGamma);
+    unsigned int low = DefaultConfig::waveformLow, high = DefaultConfig::waveformHigh;
+    unsigned int count = 10000;
+    double noise = 3.;
+    bool isFastSiPm = false;
+    char *filename = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--beta") == 0 && i + 1 < argc)
+            pars.first = atof(argv[++i]);
+        else if (strcmp(argv[i], "--gamma") == 0 && i + 1 < argc)
+            pars.second = atof(argv[++i]);
+        else if (strcmp(argv[i], "--low") == 0 && i + 1 < argc)
+            low = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--high") == 0 && i + 1 < argc)
+            high = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--traces") == 0 && i + 1 < argc)
+            count = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+            noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "--sipm") == 0)
+            isFastSiPm = true;
+        else if (strcmp(argv[i], "--help") == 0) {
+            help(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' && filename == NULL)
+            filename = argv[i];
+        else {
+            std::cout << " Error: Unknown option '" << argv[i] << "'.\n";
+            help(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::vector<unsigned int> > traces;
+    std::vector<double> truth;
+    try {
+        if (filename)
+            traces = read_traces(filename);
+        else
+            traces = simulate(count, pars, isFastSiPm, noise, truth);
+    } catch (std::exception &ex) {
+        std::cout << " Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<Waveform> waveforms;
+    std::vector<double> waveformTruth;
+    for (unsigned int i = 0; i < traces.size(); i++) {
+        Waveform waveform;
+        if (!prepare(traces[i], low, high, waveform))
+            continue;
+        waveforms.push_back(waveform);
+        if (!truth.empty())
+            waveformTruth.push_back(truth[i]);
+    }
+
+    if (waveforms.empty()) {
+        std::cout << " Error: None of the traces were long enough for the waveform.\n";
+        return 1;
+    }
+
+    GslFitter gsl;
+    TemplateFitter fast;
+    gsl.SetIsFastSiPm(isFastSiPm);
+    fast.SetIsFastSiPm(isFastSiPm);
+
+    //The first pass fills the caches of both drivers so that only the fits are timed.
+    run(fast, std::vector<Waveform>(waveforms.begin(), waveforms.begin() + 1), pars, low);
+    Result gslResult = run(gsl, waveforms, pars, low);
+    Result fastResult = run(fast, waveforms, pars, low);
+
+    std::cout << "Waveforms : " << waveforms.size() << " with " << waveforms[0].data.size() << " samples\n";
+    std::cout << "GslFitter      : " << gslResult.microseconds << " us/waveform\n";
+    std::cout << "TemplateFitter : " << fastResult.microseconds << " us/waveform ("
+              << gslResult.microseconds / fastResult.microseconds << "x)\n";
+
+    std::pair<double, double> difference = compare(fastResult.phases, gslResult.phases);
+    std::cout << "Template - GSL : mean " << difference.first << ", sigma " << difference.second << " samples\n";
+
+    if (!waveformTruth.empty()) {
+        std::pair<double, double> gslResolution = compare(gslResult.phases, waveformTruth);
+        std::pair<double, double> fastResolution = compare(fastResult.phases, waveformTruth);
+        std::cout << "GslFitter - truth      : mean " << gslResolution.first << ", sigma " << gslResolution.second
+                  << " samples\n";
+        std::cout << "TemplateFitter - truth : mean " << fastResolution.first << ", sigma " << fastResolution.second
+                  << " samples\n";
+    }
+
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <vector>
 #include <cmath>
 
+#include "TrapezoidalFilter.hpp"
 #include "Unpacker.hpp"
 
 class ChannelEvent;
@@ -33,6 +34,9 @@ private:
     float *fast_filter_y;
     float *slow_filter_y;
 
+    TrapezoidalFilter engine_; ///< The running sums of the current trace.
+    std::vector<double> filtered_; ///< The output of the filter engine.
+
     bool need_graph_update; /// Set to true if the graph range needs updated.
 
     int delay_; /// The number of seconds to wait between drawing traces.
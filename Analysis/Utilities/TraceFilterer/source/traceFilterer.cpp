@@ -23,27 +23,10 @@
 void Filterer::Filter(float *trace_, const size_t &length_, float *filtered1,
                       const unsigned int &risetime_,
                       const unsigned int &flattop_) {
-    float sum;
-    size_t a1, a2, a3, a4;
-
-    for (size_t i = 0; i < 2 * risetime_ + flattop_; i++) {
-        filtered1[i] = 0;
-    }
-
-    for (size_t i = 2 * risetime_ + flattop_; i < length_; i++) {
-        sum = 0.0;
-        a1 = i - (2 * risetime_ + flattop_);
-        a2 = i - (risetime_ + flattop_);
-        a3 = i - risetime_;
-        a4 = i;
-        for (size_t j = a1; j <= a2; j++) {
-            sum += -1 * trace_[j];
-        }
-        for (size_t j = a3; j <= a4; j++) {
-            sum += trace_[j];
-        }
-        filtered1[i] = sum / risetime_;
-    }
+    engine_.SetTrace(trace_, length_);
+    engine_.CalculateTriggerFilter(risetime_, flattop_, filtered_);
+    for (size_t i = 0; i < length_; i++)
+        filtered1[i] = filtered_[i];
 }
 
 Filterer::Filterer(int mod /*= 0*/, int chan/*=0*/) :
@@ -25,17 +25,20 @@
 #include <utility>
 
 #include "Trace.hpp"
+#include "TrapezoidalFilter.hpp"
 #include "TrapFilterParameters.hpp"
 
 /*! The class to perform the filtering */
 class TraceFilter {
 public:
     /** Default Constructor */
-    TraceFilter() {};
+    TraceFilter() : isVerbose_(false), isConverted_(false), analyzePileup_(false) {};
 
     /** Constructor
      * \param [in] nsPerSample : The ns/Sample for the ADC */
-    TraceFilter(const int &nsPerSample) { nsPerSample_ = nsPerSample; }
+    TraceFilter(const int &nsPerSample) : isVerbose_(false), isConverted_(false), analyzePileup_(false) {
+        nsPerSample_ = nsPerSample;
+    }
 
     /** Constructor
      * \param [in] nsPerSample : The ns/Sample for the ADC 
@@ -138,6 +141,7 @@ private:
     unsigned int nsPerSample_; //!< The number of ns per sample
 
     const Trace *sig_; //!< the signal to filter
+    TrapezoidalFilter filter_; //!< the running sums of the signal
 
     std::vector<double> en_; //!< the calculated energies
     std::vector<double> coeffs_; //!< the calculated energy coefficients
@@ -20,6 +20,7 @@
 
 #include "FittingAnalyzer.hpp"
 #include "GslFitter.hpp"
+#include "TemplateFitter.hpp"
 
 #ifdef USE_ROOT
 
@@ -33,6 +34,8 @@ FittingAnalyzer::FittingAnalyzer(const std::string &s ,const std::set<std::strin
     name = "FittingAnalyzer";
     if (s == "GSL" || s == "gsl")
         driver_ = new GslFitter();
+    else if (s == "TEMPLATE" || s == "template")
+        driver_ = new TemplateFitter();
 #ifdef USE_ROOT
     else if (s == "ROOT" || s == "root")
         driver_ = new RootFitter();
@@ -44,6 +44,7 @@ TraceFilter::TraceFilter(const unsigned int &adc, const TrapFilterParameters &tF
     t_ = tFilt;
     nsPerSample_ = adc;
     isVerbose_ = verbose;
+    isConverted_ = false;
     analyzePileup_ = analyzePileup;
 }
 
@@ -54,9 +55,7 @@ void TraceFilter::CalcBaseline(void) {
     if (offset < 0)
         throw (EARLY_TRIG);
 
-    for (unsigned int i = 0; i < (unsigned int) offset; i++)
-        baseline_ += sig_->at(i);
-    baseline_ /= offset;
+    baseline_ = filter_.Sum(0, offset) / offset;
 
     if (isVerbose_)
         cout << "********** CalcBaseline **********" << endl
@@ -68,6 +67,7 @@ unsigned int TraceFilter::CalcFilters(const Trace *sig) {
     try {
         Reset();
         sig_ = sig;
+        filter_.SetTrace(*sig_);
 
         if (!isConverted_)
             ConvertToClockticks();
@@ -113,14 +113,9 @@ unsigned int TraceFilter::CalcFilters(const Trace *sig) {
 }
 
 void TraceFilter::CalcEnergyFilter(void) {
-    double partA = 0, partB = 0, partC = 0;
-
-    for (unsigned int i = limits_[0]; i < limits_[1]; i++)
-        partA += sig_->at(i);
-    for (unsigned int i = limits_[2]; i < limits_[3]; i++)
-        partB += sig_->at(i);
-    for (unsigned int i = limits_[4]; i < limits_[5]; i++)
-        partC += sig_->at(i);
+    double partA = filter_.Sum(limits_[0], limits_[1]);
+    double partB = filter_.Sum(limits_[2], limits_[3]);
+    double partC = filter_.Sum(limits_[4], limits_[5]);
     esums_.push_back(partA);
     esums_.push_back(partB);
     esums_.push_back(partC);
@@ -133,21 +128,14 @@ void TraceFilter::CalcEnergyFilter(void) {
 }
 
 void TraceFilter::CalcEnergyFilterCoeffs(void) {
-    double l = e_.GetRisetime();
-    double beta = exp(-1.0 / e_.GetT());
-    double cg = 1 - beta;
-    double ctmp = 1 - pow(beta, l);
+    coeffs_ = TrapezoidalFilter::CalculateEnergyCoefficients(e_.GetRisetime(), e_.GetT());
 
-    if (std::isnan(beta) || std::isnan(cg) || std::isnan(ctmp))
+    if (std::isnan(coeffs_[0]) || std::isnan(coeffs_[1]) || std::isnan(coeffs_[2]))
         throw (BAD_FILTER_COEFF);
 
-    coeffs_.push_back(-(cg / ctmp) * pow(beta, l));
-    coeffs_.push_back(cg);
-    coeffs_.push_back(cg / ctmp);
-
     if (isVerbose_)
         cout << "********** CalcEnergyFilterCoeffs **********" << endl
-             << "  beta  : " << beta << endl
+             << "  beta  : " << exp(-1.0 / e_.GetT()) << endl
              << "  CRise : " << coeffs_[0] << endl
              << "  CGap  : " << coeffs_[1] << endl
              << "  CFall : " << coeffs_[2] << endl << endl;
@@ -187,33 +175,9 @@ void TraceFilter::CalcEnergyFilterLimits(const unsigned int &tpos) {
 }
 
 void TraceFilter::CalcTriggerFilter(void) {
-    bool hasRecrossed = false;
-
-    int l = t_.GetRisetime(), g = t_.GetFlattop();
-    for (int i = 0; i < (int) sig_->size(); i++) {
-        double sum1 = 0, sum2 = 0;
-        if ((i - 2 * l - g + 1) >= 0) {
-            for (int a = i - 2 * l - g + 1; a < i - l - g + 1; a++)
-                sum1 += sig_->at(a);
-            for (int a = i - l + 1; a < i + 1; a++)
-                sum2 += sig_->at(a);
-
-            if ((sum2 - sum1) / l >= t_.GetT()) {
-                if (trigs_.size() == 0)
-                    trigs_.push_back(i);
-                if (hasRecrossed) {
-                    trigs_.push_back(i);
-                    hasRecrossed = false;
-                }
-            } else {
-                if (trigs_.size() != 0)
-                    hasRecrossed = true;
-            }
-
-            trigFilter_.push_back((sum2 - sum1) / l);
-        } else
-            trigFilter_.push_back(0.0);
-    }
+    unsigned int l = t_.GetRisetime(), g = t_.GetFlattop();
+    filter_.CalculateTriggerFilter(l, g, trigFilter_);
+    trigs_ = TrapezoidalFilter::FindTriggers(trigFilter_, t_.GetT(), 2 * l + g - 1);
 
     if (trigs_.size() == 0)
         throw (NO_TRIG);
@@ -284,6 +248,8 @@ void TraceFilter::ConvertToClockticks(void) {
 void TraceFilter::Reset(void) {
     en_.clear();
     baseline_ = 0;
+    coeffs_.clear();
+    esums_.clear();
     trigFilter_.clear();
     trigs_.clear();
     limits_.clear();
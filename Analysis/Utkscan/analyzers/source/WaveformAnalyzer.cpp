@@ -14,6 +14,7 @@
 #include <cmath>
 
 #include "HelperFunctions.hpp"
+#include "TraceKernels.hpp"
 #include "WaveformAnalyzer.hpp"
 
 using namespace std;
@@ -46,7 +47,7 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
     //First we calculate the position of the maximum.
     pair<unsigned int, double> max;
     try {
-        max = TraceFunctions::FindMaximum(trace, cfg.GetTraceDelayInSamples());
+        max = TraceKernels::FindMaximum(trace, cfg.GetTraceDelayInSamples());
     } catch (range_error &ex) {
         trace.SetHasValidWaveformAnalysis(false);
         cout << "WaveformAnalyzer::Analyze - " << ex.what() << endl;
@@ -70,7 +71,7 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
 
     try {
         //Next we calculate the baseline and its standard deviation
-        pair<double, double> baseline = TraceFunctions::CalculateBaseline(trace, make_pair(0, max.first - range.first));
+        pair<double, double> baseline = TraceKernels::CalculateBaseline(trace, make_pair(0, max.first - range.first));
 
         //For well behaved traces the standard deviation of the baseline
         // shouldn't ever be more than 1-3 ADC units for 12b. However, for traces
@@ -100,14 +101,10 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
         //Subtract the baseline from the maximum value.
         max.second -= baseline.first;
 
-        vector<double> traceNoBaseline;
-        for (unsigned int i = 0; i < trace.size(); i++)
-            traceNoBaseline.push_back(trace[i] - baseline.first);
-
         //Finally, we calculate the QDC in the waveform range and subtract
         // the baseline from it.
         pair<unsigned int, unsigned int> waveformRange(max.first - range.first, max.first + range.second);
-        double qdc = TraceFunctions::CalculateQdc(traceNoBaseline, waveformRange);
+        double qdc = TraceKernels::CalculateQdc(trace, waveformRange, baseline.first);
 
         //Now we are going to set all the different values into the trace.
         trace.SetQdc(qdc);
@@ -115,7 +112,6 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
         trace.SetMax(max);
         trace.SetExtrapolatedMax(make_pair(max.first,
                                            TraceFunctions::ExtrapolateMaximum(trace, max).first - baseline.first));
-        trace.SetTraceSansBaseline(traceNoBaseline);
         trace.SetWaveformRange(waveformRange);
         trace.SetHasValidWaveformAnalysis(true);
     } catch (range_error &ex) {
@@ -6,18 +6,28 @@
 #ifndef __BARBUILDER_HPP__
 #define __BARBUILDER_HPP__
 
+#include <vector>
+
 #include "BarDetector.hpp"
+#include "FlatMap.hpp"
 #include "HighResTimingData.hpp"
 
-//! Class that builds bars out of a list of ends
+/** Defines a map to hold the average time and energy of bars without traces */
+typedef FlatMap<unsigned int, std::pair<double, double> > LrtBarMap;
+
+//! Class that builds bars out of a list of ends. The builder only keeps
+//! pointers to the events, and its maps keep their memory between calls to
+//! BuildBars, so a builder that is reused for every event does not allocate
+//! once it has seen the largest event.
 class BarBuilder {
 public:
     /** Default constructor */
-    BarBuilder() {};
+    BarBuilder() : list_(NULL) {};
 
     /** Constructor taking the map of channels to build bars with
-     * \param [in] vec : Reference to the vector to build channels with */
-    BarBuilder(const std::vector<ChanEvent *> vec) { list_ = vec; };
+     * \param [in] vec : Reference to the vector to build channels with. It
+     * has to live until the bars are built. */
+    BarBuilder(const std::vector<ChanEvent *> &vec) : list_(&vec) {};
 
     /** Default destructor */
     virtual ~BarBuilder() {};
@@ -25,13 +35,12 @@ public:
     /** Gets the built bar map. If you have used the default constructor
      * you must call the BuildBars method <strong> first </strong>.
      * \return A BarMap of the bars having traces. */
-    BarMap GetBarMap(void) { return (hrtBars_); };
+    const BarMap &GetBarMap(void) const { return (hrtBars_); };
 
     /** Gets the built bar map. If you have used the default constructor
      * you must call the BuildBars method <strong> first </strong>.
      * \return A BarMap of the bars having no traces */
-    std::map<unsigned int, std::pair<double, double> >
-    GetLrtBarMap(void) { return (lrtBars_); };
+    const LrtBarMap &GetLrtBarMap(void) const { return (lrtBars_); };
 
     /** Builds BarDetectors from the individual channel maps. We make assumptions
 	that the bars are not going to be vastly out of order, such that the 
@@ -39,10 +48,18 @@ public:
 	(as of 04/22/2016) VANDLE firmware. */
     void BuildBars(void);
 
+    /** Sets the channel list and builds the bars out of it.
+     * \param [in] a : The channel list to build bars out of. */
+    void BuildBars(const std::vector<ChanEvent *> &a) {
+        SetChannelList(a);
+        BuildBars();
+    }
+
     /** Sets the channel list to build bars out of. This list <strong>
-     * must </strong> contain both ends of the detector.
+     * must </strong> contain both ends of the detector and has to live until
+     * the bars are built.
      * \param [in] a : The channel list to build bars out of. */
-    void SetChannelList(const std::vector<ChanEvent *> a) { list_ = a; };
+    void SetChannelList(const std::vector<ChanEvent *> &a) { list_ = &a; };
 private:
     /** The bar number calculated from the location. We assume here
      * that the bars are located in adjacent slots so that they are always
@@ -55,18 +72,18 @@ private:
     /** Clears out the data maps from any previously built bars and ends */
     void ClearMaps(void);
 
-    /** Fills the ends of the detector into two separate maps. Things labeled
-     * {left, up,top} are filled into one map, and things labeled {right, down,bottom}
-     * are filled into another map. Currently these are the only six
-     * recognized end types that one may have, this can be expanded later if
-     * others should arise. */
+    /** Fills the ends of the detector into two arrays indexed by the bar
+     * number. Things labeled {left, up,top} are filled into one array, and
+     * things labeled {right, down,bottom} are filled into another. Currently
+     * these are the only six recognized end types that one may have, this can
+     * be expanded later if others should arise. */
     void FillMaps(void);
 
     BarMap hrtBars_; //!< Map containing bars with high resolution timing..
-    std::map<unsigned int, std::pair<double, double> > lrtBars_; //!<Map with low res bars
-    std::map<unsigned int, unsigned int> lefts_; //!< Map containing the left sides of bars
-    std::map<unsigned int, unsigned int> rights_; //!< Map containing the left sides of bars
-    std::vector<ChanEvent *> list_; //!< Vector of events to build bars out of.
+    LrtBarMap lrtBars_; //!<Map with low res bars
+    std::vector<const ChanEvent *> lefts_; //!< The left sides of the bars indexed by bar number
+    std::vector<const ChanEvent *> rights_; //!< The right sides of the bars indexed by bar number
+    const std::vector<ChanEvent *> *list_; //!< Vector of events to build bars out of.
 };
 
 #endif // __BARBUILDER_HPP_
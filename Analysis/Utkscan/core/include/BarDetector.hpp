@@ -8,8 +8,8 @@
 
 #include <iostream>
 #include <limits>
-#include <map>
 
+#include "FlatMap.hpp"
 #include "HighResTimingData.hpp"
 #include "TimingCalibrator.hpp"
 
@@ -26,12 +26,8 @@ public:
     * \param [in] Right : The right side of the bar
     * \param [in] Left : The left side of the bar
     * \param [in] key : The TimingIdentifier for the bar */
-    BarDetector(HighResTimingData Left, HighResTimingData Right,
-                TimingDefs::TimingIdentifier &key) {
-        left_ = Left;
-        right_ = Right;
-        key_ = key;
-    }
+    BarDetector(const HighResTimingData &Left, const HighResTimingData &Right,
+                const TimingDefs::TimingIdentifier &key) : right_(Right), left_(Left), key_(key) {}
 
     /** \return the true if there was an event in the bar */
     bool GetHasEvent(void) const {
@@ -134,5 +130,5 @@ private:
 };
 
 /** Defines a map to hold Bar Detectors */
-typedef std::map<TimingDefs::TimingIdentifier, BarDetector> BarMap;
+typedef FlatMap<TimingDefs::TimingIdentifier, BarDetector> BarMap;
 #endif // __BARDETECTOR_HPP__
@@ -9,6 +9,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <utility>
 
 #include "ChannelConfiguration.hpp"
 
@@ -65,12 +66,45 @@ public:
      * \param [in] raw : the raw value to use for the calibration */
     double GetCalEnergy(const ChannelConfiguration &chanID, double raw) const;
 
+    /** Builds a table of the calibrations indexed by channel id, so that
+     * GetCalEnergy can find a channel without comparing configurations.
+     * Channels added after this are only found by their ChannelConfiguration
+     * until Compile is called again.
+     * \param [in] channels : the configuration of every channel, indexed by
+     * channel id */
+    void Compile(const std::vector<ChannelConfiguration> &channels);
+
+    /** \return calibrated energy for the channel with the given id in the
+     * table built by Compile.
+     * \param [in] index : the channel id
+     * \param [in] raw : the raw value to use for the calibration */
+    double GetCalEnergy(const unsigned int &index, double raw) const {
+        if (index >= table_.size() || table_[index].second == 0)
+            return raw;
+        return Calibrate(&compiled_[table_[index].first], table_[index].second, raw);
+    }
+
 private:
     /** Map where key is a channel ChannelConfiguration
      * and value is a vector holding struct with calibration range
      * and calibration model and parameters.*/
     std::map<ChannelConfiguration, std::vector<CalibrationParams>> channels_;
 
+    /** The calibration ranges of every channel in the table, stored one
+     * channel after another */
+    std::vector<CalibrationParams> compiled_;
+
+    /** The first range in compiled_ and the number of ranges for each
+     * channel id. Channels without a calibration have no ranges. */
+    std::vector<std::pair<unsigned int, unsigned int> > table_;
+
+    /** \return the calibrated value using the first range that holds raw,
+     * or 0 if none of them do.
+     * \param [in] ranges : the calibration ranges of the channel
+     * \param [in] numRanges : the number of ranges
+     * \param [in] raw : the raw value to calibrate */
+    double Calibrate(const CalibrationParams *ranges, const unsigned int &numRanges, double raw) const;
+
     /** Use if you want to switch off the calibration.
      * \param [in] raw : the raw value to calibrate
      * \return the raw channel number. */
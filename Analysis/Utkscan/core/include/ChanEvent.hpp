@@ -30,7 +30,7 @@ public:
     ///Constructor taking the base class as an argument so that we can set
     /// the trace information properly
     ///@param[in] evt : The event that we are going to assign here.
-    ChanEvent(XiaData &evt) : ProcessedXiaData(evt) {}
+    ChanEvent(const XiaData &evt) : ProcessedXiaData(evt) {}
 
     ///Default Destructor
     ~ChanEvent() {}
@@ -48,7 +48,7 @@ public:
     ///@return true if the module number, channel number, and time are identical
     bool operator==(const ChanEvent &rhs) const {
         return GetModuleNumber() == rhs.GetModuleNumber() && GetChannelNumber() == rhs.GetChannelNumber() &&
-                GetTime() == rhs.GetTime();
+                GetTimestamp() == rhs.GetTimestamp();
     }
 
     ///Not - Equality operator for ChanEvent
@@ -61,7 +61,7 @@ public:
     ///@return true if the type, subtype, or location are less than those in rhs
     bool operator<(const ChanEvent &rhs) const {
         if(GetWalkCorrectedTime() == 0)
-            return GetTime() < rhs.GetTime();
+            return GetTimestamp() < rhs.GetTimestamp();
         return GetWalkCorrectedTime() < rhs.GetWalkCorrectedTime();
     }
 
@@ -0,0 +1,65 @@
+///@file ChanEventPool.hpp
+///@brief A recycling pool of ChanEvent objects so that the raw events are
+/// built without going through the allocator for every channel.
+///@date October 17, 2026
+#ifndef __CHANEVENTPOOL_HPP__
+#define __CHANEVENTPOOL_HPP__
+
+#include <mutex>
+#include <vector>
+
+class ChanEvent;
+class XiaData;
+
+///A pool that owns all of the ChanEvents handed out by it. Released events go
+/// back on a free list and are assigned the next XiaData that we are asked
+/// for. The events keep the storage of their traces and trace analysis
+/// buffers, so once the pool has seen the largest event of the run a raw
+/// event is built without any heap allocations.
+class ChanEventPool {
+public:
+    ///Default constructor
+    ChanEventPool() : threadSafe_(false) {}
+
+    ///Destructor that frees every event that the pool has ever created.
+    ~ChanEventPool();
+
+    ///@param[in] data : The decoded channel that the event is made from
+    ///@return An event holding the information of the channel. A new event is
+    /// only created if the free list is empty.
+    ChanEvent *Acquire(const XiaData &data);
+
+    ///Returns an event to the pool so that it can be recycled. The event
+    /// must have been obtained from this pool.
+    ///@param[in] event : The event to recycle
+    void Release(ChanEvent *event);
+
+    ///Makes sure that the pool holds at least the requested number of events.
+    ///@param[in] size : The number of events to preallocate.
+    void Reserve(const unsigned int &size);
+
+    ///Toggles locking of the pool so that events can be acquired and released
+    /// from several threads at once.
+    ///@param[in] state : True if the pool is shared between threads
+    void SetThreadSafe(const bool &state = true) { threadSafe_ = state; }
+
+    ///@return The number of events currently handed out by the pool.
+    unsigned int GetNumberInUse() const { return (unsigned int) (storage_.size() - free_.size()); }
+
+    ///@return The total number of events that the pool has created.
+    unsigned int GetCapacity() const { return (unsigned int) storage_.size(); }
+
+private:
+    ChanEventPool(const ChanEventPool &); ///< Pools cannot be copied
+    ChanEventPool &operator=(const ChanEventPool &); ///< Pools cannot be assigned
+
+    std::vector<ChanEvent *> storage_; ///< Every event created by the pool
+    std::vector<ChanEvent *> free_; ///< The events ready to be handed out
+    bool threadSafe_; ///< True if Acquire and Release need to lock the pool
+    std::mutex mutex_; ///< Protects the free list when the pool is shared
+
+    ///@return An event from the free list without locking the pool.
+    ChanEvent *AcquireUnlocked();
+};
+
+#endif //__CHANEVENTPOOL_HPP__
@@ -68,12 +68,18 @@
 
 class Calibration;
 
+class DetectorSummary;
+
 class RawEvent;
 
 class EventProcessor;
 
 class TraceAnalyzer;
 
+class Place;
+
+class TreeCorrelator;
+
 /*! \brief DetectorDriver controls event processing
 
   This class controls the processing of each event and includes the
@@ -82,9 +88,36 @@ class TraceAnalyzer;
 */
 class DetectorDriver {
 public:
-    /*! \return Instance is created upon first call */
+    /*! \return Instance is created upon first call. This is the replica
+     * that was set for the calling thread with SetLocal, if there is one. */
     static DetectorDriver *get();
 
+    /*! Sets the DetectorDriver that get returns in the calling thread.
+     * \param [in] driver : the replica to use or NULL to use the instance */
+    static void SetLocal(DetectorDriver *driver) { local_ = driver; }
+
+    /*! \brief Creates a replica of the driver for a worker thread.
+     * The replica loads its own processors and analyzers from the
+     * configuration file and plots into the histograms of this instance. It
+     * needs its own TreeCorrelator, see TreeCorrelator::Replicate, and must
+     * be initialized with Init on its own RawEvent.
+     * \return The replica, which belongs to the caller */
+    DetectorDriver *Replicate() const;
+
+    /*! Writes the ROOT events kept by a replica into our tree. The caller
+     * has to make sure that neither driver is processing an event.
+     * \param [in] replica : the replica to merge */
+    void MergeReplica(DetectorDriver *replica);
+
+    /*! \return True if the events have to be processed in time order by a
+     * single driver. This is the case if any of the processors asks for it or
+     * if the TreeCorrelator has places that keep their state across events. */
+    bool IsTimeOrdered() const;
+
+    /*! Sets the event number that is given to the next event
+     * \param [in] a : the event number */
+    void SetEventNumber(const unsigned long &a) { eventNumber_ = a; }
+
     const WalkCorrector *walk_; //!< Instance of the walk correction
     const Calibrator *cali_;//!< Instance of the calibrator
     Plots histo;//!< Instance of the histogram class
@@ -215,12 +248,15 @@ public:
 
 
 private:
-    /** Constructor that initializes the various processors and analyzers. */
-    DetectorDriver();
+    /** Constructor that initializes the various processors and analyzers.
+     * \param [in] isReplica : True if this is a replica for a worker thread */
+    DetectorDriver(const bool &isReplica = false);
 
     DetectorDriver(const DetectorDriver &); //!< Overloaded constructor
     DetectorDriver &operator=(DetectorDriver const &);//!< Equality constructor
     static DetectorDriver *instance;//!< The only instance of DetectorDriver
+    static thread_local DetectorDriver *local_;//!< The replica used by the calling thread
+    bool isReplica_;//!< True if this is a replica used by a worker thread
 
     std::vector<EventProcessor *> vecProcess; /**< vector of processors to handle each event */
 
@@ -234,6 +270,37 @@ private:
     double firstEventTime_; //!< The time of the first event that passes through the DetectorDriver
     double firstEventTimeinNs_; //!< The time of the first event that passes through the DetectorDriver in ns
     double eventFirstTime_; //!<The Time of the first detector event in the current pixie event
+
+    /// What ThreshAndCal and ProcessEvent need to know about a channel. It is
+    /// worked out from the channel configuration on the first hit in the
+    /// channel, so that the following hits need no string work.
+    struct ChannelDispatch {
+        bool resolved; //!< True once the entry has been filled in
+        bool ignored; //!< True if the type is "ignore" or empty
+        bool hasIts; //!< True if the channel has the "its" tag
+        bool hasEts1; //!< True if the channel has the "ets1" tag
+        bool hasEts2; //!< True if the channel has the "ets2" tag
+        std::vector<TraceAnalyzer *> analyzers; //!< The analyzers that do not ignore the channel
+        DetectorSummary *typeSummary; //!< The summary for the type
+        DetectorSummary *subtypeSummary; //!< The summary for type:subtype, NULL if there is none
+        DetectorSummary *startSummary; //!< The summary for type:subtype:start, NULL if unused
+        Place *place; //!< The place of the channel in the TreeCorrelator, NULL if it has none
+
+        ChannelDispatch() : resolved(false), ignored(false), hasIts(false), hasEts1(false), hasEts2(false),
+                            typeSummary(NULL), subtypeSummary(NULL), startSummary(NULL), place(NULL) {}
+    };
+
+    std::vector<ChannelDispatch> dispatch_; //!< The dispatch entries, indexed by channel id
+    const RawEvent *dispatchEvent_; //!< The raw event that owns the summaries in dispatch_
+    const TreeCorrelator *dispatchTree_; //!< The TreeCorrelator that owns the places in dispatch_
+    size_t dispatchSummaries_; //!< The number of summaries in dispatchEvent_ when dispatch_ was last filled in
+
+    /*! \return The dispatch entry of a channel, filled in if this is the
+     * first hit in the channel or if summaries were added since
+     * \param [in] chan : the channel to look up
+     * \param [in] rawev : the raw event holding the detector summaries */
+    ChannelDispatch &GetDispatch(const ChanEvent *chan, RawEvent &rawev);
+
     /*! Declares a 1D histogram calls the C++ wrapper for DAMM
     * \param [in] dammId : The histogram number to define
     * \param [in] xSize : The range of the x-axis
@@ -267,6 +334,7 @@ private:
     TBranch *PBr;
 
     PixTreeEvent pixie_tree_event_; /** tree event container class **/
+    std::vector<PixTreeEvent> treeEvents_; /** events of a replica waiting for MergeReplica **/
 
     bool sysrootbool_; ///Bool for ROOT ouput
     bool fillLogic_; /// Should we fill the logic struct
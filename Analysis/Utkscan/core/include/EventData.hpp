@@ -7,6 +7,7 @@
 
 #include <string>
 #include "Globals.hpp"
+#include "XiaTimestamp.hpp"
 
 /** \brief Simple structure holding basic parameters needed for correlation
  * of events in the same place. */
@@ -23,6 +24,7 @@ public:
     EventData(double ptime, bool pstatus = true, double penergy = 0,
               int plocation = -1, std::string ptype = "") {
         time = ptime;
+        timestamp = XiaTimestamp::FromDouble(ptime);
         status = pstatus;
         energy = penergy;
         location = plocation;
@@ -38,6 +40,25 @@ public:
     EventData(double ptime, double penergy, int plocation = -1,
               bool pstatus = true, std::string ptype = "") {
         time = ptime;
+        timestamp = XiaTimestamp::FromDouble(ptime);
+        energy = penergy;
+        location = plocation;
+        status = pstatus;
+        type = ptype;
+    }
+
+    /** Timestamp, energy, location type of constructor. The time is kept
+     * exactly so that the correlations can order the events with integer
+     * compares.
+     * \param [in] ptimestamp : the timestamp to set
+     * \param [in] penergy : the energy to set
+     * \param [in] plocation : the location to set
+     * \param [in] pstatus : the status to set
+     * \param [in] ptype : the type to set */
+    EventData(const XiaTimestamp &ptimestamp, double penergy,
+              int plocation = -1, bool pstatus = true, std::string ptype = "") {
+        time = ptimestamp.ToDouble();
+        timestamp = ptimestamp;
         energy = penergy;
         location = plocation;
         status = pstatus;
@@ -46,6 +67,7 @@ public:
 
     bool status; //!< the status of the event
     double time;//!< the time of the event
+    XiaTimestamp timestamp;//!< the time of the event in ADC ticks and CFD fractions
     double energy;//!< the energy of the event
     int location;//!< the location of the detector
     std::string type;//!< the detector type
@@ -0,0 +1,116 @@
+///@file FlatMap.hpp
+///@brief A map that keeps its entries sorted in a vector so that clearing and
+/// refilling it every event does not allocate.
+///@date October 17, 2026
+#ifndef __FLATMAP_HPP__
+#define __FLATMAP_HPP__
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+///@brief A sorted vector with the parts of the std::map interface that the
+/// builders and processors use. The entries are stored contiguously and
+/// clear() keeps the capacity, so a map that is filled once per event stops
+/// allocating after the first few events. Inserting or erasing invalidates
+/// the iterators, just as it does for a vector.
+template<typename Key, typename Value>
+class FlatMap {
+public:
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef std::pair<Key, Value> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+    typedef typename std::vector<value_type>::size_type size_type;
+
+    ///Default Constructor
+    FlatMap() {}
+
+    ///Default Destructor
+    ~FlatMap() {}
+
+    ///@return An iterator to the entry with the smallest key
+    iterator begin() { return data_.begin(); }
+
+    ///@return An iterator to the entry with the smallest key
+    const_iterator begin() const { return data_.begin(); }
+
+    ///@return An iterator past the entry with the largest key
+    iterator end() { return data_.end(); }
+
+    ///@return An iterator past the entry with the largest key
+    const_iterator end() const { return data_.end(); }
+
+    ///@return The number of entries in the map
+    size_type size() const { return data_.size(); }
+
+    ///@return True if there are no entries in the map
+    bool empty() const { return data_.empty(); }
+
+    ///Removes all of the entries but keeps the memory for the next fill.
+    void clear() { data_.clear(); }
+
+    ///Reserves memory for the given number of entries
+    ///@param[in] a : The number of entries to reserve memory for
+    void reserve(const size_type &a) { data_.reserve(a); }
+
+    ///@param[in] key : The key to look for
+    ///@return An iterator to the entry with the key or end() if there is none
+    iterator find(const Key &key) {
+        iterator it = LowerBound(key);
+        return it != data_.end() && !(key < it->first) ? it : data_.end();
+    }
+
+    ///@param[in] key : The key to look for
+    ///@return An iterator to the entry with the key or end() if there is none
+    const_iterator find(const Key &key) const {
+        const_iterator it = LowerBound(key);
+        return it != data_.end() && !(key < it->first) ? it : data_.end();
+    }
+
+    ///@param[in] key : The key to look for
+    ///@return 1 if there is an entry with the key, 0 otherwise
+    size_type count(const Key &key) const { return find(key) != end() ? 1 : 0; }
+
+    ///Inserts the entry if there is no entry with its key yet.
+    ///@param[in] entry : The key and value to insert
+    ///@return The iterator to the entry with the key and true if it was inserted
+    std::pair<iterator, bool> insert(const value_type &entry) {
+        iterator it = LowerBound(entry.first);
+        if (it != data_.end() && !(entry.first < it->first))
+            return std::make_pair(it, false);
+        return std::make_pair(data_.insert(it, entry), true);
+    }
+
+    ///@param[in] key : The key of the entry to access
+    ///@return The value with the key, which is default constructed if the key was not in the map
+    Value &operator[](const Key &key) {
+        return insert(std::make_pair(key, Value())).first->second;
+    }
+
+    ///Removes the entry that the iterator points to
+    ///@param[in] it : The entry to remove
+    ///@return An iterator to the entry after the removed one
+    iterator erase(iterator it) { return data_.erase(it); }
+
+private:
+    ///@return The first entry whose key is not less than the given key
+    iterator LowerBound(const Key &key) {
+        return std::lower_bound(data_.begin(), data_.end(), key, CompareKey());
+    }
+
+    ///@return The first entry whose key is not less than the given key
+    const_iterator LowerBound(const Key &key) const {
+        return std::lower_bound(data_.begin(), data_.end(), key, CompareKey());
+    }
+
+    ///Compares an entry to a key using only the key of the entry
+    struct CompareKey {
+        bool operator()(const value_type &lhs, const Key &rhs) const { return lhs.first < rhs; }
+    };
+
+    std::vector<value_type> data_; //!< The entries sorted by their key
+};
+
+#endif // __FLATMAP_HPP__
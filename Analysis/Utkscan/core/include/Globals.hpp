@@ -109,7 +109,7 @@ public:
     std::string GetPixieRevision() const { return revision_; }
 
     ///@return rejection regions to exclude from scan.
-    std::vector<std::pair<unsigned int, unsigned int> > GetRejectionRegions() const { return reject_; }
+    const std::vector<std::pair<unsigned int, unsigned int> > &GetRejectionRegions() const { return reject_; }
 
     ///@return the frequency of the system clock in Hz
     double GetSystemClockFreqInHz() const { return sysClockFreqInHz_; }
@@ -8,21 +8,52 @@
 
 #include "ChanEvent.hpp"
 #include "Constants.hpp"
+#include "FlatMap.hpp"
 #include "Globals.hpp"
 
 //! Class for holding information for high resolution timing. All times more
 //! precise than the filter time will be in nanoseconds (phase, highResTime).
-class HighResTimingData : public ChanEvent {
+//! The class only points to the channel event that it was made from, so it is
+//! cheap to copy but is only valid as long as the event is, i.e. until the
+//! RawEvent is cleared for the next event.
+class HighResTimingData {
 public:
     /** Default constructor */
-    HighResTimingData() {};
+    HighResTimingData() : evt_(NULL) {};
 
     /** Default destructor */
     virtual ~HighResTimingData() {};
 
     /** Constructor using the channel event
     * \param [in] chan : the channel event for grabbing values from */
-    HighResTimingData(ChanEvent &evt) : ChanEvent(evt) {}
+    HighResTimingData(const ChanEvent &evt) : evt_(&evt) {}
+
+    /** \return The channel event that this data was made from */
+    const ChanEvent &GetChanEvent() const { return *evt_; }
+
+    /** \return The channel configuration of the event */
+    const ChannelConfiguration &GetChanID() const { return evt_->GetChanID(); }
+
+    /** \return The calibrated energy of the event */
+    double GetCalibratedEnergy() const { return evt_->GetCalibratedEnergy(); }
+
+    /** \return The energy of the event */
+    double GetEnergy() const { return evt_->GetEnergy(); }
+
+    /** \return The high resolution time of the event in ns */
+    double GetHighResTimeInNs() const { return evt_->GetHighResTimeInNs(); }
+
+    /** \return The time of the event in clock ticks */
+    double GetTime() const { return evt_->GetTime(); }
+
+    /** \return The time of the event in clock ticks without the CFD correction */
+    double GetTimeSansCfd() const { return evt_->GetTimeSansCfd(); }
+
+    /** \return The trace of the event */
+    const Trace &GetTrace() const { return evt_->GetTrace(); }
+
+    /** \return The walk corrected time of the event */
+    double GetWalkCorrectedTime() const { return evt_->GetWalkCorrectedTime(); }
 
     /** Calculate the energy from the time of flight, using a correction
     * \param [in] tof : The time of flight to use for the calculation in ns
@@ -36,7 +67,7 @@ public:
     ///@return True if the trace was successfully analyzed and we managed to
     /// find a phase.
     bool GetIsValid() const {
-        if (GetTrace().HasValidWaveformAnalysis() && GetTrace().HasValidTimingAnalysis() && GetTrace().GetPhase() != 0.0)
+        if (evt_ && GetTrace().HasValidWaveformAnalysis() && GetTrace().HasValidTimingAnalysis() && GetTrace().GetPhase() != 0.0)
             return (true);
         return (false);
     }
@@ -106,8 +137,10 @@ public:
     }
 
 #endif
+private:
+    const ChanEvent *evt_; //!< The event that holds the data
 };
 
 /** Defines a map to hold timing data for a channel. */
-typedef std::map<TimingDefs::TimingIdentifier, HighResTimingData> TimingMap;
+typedef FlatMap<TimingDefs::TimingIdentifier, HighResTimingData> TimingMap;
 #endif // __HIGHRESTIMINGDATA_HPP__
@@ -13,16 +13,14 @@
 #ifndef HISFILE_H
 #define HISFILE_H
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <memory>
-#include <thread>
-#include <deque>
-#include <unistd.h>
-#include <mutex>
 #ifndef USE_HRIBF
 
 /// Create a DAMM 1D histogram
@@ -120,6 +118,22 @@ struct drr_entry {
     unsigned int total_counts; /// Total number of attempted histogram fills
     unsigned int good_counts; /// Total number of actual histogram fills
 
+    /// Number of cells in each block of the histogram that is written to the
+    /// .his file as a whole when it has changed
+    static const size_t cells_per_block = 4096;
+
+    /// Contents of every cell of a histogram being written by OutputHisFile.
+    /// Cells are kept as ints for short histograms too, and are truncated to
+    /// the cell size of the histogram when they are written to file.
+    std::vector<unsigned int> cells;
+    std::vector<bool> dirty; /// True for blocks of cells changed since the last write
+
+    /// True if the cells did not fit in the memory limit of the OutputHisFile
+    /// and are added to the .his file in place when it is flushed
+    bool on_disk = false;
+    /// Weights to add to the cells of a histogram kept on disk, keyed by global bin
+    std::map<unsigned int, unsigned int> pending;
+
     /// Default constructor
     drr_entry() {}
 
@@ -188,6 +202,27 @@ struct drr_entry {
     {
         return (offset * 2) + (bin * halfWords * 2);
     }
+
+    /// Allocate the in-memory cells of the histogram, set to zero
+    void allocate_cells() {
+        cells.assign(total_bins, 0);
+        dirty.assign((total_bins + cells_per_block - 1) / cells_per_block, false);
+    }
+
+    /// Add weight_ to the cell at a global bin, or to the pending weights of a
+    /// histogram kept on disk. Returns false if the bin is past the end of the
+    /// histogram or the cells are not allocated.
+    bool increment(unsigned int bin_, unsigned int weight_) {
+        if (on_disk) {
+            if (bin_ >= total_bins) { return false; }
+            pending[bin_] += weight_;
+            return true;
+        }
+        if (bin_ >= cells.size()) { return false; }
+        cells[bin_] += weight_;
+        dirty[bin_ / cells_per_block] = true;
+        return true;
+    }
 };
 
 
@@ -338,121 +373,21 @@ public:
 
 
 
-struct WriteQueueObject
-{
-
-    /// @brief Location in the file that needs to be written to
-    unsigned long long bufferLocation;
-    /// @brief If the drr_entry for the histogram indicates that this histogram is integer valued
-    bool isInt;
-    /// @brief How much weight to add to the bin
-    unsigned int weight;
-
+/// Histogram fills made by one thread that have not been added to the
+/// histograms of the OutputHisFile yet
+struct HisFillDelta {
+    /// Weight to add to each bin, keyed by (his ID << 32 | global bin)
+    std::unordered_map<unsigned long long, unsigned int> weights;
+    /// Number of attempted and good fills, keyed by his ID
+    std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int> > counts;
+    std::set<unsigned int> undef_his; /// IDs of undefined histograms that were filled
+    unsigned int fills; /// Number of fills made into the delta
+    unsigned long long generation; /// Number of Zero calls on the file when the delta was started
+    HisFillDelta *next; /// The next delta waiting to be merged
 
-    WriteQueueObject(unsigned long long bufferLoc, bool isInt, unsigned int weight) :
-        bufferLocation(bufferLoc), isInt(isInt), weight(weight){};
+    HisFillDelta() : fills(0), generation(0), next(nullptr) {}
 };
 
-
-class HisFileWriter final
-{
-    private:
-        /// @brief How many events have been processed since the last write
-        unsigned long long events_since_write;
-
-        /// @brief How many events will be processed between writes, serves as a way to keep from
-        /// writing too often
-        unsigned long long max_events_between_writes;
-
-        /// @brief Waiting writes to specific locations in the output file
-        std::map<unsigned long long, std::pair<unsigned int, bool>> waiting_writes; 
-
-        /// @brief Events that are scheduled to be written but not yet processed
-        std::deque<WriteQueueObject> event_queue;
-
-        /// @brief ptr to the output file in the OutputHisFile object
-        std::fstream *ofile;
-
-        /// @brief used to help the thread determine if it needs to halt execution
-        bool stopCalled;
-        
-        /// @brief serves as a guard to prevent multiple threads of execution being started
-        bool running;
- 
-        /// @brief The execution thread for the HisFileWriter
-        /// static object because I'm a dolt and sleep deprived
-        std::thread HisFileWriterEventThread;
-    public:
-        static std::shared_ptr<HisFileWriter> instance;
-        HisFileWriter()
-        {
-            events_since_write = 0;
-            max_events_between_writes = 1000000;
-            waiting_writes = {};
-            event_queue = {};
-            ofile = nullptr;
-            stopCalled = false;
-            running = false;
-        }
-        /// @brief Used to allow utkscan and HisFileWriter to share the queues
-        std::mutex HisWriterMutex;
-
-        static void SetOfile(std::fstream *ofile_)
-        {
-            instance->ofile = ofile_;
-        }
-        
-        /// @brief Takes a vector of events and pushes them to the queue on the execution thread
-        /// uses the mutex to lock access to the queue while operating
-        /// @param events a vector of events
-        static void EnqueueWrites(std::vector<WriteQueueObject> &events);
-
-        inline static void SetMaxEventsBetweenWrites(unsigned long long newMax)
-        {
-            instance->max_events_between_writes = newMax;
-        }
-        
-        /// Stops the event loop, finishing processing all events
-        /// before terminating the thread
-        static void Stop(){
-            if(!instance->running) {return;}
-            instance->stopCalled = true;
-            instance->running = false;
-            instance->HisFileWriterEventThread.join();
-        }
-
-        /// @brief Starts the execution thread fo the HisFileWriter which does nothing until
-        /// events are passed in using EnqeueWrite()
-        static void Start(){
-            if(instance->running) {return;}
-            instance->running = true;
-            instance->HisFileWriterEventThread = std::thread(EventLoop);
-        }
-
-        /// @brief Takes events from the event queue and pushes them into waiting writes
-        static void ProcessQueue();
-
-        /// @brief Flushes all waiting writes to disk
-        static void FlushWrites();
-
-        /// @brief Completely empties the event queue and then flushes all remaining writes to disk
-        static void Finalize();
-
-        /// @brief Handles processing the queue and flushing the disk, this is the
-        /// alternates between reading from the queue and writing to disk.
-        static inline void EventLoop(){
-            while(!instance->stopCalled)
-            {
-                ProcessQueue();
-                FlushWrites();
-                usleep(10);
-            }
-            Finalize();
-        }
-};
-
-
-
 class OutputHisFile : public HisFile {
 private:
     std::fstream ofile; /// The output .his file stream
@@ -463,19 +398,58 @@ private:
     unsigned int Flush_wait; /// Number of fills to wait between Flushes
     unsigned int Flush_count; /// Number of fills since last Flush
 
-    /// @brief a vector of events we're waiting to send to the writer
-    std::vector<WriteQueueObject> waiting_to_enqueue = {};
     std::map<unsigned int, unsigned long long> failed_fills; /// Vector containing list of histogram fills into an invalid his id
     std::set<unsigned int> undef_his_failed_fills; /// Vector containing list of histogram fills into an invalid his id
     /// Vector containing list of histogram fills that failed because they did not try to access a valid bin
     std::map<unsigned int, unsigned long long>  bin_not_found_failed_fills;
     std::streampos total_his_size; /// Total size of .his file
+    size_t memory_limit; /// Largest number of bytes of histogram cells kept in memory
+    size_t memory_used; /// Number of bytes of histogram cells kept in memory
+
+    bool threaded_fills; /// True if fills go to the delta of the calling thread
+    std::atomic<HisFillDelta *> full_deltas; /// Deltas handed over by the threads, waiting to be merged
+    std::atomic_flag merging = ATOMIC_FLAG_INIT; /// Held by the thread merging deltas or writing the file
+    unsigned long long merged_fills; /// Number of fills merged since the last write to file
+
+    const unsigned long long instance_id; /// Number telling this file apart from every other OutputHisFile
+    static std::atomic<unsigned long long> next_instance_id; /// The number given to the next OutputHisFile
+
+    std::atomic<unsigned long long> zero_generation; /// Number of Zero calls, starts the generation of new deltas
+    unsigned long long all_zeroed_at; /// Generation of the last call to Zero all histograms. Must hold merging.
+    std::map<unsigned int, unsigned long long> zeroed_at; /// Generation each histogram was last zeroed at. Must hold merging.
+
+    /// The deltas of the calling thread, keyed by the instance_id of the file
+    /// they fill, each allocated on the first fill of the thread into that file
+    static thread_local std::unordered_map<unsigned long long, HisFillDelta *> thread_deltas;
+
+    /// Return true if the fills of a delta into a histogram were made before
+    /// the histogram was zeroed. Must hold merging.
+    bool zeroed_since(const HisFillDelta &delta_, unsigned int hisID_);
 
     /// Find the specified .drr entry in the drr list using its histogram id
-    std::shared_ptr<drr_entry> find_drr_in_list(unsigned int hisID_);
+    drr_entry *find_drr_in_list(unsigned int hisID_);
+
+    /// Add a fill to the histograms, or to the delta of the calling thread
+    bool add_fill(unsigned int hisID_, drr_entry *entry_, bool found_,
+                  unsigned int bin_, unsigned int weight_);
 
-    /// Enqueues a write in the output file with a 
-    void EnqueueWrite(std::shared_ptr<drr_entry> entry, unsigned int bin, unsigned int weight);
+    /// Hand the delta of the calling thread over to be merged
+    void publish_delta();
+
+    /// Add every handed over delta to the histograms. Must hold merging.
+    void merge_deltas();
+
+    /// Take the merging flag, waiting for another thread to release it
+    void lock_merging();
+
+    /// Write the changed blocks of a histogram to the .his file
+    void write_blocks(drr_entry &entry_, bool all_ = false);
+
+    /// Add the pending weights of a histogram kept on disk to the .his file
+    void write_pending(drr_entry &entry_);
+
+    /// Set every cell of a histogram to zero, in memory and in the .his file
+    void zero_entry(drr_entry &entry_);
 
 public:
     OutputHisFile();
@@ -491,10 +465,31 @@ public:
     std::fstream *GetOutputFile() { return &ofile; }
 
     /// Set the number of fills to wait between file Flushes
-    void SetFlushWait(unsigned int wait_) { 
-        Flush_wait = wait_;
-        HisFileWriter::SetMaxEventsBetweenWrites(wait_);
-    }
+    void SetFlushWait(unsigned int wait_) { Flush_wait = wait_; }
+
+    /* Set the largest number of bytes of histogram cells to keep in memory.
+     * Cells take 4 bytes whatever the size of the cell on disk, so a 4096 x
+     * 4096 histogram takes 64 MB. Histograms added once the limit is reached
+     * are kept on disk, their fills are summed by bin and added to the .his
+     * file with a read and a write per bin when it is flushed, which is much
+     * slower. A warning is printed for the first of them. Only histograms
+     * added after the call are affected.
+     */
+    void SetMemoryLimit(size_t bytes_) { memory_limit = bytes_; }
+
+    /* Turn threaded fills on or off. While they are on Fill and FillBin may be
+     * called from several threads at once. Each thread sums its fills by
+     * histogram and bin in a delta of its own, without locking, and hands it
+     * over when it is full or when PublishFills is called. A thread that
+     * hands over a delta merges all of the waiting deltas into the histograms,
+     * unless another thread is already doing so. No histograms may be added
+     * while threaded fills are on.
+     */
+    void SetThreadedFills(bool threaded_);
+
+    /// Hand the fills of the calling thread over to the histograms. Every
+    /// thread that filled needs to call this before the file is flushed.
+    void PublishFills();
 
     /* Push back with another histogram entry. This command will also
      * extend the length of the .his file (if possible). DO NOT delete
@@ -518,10 +513,13 @@ public:
     bool FillBin(unsigned int hisID_, unsigned int x_, unsigned int y_,
                  unsigned int weight_ = 1);
 
-    /// Zero the specified histogram 
+    /// Zero the specified histogram. With threaded fills on, the fills into it
+    /// that are not merged yet are discarded. Another thread that is filling
+    /// during the call also loses the fills it makes until it next hands its
+    /// delta over.
     bool Zero(unsigned int hisID_);
 
-    /// Zero all histograms
+    /// Zero all histograms, discarding the fills not merged yet as above
     bool Zero();
 
     /// Open a new .his file
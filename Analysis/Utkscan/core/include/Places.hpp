@@ -6,7 +6,6 @@
 #ifndef __PLACES_HPP__
 #define __PLACES_HPP__
 
-#include <deque>
 #include <iostream>
 #include <vector>
 #include <utility>
@@ -15,6 +14,7 @@
 
 #include "Globals.hpp"
 #include "EventData.hpp"
+#include "RingBuffer.hpp"
 
 /** \brief A pure abstract class to define a "place" for correlator.
  *
@@ -27,10 +27,14 @@ public:
      * fifo remembers only current and previous event.
      * \param [in] resetable : if the place resets automatically
      * \param [in] max_size : sets the maximum size of the fifo */
-    Place(bool resetable = true, unsigned max_size = 2) {
+    Place(bool resetable = true, unsigned max_size = 2) : info_(max_size) {
         resetable_ = resetable;
         max_size_ = max_size;
         status_ = false;
+        dirty_ = false;
+        dirtyList_ = NULL;
+        pending_ = false;
+        orderValid_ = false;
     }
 
     /** Default Destructor */
@@ -77,19 +81,28 @@ public:
         activate(info);
     }
 
+    /** Simplified activation for detectors that have the exact time
+     * of arrival.
+     * \param [in] timestamp : the timestamp for the activation */
+    void activate(const XiaTimestamp &timestamp) {
+        EventData info(timestamp, 0);
+        activate(info);
+    }
+
     /** Changes status to false. Only time and status change is
      * recorded in fifo.
      * \param [in] time : the time at which to set the place */
-    virtual void deactivate(double time) {
-        if (status_) {
-            status_ = false;
-            EventData info(time, status_);
-            add_info_(info);
-            report_(info);
-        } else {
-            EventData info(time, status_);
-            add_info_(info);
-        }
+    void deactivate(double time) {
+        EventData info(time, false);
+        deactivate_(info);
+    }
+
+    /** Changes status to false keeping the exact time of arrival, so that
+     * the places above this one see the same timestamp.
+     * \param [in] timestamp : the timestamp at which to set the place */
+    void deactivate(const XiaTimestamp &timestamp) {
+        EventData info(timestamp, 0, -1, false);
+        deactivate_(info);
     }
 
     /** Changes status to false without storing correlation
@@ -98,6 +111,21 @@ public:
      * the system use deactivate() method.*/
     virtual void reset() { status_ = false; };
 
+    /** Sets the list that a resetable place adds itself to when it records
+     * something, so that only those places are reset at the end of the
+     * event. The place is added right away since it may already have been
+     * activated.
+     * \param [in] list : the list of places to reset, NULL to not track */
+    void setDirtyList(std::vector<Place *> *list) {
+        dirtyList_ = list;
+        dirty_ = false;
+        markDirty_();
+    }
+
+    /** Marks the place as clean after it was reset and taken off the list
+     * of places to reset. */
+    void clearDirty() { dirty_ = false; }
+
     /** \return Logical AND operator for two Places.
     * \param [in] right : the place to use for comparison */
     virtual bool operator&&(const Place &right) const {
@@ -172,10 +200,24 @@ public:
 
     /** Pythonic style private field. Use it if you must,
      * but perhaps you should not. Stores information on past
-     * events in a given Place.*/
-    std::deque<EventData> info_;
+     * events in a given Place, oldest first. The capacity is the fifo
+     * depth, so storing an event never allocates once it is full.*/
+    RingBuffer<EventData> info_;
 
 protected:
+    /** Changes status to false. Only time and status change is
+     * recorded in fifo.
+     * \param [in] info : the deactivation, its status is false */
+    virtual void deactivate_(EventData &info) {
+        if (status_) {
+            status_ = false;
+            add_info_(info);
+            report_(info);
+        } else {
+            add_info_(info);
+        }
+    }
+
     /** Pure virutal function. The check function should decide how
      * to change status depending on the status of children. Should be
      * implemented in a derived class.
@@ -193,28 +235,61 @@ protected:
         parents_.push_back(parent);
     }
 
-    /** Reports change of status to parents.
-     * Calls check() function for all the parents.
+    /** Reports change of status to parents. The parents are marked as
+     * pending and, unless a report is already being propagated, the
+     * ancestors of this place are checked in topological order. Every
+     * pending place is checked once, after all of its children that
+     * changed, and may in turn mark its own parents.
      * \param [in] info : the information to report
      */
     virtual void report_(EventData &info) {
-        std::vector<Place *>::iterator it;
-        for (it = parents_.begin(); it != parents_.end(); ++it)
-            (*it)->check_(info);
+        if (parents_.empty())
+            return;
+        for (std::vector<Place *>::iterator it = parents_.begin(); it != parents_.end(); ++it)
+            (*it)->pending_ = true;
+        if (!propagating_)
+            propagate_(info);
     }
 
+    /** Checks the pending ancestors of the place in topological order.
+     * \param [in] info : the information that started the report */
+    void propagate_(EventData &info);
+
+    /** Fills order_ with the ancestors of the place such that every place
+     * comes after all of its children. */
+    void buildOrder_();
+
+    /** Marks the order of the place and all of the places below it as out
+     * of date, since a new child changed their ancestors. */
+    void invalidateOrder_();
+
     /** Add information to the place
     * \param [in] info : the information to add */
     virtual void add_info_(const EventData &info) {
+        markDirty_();
         info_.push_back(info);
-        while (info_.size() > max_size_)
-            info_.pop_front();
+    }
+
+    /** Adds a resetable place to the list of places to reset at the end of
+     * the event, if it isn't on it already. Every change of the status or
+     * the counters goes through add_info_, which calls this. */
+    void markDirty_() {
+        if (!dirty_ && dirtyList_ && resetable_) {
+            dirty_ = true;
+            dirtyList_->push_back(this);
+        }
     }
 
     /** Status is true if given place is in active state (e.g. detector
      * recorded an event).*/
     bool status_;
 
+    /** True if the place is on the list of places to reset */
+    bool dirty_;
+
+    /** The list of places to reset at the end of the event */
+    std::vector<Place *> *dirtyList_;
+
     /** Indicates if place should be reseted after end of event (true)
      * or if should persist until status is changed explicitly (false).*/
     bool resetable_;
@@ -229,6 +304,19 @@ protected:
      * should be reported.
      */
     std::vector<Place *> parents_;
+
+    /** The ancestors of the place in the order that they are checked */
+    std::vector<Place *> order_;
+
+    /** True if order_ matches the current tree */
+    bool orderValid_;
+
+    /** True if a child reported a change that the place did not check yet */
+    bool pending_;
+
+    /** True while a report is propagated up the tree. Each thread has its
+     * own TreeCorrelator, so the flag is per thread. */
+    static thread_local bool propagating_;
 };
 
 /** \brief "Lazy" Place does not store multiple activation or deactivation events.
@@ -252,13 +340,13 @@ public:
         }
     }
 
+protected:
     /** Changes status to false, time and status change is
      * recorded in fifo only if Place was active before.
-     * \param [in] time : the time to deactivate the place */
-    virtual void deactivate(double time) {
+     * \param [in] info : the deactivation, its status is false */
+    virtual void deactivate_(EventData &info) {
         if (status_) {
             status_ = false;
-            EventData info(time, status_);
             add_info_(info);
             report_(info);
         }
@@ -361,13 +449,6 @@ public:
         Place::activate(info);
     }
 
-    /** Deactive the place
-    * \param [in] time : the time to deactivate */
-    void deactivate(double time) {
-        --counter_;
-        Place::deactivate(time);
-    }
-
     /** Resets the place */
     void reset() {
         Place::reset();
@@ -382,6 +463,13 @@ public:
 protected:
     int counter_;//!< The counter for the place activation
 
+    /** Deactive the place
+    * \param [in] info : the deactivation, its status is false */
+    void deactivate_(EventData &info) {
+        --counter_;
+        Place::deactivate_(info);
+    }
+
     /** \brief Checks to see if a place is active
     * \param [in] info : the information to use for the threshold check */
     virtual void check_(EventData &info);
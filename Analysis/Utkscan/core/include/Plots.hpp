@@ -6,11 +6,14 @@
 #ifndef __PLOTS_HPP_
 #define __PLOTS_HPP_
 
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "Globals.hpp"
 #include "HisFile.hpp"
@@ -157,7 +160,43 @@ public:
     * \return true if the x,y coordinate was inside the banana */
     bool BananaTest(const int &id, const double &x, const double &y);
 
+    /** Turns the buffering of histogram fills on or off. While it is on each
+    * thread collects its fills in its own buffer, which is merged into the
+    * histograms when it is full or when MergeBufferedFills is called. This
+    * is what lets several DetectorDriver replicas plot at the same time.
+    * Without HRIBF the buffers are the lock free per thread deltas of the
+    * OutputHisFile, with HRIBF they are merged into DAMM under a lock.
+    * \param [in] a : True to buffer the fills */
+    static void SetBufferedFills(const bool &a);
+
+    /** \return True if the histogram fills are buffered */
+    static bool IsBufferingFills() { return bufferedFills_; }
+
+    /** Merges the fills buffered by the calling thread into the histograms.
+    * This needs to be called by every thread that plotted before it stops and
+    * before the histograms are written for the last time. */
+    static void MergeBufferedFills();
+
 private:
+    /// A histogram fill that is waiting to be merged into the histograms.
+    struct BufferedFill {
+        int dammId; ///< The histogram id including the offset
+        int x; ///< The x value
+        int y; ///< The y value or weight for a 1D histogram
+        int z; ///< The weight for a 2D histogram or -1 if there is none
+    };
+
+    static std::atomic<bool> bufferedFills_; //!< True if the fills are buffered
+    static std::mutex fillMutex_; //!< Serializes the merges into the histograms
+    static thread_local std::vector<BufferedFill> threadFills_; //!< The fills buffered by this thread
+
+    /** Sends a fill to the histograms or to the buffer of this thread
+    * \param [in] dammId : The histogram id including the offset
+    * \param [in] x : the x value
+    * \param [in] y : the y value or weight for a 1D histogram
+    * \param [in] z : the weight for a 2D histogram or -1 if there is none */
+    static void Fill(const int &dammId, const int &x, const int &y, const int &z);
+
     static PlotsRegister *plots_register_;//!< Instance of the plots register
     /** Holds offset for a given set of plots */
     int offset_;
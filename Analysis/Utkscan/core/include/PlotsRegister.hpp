@@ -30,18 +30,29 @@ public:
     * \return true if everything is good */
     bool Add(int offset, int range, std::string name_);
 
+    /** \return True if the plots being created belong to a replica of the
+     * DetectorDriver. */
+    bool IsReplicating() const { return replicating_; }
+
+    /** Sets the replicating flag. The plots of a DetectorDriver replica share
+     * the ids and histograms of the original, so they are neither registered
+     * nor declared again while the flag is set.
+     * \param [in] a : True while creating a replica */
+    void SetReplicating(const bool &a) { replicating_ = a; }
+
     /** Default destructor */
     ~PlotsRegister();
 
 private:
     /** Default constructor */
-    PlotsRegister() {};
+    PlotsRegister() : replicating_(false) {};
 
     PlotsRegister(const PlotsRegister &);//!< Overload of the constructor
     PlotsRegister &operator=(PlotsRegister const &);//!< the copy constructor
     static PlotsRegister *instance;//!< static instance of the class
 
     std::vector<std::pair<int, int>> reg; //!< Vector of min, max of histogram numbers
+    bool replicating_; //!< True while the plots of a replica are created
 };
 
 #endif // __PLOTSREGISTER_HPP_
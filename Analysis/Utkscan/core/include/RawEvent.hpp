@@ -20,6 +20,7 @@
 #include "Globals.hpp"
 #include "DetectorSummary.hpp"
 #include "ChanEvent.hpp"
+#include "ChanEventPool.hpp"
 
 /** \brief The all important raw event
  *
@@ -36,7 +37,7 @@
 class RawEvent {
 public:
     /** Default Constructor */
-    RawEvent() {};
+    RawEvent() : pool_(NULL) {};
 
     /** Default Destructor */
     ~RawEvent() {};
@@ -53,16 +54,22 @@ public:
     */
     void Init(const std::set<std::string> &usedTypes);
 
-    /** Add a channel event to the raw event
+    /** Add a channel event to the raw event and mark its detector type as
+    * used, so that its summaries are zeroed with the event.
     * \param [in] event : the event to add to the raw event */
-    void AddChan(ChanEvent *event) { eventList.push_back(event); };
+    void AddChan(ChanEvent *event);
+
+    /** Sets the pool that the channel events are returned to when the event
+    * is zeroed. Without a pool the channel events are deleted.
+    * \param [in] a : The pool that the channel events came from */
+    void SetChanEventPool(ChanEventPool *a) { pool_ = a; }
 
     /** \brief Raw event zeroing
     *
     * For any detector type that was used in the event, zero the appropriate
-    * detector summary in the map, and clear the event list
-    * \param [in] usedev : the detector summary to zero */
-    void Zero(const std::set<std::string> &usedev);
+    * detector summaries, give back the channel events and clear the event
+    * list. The memory of the summaries and lists is kept for the next event. */
+    void Zero(void);
 
     /** \brief Get a pointer to a specific detector summary
     *
@@ -77,15 +84,35 @@ public:
     * \param [in] a : the name of the summary that you would like */
     const DetectorSummary *GetSummary(const std::string &a) const;
 
+    /** \return the number of detector summaries that have been constructed */
+    size_t GetNumSummaries(void) const { return sumMap.size(); }
+
     /** \return the list of events */
     const std::vector<ChanEvent *> &GetEventList(void) const { return eventList; }
 
 private:
+    /** Adds a summary to the map and to the summaries of its detector type
+    * \param [in] name : The name of the summary
+    * \param [in] summary : The summary to add
+    * \return An iterator to the summary in the map */
+    std::map<std::string, DetectorSummary>::iterator AddSummary(const std::string &name,
+                                                                const DetectorSummary &summary);
+
+    /** \return The index of the detector type, which is given one if it doesn't have one yet
+    * \param [in] type : The detector type */
+    unsigned int GetTypeIndex(const std::string &type);
+
     std::map<std::string, DetectorSummary> sumMap; /**< An STL map containing DetectorSummary classes
 					    associated with detector types */
     mutable std::set<std::string> nullSummaries;   /**< Summaries which were requested but don't exist */
     std::vector<ChanEvent *> eventList; /**< Pointers to all the channels that are close
                                             enough in time to be considered a single event */
+
+    ChanEventPool *pool_; //!< The pool that the channel events are returned to
+    std::map<std::string, unsigned int> typeIndices_; //!< The index of every detector type
+    std::vector<std::vector<DetectorSummary *> > typeSummaries_; //!< The summaries of each detector type
+    std::vector<int> channelTypes_; //!< The type index of each channel id, -1 if not known yet
+    std::vector<bool> usedTypes_; //!< The types that have channels in the current event
 };
 
 #endif // __RAWEVENT_HPP_
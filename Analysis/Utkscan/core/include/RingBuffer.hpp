@@ -0,0 +1,114 @@
+///@file RingBuffer.hpp
+///@brief A queue with a fixed capacity that overwrites its oldest entry when
+/// it is full.
+///@date October 17, 2026
+#ifndef __RINGBUFFER_HPP__
+#define __RINGBUFFER_HPP__
+
+#include <stdexcept>
+#include <vector>
+
+///@brief Keeps the last N entries that were pushed into it. The memory for
+/// all of the entries is taken when the first N entries are pushed, after
+/// that pushing an entry assigns over the oldest one and never allocates.
+/// Index 0 is the oldest entry and size() - 1 the newest, as with a
+/// std::deque that is trimmed from the front.
+template<typename T>
+class RingBuffer {
+public:
+    typedef T value_type;
+    typedef typename std::vector<T>::size_type size_type;
+
+    ///Constructor
+    ///@param[in] capacity : The number of entries that the buffer keeps
+    explicit RingBuffer(const size_type &capacity = 2) : capacity_(capacity), head_(0) {
+        data_.reserve(capacity);
+    }
+
+    ///Default Destructor
+    ~RingBuffer() {}
+
+    ///@return The number of entries in the buffer
+    size_type size() const { return data_.size(); }
+
+    ///@return The number of entries that the buffer keeps
+    size_type capacity() const { return capacity_; }
+
+    ///@return True if there are no entries in the buffer
+    bool empty() const { return data_.empty(); }
+
+    ///Removes all of the entries but keeps the memory.
+    void clear() {
+        data_.clear();
+        head_ = 0;
+    }
+
+    ///Adds an entry, removing the oldest one if the buffer is full.
+    ///@param[in] value : The entry to add
+    void push_back(const T &value) {
+        if (capacity_ == 0)
+            return;
+        if (data_.size() < capacity_) {
+            data_.push_back(value);
+            return;
+        }
+        data_[head_] = value;
+        if (++head_ == capacity_)
+            head_ = 0;
+    }
+
+    ///@param[in] index : The position of the entry counting from the oldest
+    ///@return The entry without checking the index
+    T &operator[](const size_type &index) { return data_[Position(index)]; }
+
+    ///@param[in] index : The position of the entry counting from the oldest
+    ///@return The entry without checking the index
+    const T &operator[](const size_type &index) const { return data_[Position(index)]; }
+
+    ///@param[in] index : The position of the entry counting from the oldest
+    ///@return The entry
+    ///@throw std::out_of_range if the index is not smaller than size()
+    T &at(const size_type &index) {
+        CheckIndex(index);
+        return (*this)[index];
+    }
+
+    ///@param[in] index : The position of the entry counting from the oldest
+    ///@return The entry
+    ///@throw std::out_of_range if the index is not smaller than size()
+    const T &at(const size_type &index) const {
+        CheckIndex(index);
+        return (*this)[index];
+    }
+
+    ///@return The oldest entry
+    T &front() { return (*this)[0]; }
+
+    ///@return The oldest entry
+    const T &front() const { return (*this)[0]; }
+
+    ///@return The newest entry
+    T &back() { return (*this)[data_.size() - 1]; }
+
+    ///@return The newest entry
+    const T &back() const { return (*this)[data_.size() - 1]; }
+
+private:
+    ///@return The position in the storage of the entry at the index
+    size_type Position(const size_type &index) const {
+        size_type position = head_ + index;
+        return position < data_.size() ? position : position - data_.size();
+    }
+
+    ///Throws if the index is not that of an entry
+    void CheckIndex(const size_type &index) const {
+        if (index >= data_.size())
+            throw std::out_of_range("RingBuffer::at - The index is past the newest entry.");
+    }
+
+    size_type capacity_; //!< The number of entries that the buffer keeps
+    size_type head_; //!< The position of the oldest entry once the buffer is full
+    std::vector<T> data_; //!< The entries
+};
+
+#endif // __RINGBUFFER_HPP__
@@ -9,7 +9,8 @@
 #include "ChanEvent.hpp"
 #include "HighResTimingData.hpp"
 
-//! A class that builds timing maps from a list of ChanEvents
+//! A class that builds timing maps from a list of ChanEvents. The map only
+//! points to the events and keeps its memory between calls to BuildMap.
 class TimingMapBuilder {
 public:
     /** Default constructor */
@@ -22,8 +23,12 @@ public:
      * \param [in] evts : The list of events */
     TimingMapBuilder(const std::vector<ChanEvent *> &evts);
 
+    /** Rebuilds the map from a new list of events
+     * \param [in] evts : The list of events */
+    void BuildMap(const std::vector<ChanEvent *> &evts) { FillMaps(evts); }
+
     /** \return The map of events that had high resolution timing data. */
-    TimingMap GetMap(void) { return (map_); };
+    const TimingMap &GetMap(void) const { return (map_); };
 private:
     /** Fills finds all of the events that had high resolution timing data in
      * the vector of channel events
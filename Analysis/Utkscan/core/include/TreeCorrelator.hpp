@@ -12,6 +12,8 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "pugixml.hpp"
 #include "Places.hpp"
@@ -21,9 +23,24 @@
 /** \brief Singleton class holding map of all places.*/
 class TreeCorrelator {
 public:
-    /** \return Instance of TreeCorrelator class.*/
+    /** \return Instance of TreeCorrelator class. This is the replica that
+     * was set for the calling thread with SetLocal, if there is one. */
     static TreeCorrelator *get();
 
+    /** Sets the TreeCorrelator that get returns in the calling thread.
+    * \param [in] tree : the replica to use or NULL to use the instance */
+    static void SetLocal(TreeCorrelator *tree) { local_ = tree; }
+
+    /** Creates a new tree with the same places as this one by repeating
+     * every call to createPlace. The places of the replica start out
+     * inactive with an empty history.
+     * \return A replica of the tree, which belongs to the caller */
+    TreeCorrelator *Replicate() const;
+
+    /** \return True if any place keeps its state from one event to the next,
+     * which means that the events have to be processed in time order. */
+    bool HasPersistentPlaces() const;
+
     /** \return pointer to place or throw exception if it doesn't exist.
     * \param [in] name : the name of the place */
     Place *place(std::string name);
@@ -52,6 +69,10 @@ public:
     */
     void buildTree();
 
+    /** Resets the resetable places that recorded something since the last
+     * call. This is called at the end of every event. */
+    void resetPlaces();
+
     /** Default Destructor */
     ~TreeCorrelator();
 
@@ -66,6 +87,13 @@ private:
     TreeCorrelator(TreeCorrelator const &);//!< Overload of the constructor
     void operator=(TreeCorrelator const &); //!< the copy constructor
     static TreeCorrelator *instance; //!< A static instance of the tree correlator
+    static thread_local TreeCorrelator *local_; //!< The replica used by the calling thread
+
+    /** The resetable places that recorded something in the current event */
+    std::vector<Place *> resetList_;
+
+    /** The parameters of every call to createPlace, used to build replicas */
+    std::vector<std::pair<std::map<std::string, std::string>, bool> > history_;
 
     static PlaceBuilder builder; //!< Instance of the PlaceBuilder
 
@@ -22,6 +22,12 @@ public:
      * \param[in]  prefix_ String to append to the beginning of system output.
      * \return True upon successfully initializing and false otherwise. */
     bool Initialize(std::string prefix_ = "");
+
+    /** Adds the command line options that are specific to utkscan. */
+    void ArgHelp();
+
+    /** Applies the command line options that are specific to utkscan. */
+    void ExtraArguments();
 private:
     bool init_; /// Set to true when the initialization process successfully completes.
     std::string outputFname_; /// The output histogram filename prefix.
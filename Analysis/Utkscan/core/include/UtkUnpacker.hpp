@@ -6,11 +6,21 @@
 #ifndef __UTKUNPACKER_HPP__
 #define __UTKUNPACKER_HPP__
 
+#include <condition_variable>
 #include <ctime>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "BoundedQueue.hpp"
+#include "ChanEventPool.hpp"
 #include "DetectorDriver.hpp"
 #include "DetectorLibrary.hpp"
 #include "RawEvent.hpp"
+#include "TreeCorrelator.hpp"
 #include "Unpacker.hpp"
 
 ///A class that is derived from Unpacker that defines what we are going to do
@@ -18,19 +28,91 @@
 /// define a single class (ProcessRawEvent) and overload the RawStats class
 /// to take a pointer to a DetectorDriver instance. The rest of the virtual
 /// methods in the parent are used as default.
+///
+/// The raw events can be processed by several worker threads. Each of them
+/// has its own replica of the DetectorDriver and the TreeCorrelator and is
+/// handed batches of whole raw events, so the events of a worker are not in
+/// time order with respect to the other workers. The histogram fills of all
+/// threads are buffered and merged into the histograms by each thread.
 class UtkUnpacker : public Unpacker {
 public:
-    /// Default constructor that does nothing in particular
-    UtkUnpacker() : Unpacker() {}
+    /// Default constructor that turns on pooled decoding since we only read
+    /// the XiaData in the raw event and copy what we need into ChanEvents,
+    /// which are recycled as well.
+    UtkUnpacker() : Unpacker(), numWorkers_(1), eventBatch_(NULL), nextEventNumber_(0), driver_(NULL),
+                    batchesInFlight_(0), workQueue_(2 * MAX_WORKERS) { SetPooledDecoding(); }
 
     /// Default destructor that deconstructs the DetectorDriver singleton
     ~UtkUnpacker();
 
+    ///@return The number of worker threads that process the raw events
+    unsigned int GetNumWorkers() const { return numWorkers_; }
+
+    ///@brief Sets the number of worker threads that process the raw events.
+    /// With more than one worker every worker gets its own replica of the
+    /// DetectorDriver. We stay with a single DetectorDriver if any part of the
+    /// analysis needs the events in time order, see
+    /// DetectorDriver::IsTimeOrdered. This has to be set before the scan starts.
+    ///@param[in] a : The number of workers, between 1 and MAX_WORKERS
+    void SetNumWorkers(const unsigned int &a);
+
+    static const unsigned int MAX_WORKERS = 64; ///< The largest number of workers that we will start
+
 private:
+    /// The raw events that are handed to a worker in one go.
+    struct EventBatch {
+        unsigned long firstEventNumber; ///< The DetectorDriver event number of the first event
+        std::vector<std::vector<ChanEvent *> > events; ///< The channels of every raw event
+    };
+
+    unsigned int numWorkers_; ///< The number of worker threads that process the raw events
+    EventBatch *eventBatch_; ///< The batch that is being filled by ProcessRawEvent
+    unsigned long nextEventNumber_; ///< The event number of the next event that is added to a batch
+    DetectorDriver *driver_; ///< The DetectorDriver that the replicas merge their output into
+    std::vector<std::pair<DetectorDriver *, TreeCorrelator *> > replicas_; ///< The replicas used by the workers
+    std::vector<std::thread> workers_; ///< The worker threads
+    unsigned int batchesInFlight_; ///< The number of batches that have not been processed yet
+    std::exception_ptr workerError_; ///< The first exception thrown by a worker
+    BoundedQueue<EventBatch *> workQueue_; ///< The batches waiting for a worker
+    std::mutex workMutex_; ///< Protects batchesInFlight_ and workerError_
+    std::condition_variable batchDone_; ///< Signalled when a worker finishes a batch
+    std::mutex mergeMutex_; ///< Serializes the merges into driver_
+    ChanEventPool chanEventPool_; ///< The recycled channel events of the raw events
+
     ///@brief Process all events in the event list.
     ///@param[in]  addr_ Pointer to a ScanInterface object.
     void ProcessRawEvent();
 
+    ///@brief Hands the last batch to the workers and waits until they have
+    /// processed all of them.
+    void FinishRawEvents();
+
+    ///@brief Processes the raw event and resets it for the next one. The
+    /// DetectorDriver resets the places of the TreeCorrelator.
+    ///@param[in] driver The DetectorDriver to process the event with.
+    ///@param[in] rawev The raw event to process.
+    static void ProcessEvent(DetectorDriver *driver, RawEvent &rawev);
+
+    ///@brief Creates the replicas and starts the workers. We fall back to a
+    /// single worker if the analysis needs its events in time order.
+    ///@param[in] driver The DetectorDriver to replicate.
+    void StartWorkers(DetectorDriver *driver);
+
+    ///@brief Stops the workers once they processed the batches in the queue
+    /// and deletes the replicas.
+    void StopWorkers();
+
+    ///@brief Hands the batch that is being filled to the workers.
+    void DispatchBatch();
+
+    ///@brief The worker thread that processes batches of raw events.
+    ///@param[in] driver The replica of the DetectorDriver used by the worker.
+    ///@param[in] tree The replica of the TreeCorrelator used by the worker.
+    void ProcessBatches(DetectorDriver *driver, TreeCorrelator *tree);
+
+    ///@brief Throws the exception of a worker in the calling thread.
+    void CheckWorkers();
+
     ///@brief Initializes the DetectorLibrary and DetectorDriver
     ///@param[in] driver A pointer to the DetectorDriver that we're using.
     ///@param[in] detlib A pointer to the DetectorLibrary that we're using.
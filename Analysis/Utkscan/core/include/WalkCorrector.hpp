@@ -9,6 +9,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <utility>
 
 #include "ChannelConfiguration.hpp"
 
@@ -59,7 +60,25 @@ public:
      * \param [in] chanID : The channel channelConfiguration to get
      * \param [in] raw : The raw value to perform the correction on
      * \return The walk corrected value of raw */
-    double GetCorrection(ChannelConfiguration &chanID, double raw) const;
+    double GetCorrection(const ChannelConfiguration &chanID, double raw) const;
+
+    /** Builds a table of the corrections indexed by channel id, so that
+     * GetCorrection can find a channel without comparing configurations.
+     * Channels added after this are only found by their ChannelConfiguration
+     * until Compile is called again.
+     * \param [in] channels : the configuration of every channel, indexed by
+     * channel id */
+    void Compile(const std::vector<ChannelConfiguration> &channels);
+
+    /** \return The correction for the channel with the given id in the table
+     * built by Compile, or 0 if the channel is not corrected.
+     * \param [in] index : the channel id
+     * \param [in] raw : The raw value to perform the correction on */
+    double GetCorrection(const unsigned int &index, double raw) const {
+        if (index >= table_.size() || table_[index].second == 0)
+            return 0;
+        return Correct(&compiled_[table_[index].first], table_[index].second, raw);
+    }
 
 protected:
     /** \return always 0.
@@ -142,6 +161,21 @@ private:
      * and value is a vector holding struct with calibration range
      * and walk correction model and parameters. */
     std::map<ChannelConfiguration, std::vector<CorrectionParams>> channels_;
+
+    /** The correction ranges of every channel in the table, stored one
+     * channel after another */
+    std::vector<CorrectionParams> compiled_;
+
+    /** The first range in compiled_ and the number of ranges for each
+     * channel id. Channels without a correction have no ranges. */
+    std::vector<std::pair<unsigned int, unsigned int> > table_;
+
+    /** \return The correction from the first range that holds raw, or 0 if
+     * none of them do.
+     * \param [in] ranges : the correction ranges of the channel
+     * \param [in] numRanges : the number of ranges
+     * \param [in] raw : the raw value to perform the correction on */
+    double Correct(const CorrectionParams *ranges, const unsigned int &numRanges, double raw) const;
 };
 
 #endif
@@ -3,34 +3,33 @@
  *  \author S. V. Paulauskas
  *  \date December 15, 2014
 */
-#include <iostream>
 #include <vector>
 
+#include <cmath>
+
 #include "BarBuilder.hpp"
-#include "TimingMapBuilder.hpp"
 
 using namespace std;
 
 void BarBuilder::BuildBars(void) {
     ClearMaps();
+    if (!list_)
+        return;
     FillMaps();
 
-    for (map<unsigned int, unsigned int>::const_iterator it = lefts_.begin(); it != lefts_.end(); it++) {
-        map<unsigned int, unsigned int>::const_iterator mate = rights_.find(it->first);
-        if (mate == rights_.end())
+    for (unsigned int bar = 0; bar < lefts_.size() && bar < rights_.size(); bar++) {
+        const ChanEvent *left = lefts_[bar], *right = rights_[bar];
+        if (!left || !right)
             continue;
 
-        if (list_.at(it->second)->GetTrace().size() != 0 && list_.at(mate->second)->GetTrace().size() != 0) {
-            TimingDefs::TimingIdentifier key =
-                    make_pair(it->first, list_.at(it->second)->GetChanID().GetSubtype());
-            hrtBars_.insert(make_pair(key, BarDetector(HighResTimingData(*(list_.at(it->second))),
-                                                       HighResTimingData(*(list_.at(mate->second))), key)));
+        if (left->GetTrace().size() != 0 && right->GetTrace().size() != 0) {
+            TimingDefs::TimingIdentifier key(bar, left->GetChanID().GetSubtype());
+            hrtBars_.insert(make_pair(key, BarDetector(HighResTimingData(*left), HighResTimingData(*right), key)));
         } else {
-            lrtBars_.insert(make_pair(it->first,
-                                      make_pair(0.5 * (list_.at(it->second)->GetWalkCorrectedTime() +
-                                                        list_.at(mate->second)->GetWalkCorrectedTime()),
-                                                sqrt(list_.at(it->second)->GetCalibratedEnergy() *
-                                                             list_.at(mate->second)->GetCalibratedEnergy()))));
+            lrtBars_.insert(make_pair(bar, make_pair(0.5 * (left->GetWalkCorrectedTime() +
+                                                            right->GetWalkCorrectedTime()),
+                                                     sqrt(left->GetCalibratedEnergy() *
+                                                          right->GetCalibratedEnergy()))));
         }
     }
 }
@@ -42,18 +41,25 @@ unsigned int BarBuilder::CalcBarNumber(const unsigned int &loc) {
 void BarBuilder::ClearMaps(void) {
     lrtBars_.clear();
     hrtBars_.clear();
-    lefts_.clear();
-    rights_.clear();
+    lefts_.assign(lefts_.size(), NULL);
+    rights_.assign(rights_.size(), NULL);
 }
 
 void BarBuilder::FillMaps(void) {
-    for (vector<ChanEvent *>::const_iterator it = list_.begin(); it != list_.end(); it++) {
-        ChannelConfiguration id = (*it)->GetChanID();
+    for (vector<ChanEvent *>::const_iterator it = list_->begin(); it != list_->end(); it++) {
+        const ChannelConfiguration &id = (*it)->GetChanID();
         unsigned int barNum = CalcBarNumber(id.GetLocation());
-        unsigned int idx = (unsigned int) (it - list_.begin());
-        if (id.HasTag("left") || id.HasTag("up") || id.HasTag("top"))
-            lefts_.insert(make_pair(barNum, idx));
-        if (id.HasTag("right") || id.HasTag("down") || id.HasTag("bottom"))
-            rights_.insert(make_pair(barNum, idx));
+        if (id.HasTag("left") || id.HasTag("up") || id.HasTag("top")) {
+            if (barNum >= lefts_.size())
+                lefts_.resize(barNum + 1, NULL);
+            if (!lefts_[barNum])
+                lefts_[barNum] = *it;
+        }
+        if (id.HasTag("right") || id.HasTag("down") || id.HasTag("bottom")) {
+            if (barNum >= rights_.size())
+                rights_.resize(barNum + 1, NULL);
+            if (!rights_[barNum])
+                rights_[barNum] = *it;
+        }
     }
 }
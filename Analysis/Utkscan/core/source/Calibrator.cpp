@@ -82,45 +82,54 @@ double Calibrator::GetCalEnergy(const ChannelConfiguration &chanID, double raw)
     map < ChannelConfiguration, vector < CalibrationParams > > ::const_iterator
     itch =
             channels_.find(chanID);
-    if (itch != channels_.end()) {
-        vector<CalibrationParams>::const_iterator itf;
-        for (itf = itch->second.begin(); itf != itch->second.end(); ++itf) {
-            if (itf->min <= raw && raw <= itf->max)
-                break;
-        }
-        // Parts of spectrum that are not within some min-max range are
-        // zeroed
-        if (itf == itch->second.end()) {
-            return 0;
-        }
-        switch (itf->model) {
-            case cal_raw:
-                return ModelRaw(raw);
-                break;
-            case cal_off:
-                return ModelOff();
-                break;
-            case cal_linear:
-                return ModelLinear(itf->parameters, raw);
-                break;
-            case cal_quadratic:
-                return ModelQuadratic(itf->parameters, raw);
-                break;
-            case cal_cubic:
-                return ModelCubic(itf->parameters, raw);
-                break;
-            case cal_polynomial:
-                return ModelPolynomial(itf->parameters, raw);
-                break;
-            case cal_hyplin:
-                return ModelHypLin(itf->parameters, raw);
-                break;
-            case cal_exp:
-                return ModelExp(itf->parameters, raw);
-                break;
-            default:
-                break;
-        }
+    if (itch != channels_.end())
+        return Calibrate(&itch->second[0], itch->second.size(), raw);
+    return raw;
+}
+
+void Calibrator::Compile(const std::vector<ChannelConfiguration> &channels) {
+    compiled_.clear();
+    table_.assign(channels.size(), make_pair(0u, 0u));
+    for (unsigned int i = 0; i < channels.size(); i++) {
+        map<ChannelConfiguration, vector<CalibrationParams> >::const_iterator itch = channels_.find(channels[i]);
+        if (itch == channels_.end())
+            continue;
+        table_[i] = make_pair((unsigned int) compiled_.size(), (unsigned int) itch->second.size());
+        compiled_.insert(compiled_.end(), itch->second.begin(), itch->second.end());
+    }
+}
+
+double Calibrator::Calibrate(const CalibrationParams *ranges, const unsigned int &numRanges, double raw) const {
+    const CalibrationParams *itf = ranges;
+    const CalibrationParams *end = ranges + numRanges;
+    for (; itf != end; ++itf) {
+        if (itf->min <= raw && raw <= itf->max)
+            break;
+    }
+    // Parts of spectrum that are not within some min-max range are
+    // zeroed
+    if (itf == end)
+        return 0;
+
+    switch (itf->model) {
+        case cal_raw:
+            return ModelRaw(raw);
+        case cal_off:
+            return ModelOff();
+        case cal_linear:
+            return ModelLinear(itf->parameters, raw);
+        case cal_quadratic:
+            return ModelQuadratic(itf->parameters, raw);
+        case cal_cubic:
+            return ModelCubic(itf->parameters, raw);
+        case cal_polynomial:
+            return ModelPolynomial(itf->parameters, raw);
+        case cal_hyplin:
+            return ModelHypLin(itf->parameters, raw);
+        case cal_exp:
+            return ModelExp(itf->parameters, raw);
+        default:
+            break;
     }
     return raw;
 }
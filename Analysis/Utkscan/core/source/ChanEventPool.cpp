@@ -0,0 +1,60 @@
+///@file ChanEventPool.cpp
+///@brief A recycling pool of ChanEvent objects so that the raw events are
+/// built without going through the allocator for every channel.
+///@date October 17, 2026
+#include "ChanEvent.hpp"
+#include "ChanEventPool.hpp"
+
+using namespace std;
+
+ChanEventPool::~ChanEventPool() {
+    for (vector<ChanEvent *>::iterator it = storage_.begin(); it != storage_.end(); it++)
+        delete *it;
+}
+
+///The event is taken off the free list while holding the lock, but the
+/// channel is copied into it after the lock is released since that is the
+/// expensive part.
+ChanEvent *ChanEventPool::Acquire(const XiaData &data) {
+    ChanEvent *event;
+    if (threadSafe_) {
+        lock_guard<mutex> lock(mutex_);
+        event = AcquireUnlocked();
+    } else
+        event = AcquireUnlocked();
+    event->Assign(data);
+    return event;
+}
+
+ChanEvent *ChanEventPool::AcquireUnlocked() {
+    if (free_.empty())
+        Reserve((unsigned int) (storage_.empty() ? 256 : 2 * storage_.size()));
+
+    ChanEvent *event = free_.back();
+    free_.pop_back();
+    return event;
+}
+
+///The free list always has enough capacity to hold every event in the pool
+/// so releasing never needs to allocate.
+void ChanEventPool::Release(ChanEvent *event) {
+    if (!event)
+        return;
+    if (threadSafe_) {
+        lock_guard<mutex> lock(mutex_);
+        free_.push_back(event);
+    } else
+        free_.push_back(event);
+}
+
+void ChanEventPool::Reserve(const unsigned int &size) {
+    if (size <= storage_.size())
+        return;
+
+    storage_.reserve(size);
+    free_.reserve(size);
+    while (storage_.size() < size) {
+        storage_.push_back(new ChanEvent());
+        free_.push_back(storage_.back());
+    }
+}
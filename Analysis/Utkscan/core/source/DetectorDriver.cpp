@@ -20,6 +20,7 @@
 #include "EventProcessor.hpp"
 #include "Exceptions.hpp"
 #include "HighResTimingData.hpp"
+#include "PlotsRegister.hpp"
 #include "RandomInterface.hpp"
 #include "RawEvent.hpp"
 #include "TraceAnalyzer.hpp"
@@ -30,13 +31,21 @@ using namespace dammIds::raw;
 
 DetectorDriver *DetectorDriver::instance = NULL;
 
+thread_local DetectorDriver *DetectorDriver::local_ = NULL;
+
 DetectorDriver *DetectorDriver::get() {
+    if (local_)
+        return local_;
     if (!instance)
         instance = new DetectorDriver();
     return instance;
 }
 
-DetectorDriver::DetectorDriver() : histo(OFFSET, RANGE, "DetectorDriver") {
+DetectorDriver::DetectorDriver(const bool &isReplica/*=false*/) : histo(OFFSET, RANGE, "DetectorDriver") {
+    isReplica_ = isReplica;
+    dispatchEvent_ = NULL;
+    dispatchTree_ = NULL;
+    dispatchSummaries_ = 0;
     eventNumber_ = 0;
     sysrootbool_ = false;
     fillLogic_  = false;
@@ -79,38 +88,44 @@ DetectorDriver::DetectorDriver() : histo(OFFSET, RANGE, "DetectorDriver") {
 
         }
 
-        Long64_t rFileSizeB_ = rFileSizeGB_ * pow(1000,3);
-        std::string name = Globals::get()->GetOutputPath() + Globals::get()->GetOutputFileName() + "_DD.root";
-        PixieFile = new TFile(name.c_str(), "RECREATE");
-        PTree = new TTree("PixTree", "Pixie Event Tree");
-        PTree->SetMaxTreeSize(rFileSizeB_);
-
-        // ROOTFILE system wide header
-        //get the current systemTime and make it a string
-        time_t now = time(nullptr);
-        std::string date = ctime(&now);
-
-        TNamed cfgTNamed("config", Globals::get()->GetConfigFileName());
-        TNamed outfTNamed("outputFile", Globals::get()->GetOutputFileName());
-        TNamed createTnamed("createTime", date);
-        TNamed rootVersionTnamed("RootVersion", gROOT->GetVersion());
-        TNamed rootSysTnamed("RootSys", gROOT->GetRootSys().Data());
-        TNamed outRootTNamed("outputRootFile", name);
-
-        cfgTNamed.Write();
-        outfTNamed.Write();
-        createTnamed.Write();
-        rootVersionTnamed.Write();
-        rootSysTnamed.Write();
-        outRootTNamed.Write();
-
-        // new Branch for PixTreeEvent
-        PTree->Branch("PixTreeEvent",&pixie_tree_event_);
+        // A replica keeps its events in memory until MergeReplica hands
+        // them to the original, which owns the file.
+        if (!isReplica_) {
+            Long64_t rFileSizeB_ = rFileSizeGB_ * pow(1000,3);
+            std::string name = Globals::get()->GetOutputPath() + Globals::get()->GetOutputFileName() + "_DD.root";
+            PixieFile = new TFile(name.c_str(), "RECREATE");
+            PTree = new TTree("PixTree", "Pixie Event Tree");
+            PTree->SetMaxTreeSize(rFileSizeB_);
+
+            // ROOTFILE system wide header
+            //get the current systemTime and make it a string
+            time_t now = time(nullptr);
+            std::string date = ctime(&now);
+
+            TNamed cfgTNamed("config", Globals::get()->GetConfigFileName());
+            TNamed outfTNamed("outputFile", Globals::get()->GetOutputFileName());
+            TNamed createTnamed("createTime", date);
+            TNamed rootVersionTnamed("RootVersion", gROOT->GetVersion());
+            TNamed rootSysTnamed("RootSys", gROOT->GetRootSys().Data());
+            TNamed outRootTNamed("outputRootFile", name);
+
+            cfgTNamed.Write();
+            outfTNamed.Write();
+            createTnamed.Write();
+            rootVersionTnamed.Write();
+            rootSysTnamed.Write();
+            outRootTNamed.Write();
+
+            // new Branch for PixTreeEvent
+            PTree->Branch("PixTreeEvent",&pixie_tree_event_);
+        }
 
         // Loop over processor list and do root things, like setting headers
         // NO data is processed here. 
         for (auto itp = setProcess.begin(); itp !=setProcess.end();itp++) {
             GetProcessor((*itp))->SetPixTreeEventPtr(&pixie_tree_event_);
+            if (isReplica_)
+                continue;
 
             if ((*itp) == "GammaScintProcessor") {
                 //GammaScint Processor Header
@@ -145,9 +160,10 @@ DetectorDriver::~DetectorDriver() {
     for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
         delete (*it);
     vecAnalyzer.clear();
-    instance = NULL;
+    if (instance == this)
+        instance = NULL;
 
-    if (sysrootbool_) {
+    if (sysrootbool_ && !isReplica_) {
         PixieFile = PTree->GetCurrentFile();
         PixieFile->Write(0,2,0);
         PixieFile->Close();
@@ -166,6 +182,62 @@ void DetectorDriver::Init(RawEvent &rawev) {
 
     walk_ = DetectorLibrary::get()->GetWalkCorrections();
     cali_ = DetectorLibrary::get()->GetCalibrations();
+
+    dispatch_.assign(DetectorLibrary::get()->size(), ChannelDispatch());
+    dispatchEvent_ = &rawev;
+    dispatchTree_ = TreeCorrelator::get();
+    dispatchSummaries_ = rawev.GetNumSummaries();
+}
+
+///The summaries are looked up the same way as they used to be on every hit,
+/// so they are still created on the first hit of their type. A std::map never
+/// moves its elements, so the pointers stay good as more summaries are added.
+/// The subtype and start summaries are not constructed here and processors
+/// may create them later on, so the table is filled in again whenever the
+/// number of summaries changes.
+DetectorDriver::ChannelDispatch &DetectorDriver::GetDispatch(const ChanEvent *chan, RawEvent &rawev) {
+    unsigned int id = chan->GetID();
+    if (dispatchEvent_ != &rawev || dispatchTree_ != TreeCorrelator::get() || id >= dispatch_.size()
+        || dispatchSummaries_ != rawev.GetNumSummaries()) {
+        dispatch_.assign(max(DetectorLibrary::get()->size(), (size_t) id + 1), ChannelDispatch());
+        dispatchEvent_ = &rawev;
+        dispatchTree_ = TreeCorrelator::get();
+        dispatchSummaries_ = rawev.GetNumSummaries();
+    }
+
+    ChannelDispatch &entry = dispatch_[id];
+    if (entry.resolved)
+        return entry;
+
+    const ChannelConfiguration &chanCfg = chan->GetChanID();
+    string type = chanCfg.GetType();
+    string subtype = chanCfg.GetSubtype();
+
+    entry.resolved = true;
+    entry.ignored = type == "ignore" || type == "";
+    entry.hasIts = chanCfg.HasTag("its");
+    entry.hasEts1 = chanCfg.HasTag("ets1");
+    entry.hasEts2 = chanCfg.HasTag("ets2");
+
+    string place = chanCfg.GetPlaceName();
+    if (place != "__9999")
+        entry.place = TreeCorrelator::get()->place(place);
+    if (entry.ignored)
+        return entry;
+
+    for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
+        if (!(*it)->IsIgnoredDetector(chanCfg))
+            entry.analyzers.push_back(*it);
+
+    //TODO Add group support for GetSummary()
+    entry.typeSummary = rawev.GetSummary(type);
+    entry.subtypeSummary = rawev.GetSummary(type + ':' + subtype, false);
+    if (chanCfg.HasTag("start") && type != "logic")
+        entry.startSummary = rawev.GetSummary(type + ':' + subtype + ':' + "start", false);
+
+    // The type summary may have been constructed just now.
+    dispatchSummaries_ = rawev.GetNumSummaries();
+    return entry;
 }
 
 void DetectorDriver::ProcessEvent(RawEvent &rawev) {
@@ -184,31 +256,30 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
             PlotRaw((*it));
             ThreshAndCal((*it), rawev);
             PlotCal((*it));
+            const ChannelDispatch &dispatch = GetDispatch(*it, rawev);
 
             //internal TS for the FDSi experiment (Xu)
-            if ((*it)->GetChanID().HasTag("its")) {
+            if (dispatch.hasIts) {
                 pixie_tree_event_.internalTS = (*it)->GetTimeSansCfd() * Globals::get()->GetClockInSeconds((*it)->GetChanID().GetModFreq()) * 1e9;
             }
-            string place = (*it)->GetChanID().GetPlaceName();
-            if (place == "__9999")
+            if (!dispatch.place)
                 continue;
 
             if ((*it)->IsSaturated() || (*it)->IsPileup())
                 continue;
 
-            double time = (*it)->GetTime();
             double energy = (*it)->GetCalibratedEnergy();
             int location = (*it)->GetChanID().GetLocation();
 
-            EventData data(time, energy, location);
-            TreeCorrelator::get()->place(place)->activate(data);
+            EventData data((*it)->GetTimestamp(), energy, location);
+            dispatch.place->activate(data);
             if (innerEvtCounter == 0) {
                 eventFirstTime_ = (*it)->GetTimeSansCfd(); //sets the time of the first det event in the pixie event
             }
-            if ((*it)->GetChanID().HasTag("ets1")) {
+            if (dispatch.hasEts1) {
                 pixie_tree_event_.externalTS1 = (*it)->GetExternalTimeStamp();
             }
-            if ((*it)->GetChanID().HasTag("ets2")){
+            if (dispatch.hasEts2){
                 pixie_tree_event_.externalTS2 = (*it)->GetExternalTimeStamp();
             }
             if(pixie_tree_event_.externalTS2 != 0 && pixie_tree_event_.externalTS1 !=0 ) {
@@ -232,11 +303,6 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
         for (vector<EventProcessor *>::iterator iProc = vecProcess.begin(); iProc != vecProcess.end(); iProc++)
             if ((*iProc)->HasEvent())
                 (*iProc)->Process(rawev);
-        // Clear all places in correlator (if of resetable type)
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
     } catch (GeneralException &e) {
         /// Any exception in activation of basic places, PreProcess and Process
         /// will be intercepted here
@@ -246,13 +312,19 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
         cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessEvent") << endl;
         cout << "\t" << Display::WarningStr(w.what()) << endl;
     }
+    // Clear the places in the correlator that were changed in this event (if of resetable type)
+    TreeCorrelator::get()->resetPlaces();
+
     if (sysrootbool_) {
         if(fillLogic_) {
             FillLogicStruc();
         }
         pixie_tree_event_.eventNum = eventNumber_;
         pixie_tree_event_.fileName = Globals::get()->GetOutputFileName();
-        PTree->Fill();
+        if (isReplica_)
+            treeEvents_.push_back(pixie_tree_event_);
+        else
+            PTree->Fill();
     }
     eventNumber_++;
 
@@ -318,22 +390,62 @@ void DetectorDriver::DeclarePlots() {
     }
 }
 
+DetectorDriver *DetectorDriver::Replicate() const {
+    DetectorDriver *replica = NULL;
+
+    //The replica plots into the histograms of this instance, so we must not
+    // register or declare them a second time.
+    PlotsRegister::get()->SetReplicating(true);
+    try {
+        replica = new DetectorDriver(true);
+        replica->DeclarePlots();
+    } catch (exception &e) {
+        PlotsRegister::get()->SetReplicating(false);
+        delete replica;
+        cout << Display::ErrorStr("Exception caught at DetectorDriver::Replicate") << endl;
+        throw;
+    }
+    PlotsRegister::get()->SetReplicating(false);
+
+    replica->pixieToWallClock = pixieToWallClock;
+    replica->eventNumber_ = eventNumber_;
+    replica->firstEventTime_ = firstEventTime_;
+    replica->firstEventTimeinNs_ = firstEventTimeinNs_;
+    return replica;
+}
+
+void DetectorDriver::MergeReplica(DetectorDriver *replica) {
+    if (!sysrootbool_ || replica->treeEvents_.empty())
+        return;
+
+    for (vector<PixTreeEvent>::const_iterator it = replica->treeEvents_.begin();
+         it != replica->treeEvents_.end(); it++) {
+        pixie_tree_event_ = *it;
+        PTree->Fill();
+    }
+    replica->treeEvents_.clear();
+}
+
+bool DetectorDriver::IsTimeOrdered() const {
+    for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
+        if ((*it)->IsTimeOrdered())
+            return true;
+    return TreeCorrelator::get()->HasPersistentPlaces();
+}
+
 int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
-    ChannelConfiguration chanCfg = chan->GetChanID();
+    const ChannelDispatch &dispatch = GetDispatch(chan, rawev);
+    if (dispatch.ignored)
+        return (0);
+
+    const ChannelConfiguration &chanCfg = chan->GetChanID();
     int id = chan->GetID();
-    string type = chanCfg.GetType();
-    string subtype = chanCfg.GetSubtype();
-    set<string> tags = chanCfg.GetTags();
-    bool hasStartTag = chanCfg.HasTag("start");
     Trace &trace = chan->GetTrace();
 
     RandomInterface *randoms = RandomInterface::get();
 
     double energy = 0.0;
 
-    if (type == "ignore" || type == "")
-        return (0);
-
     if (!trace.empty()) {
         plot(D_HAS_TRACE, id);
         
@@ -341,11 +453,9 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
         chan->GetTrace().SetHasValidWaveformAnalysis(false);
         chan->GetTrace().SetHasValidTimingAnalysis(false);
 
-        for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++){
-            if (!(*it)->IsIgnoredDetector(chanCfg)){
-                (*it)->Analyze(trace, chanCfg);
-            }
-        }
+        for (vector<TraceAnalyzer *>::const_iterator it = dispatch.analyzers.begin();
+             it != dispatch.analyzers.end(); it++)
+            (*it)->Analyze(trace, chanCfg);
 
         if(chan->GetTrace().HasValidWaveformAnalysis()){
             plot(D_HAS_TRACE_2,id);
@@ -356,7 +466,7 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
             trace.SetPhase(0.0); // if the timing analysis fails for any reason then set the phase to 0
         }
         //We are going to handle the filtered energies here.
-        vector<double> filteredEnergies = trace.GetFilteredEnergies();
+        const vector<double> &filteredEnergies = trace.GetFilteredEnergies();
         if (filteredEnergies.empty()) {
             energy = chan->GetEnergy() + randoms->Generate();
         } else {
@@ -381,28 +491,20 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
     double time, walk_correction;
     if (chan->GetHighResTimeInNs() == 0.0) {
         time = chan->GetTime(); //time is in clock ticks
-        walk_correction = walk_->GetCorrection(chanCfg, energy);
+        walk_correction = walk_->GetCorrection(id, energy);
     } else {
         time = chan->GetHighResTimeInNs(); //time here is in ns
-        walk_correction = walk_->GetCorrection(chanCfg, trace.GetQdc());
+        walk_correction = walk_->GetCorrection(id, trace.GetQdc());
     }
 
-    chan->SetCalibratedEnergy(cali_->GetCalEnergy(chanCfg, energy));
+    chan->SetCalibratedEnergy(cali_->GetCalEnergy(id, energy));
     chan->SetWalkCorrectedTime(time - walk_correction);
 
-    //TODO Add group support for GetSummary() 
-    rawev.GetSummary(type)->AddEvent(chan);
-    DetectorSummary *summary;
-
-    summary = rawev.GetSummary(type + ':' + subtype, false);
-    if (summary != NULL)
-        summary->AddEvent(chan);
-
-    if (hasStartTag && type != "logic") {
-        summary = rawev.GetSummary(type + ':' + subtype + ':' + "start", false);
-        if (summary != NULL)
-            summary->AddEvent(chan);
-    }
+    dispatch.typeSummary->AddEvent(chan);
+    if (dispatch.subtypeSummary != NULL)
+        dispatch.subtypeSummary->AddEvent(chan);
+    if (dispatch.startSummary != NULL)
+        dispatch.startSummary->AddEvent(chan);
     return (1);
 }
 
@@ -10,10 +10,12 @@
  * \author C. R. Thornsberry
  * \date Feb. 12th, 2016
  */
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include <string.h>
@@ -25,110 +27,6 @@
 #ifndef USE_HRIBF
 
 
-///////////////////////////////////////////////////////////////////////////////
-// class HisFileWriter
-///////////////////////////////////////////////////////////////////////////////
-// do not redefine
-std::shared_ptr<HisFileWriter> HisFileWriter::instance = nullptr;
-
-void HisFileWriter::EnqueueWrites(std::vector<WriteQueueObject> &events)
-{
-    /// called from the main utkscan thread
-    instance->HisWriterMutex.lock();
-    for(auto &evt: events){
-        instance->event_queue.push_back(evt);
-    }
-    instance->HisWriterMutex.unlock();
-    events.clear();
-}
-
-void HisFileWriter::ProcessQueue()
-{
-    if(!instance->HisWriterMutex.try_lock()){return;}
-    while(instance->event_queue.size() > 0 && instance->events_since_write < instance->max_events_between_writes)
-    {
-        WriteQueueObject evt = instance->event_queue.front();
-        instance->event_queue.pop_front();
-        
-        if(instance->waiting_writes.find(evt.bufferLocation) == instance->waiting_writes.end())
-        {
-           instance->waiting_writes.insert({evt.bufferLocation, {evt.weight, evt.isInt}});
-        }
-        else
-        {
-            instance->waiting_writes.at(evt.bufferLocation).first += evt.weight;
-        }
-        instance->events_since_write++;
-    }
-    instance->HisWriterMutex.unlock();
-}
-
-void HisFileWriter::FlushWrites()
-{
-    if(instance->waiting_writes.size() == 0) {return;}
-    for (auto &fill: instance->waiting_writes) {
-        // the location in the file that we're filling with the value the map 
-        // being sorted by smallest location allows piling what would've 
-        // been multiple writes to the same location to a single write
-        unsigned long long location = fill.first;
-        unsigned int weight         = fill.second.first;
-        bool isInt                  = fill.second.second;
-
-        // Seek to the specified bin
-        instance->ofile->seekg(location,
-                    std::ios::beg); // input offset
-
-        unsigned short sval = 0;
-        unsigned int ival = 0;
-
-        // Overwrite the bin value
-        if (isInt) {
-            // Get the original value of the bin
-            instance->ofile->read((char *) &ival, 4);
-            ival += weight;
-
-            // Set the new value of the bin
-            instance->ofile->seekp(location, std::ios::beg); 
-            instance->ofile->write((char *) &ival, 4);
-        } else {
-            // Get the original value of the bin
-            instance->ofile->read((char *) &sval, 2);
-            sval += (short) weight;
-
-            // Set the new value of the bin
-            instance->ofile->seekp(location, std::ios::beg);
-            instance->ofile->write((char *) &sval, 2);
-        }
-    }
-    instance->events_since_write = 0;
-    instance->waiting_writes.clear();
-}
-
-void HisFileWriter::Finalize()
-{
-    // block till we acquire the lock because we're going to lose data otherwise
-    instance->HisWriterMutex.lock();
-    while(instance->event_queue.size() > 0 && instance->events_since_write < instance->max_events_between_writes)
-    {
-        WriteQueueObject evt = instance->event_queue.front();
-        instance->event_queue.pop_front();
-        if(instance->waiting_writes.find(evt.bufferLocation) == instance->waiting_writes.end())
-        {
-           instance->waiting_writes.insert({evt.bufferLocation, {evt.weight, evt.isInt}});
-        }
-        else
-        {
-            instance->waiting_writes.at(evt.bufferLocation).first += evt.weight;
-        }
-        instance->events_since_write++;
-    }
-    instance->HisWriterMutex.unlock();
-    FlushWrites();
-}
-
-
-
-
 /// Create a DAMM 1D histogram (implemented for backwards compatibility)
 void
 hd1d_(int dammId, int nHalfWords, int rawlen, int histlen, int min, int max,
@@ -281,6 +179,8 @@ unsigned int &HisData::operator[](const size_t &index_) {
 // struct drr_entry
 ///////////////////////////////////////////////////////////////////////////////
 
+const size_t drr_entry::cells_per_block;
+
 /// Constructor for 1d histogram
 drr_entry::drr_entry(unsigned int hisID_, unsigned short halfWords_,
                      unsigned short raw_, unsigned short scaled_,
@@ -532,12 +432,10 @@ void HisFile::initialize() {
 }
 
 HisFile::HisFile() {
-    HisFileWriter::instance = std::make_shared<HisFileWriter>();
     initialize();
 }
 
 HisFile::HisFile(const char *prefix_) {
-    HisFileWriter::instance = std::make_shared<HisFileWriter>();
     initialize();
     LoadDrr(prefix_);
 }
@@ -941,20 +839,214 @@ void HisFile::PrintEntry() {
 // class OutputHisFile
 ///////////////////////////////////////////////////////////////////////////////
 
-std::shared_ptr<drr_entry> OutputHisFile::find_drr_in_list(unsigned int hisId) {
-    if(hisId < drr_entry_map.size() + 1 && drr_entry_map[hisId])
+/// Fills are only buffered by a thread while threaded fills are on, so this
+/// only has entries in threads that fill during a threaded scan.
+thread_local std::unordered_map<unsigned long long, HisFillDelta *> OutputHisFile::thread_deltas;
+
+std::atomic<unsigned long long> OutputHisFile::next_instance_id(0);
+
+drr_entry *OutputHisFile::find_drr_in_list(unsigned int hisId) {
+    if(hisId < drr_entry_map.size())
     {
-        return drr_entry_map[hisId];
+        return drr_entry_map[hisId].get();
     }
     return nullptr;
 }
 
+bool OutputHisFile::add_fill(unsigned int hisID_, drr_entry *entry_, bool found_,
+                             unsigned int bin_, unsigned int weight_) {
+    if (threaded_fills) {
+        HisFillDelta *&delta = thread_deltas[instance_id];
+        if (!delta) {
+            delta = new HisFillDelta();
+            delta->generation = zero_generation.load(std::memory_order_acquire);
+        }
+        if (!entry_) {
+            delta->undef_his.insert(hisID_);
+        } else {
+            std::pair<unsigned int, unsigned int> &counts = delta->counts[hisID_];
+            counts.first++;
+            if (found_) {
+                counts.second++;
+                delta->weights[((unsigned long long) hisID_ << 32) | bin_] += weight_;
+            }
+        }
+        if (++delta->fills >= Flush_wait)
+            publish_delta();
+        return entry_ && found_;
+    }
+
+    if (entry_ == nullptr) {
+        undef_his_failed_fills.insert(hisID_);
+        return false;
+    }
+    entry_->total_counts++;
+    if (!found_ || !entry_->increment(bin_, weight_)) {
+        bin_not_found_failed_fills[hisID_] += 1;
+        return false;
+    }
+    entry_->good_counts++;
+    if(++Flush_count > Flush_wait)
+    {
+        Flush();
+    }
+    return true;
+}
+
+void OutputHisFile::publish_delta() {
+    auto mine = thread_deltas.find(instance_id);
+    if (mine == thread_deltas.end())
+        return;
+
+    // Push the delta onto the list of full deltas. Nothing is ever popped off
+    // the list alone, it is only swapped out whole, so there is no ABA issue.
+    HisFillDelta *delta = mine->second;
+    thread_deltas.erase(mine);
+    delta->next = full_deltas.load(std::memory_order_relaxed);
+    while (!full_deltas.compare_exchange_weak(delta->next, delta, std::memory_order_release,
+                                              std::memory_order_relaxed)) {}
+
+    // If another thread is merging it will pick up our delta, or the next
+    // thread to hand one over will.
+    if (merging.test_and_set(std::memory_order_acquire))
+        return;
+    merge_deltas();
+    merging.clear(std::memory_order_release);
+}
+
+void OutputHisFile::merge_deltas() {
+    HisFillDelta *delta = full_deltas.exchange(nullptr, std::memory_order_acquire);
+    while (delta) {
+        for (auto &fill: delta->weights) {
+            if (zeroed_since(*delta, (unsigned int) (fill.first >> 32)))
+                continue;
+            drr_entry_map[fill.first >> 32]->increment((unsigned int) fill.first, fill.second);
+        }
+        for (auto &count: delta->counts) {
+            drr_entry *entry = drr_entry_map[count.first].get();
+            entry->total_counts += count.second.first;
+            entry->good_counts += count.second.second;
+            if (count.second.first != count.second.second)
+                bin_not_found_failed_fills[count.first] += count.second.first - count.second.second;
+        }
+        undef_his_failed_fills.insert(delta->undef_his.begin(), delta->undef_his.end());
+        merged_fills += delta->fills;
+
+        HisFillDelta *next = delta->next;
+        delete delta;
+        delta = next;
+    }
+
+    if (merged_fills > Flush_wait) {
+        for (auto &entry: drr_entry_map) {
+            if(entry == nullptr){continue;}
+            write_blocks(*entry);
+        }
+        merged_fills = 0;
+    }
+}
+
+bool OutputHisFile::zeroed_since(const HisFillDelta &delta_, unsigned int hisID_) {
+    if (delta_.generation < all_zeroed_at)
+        return true;
+    if (zeroed_at.empty())
+        return false;
+    auto zeroed = zeroed_at.find(hisID_);
+    return zeroed != zeroed_at.end() && delta_.generation < zeroed->second;
+}
+
+void OutputHisFile::lock_merging() {
+    while (merging.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+void OutputHisFile::SetThreadedFills(bool threaded_) {
+    if (threaded_ == threaded_fills)
+        return;
+    if (!threaded_)
+        Flush();
+    threaded_fills = threaded_;
+}
+
+void OutputHisFile::PublishFills() {
+    if (threaded_fills)
+        publish_delta();
+}
+
+void OutputHisFile::write_blocks(drr_entry &entry_, bool all_/*=false*/) {
+    if (entry_.on_disk) {
+        write_pending(entry_);
+        return;
+    }
+
+    const size_t cell_size = entry_.use_int ? 4 : 2;
+    std::vector<unsigned short> svals;
+    for (size_t block = 0; block < entry_.dirty.size(); block++) {
+        if (!all_ && !entry_.dirty[block]) { continue; }
+        entry_.dirty[block] = false;
+
+        size_t first = block * drr_entry::cells_per_block;
+        size_t count = std::min(drr_entry::cells_per_block, entry_.cells.size() - first);
+        ofile.seekp(entry_.offset * 2 + first * cell_size, std::ios::beg);
+        if (entry_.use_int) {
+            ofile.write((char *) &entry_.cells[first], count * cell_size);
+        } else {
+            svals.assign(entry_.cells.begin() + first, entry_.cells.begin() + first + count);
+            ofile.write((char *) svals.data(), count * cell_size);
+        }
+    }
+}
+
+void OutputHisFile::write_pending(drr_entry &entry_) {
+    for (auto &fill: entry_.pending) {
+        std::streamoff pos = (std::streamoff) entry_.offset * 2 +
+                             (std::streamoff) fill.first * (entry_.use_int ? 4 : 2);
+        ofile.seekg(pos, std::ios::beg);
+        if (entry_.use_int) {
+            unsigned int val = 0;
+            ofile.read((char *) &val, 4);
+            val += fill.second;
+            ofile.seekp(pos, std::ios::beg);
+            ofile.write((char *) &val, 4);
+        } else {
+            unsigned short val = 0;
+            ofile.read((char *) &val, 2);
+            val += (unsigned short) fill.second;
+            ofile.seekp(pos, std::ios::beg);
+            ofile.write((char *) &val, 2);
+        }
+    }
+    entry_.pending.clear();
+}
+
+void OutputHisFile::zero_entry(drr_entry &entry_) {
+    if (!entry_.on_disk) {
+        std::fill(entry_.cells.begin(), entry_.cells.end(), 0);
+        write_blocks(entry_, true);
+        return;
+    }
+
+    entry_.pending.clear();
+    std::vector<char> zeros(std::min(entry_.total_size, drr_entry::cells_per_block * 4), 0);
+    ofile.seekp((std::streamoff) entry_.offset * 2, std::ios::beg);
+    for (size_t left = entry_.total_size; left > 0; left -= std::min(left, zeros.size()))
+        ofile.write(zeros.data(), std::min(left, zeros.size()));
+}
+
 void OutputHisFile::Flush() {
     if (debug_mode)
         std::cout << "debug: Flushing histogram entries to file.\n";
 
-    if (writable) { 
-        HisFileWriter::EnqueueWrites(waiting_to_enqueue);
+    if (writable) {
+        publish_delta();
+        lock_merging();
+        merge_deltas();
+        for (auto &entry: drr_entry_map) {
+            if(entry == nullptr){continue;}
+            write_blocks(*entry);
+        }
+        ofile.flush();
+        merging.clear(std::memory_order_release);
     } else if (debug_mode) {
         std::cout << "debug: Output file is not writable!\n";
     }
@@ -962,7 +1054,7 @@ void OutputHisFile::Flush() {
     Flush_count = 0;
 }
 
-OutputHisFile::OutputHisFile() {
+OutputHisFile::OutputHisFile() : instance_id(next_instance_id++) {
     fname = "";
     writable = false;
     finalized = false;
@@ -970,13 +1062,18 @@ OutputHisFile::OutputHisFile() {
     Flush_wait = 100000;
     Flush_count = 0;
     total_his_size = 0;
+    memory_limit = (size_t) 2048 * 1024 * 1024;
+    memory_used = 0;
+    threaded_fills = false;
+    full_deltas = nullptr;
+    merged_fills = 0;
+    zero_generation = 0;
+    all_zeroed_at = 0;
 
     initialize();
-    HisFileWriter::SetOfile(&ofile);
-    HisFileWriter::SetMaxEventsBetweenWrites(Flush_wait);
 }
 
-OutputHisFile::OutputHisFile(std::string fname_prefix) {
+OutputHisFile::OutputHisFile(std::string fname_prefix) : instance_id(next_instance_id++) {
     fname = "";
     writable = false;
     finalized = false;
@@ -984,11 +1081,16 @@ OutputHisFile::OutputHisFile(std::string fname_prefix) {
     Flush_wait = 1000000;
     Flush_count = 0;
     total_his_size = 0;
+    memory_limit = (size_t) 2048 * 1024 * 1024;
+    memory_used = 0;
+    threaded_fills = false;
+    full_deltas = nullptr;
+    merged_fills = 0;
+    zero_generation = 0;
+    all_zeroed_at = 0;
 
     initialize();
     Open(fname_prefix);
-    HisFileWriter::SetOfile(&ofile);
-    HisFileWriter::SetMaxEventsBetweenWrites(Flush_wait);
 }
 
 OutputHisFile::~OutputHisFile() {
@@ -1020,6 +1122,18 @@ size_t OutputHisFile::push_back(std::shared_ptr<drr_entry> entry) {
     ofile.seekp(0, std::ios::end);
     entry->offset =
             (size_t) ofile.tellp() / 2; // Set the file offset (in 2 byte words)
+    size_t cell_bytes = entry->total_bins * sizeof(unsigned int);
+    if (cell_bytes <= memory_limit - std::min(memory_used, memory_limit)) {
+        entry->allocate_cells();
+        memory_used += cell_bytes;
+    } else {
+        if (!std::any_of(drr_entry_map.begin(), drr_entry_map.end(),
+                         [](const std::shared_ptr<drr_entry> &e) { return e && e->on_disk; }))
+            std::cout << "OutputHisFile: The histograms take more than "
+                      << memory_limit / (1024 * 1024) << " MB of memory, his ID = "
+                      << entry->hisID << " and those added after it are kept on disk and filled slowly.\n";
+        entry->on_disk = true;
+    }
     AddDrrEntry(entry);
 
     if (debug_mode)
@@ -1149,25 +1263,12 @@ bool OutputHisFile::Fill(unsigned int hisID_, unsigned int x_, unsigned int y_,
                          unsigned int weight_/*=1*/) {
     if (!writable)[[unlikely]]{return false;}
 
-    std::shared_ptr<drr_entry> temp_drr = find_drr_in_list(hisID_);
-    if (temp_drr == nullptr) {
-        undef_his_failed_fills.insert(hisID_);
-        return false;
-    }
-    unsigned int bin;
-    temp_drr->total_counts++;
-    if (!temp_drr->find_bin((unsigned int) (x_ / temp_drr->comp[0]),
-                            (unsigned int) (y_ / temp_drr->comp[1]), bin)){
-        bin_not_found_failed_fills[hisID_] += 1;
-        return false;
-    }
-    // Push this fill into the queue
-    waiting_to_enqueue.push_back(WriteQueueObject(temp_drr->calculate_buffer_location(bin), temp_drr->use_int, weight_));
-    if(++Flush_count > Flush_wait)
-    {
-        Flush();
-    }
-    return true;
+    drr_entry *temp_drr = find_drr_in_list(hisID_);
+    unsigned int bin = 0;
+    bool found = temp_drr && temp_drr->find_bin((unsigned int) (x_ / temp_drr->comp[0]),
+                                                (unsigned int) (y_ / temp_drr->comp[1]), bin) &&
+                 temp_drr->check_bin(bin);
+    return add_fill(hisID_, temp_drr, found, bin, weight_);
 }
 
 
@@ -1175,38 +1276,24 @@ bool OutputHisFile::FillBin(unsigned int hisID_, unsigned int x_, unsigned int y
                        unsigned int weight_) {
     if (!writable)[[unlikely]] { return false; }
 
-    std::shared_ptr<drr_entry> temp_drr = find_drr_in_list(hisID_);
-    if (temp_drr == nullptr) {
-        undef_his_failed_fills.insert(hisID_);
-        return false;
-    }
-    unsigned int bin;
-    temp_drr->total_counts++;
-    if (!temp_drr->get_bin(x_, y_, bin)) { 
-        bin_not_found_failed_fills[hisID_] += 1;
-        return false; 
-    }
-    // Push this fill into the queue
-    waiting_to_enqueue.push_back(WriteQueueObject(temp_drr->calculate_buffer_location(bin), temp_drr->use_int, weight_));
-    if(++Flush_count > Flush_wait)
-    {
-        Flush();
-    }
-    return true;
+    drr_entry *temp_drr = find_drr_in_list(hisID_);
+    unsigned int bin = 0;
+    bool found = temp_drr && temp_drr->get_bin(x_, y_, bin) && temp_drr->check_bin(bin);
+    return add_fill(hisID_, temp_drr, found, bin, weight_);
 }
 
 bool OutputHisFile::Zero(unsigned int hisID_) {
     if (!writable) { return false; }
 
-    std::shared_ptr<drr_entry> temp_drr = find_drr_in_list(hisID_);
+    drr_entry *temp_drr = find_drr_in_list(hisID_);
     if (temp_drr) {
-        ofile.seekp(temp_drr->offset * 2, std::ios::beg);
-
-        char *block = new char[temp_drr->total_size];
-        memset(block, 0x0, temp_drr->total_size);
-        ofile.write(block, temp_drr->total_size);
-        delete[] block;
-
+        // Hand our own fills over first so only those made before the call are
+        // dropped, those we make afterwards go to a new delta.
+        publish_delta();
+        lock_merging();
+        zeroed_at[hisID_] = ++zero_generation;
+        zero_entry(*temp_drr);
+        merging.clear(std::memory_order_release);
         return true;
     }
 
@@ -1217,13 +1304,15 @@ bool OutputHisFile::Zero() {
     if (!writable)
         return false;
 
+    publish_delta();
+    lock_merging();
+    all_zeroed_at = ++zero_generation;
+    zeroed_at.clear();
     for (auto &entry: drr_entry_map) {
-        ofile.seekp(entry->offset * 2, std::ios::beg);
-        char *block = new char[entry->total_size];
-        memset(block, 0x0, entry->total_size);
-        ofile.write(block, entry->total_size);
-        delete[] block;
+        if(entry == nullptr){continue;}
+        zero_entry(*entry);
     }
+    merging.clear(std::memory_order_release);
     return true;
 }
 
@@ -1242,8 +1331,6 @@ bool OutputHisFile::Open(std::string fname_prefix) {
     ofile.open((fname + ".his").c_str(),
                std::ios::out | std::ios::in | std::ios::trunc |
                std::ios::binary);
-    HisFileWriter::SetOfile(&ofile);
-    HisFileWriter::Start();
     return (writable = ofile.good());
 }
 
@@ -1287,8 +1374,8 @@ void OutputHisFile::Close() {
 
     // Clear the .drr entries in the entries vector
     clear_drr_entries();
+    memory_used = 0;
     writable = false;
-    HisFileWriter::Stop();
     ofile.close();
 }
 
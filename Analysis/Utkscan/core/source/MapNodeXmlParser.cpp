@@ -169,6 +169,9 @@ void MapNodeXmlParser::ParseNode(DetectorLibrary *lib) {
         }//end loop over channels
     }//end loop over modules
 
+    //Now that every channel is known we can index the calibrations by channel id.
+    calibrations_.Compile(*lib);
+    walkCorrector_.Compile(*lib);
     lib->SetCalibrations(calibrations_);
     lib->SetWalkCorrection(walkCorrector_);
     messenger_.done();
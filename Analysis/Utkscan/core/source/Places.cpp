@@ -3,6 +3,7 @@
 * \author K. A. Miernik
 * \date October 22, 2012
 */
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <map>
@@ -12,6 +13,58 @@
 
 using namespace std;
 
+thread_local bool Place::propagating_ = false;
+
+void Place::propagate_(EventData &info) {
+    if (!orderValid_)
+        buildOrder_();
+
+    propagating_ = true;
+    try {
+        for (vector<Place *>::iterator it = order_.begin(); it != order_.end(); ++it) {
+            if ((*it)->pending_) {
+                (*it)->pending_ = false;
+                (*it)->check_(info);
+            }
+        }
+    } catch (...) {
+        for (vector<Place *>::iterator it = order_.begin(); it != order_.end(); ++it)
+            (*it)->pending_ = false;
+        propagating_ = false;
+        throw;
+    }
+    propagating_ = false;
+}
+
+void Place::buildOrder_() {
+    //A depth first search through the parents gives every place after all of
+    // its own parents, so we reverse it to put the children first.
+    order_.clear();
+    vector<pair<Place *, unsigned> > stack;
+    stack.push_back(make_pair(this, 0u));
+    while (!stack.empty()) {
+        Place *current = stack.back().first;
+        unsigned &next = stack.back().second;
+        if (next < current->parents_.size()) {
+            Place *parent = current->parents_[next++];
+            if (find(order_.begin(), order_.end(), parent) == order_.end())
+                stack.push_back(make_pair(parent, 0u));
+        } else {
+            if (current != this && find(order_.begin(), order_.end(), current) == order_.end())
+                order_.push_back(current);
+            stack.pop_back();
+        }
+    }
+    reverse(order_.begin(), order_.end());
+    orderValid_ = true;
+}
+
+void Place::invalidateOrder_() {
+    orderValid_ = false;
+    for (vector<pair<Place *, bool> >::iterator it = children_.begin(); it != children_.end(); ++it)
+        it->first->invalidateOrder_();
+}
+
 bool Place::checkParents(Place *child) {
     bool isAllDifferent = true;
     vector<Place *>::iterator it;
@@ -39,6 +92,7 @@ void Place::addChild(Place *child, bool relation) {
     if (checkChildren(child) && checkParents(child)) {
         children_.push_back(pair<Place *, bool>(child, relation));
         child->addParent_(this);
+        child->invalidateOrder_();
     } else {
         stringstream ss;
         ss << "Place " << this << " attempted unsuccesfully to add child "
@@ -60,7 +114,7 @@ void PlaceOR::check_(EventData &info) {
         if (result)
             this->activate(info);
         else
-            this->deactivate(info.time);
+            this->deactivate(info.timestamp);
         report_(info);
     } else {
         stringstream ss;
@@ -83,7 +137,7 @@ void PlaceThresholdOR::check_(EventData &info) {
         if (result)
             this->activate(info);
         else
-            this->deactivate(info.time);
+            this->deactivate(info.timestamp);
         report_(info);
     } else {
         stringstream ss;
@@ -112,7 +166,7 @@ void PlaceAND::check_(EventData &info) {
         if (result)
             this->activate(info);
         else
-            this->deactivate(info.time);
+            this->deactivate(info.timestamp);
         report_(info);
     }
 }
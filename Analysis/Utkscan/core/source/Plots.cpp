@@ -13,6 +13,13 @@
 
 using namespace std;
 
+///The number of fills a thread buffers before it merges them.
+static const size_t BUFFERED_FILLS_PER_MERGE = 65536;
+
+atomic<bool> Plots::bufferedFills_(false);
+mutex Plots::fillMutex_;
+thread_local vector<Plots::BufferedFill> Plots::threadFills_;
+
 Plots::Plots(int offset, int range, std::string name) {
     offset_ = offset;
     range_ = range;
@@ -82,8 +89,9 @@ bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title,
                                int halfWordsPerChan, int xHistLength,
                                int xLow, int xHigh, const std::string &mne) {
     AddHistogram(dammId, mne, title);
-    hd1d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength,
-          xLow, xHigh, title, strlen(title));
+    if (!PlotsRegister::get()->IsReplicating())
+        hd1d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength,
+              xLow, xHigh, title, strlen(title));
     return true;
 }
 
@@ -108,8 +116,9 @@ bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize,
                                int yHistLength, int yLow, int yHigh,
                                const std::string &mne) {
     AddHistogram(dammId, mne, title);
-    hd2d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow, xHigh,
-          ySize, yHistLength, yLow, yHigh, title, strlen(title));
+    if (!PlotsRegister::get()->IsReplicating())
+        hd2d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow,
+              xHigh, ySize, yHistLength, yLow, yHigh, title, strlen(title));
     return true;
 }
 
@@ -147,14 +156,58 @@ bool Plots::Plot(int dammId, double val1, double val2, double val3,
     }
 
     if (val2 == -1 && val3 == -1)
-        count1cc_(dammId + offset_, int(val1), 1);
+        Fill(dammId + offset_, int(val1), 1, -1);
     else if (val3 == -1 || val3 == 0)
-        count1cc_(dammId + offset_, int(val1), int(val2));
+        Fill(dammId + offset_, int(val1), int(val2), -1);
     else
-        set2cc_(dammId + offset_, int(val1), int(val2), int(val3));
+        Fill(dammId + offset_, int(val1), int(val2), int(val3));
     return (true);
 }
 
+void Plots::SetBufferedFills(const bool &a) {
+#ifndef USE_HRIBF
+    if (output_his)
+        output_his->SetThreadedFills(a);
+#endif
+    bufferedFills_ = a;
+}
+
+void Plots::Fill(const int &dammId, const int &x, const int &y, const int &z) {
+#ifdef USE_HRIBF
+    if (bufferedFills_) {
+        BufferedFill fill = {dammId, x, y, z};
+        threadFills_.push_back(fill);
+        if (threadFills_.size() >= BUFFERED_FILLS_PER_MERGE)
+            MergeBufferedFills();
+        return;
+    }
+#endif
+
+    if (z == -1)
+        count1cc_(dammId, x, y);
+    else
+        set2cc_(dammId, x, y, z);
+}
+
+void Plots::MergeBufferedFills() {
+#ifndef USE_HRIBF
+    if (output_his)
+        output_his->PublishFills();
+#else
+    if (threadFills_.empty())
+        return;
+
+    lock_guard<mutex> lock(fillMutex_);
+    for (vector<BufferedFill>::const_iterator it = threadFills_.begin(); it != threadFills_.end(); it++) {
+        if (it->z == -1)
+            count1cc_(it->dammId, it->x, it->y);
+        else
+            set2cc_(it->dammId, it->x, it->y, it->z);
+    }
+    threadFills_.clear();
+#endif
+}
+
 bool Plots::Plot(const std::string &mne, double val1, double val2, double val3,
                  const char *name) {
     if (!Exists(mne))
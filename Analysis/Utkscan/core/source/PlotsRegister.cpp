@@ -47,6 +47,10 @@ bool PlotsRegister::Add(int offset, int range, std::string name) {
     if (offset == 0 && range == 0)
         return true;
 
+    // Replicas reuse the range of the original
+    if (replicating_)
+        return true;
+
     int min = offset;
     int max = offset + range - 1;
 
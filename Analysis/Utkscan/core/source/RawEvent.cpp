@@ -20,33 +20,54 @@ void RawEvent::Init(const std::set<std::string> &usedTypes) {
 
     for (set<string>::const_iterator it = usedTypes.begin(); it != usedTypes.end(); it++) {
         ds.SetName(*it);
-        sumMap.insert(make_pair(*it, ds));
+        AddSummary(*it, ds);
     }
 }
 
-void RawEvent::Zero(const std::set<std::string> &usedev) {
-    for (map<string, DetectorSummary>::iterator it = sumMap.begin(); it != sumMap.end(); it++)
-        (*it).second.Zero();
+void RawEvent::AddChan(ChanEvent *event) {
+    unsigned int id = event->GetID();
+    if (id >= channelTypes_.size())
+        channelTypes_.resize(id + 1, -1);
+    if (channelTypes_[id] < 0)
+        channelTypes_[id] = (int) GetTypeIndex(event->GetChanID().GetType());
 
-    for (vector<ChanEvent *>::iterator it = eventList.begin(); it != eventList.end(); it++)
-        delete *it;
+    usedTypes_[channelTypes_[id]] = true;
+    eventList.push_back(event);
+}
+
+/// The summaries only ever hold channels of their own detector type, so we
+/// only need to zero the summaries of the types that had a channel.
+void RawEvent::Zero(void) {
+    for (unsigned int type = 0; type < usedTypes_.size(); type++) {
+        if (!usedTypes_[type])
+            continue;
+        for (vector<DetectorSummary *>::iterator it = typeSummaries_[type].begin();
+             it != typeSummaries_[type].end(); it++)
+            (*it)->Zero();
+        usedTypes_[type] = false;
+    }
+
+    for (vector<ChanEvent *>::iterator it = eventList.begin(); it != eventList.end(); it++) {
+        if (pool_)
+            pool_->Release(*it);
+        else
+            delete *it;
+    }
 
     eventList.clear();
 }
 
 DetectorSummary *RawEvent::GetSummary(const std::string &s, bool construct) {
     map<string, DetectorSummary>::iterator it = sumMap.find(s);
-    static set <string> nullSummaries;
 
-    Messenger m;
-    stringstream ss;
     if (it == sumMap.end()) {
+        Messenger m;
+        stringstream ss;
         if (construct) {
             // construct the summary
             ss << "Constructing detector summary for type " << s;
             m.detail(ss.str());
-            sumMap.insert(make_pair(s, DetectorSummary(s, eventList)));
-            it = sumMap.find(s);
+            it = AddSummary(s, DetectorSummary(s, eventList));
         } else {
             if (nullSummaries.count(s) == 0) {
                 ss << "Returning NULL detector summary for type " << s;
@@ -71,3 +92,22 @@ const DetectorSummary *RawEvent::GetSummary(const std::string &s) const {
     }
     return &(it->second);
 }
+
+map<string, DetectorSummary>::iterator RawEvent::AddSummary(const std::string &name, const DetectorSummary &summary) {
+    pair<map<string, DetectorSummary>::iterator, bool> result = sumMap.insert(make_pair(name, summary));
+    if (result.second)
+        typeSummaries_[GetTypeIndex(name.substr(0, name.find(':')))].push_back(&result.first->second);
+    return result.first;
+}
+
+unsigned int RawEvent::GetTypeIndex(const std::string &type) {
+    map<string, unsigned int>::iterator it = typeIndices_.find(type);
+    if (it != typeIndices_.end())
+        return it->second;
+
+    unsigned int index = (unsigned int) typeSummaries_.size();
+    typeIndices_.insert(make_pair(type, index));
+    typeSummaries_.push_back(vector<DetectorSummary *>());
+    usedTypes_.push_back(false);
+    return index;
+}
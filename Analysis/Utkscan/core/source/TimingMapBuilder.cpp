@@ -3,7 +3,6 @@
  *  \author S. V. Paulauskas
  *  \date December 16, 2014
 */
-#include <iostream>
 #include <vector>
 
 #include "TimingMapBuilder.hpp"
@@ -18,12 +17,10 @@ void TimingMapBuilder::FillMaps(const std::vector<ChanEvent *> &evts) {
     map_.clear();
     for (vector<ChanEvent *>::const_iterator it = evts.begin();
          it != evts.end(); it++) {
-        ChannelConfiguration id = (*it)->GetChanID();
-        TimingDefs::TimingIdentifier key(id.GetLocation(), id.GetSubtype());
-
         HighResTimingData data(*(*it));
         if (!data.GetIsValid())
             continue;
-        map_.insert(make_pair(key, data));
+        const ChannelConfiguration &id = (*it)->GetChanID();
+        map_.insert(make_pair(TimingDefs::TimingIdentifier(id.GetLocation(), id.GetSubtype()), data));
     }
 }
@@ -5,6 +5,8 @@
  * \author K. A. Miernik
  * \date August 19, 2012
  */
+#include <algorithm>
+
 #include "Exceptions.hpp"
 #include "Globals.hpp"
 #include "Messenger.hpp"
@@ -17,9 +19,13 @@ using namespace StringManipulation;
 
 TreeCorrelator *TreeCorrelator::instance = NULL;
 
+thread_local TreeCorrelator *TreeCorrelator::local_ = NULL;
+
 PlaceBuilder TreeCorrelator::builder = PlaceBuilder();
 
 TreeCorrelator *TreeCorrelator::get() {
+    if (local_)
+        return local_;
     if (!instance)
         instance = new TreeCorrelator();
     return instance;
@@ -63,6 +69,8 @@ void TreeCorrelator::addChild(std::string parent, std::string child, bool coin,
 }
 
 void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, bool verbose) {
+    history_.push_back(make_pair(params, verbose));
+
     bool replace = false;
     if (params["replace"] != "")
         replace = StringToBool(params["replace"]);
@@ -78,6 +86,7 @@ void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, boo
                        << ", it doesn't exist";
                     throw TreeCorrelatorException(ss.str());
                 }
+                resetList_.erase(remove(resetList_.begin(), resetList_.end(), places_[(*it)]), resetList_.end());
                 delete places_[(*it)];
                 if (verbose) {
                     Messenger m;
@@ -100,6 +109,7 @@ void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, boo
             }
             Place *current = builder.create(params, verbose);
             places_[(*it)] = current;
+            current->setDirtyList(&resetList_);
             if (StringToBool(params["init"]))
                 current->activate(0.0);
         }
@@ -111,6 +121,30 @@ void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, boo
     }
 }
 
+TreeCorrelator *TreeCorrelator::Replicate() const {
+    TreeCorrelator *tree = new TreeCorrelator();
+    for (vector<pair<map<string, string>, bool> >::const_iterator it = history_.begin(); it != history_.end(); ++it) {
+        map<string, string> params = it->first;
+        tree->createPlace(params, false);
+    }
+    return tree;
+}
+
+void TreeCorrelator::resetPlaces() {
+    for (vector<Place *>::iterator it = resetList_.begin(); it != resetList_.end(); ++it) {
+        (*it)->reset();
+        (*it)->clearDirty();
+    }
+    resetList_.clear();
+}
+
+bool TreeCorrelator::HasPersistentPlaces() const {
+    for (map<string, Place *>::const_iterator it = places_.begin(); it != places_.end(); ++it)
+        if (!it->second->resetable())
+            return true;
+    return false;
+}
+
 void TreeCorrelator::buildTree() {
     Messenger m;
     m.start("Growing TreeCorrelator");
@@ -158,7 +192,7 @@ TreeCorrelator::~TreeCorrelator() {
     for (map<string, Place *>::iterator it = places_.begin(); it != places_.end(); ++it)
         delete it->second;
     places_.clear();
-    delete instance;
-    instance = NULL;
+    if (instance == this)
+        instance = NULL;
 }
 
@@ -28,6 +28,9 @@ void TreeCorrelatorXmlParser::ParsePlace(pugi::xml_node node, std::string parent
          attr = attr.next_attribute()) {
         params[attr.name()] = attr.value();
     }
+    //The depth is the newer name of the size of the history of the place
+    if (params.find("depth") != params.end())
+        params["fifo"] = params["depth"];
     ///@TODO This is a little clunky since we have the tree in the main
     /// method. This should be cleaned up at some point.
     TreeCorrelator::get()->createPlace(params, verbose);
@@ -32,6 +32,22 @@ UtkScanInterface::~UtkScanInterface() {
 #endif
 }
 
+/** Adds the --workers option, which sets the number of threads that process
+ * the raw events. */
+void UtkScanInterface::ArgHelp() {
+    AddOption(optionExt("workers", required_argument, NULL, 0, "<N>",
+                        "Process the raw events with N DetectorDriver replicas (default=1)"));
+}
+
+/** Passes the number of workers on to the UtkUnpacker. */
+void UtkScanInterface::ExtraArguments() {
+    if (userOpts.at(0).active) {
+        unsigned int numWorkers = (unsigned int) stoi(userOpts.at(0).argument);
+        ((UtkUnpacker *) unpacker_)->SetNumWorkers(numWorkers);
+        cout << msgHeader << "Processing the raw events with " << numWorkers << " workers.\n";
+    }
+}
+
 /** Initialize the map file, the config file, the processor handler, 
  * and add all of the required processors.
  * \param[in]  prefix_ String to append to the beginning of system output.
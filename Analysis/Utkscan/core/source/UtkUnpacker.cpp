@@ -4,13 +4,14 @@
 ///@author S. V. Paulauskas
 ///@date June 17, 2016
 #include <iostream>
-#include <set>
+#include <stdexcept>
 
 #include <unistd.h>
 #include <sys/times.h>
 
 #include "DammPlotIds.hpp"
 #include "Places.hpp"
+#include "Plots.hpp"
 #include "TreeCorrelator.hpp"
 #include "UtkScanInterface.hpp"
 #include "UtkUnpacker.hpp"
@@ -18,15 +19,31 @@
 using namespace std;
 using namespace dammIds::raw;
 
+///The number of raw events that are handed to a worker in one batch. This
+/// keeps the locking rare while the batches stay small enough to spread
+/// evenly over the workers.
+static const size_t EVENTS_PER_BATCH = 512;
+
 ///The only thing that we do here is call the destructor of the
 /// DetectorDriver. This will ensure that the memory is freed for all of the
 /// initialized detector and experiment processors and that information about
 /// the amount of time spent in each processor is output to the screen at the
-/// end of execution.
+/// end of execution. The unpacking pipeline is joined first, since its
+/// processing thread may still be handing raw events to the workers and the
+/// DetectorDriver.
 UtkUnpacker::~UtkUnpacker() {
+    StopPipeline();
+    StopWorkers();
     delete DetectorDriver::get();
 }
 
+void UtkUnpacker::SetNumWorkers(const unsigned int &a) {
+    if (a == 0 || a > MAX_WORKERS)
+        throw invalid_argument("UtkUnpacker::SetNumWorkers - The number of workers must be between 1 and " +
+                               to_string(MAX_WORKERS) + ".");
+    numWorkers_ = a;
+}
+
 /// This method initializes the DetectorLibrary and DetectorDriver classes so
 /// that we can begin processing the events. We take special action on the
 /// first event so that we can handle somethings poperly. Then we processes
@@ -39,25 +56,27 @@ void UtkUnpacker::ProcessRawEvent() {
     static RawEvent rawev;
     DetectorDriver *driver = DetectorDriver::get();
     DetectorLibrary *detectorLibrary = DetectorLibrary::get();
-    set<string> usedDetectors;
-    Messenger m;
-    stringstream ss;
 
     static clock_t systemStartTime;
     static struct tms systemTimes;
     static double lastTimeOfPreviousEvent;
     static unsigned int eventCounter = 0;
 
-    if (eventCounter == 0)
+    if (eventCounter == 1 && numWorkers_ > 1 && workers_.empty())
+        StartWorkers(driver);
+
+    if (eventCounter == 0) {
+        rawev.SetChanEventPool(&chanEventPool_);
         InitializeDriver(driver, detectorLibrary, rawev, systemStartTime);
+    }
     else if (eventCounter % 5000 == 0 || eventCounter == 1)
         PrintProcessingTimeInformation(systemStartTime, times(&systemTimes), GetEventStartTime(), eventCounter);
 
     if (Globals::get()->HasRejectionRegion()) {
         double eventTime = (GetEventStartTime() - GetFirstTime()) * Globals::get()->GetClockInSeconds();
-        vector <pair<unsigned int, unsigned int>> rejectRegions = Globals::get()->GetRejectionRegions();
+        const vector<pair<unsigned int, unsigned int> > &rejectRegions = Globals::get()->GetRejectionRegions();
 
-        for (vector<pair<unsigned int, unsigned int> >::iterator region = rejectRegions.begin();
+        for (vector<pair<unsigned int, unsigned int> >::const_iterator region = rejectRegions.begin();
              region != rejectRegions.end(); ++region)
             if (eventTime > region->first && eventTime < region->second)
                 return;
@@ -68,6 +87,17 @@ void UtkUnpacker::ProcessRawEvent() {
     driver->plot(D_EVENT_LENGTH, (GetRealStopTime() - GetRealStartTime()) * Globals::get()->GetClockInSeconds() * 1e9);
     driver->plot(D_EVENT_MULTIPLICITY, rawEvent.size());
 
+    //When the workers are running we only collect the channels of the event
+    vector<ChanEvent *> *channels = NULL;
+    if (!workers_.empty()) {
+        if (!eventBatch_) {
+            eventBatch_ = new EventBatch();
+            eventBatch_->firstEventNumber = nextEventNumber_;
+        }
+        eventBatch_->events.push_back(vector<ChanEvent *>());
+        channels = &eventBatch_->events.back();
+    }
+
     //loop over the list of channels that fired in this event
     for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++) {
 
@@ -77,9 +107,8 @@ void UtkUnpacker::ProcessRawEvent() {
         RawStats((*it), driver);
 
         if ((*it)->GetId() == std::numeric_limits<unsigned int>::max()) {
-            ss << "pattern 0 ignore";
-            m.warning(ss.str());
-            ss.str("");
+            Messenger m;
+            m.warning("pattern 0 ignore");
             continue;
         }
 
@@ -87,36 +116,197 @@ void UtkUnpacker::ProcessRawEvent() {
         if (detectorLibrary->at((*it)->GetId()).GetType() == "ignore")
             continue;
 
-        ///@TODO we need to ensure that all of the memory is getting freed
-        /// appropriately at the end of processing an event. I'm not sure
-        /// that it is right now.
-        ChanEvent *event = new ChanEvent(*(*it));
+        //The events go back to the pool when the raw event is zeroed.
+        ChanEvent *event = chanEventPool_.Acquire(*(*it));
+
+        if (channels) {
+            channels->push_back(event);
+            continue;
+        }
 
-        ///@TODO This will also fail if the user doesn't define enough modules in the map. Related to pixie16/paass:#103
-        usedDetectors.insert((*detectorLibrary)[(*it)->GetId()].GetType());
         rawev.AddChan(event);
 
         ///@TODO Add back in the processing for the dtime.
     }//for(deque<PixieData*>::iterator
 
-    try {
-        driver->ProcessEvent(rawev);
-        rawev.Zero(usedDetectors);
-        usedDetectors.clear();
-
-        ///@TODO I think that this is done twice, it needs to be investigated.
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
-    } catch (exception &ex) {
-        throw;
-    }
+    if (channels) {
+        //The DetectorDriver only numbers the events that have channels
+        if (channels->empty())
+            eventBatch_->events.pop_back();
+        else
+            nextEventNumber_++;
+        if (eventBatch_->events.size() >= EVENTS_PER_BATCH)
+            DispatchBatch();
+    } else
+        ProcessEvent(driver, rawev);
 
     eventCounter++;
     lastTimeOfPreviousEvent = GetRealStopTime();
 }
 
+void UtkUnpacker::ProcessEvent(DetectorDriver *driver, RawEvent &rawev) {
+    driver->ProcessEvent(rawev);
+    rawev.Zero();
+}
+
+/// We process the first raw event with the original DetectorDriver so that it
+/// sets up everything that depends on the first event. The replicas start
+/// from there. Processors are loaded from the configuration file again for
+/// every replica, which is only safe if none of them needs to see the events
+/// in order.
+void UtkUnpacker::StartWorkers(DetectorDriver *driver) {
+    Messenger m;
+
+    if (driver->IsTimeOrdered()) {
+        m.warning("UtkUnpacker::StartWorkers - The analysis needs its events in time order. We will process "
+                  "them with a single DetectorDriver.");
+        numWorkers_ = 1;
+        return;
+    }
+
+    m.start("Starting " + to_string(numWorkers_) + " event processing workers");
+#ifdef useroot
+    ROOT::EnableThreadSafety();
+#endif
+    driver_ = driver;
+    nextEventNumber_ = driver->GetEventNumber();
+    TreeCorrelator *tree = TreeCorrelator::get();
+    for (unsigned int i = 0; i < numWorkers_; i++)
+        replicas_.push_back(make_pair(driver->Replicate(), tree->Replicate()));
+
+    Plots::SetBufferedFills(true);
+    chanEventPool_.SetThreadSafe(true);
+    workQueue_.SetCapacity(2 * numWorkers_);
+    for (unsigned int i = 0; i < numWorkers_; i++)
+        workers_.push_back(thread(&UtkUnpacker::ProcessBatches, this, replicas_[i].first, replicas_[i].second));
+    m.done();
+}
+
+void UtkUnpacker::StopWorkers() {
+    if (workers_.empty())
+        return;
+
+    if (eventBatch_) {
+        {
+            lock_guard<mutex> lock(workMutex_);
+            batchesInFlight_++;
+        }
+        workQueue_.Push(eventBatch_);
+        eventBatch_ = NULL;
+    }
+    for (unsigned int i = 0; i < workers_.size(); i++)
+        workQueue_.Push(NULL);
+    for (vector<thread>::iterator it = workers_.begin(); it != workers_.end(); it++)
+        it->join();
+    workers_.clear();
+
+    Plots::MergeBufferedFills();
+    Plots::SetBufferedFills(false);
+    chanEventPool_.SetThreadSafe(false);
+
+    for (vector<pair<DetectorDriver *, TreeCorrelator *> >::iterator it = replicas_.begin(); it != replicas_.end(); it++) {
+        delete it->first;
+        delete it->second;
+    }
+    replicas_.clear();
+}
+
+void UtkUnpacker::DispatchBatch() {
+    CheckWorkers();
+    if (!eventBatch_)
+        return;
+
+    {
+        lock_guard<mutex> lock(workMutex_);
+        batchesInFlight_++;
+    }
+    workQueue_.Push(eventBatch_);
+    eventBatch_ = NULL;
+}
+
+void UtkUnpacker::FinishRawEvents() {
+    if (workers_.empty())
+        return;
+
+    DispatchBatch();
+    {
+        unique_lock<mutex> lock(workMutex_);
+        while (batchesInFlight_ > 0)
+            batchDone_.wait(lock);
+    }
+    Plots::MergeBufferedFills();
+    CheckWorkers();
+}
+
+void UtkUnpacker::CheckWorkers() {
+    lock_guard<mutex> lock(workMutex_);
+    if (workerError_) {
+        exception_ptr error = workerError_;
+        workerError_ = exception_ptr();
+        rethrow_exception(error);
+    }
+}
+
+/// The replicas are set as the DetectorDriver and TreeCorrelator of this
+/// thread, so the processors find them through the usual get methods. After
+/// every batch we merge our histogram fills and ROOT events into the
+/// original. Once a worker hit an exception it only frees the events that it
+/// is handed, the exception is thrown again by the thread that feeds us.
+void UtkUnpacker::ProcessBatches(DetectorDriver *driver, TreeCorrelator *tree) {
+    DetectorDriver::SetLocal(driver);
+    TreeCorrelator::SetLocal(tree);
+
+    RawEvent rawev;
+    rawev.SetChanEventPool(&chanEventPool_);
+    bool failed = false;
+    {
+        lock_guard<mutex> lock(mergeMutex_);
+        driver->Init(rawev);
+    }
+
+    EventBatch *batch;
+    while ((batch = workQueue_.Pop()) != NULL) {
+        unsigned long eventNumber = batch->firstEventNumber;
+        for (vector<vector<ChanEvent *> >::iterator event = batch->events.begin(); event != batch->events.end();
+             event++) {
+            for (vector<ChanEvent *>::iterator it = event->begin(); it != event->end(); it++) {
+                if (failed) {
+                    chanEventPool_.Release(*it);
+                    continue;
+                }
+                rawev.AddChan(*it);
+            }
+            if (failed)
+                continue;
+
+            try {
+                driver->SetEventNumber(eventNumber++);
+                ProcessEvent(driver, rawev);
+            } catch (...) {
+                rawev.Zero();
+                failed = true;
+                lock_guard<mutex> lock(workMutex_);
+                if (!workerError_)
+                    workerError_ = current_exception();
+            }
+        }
+        delete batch;
+
+        Plots::MergeBufferedFills();
+        {
+            lock_guard<mutex> lock(mergeMutex_);
+            driver_->MergeReplica(driver);
+        }
+
+        lock_guard<mutex> lock(workMutex_);
+        batchesInFlight_--;
+        batchDone_.notify_all();
+    }
+
+    DetectorDriver::SetLocal(NULL);
+    TreeCorrelator::SetLocal(NULL);
+}
+
 /// This method plots information about the running time of the program, the
 /// hit spectrum, and the scalars for each of the channels. The two runtime
 /// spectra are critical when we are trying to debug potential data losses in
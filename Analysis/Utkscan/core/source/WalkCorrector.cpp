@@ -108,48 +108,56 @@ void WalkCorrector::AddChannel(const ChannelConfiguration &chanID, const std::st
     }
 }
 
-double WalkCorrector::GetCorrection(ChannelConfiguration &chanID, double raw) const {
+double WalkCorrector::GetCorrection(const ChannelConfiguration &chanID, double raw) const {
     map < ChannelConfiguration, vector < CorrectionParams > > ::const_iterator itch = channels_.find(chanID);
-    if (itch != channels_.end()) {
-        vector<CorrectionParams>::const_iterator itf;
-        for (itf = itch->second.begin(); itf != itch->second.end(); ++itf) {
-            if (itf->min <= raw && raw <= itf->max)
-                break;
-        }
-        if (itf == itch->second.end())
-            return 0;
-
-        switch (itf->model) {
-            case none:
-                return Model_None();
-                break;
-            case A:
-                return Model_A(itf->parameters, raw);
-                break;
-            case B1:
-                return Model_B1(itf->parameters, raw);
-                break;
-            case B2:
-                return Model_B2(itf->parameters, raw);
-                break;
-            case VS:
-                return Model_VS(itf->parameters, raw);
-                break;
-            case VM:
-                return Model_VM(itf->parameters, raw);
-                break;
-            case VL:
-                return Model_VL(itf->parameters, raw);
-                break;
-            case VD:
-                return Model_VD(itf->parameters, raw);
-                break;
-            case VB:
-                return Model_VB(itf->parameters, raw);
-                break;
-            default:
-                break;
-        }
+    if (itch != channels_.end())
+        return Correct(&itch->second[0], itch->second.size(), raw);
+    return 0;
+}
+
+void WalkCorrector::Compile(const std::vector<ChannelConfiguration> &channels) {
+    compiled_.clear();
+    table_.assign(channels.size(), make_pair(0u, 0u));
+    for (unsigned int i = 0; i < channels.size(); i++) {
+        map<ChannelConfiguration, vector<CorrectionParams> >::const_iterator itch = channels_.find(channels[i]);
+        if (itch == channels_.end())
+            continue;
+        table_[i] = make_pair((unsigned int) compiled_.size(), (unsigned int) itch->second.size());
+        compiled_.insert(compiled_.end(), itch->second.begin(), itch->second.end());
+    }
+}
+
+double WalkCorrector::Correct(const CorrectionParams *ranges, const unsigned int &numRanges, double raw) const {
+    const CorrectionParams *itf = ranges;
+    const CorrectionParams *end = ranges + numRanges;
+    for (; itf != end; ++itf) {
+        if (itf->min <= raw && raw <= itf->max)
+            break;
+    }
+    if (itf == end)
+        return 0;
+
+    switch (itf->model) {
+        case none:
+            return Model_None();
+        case A:
+            return Model_A(itf->parameters, raw);
+        case B1:
+            return Model_B1(itf->parameters, raw);
+        case B2:
+            return Model_B2(itf->parameters, raw);
+        case VS:
+            return Model_VS(itf->parameters, raw);
+        case VM:
+            return Model_VM(itf->parameters, raw);
+        case VL:
+            return Model_VL(itf->parameters, raw);
+        case VD:
+            return Model_VD(itf->parameters, raw);
+        case VB:
+            return Model_VB(itf->parameters, raw);
+        default:
+            break;
     }
     return 0;
 }
@@ -0,0 +1,54 @@
+///@file unittest-Calibrator.cpp
+///@brief Program that will test functionality of the Calibrator
+///@date October 17, 2026
+#include <cmath>
+
+#include <UnitTest++.h>
+
+#include "Calibrator.hpp"
+#include "ChannelConfiguration.hpp"
+#include "Exceptions.hpp"
+
+using namespace std;
+
+TEST_FIXTURE(Calibrator, Test_GetCalEnergy) {
+    ChannelConfiguration cfg("unit", "test", 3);
+    AddChannel(cfg, "linear", 0., 100., {1.0, 2.0});
+    AddChannel(cfg, "quadratic", 100., 200., {1.0, 2.0, 0.5});
+
+    CHECK_EQUAL(1.0 + 2.0 * 50., GetCalEnergy(cfg, 50.));
+    CHECK_EQUAL(1.0 + 2.0 * 150. + 0.5 * 150. * 150., GetCalEnergy(cfg, 150.));
+    //Parts of the spectrum outside of the ranges are zeroed.
+    CHECK_EQUAL(0.0, GetCalEnergy(cfg, 250.));
+    //Channels without a calibration are left raw.
+    CHECK_EQUAL(250., GetCalEnergy(ChannelConfiguration("unit", "test", 4), 250.));
+
+    CHECK_THROW(AddChannel(cfg, "unknown", 0., 100., {1.0}), GeneralException);
+    CHECK_THROW(AddChannel(cfg, "cubic", 0., 100., {1.0, 2.0}), GeneralException);
+}
+
+TEST_FIXTURE(Calibrator, Test_CompiledCalEnergy) {
+    ChannelConfiguration cfg("unit", "test", 3);
+    ChannelConfiguration expCfg("unit", "exp", 0);
+    AddChannel(cfg, "linear", 0., 100., {1.0, 2.0});
+    AddChannel(cfg, "off", 100., 200., {});
+    AddChannel(expCfg, "exp", 0., 1000., {2.0, 100., 3.0});
+
+    vector<ChannelConfiguration> channels = {ChannelConfiguration(), cfg, expCfg};
+    Compile(channels);
+
+    double values[] = {-1., 0., 50., 100., 150., 300.};
+    for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        CHECK_EQUAL(GetCalEnergy(cfg, values[i]), GetCalEnergy(1u, values[i]));
+        CHECK_EQUAL(GetCalEnergy(expCfg, values[i]), GetCalEnergy(2u, values[i]));
+    }
+    CHECK_CLOSE(2.0 * exp(0.5) + 3.0, GetCalEnergy(2u, 50.), 1e-12);
+
+    //Channels that are not calibrated or not in the table are left raw.
+    CHECK_EQUAL(42., GetCalEnergy(0u, 42.));
+    CHECK_EQUAL(42., GetCalEnergy(7u, 42.));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
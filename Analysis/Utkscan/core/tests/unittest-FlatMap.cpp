@@ -0,0 +1,66 @@
+///@file unittest-FlatMap.cpp
+///@brief Program that will test the functionality of the FlatMap
+///@date October 17, 2026
+#include <map>
+#include <string>
+
+#include <UnitTest++.h>
+
+#include "FlatMap.hpp"
+
+using namespace std;
+
+typedef FlatMap<pair<unsigned int, string>, int> TestMap;
+
+///Testing that the entries are kept sorted and that we can find them
+TEST (Test_InsertAndFind) {
+    TestMap flat;
+    CHECK(flat.empty());
+
+    CHECK(flat.insert(make_pair(make_pair(3u, string("small")), 1)).second);
+    CHECK(flat.insert(make_pair(make_pair(1u, string("small")), 2)).second);
+    CHECK(flat.insert(make_pair(make_pair(1u, string("big")), 3)).second);
+
+    //A key that is already in the map does not overwrite the value, just like std::map
+    pair<TestMap::iterator, bool> result = flat.insert(make_pair(make_pair(3u, string("small")), 4));
+    CHECK(!result.second);
+    CHECK_EQUAL(1, result.first->second);
+    CHECK_EQUAL((unsigned int) 3, flat.size());
+
+    map<pair<unsigned int, string>, int> expected;
+    expected.insert(make_pair(make_pair(3u, string("small")), 1));
+    expected.insert(make_pair(make_pair(1u, string("small")), 2));
+    expected.insert(make_pair(make_pair(1u, string("big")), 3));
+
+    map<pair<unsigned int, string>, int>::const_iterator it = expected.begin();
+    for (TestMap::const_iterator itFlat = flat.begin(); itFlat != flat.end(); itFlat++, it++) {
+        CHECK(it->first == itFlat->first);
+        CHECK_EQUAL(it->second, itFlat->second);
+    }
+
+    CHECK_EQUAL(3, flat.find(make_pair(1u, string("big")))->second);
+    CHECK(flat.find(make_pair(2u, string("big"))) == flat.end());
+    CHECK_EQUAL((unsigned int) 1, flat.count(make_pair(1u, string("small"))));
+    CHECK_EQUAL((unsigned int) 0, flat.count(make_pair(0u, string("small"))));
+
+    flat[make_pair(0u, string("small"))] = 5;
+    CHECK_EQUAL(5, flat.begin()->second);
+    CHECK_EQUAL((unsigned int) 4, flat.size());
+}
+
+///Testing that clearing the map keeps its memory
+TEST (Test_ClearKeepsStorage) {
+    TestMap flat;
+    for (unsigned int i = 0; i < 10; i++)
+        flat.insert(make_pair(make_pair(i, string("small")), (int) i));
+    const pair<pair<unsigned int, string>, int> *storage = &(*flat.begin());
+
+    flat.clear();
+    CHECK(flat.empty());
+    flat.insert(make_pair(make_pair(7u, string("small")), 7));
+    CHECK_EQUAL(storage, &(*flat.begin()));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,59 @@
+///@file unittest-RingBuffer.cpp
+///@brief Program that will test the functionality of the RingBuffer
+///@date October 17, 2026
+#include <deque>
+#include <stdexcept>
+
+#include <UnitTest++.h>
+
+#include "RingBuffer.hpp"
+
+using namespace std;
+
+///Testing that the buffer keeps the same entries as a deque that is trimmed from the front
+TEST (Test_PushBackMatchesDeque) {
+    RingBuffer<int> ring(3);
+    deque<int> expected;
+    CHECK(ring.empty());
+    CHECK_EQUAL((unsigned int) 3, ring.capacity());
+
+    for (int i = 0; i < 10; i++) {
+        ring.push_back(i);
+        expected.push_back(i);
+        while (expected.size() > 3)
+            expected.pop_front();
+
+        CHECK_EQUAL(expected.size(), ring.size());
+        for (unsigned int j = 0; j < expected.size(); j++)
+            CHECK_EQUAL(expected.at(j), ring.at(j));
+        CHECK_EQUAL(expected.front(), ring.front());
+        CHECK_EQUAL(expected.back(), ring.back());
+    }
+
+    CHECK_THROW(ring.at(3), out_of_range);
+}
+
+///Testing that a full buffer overwrites its storage and that a buffer without capacity stays empty
+TEST (Test_FullBufferKeepsStorage) {
+    RingBuffer<int> ring(2);
+    ring.push_back(1);
+    ring.push_back(2);
+    const int *storage = &ring.front();
+
+    ring.push_back(3);
+    CHECK_EQUAL(storage, &ring.back());
+    CHECK_EQUAL(2, ring.front());
+
+    ring.clear();
+    CHECK(ring.empty());
+    ring.push_back(4);
+    CHECK_EQUAL(storage, &ring.front());
+
+    RingBuffer<int> none(0);
+    none.push_back(1);
+    CHECK(none.empty());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -95,6 +95,24 @@ TEST_FIXTURE(WalkCorrector, Test_GetCorrection) {
     CHECK_EQUAL(expected, GetCorrection(cfg, raw));
 }
 
+TEST_FIXTURE(WalkCorrector, Test_CompiledCorrection) {
+    ChannelConfiguration cfg("unit", "test", 3);
+    ChannelConfiguration other("unit", "test", 4);
+    vector<double> par = {0.5, 2.1, 3.7};
+    AddChannel(cfg, "B2", 0.0, 100., par);
+    AddChannel(cfg, "None", 100., 1000., par);
+
+    vector<ChannelConfiguration> channels = {other, cfg};
+    Compile(channels);
+
+    double raw = 20.3;
+    CHECK_EQUAL(GetCorrection(cfg, raw), GetCorrection(1u, raw));
+    CHECK_EQUAL(0.0, GetCorrection(1u, 500.));
+    CHECK_EQUAL(0.0, GetCorrection(1u, 2000.));
+    CHECK_EQUAL(0.0, GetCorrection(0u, raw));
+    CHECK_EQUAL(0.0, GetCorrection(5u, raw));
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
@@ -111,6 +111,7 @@ Anl1471Processor::Anl1471Processor() : EventProcessor(OFFSET, RANGE,
     associatedTypes.insert("vandle");
     associatedTypes.insert("beta");
     associatedTypes.insert("ge");
+    timeOrdered_ = true;
 
     stringstream name;
     name << Globals::get()->GetOutputPath()
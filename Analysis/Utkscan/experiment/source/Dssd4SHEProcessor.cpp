@@ -31,6 +31,7 @@ Dssd4SHEProcessor::Dssd4SHEProcessor(double timeWindow,
                                      int numFrontStrips) :
         EventProcessor(OFFSET, RANGE, "dssd4she"),
         correlator_(numBackStrips, numFrontStrips) {
+    timeOrdered_ = true; // The SheCorrelator follows the decay chains in time
     timeWindow_ = timeWindow;
     deltaEnergy_ = deltaEnergy;
     highEnergyCut_ = highEnergyCut;
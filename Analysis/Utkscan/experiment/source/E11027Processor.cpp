@@ -26,6 +26,7 @@ void E11027Processor::DeclarePlots(void) {
 
 E11027Processor::E11027Processor() : EventProcessor(OFFSET, RANGE, "E11027Processor") {
     associatedTypes.insert("valid");
+    timeOrdered_ = true;
 
     stringstream name;
     name << Globals::get()->GetOutputPath()
@@ -66,6 +66,7 @@ IS600Processor::IS600Processor() : EventProcessor(OFFSET, RANGE,
     associatedTypes.insert("labr3");
     associatedTypes.insert("beta");
     associatedTypes.insert("ge");
+    timeOrdered_ = true;
 
     stringstream name;
     name << Globals::get()->GetOutputPath()
@@ -109,7 +110,7 @@ bool IS600Processor::Process(RawEvent &event) {
     double plotOffset_ = 1000;
 
     BarMap vbars, betas;
-    map<unsigned int, pair<double, double> > lrtBetas;
+    LrtBarMap lrtBetas;
     vector < ChanEvent * > geEvts;
     vector <vector<AddBackEvent>> geAddback;
 
@@ -261,8 +262,7 @@ bool IS600Processor::Process(RawEvent &event) {
 
 
     //------------------ Double Beta Processing --------------
-    for (map<unsigned int, pair<double, double> >
-         ::iterator it = lrtBetas.begin();
+    for (LrtBarMap::iterator it = lrtBetas.begin();
          it != lrtBetas.end();
          it++)
         plot(DD_PROTONBETA2TDIFF_VS_BETA2EN, it->second.second,
@@ -73,6 +73,7 @@ TemplateExpProcessor::~TemplateExpProcessor() {
 void TemplateExpProcessor::SetAssociatedTypes(void) {
     associatedTypes.insert("template");
     associatedTypes.insert("clover");
+    timeOrdered_ = true; // We write our own output files
 }
 
 ///Sets up the name of the output ascii data file
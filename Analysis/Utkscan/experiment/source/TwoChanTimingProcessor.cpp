@@ -44,6 +44,7 @@ using namespace dammIds::experiment;
 TwoChanTimingProcessor::TwoChanTimingProcessor() :
         EventProcessor(OFFSET, RANGE, "TwoChanTimingProcessor") {
     associatedTypes.insert("pulser");
+    timeOrdered_ = true;
 
     rootfile = new TFile(Globals::get()->AppendOutputPath(Globals::get()->GetOutputFileName() + ".root").c_str(), "RECREATE");
 
@@ -104,14 +105,14 @@ bool TwoChanTimingProcessor::Process(RawEvent &event) {
 
     static int trcCounter = 0;
     int bin = 0;
-    for (vector<unsigned int>::const_iterator it = start.GetTrace().begin();
+    for (Trace::const_iterator it = start.GetTrace().begin();
          it != start.GetTrace().end(); it++) {
         bin = (int) (it - start.GetTrace().begin());
         startTraces->Fill(bin, trcCounter, *it);
         startAmpDistribution->Fill(bin, *it);
     }
 
-    for (vector<unsigned int>::const_iterator it = stop.GetTrace().begin();
+    for (Trace::const_iterator it = stop.GetTrace().begin();
          it != stop.GetTrace().end(); it++) {
         bin = (int) (it - stop.GetTrace().begin());
         stopTraces->Fill(bin, trcCounter, *it);
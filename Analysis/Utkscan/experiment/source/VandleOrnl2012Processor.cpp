@@ -61,6 +61,7 @@ void VandleOrnl2012Processor::DeclarePlots(void) {
 VandleOrnl2012Processor::VandleOrnl2012Processor() :
         EventProcessor(OFFSET, RANGE, "VandleOrnl2012Processor") {
     associatedTypes.insert("vandle");
+    timeOrdered_ = true;
 
     stringstream name;
     name << Globals::get()->GetOutputPath()
@@ -6,6 +6,7 @@
 #ifndef __DOUBLEBETAPROCESSOR_HPP__
 #define __DOUBLEBETAPROCESSOR_HPP__
 
+#include "BarBuilder.hpp"
 #include "BarDetector.hpp"
 #include "EventProcessor.hpp"
 #include "HighResTimingData.hpp"
@@ -33,16 +34,15 @@ public:
     virtual bool Process(RawEvent &event);
 
     /** \return The map of the bars that had high resolution timing */
-    BarMap GetBars(void) { return (bars_); }
+    const BarMap &GetBars(void) const { return (bars_); }
 
     /** \return the map of the bars that had low resolution timing */
-    std::map<unsigned int, std::pair<double, double> > GetLowResBars(void) {
-        return (lrtbars_);
-    }
+    const LrtBarMap &GetLowResBars(void) const { return (lrtbars_); }
 
 private:
     BarMap bars_; //!< Map holding all the bars we found 
-    std::map<unsigned int, std::pair<double, double> > lrtbars_; //!< map holding low res bars
+    LrtBarMap lrtbars_; //!< map holding low res bars
+    BarBuilder builder_; //!< Builds the bars, kept to reuse its memory
     processor_struct::DOUBLEBETA DBstruc; //!<Root Struct
 
 };
@@ -91,6 +91,14 @@ public:
         return (name);
     }
 
+    /** \return True if the processor needs to see every event in time order,
+    * because it correlates events with one another or writes its own output.
+    * The analysis will not be split across DetectorDriver replicas if any of
+    * the processors sets this. */
+    bool IsTimeOrdered(void) const {
+        return (timeOrdered_);
+    }
+
 #ifdef useroot
 
     /** This functions adds the branch to the tree that will be responsible
@@ -118,6 +126,7 @@ protected:
     std::set<std::string> associatedTypes; //!< Set of associated types for Processor
     bool initDone;//!< True if the initialization has finished
     bool didProcess;//!< True if the process finished
+    bool timeOrdered_;//!< True if the processor needs the events in time order
     std::map<std::string, const DetectorSummary *> sumMap; //!< Map of associated detector summary
 
     /** Plots class for given Processor, takes care of declaration
@@ -11,6 +11,7 @@
 #include <sstream>
 #include <string>
 
+#include "BarBuilder.hpp"
 #include "DammPlotIds.hpp"
 #include "EventProcessor.hpp"
 #include "Messenger.hpp"
@@ -166,7 +167,7 @@ private:
         This is a vector of a pair of doubles The data is stored as <<Time,Energy>,...>
     */std::vector<std::pair<double,double>> BetaList;
 
-    std::map<unsigned int, std::pair<double, double> > lrtBetas; //!<Low Res Time beta bar map (ISOL style). Order is <Double Beta det #, < Time, Energy > >
+    LrtBarMap lrtBetas; //!<Low Res Time beta bar map (ISOL style). Order is <Double Beta det #, < Time, Energy > >
    
     //input arguments
     bool BetaGammGamm = false; //!< beta gamma gamma plots which are LARGE and not implamented yet. (might just dump to root rather than here)
@@ -17,9 +17,11 @@
 #include <set>
 #include <string>
 
+#include "BarBuilder.hpp"
 #include "BarDetector.hpp"
 #include "EventProcessor.hpp"
 #include "HighResTimingData.hpp"
+#include "TimingMapBuilder.hpp"
 
 #include "PaassRootStruct.hpp"
 
@@ -64,7 +66,7 @@ public:
     }
 
     ///@return the map of the build VANDLE bars */
-    BarMap GetBars(void) { return bars_; }
+    const BarMap &GetBars(void) const { return bars_; }
 
     ///@return true if we requested small bars in the xml */
     bool GetHasSmall(void) { return requestedTypes_.find("small") != requestedTypes_.end(); }
@@ -96,6 +98,10 @@ private:
     BarMap bars_;//!< A map to hold all the bars
     TimingMap starts_;//!< A map to to hold all the starts
     BarMap barStarts_;//!< A map that holds all of the bar starts
+    BarBuilder barBuilder_;//!< Builds the VANDLE bars, kept to reuse its memory
+    BarBuilder startBarBuilder_;//!< Builds the bar starts, kept to reuse its memory
+    TimingMapBuilder startBuilder_;//!< Builds the starts, kept to reuse its memory
+    std::vector<ChanEvent *> startEvents_;//!< The single ended starts of the current event
     DetectorSummary *geSummary_;//!< The Detector Summary for Ge Events
 
     bool RDecay_; //!< True if there is a rough decay match (no rear veto and no plastic dE)
@@ -154,12 +154,13 @@ bool BetaScintProcessor::Process(RawEvent &event) {
         /* Beta events gated by "Beta" place are plotted here
          * Energy-time spectra are gated
          * */
-        for (deque<EventData>::iterator itb = betas->info_.begin(); itb != betas->info_.end(); ++itb) {
-            if (itb->energy == energy && itb->time == time &&
-                itb->location == location) {
+        for (unsigned i = 0; i < betas->info_.size(); ++i) {
+            const EventData &beta = betas->info_[i];
+            if (beta.energy == energy && beta.time == time &&
+                beta.location == location) {
                 ++multiplicityThres;
                 plot(D_ENERGY_BETA_THRES_GATED, energyBin);
-                //Break the deque loop since we found the matching event
+                //Break the loop since we found the matching event
                 break;
             }
         }
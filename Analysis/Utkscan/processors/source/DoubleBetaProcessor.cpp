@@ -50,11 +50,10 @@ bool DoubleBetaProcessor::PreProcess(RawEvent &event) {
     static const vector<ChanEvent *> &events =
             event.GetSummary("beta:double")->GetList();
 
-    BarBuilder builder(events);
-    builder.BuildBars();
+    builder_.BuildBars(events);
 
-    lrtbars_ = builder.GetLrtBarMap();
-    bars_ = builder.GetBarMap();
+    lrtbars_ = builder_.GetLrtBarMap();
+    bars_ = builder_.GetBarMap();
 
     double resolution = 2;
     double offset = 1500;
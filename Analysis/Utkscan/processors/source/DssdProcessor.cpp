@@ -33,6 +33,7 @@ namespace dammIds {
 DssdProcessor::DssdProcessor() : EventProcessor(OFFSET, RANGE, "DssdProcessor"), frontSummary(NULL), backSummary(NULL) {
     associatedTypes.insert("dssd_front");
     associatedTypes.insert("dssd_back");
+    timeOrdered_ = true; // Implants and decays are correlated across events
 }
 
 void DssdProcessor::DeclarePlots(void) {
@@ -24,14 +24,14 @@ using namespace std;
 
 EventProcessor::EventProcessor() :
         name("generic"), initDone(false), didProcess(false),
-        histo(0, 0, "generic"),
+        timeOrdered_(false), histo(0, 0, "generic"),
         userTime(0.), systemTime(0.) {
     clocksPerSecond = sysconf(_SC_CLK_TCK);
 }
 
 EventProcessor::EventProcessor(int offset, int range, std::string proc_name) :
         name(proc_name), initDone(false), didProcess(false),
-        histo(offset, range, proc_name), userTime(0.), systemTime(0.) {
+        timeOrdered_(false), histo(offset, range, proc_name), userTime(0.), systemTime(0.) {
     clocksPerSecond = sysconf(_SC_CLK_TCK);
 }
 
@@ -62,6 +62,7 @@ namespace dammIds {
 ImplantSsdProcessor::ImplantSsdProcessor() :
         EventProcessor(OFFSET, RANGE, "ImplantSsdProcessor") {
     associatedTypes.insert("ssd");
+    timeOrdered_ = true; // Implants and decays are correlated across events
 }
 
 void ImplantSsdProcessor::DeclarePlots(void) {
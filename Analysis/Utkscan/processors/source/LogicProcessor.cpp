@@ -65,6 +65,7 @@ LogicProcessor::LogicProcessor(void) : EventProcessor(dammIds::logic::OFFSET, da
     associatedTypes.insert("logic");
     associatedTypes.insert("timeclass"); // old detector type
     associatedTypes.insert("mtc");
+    timeOrdered_ = true; // The cycle and beam status spans many events
 }
 
 LogicProcessor::LogicProcessor(bool doubleStop/*=false*/, bool doubleStart/*=false*/) :
@@ -73,6 +74,7 @@ LogicProcessor::LogicProcessor(bool doubleStop/*=false*/, bool doubleStart/*=fal
     associatedTypes.insert("logic");
     associatedTypes.insert("timeclass"); // old detector type
     associatedTypes.insert("mtc");
+    timeOrdered_ = true;
 
     doubleStop_ = doubleStop;
     doubleStart_ = doubleStart;
@@ -21,6 +21,7 @@
 #include "Globals.hpp"
 #include "HelperFunctions.hpp"
 #include "Messenger.hpp"
+#include "TraceKernels.hpp"
 
 using namespace std;
 using namespace dammIds::pspmt;
@@ -379,7 +380,7 @@ bool PspmtProcessor::PreProcess(RawEvent &event)
 
         	double qdcRit = (*it)->GetTrace().GetQdc();
 		if(qdcRit==0){ cout<<"Come here: 381"<<std::endl;continue;}
-        	double psd = TraceFunctions::CalculateTailRatio((*it)->GetTrace().GetTraceSansBaseline(),(*it)->GetChanID().GetWaveformBoundsInSamples(),qdcRit);	
+        	double psd = TraceKernels::CalculateTailRatio((*it)->GetTrace(),(*it)->GetChanID().GetWaveformBoundsInSamples(),(*it)->GetTrace().GetBaselineInfo().first,qdcRit);	
         	// std::cout<<"Here: "<<psd<<std::endl;
         	plot(DD_RIT_PSD, qdcRit/10., psd*SA/2 + SA/2);
          }
@@ -748,7 +749,7 @@ bool PspmtProcessor::PreProcess(RawEvent &event)
 	 if ((*it)->GetTrace().size()>0 && (*it)->GetChanID().HasTag("stilbene") && (*it)->GetTrace().HasValidWaveformAnalysis()){
 		double qdcRit = (*it)->GetTrace().GetQdc();
 		if(qdcRit==0){ cout<<"Come here: 750"<<std::endl;continue;}
-		double psd = TraceFunctions::CalculateTailRatio((*it)->GetTrace().GetTraceSansBaseline(),(*it)->GetChanID().GetWaveformBoundsInSamples(),qdcRit);	
+		double psd = TraceKernels::CalculateTailRatio((*it)->GetTrace(),(*it)->GetChanID().GetWaveformBoundsInSamples(),(*it)->GetTrace().GetBaselineInfo().first,qdcRit);	
 		// std::cout<<"Here: "<<psd<<std::endl;
 		plot(DD_RIT_PSD, qdcRit/10., psd*SA/2 + SA/2);
 	 }
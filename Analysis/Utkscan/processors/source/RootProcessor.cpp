@@ -21,6 +21,7 @@ using std::endl;
 RootProcessor::RootProcessor(const char *fileName, const char *treeName)
         : EventProcessor() {
     name = "RootProcessor";
+    timeOrdered_ = true;
     file = new TFile(fileName, "recreate"); //! overwrite tree for now
     tree = new TTree(treeName, treeName);
 }
@@ -116,9 +116,8 @@ bool VandleProcessor::PreProcess(RawEvent &event) {
         return false;
     }
 
-    BarBuilder billy(events);
-    billy.BuildBars();
-    bars_ = billy.GetBarMap();
+    barBuilder_.BuildBars(events);
+    bars_ = barBuilder_.GetBarMap();
 
     if (bars_.empty()) {
         plot(D_DEBUGGING, 25);
@@ -145,19 +144,18 @@ bool VandleProcessor::Process(RawEvent &event) {
     static const vector<ChanEvent *> &LIonVeto =  event.GetSummary("pspmt:RIT")->GetList();
     static const vector<ChanEvent *> &IondE=  event.GetSummary("pspmt:FIT")->GetList();
 
-    vector<ChanEvent *> startEvents;
-    startEvents.insert(startEvents.end(), betaStarts.begin(), betaStarts.end());
-    startEvents.insert(startEvents.end(), liquidStarts.begin(), liquidStarts.end());
-    startEvents.insert(startEvents.end(),pspmtStarts.begin(),pspmtStarts.end());
-    startEvents.insert(startEvents.end(),singleBetaStarts.begin(),singleBetaStarts.end());
+    startEvents_.clear();
+    startEvents_.insert(startEvents_.end(), betaStarts.begin(), betaStarts.end());
+    startEvents_.insert(startEvents_.end(), liquidStarts.begin(), liquidStarts.end());
+    startEvents_.insert(startEvents_.end(),pspmtStarts.begin(),pspmtStarts.end());
+    startEvents_.insert(startEvents_.end(),singleBetaStarts.begin(),singleBetaStarts.end());
 
-    TimingMapBuilder bldStarts(startEvents);
-    starts_ = bldStarts.GetMap();
+    startBuilder_.BuildMap(startEvents_);
+    starts_ = startBuilder_.GetMap();
 
     static const vector<ChanEvent *> &doubleBetaStarts = event.GetSummary("beta:double:start")->GetList();
-    BarBuilder startBars(doubleBetaStarts);
-    startBars.BuildBars();
-    barStarts_ = startBars.GetBarMap();
+    startBarBuilder_.BuildBars(doubleBetaStarts);
+    barStarts_ = startBarBuilder_.GetBarMap();
 
     if (DetectorDriver::get()->GetSysRootOutput()){
         vandles.vMulti = (int)bars_.size();
@@ -229,7 +227,7 @@ void VandleProcessor::AnalyzeStarts(const BarDetector &bar, unsigned int &barLoc
                 continue;
 
             unsigned int startLoc = (*itStart).first.first;
-            HighResTimingData start = (*itStart).second;
+            const HighResTimingData &start = (*itStart).second;
             
             double startTime;
             //! Set the start time in ns. needed because WalkCorTime without fitting is in GetTime() Ticks
@@ -31,6 +31,60 @@
 
 class Client;
 
+/** A private, read-only view of an entire .ldf or .pld file in memory. The
+  * file is mapped with mmap so that spills may be handed to the scan without
+  * first being read into a separate array. It mirrors the parts of
+  * std::ifstream that the buffer readers use. Because the mapping is private,
+  * the two words following a spill may be overwritten with the end of spill
+  * words. They are restored by the next call to Read, seekg or close.
+  */
+class MappedFile {
+private:
+    unsigned int *words; /// Pointer to the first word of the mapping.
+    size_t length; /// The length of the file (in bytes).
+    size_t pos; /// The current position in the file (in bytes).
+    bool fail; /// Set to true when a request runs past the end of the file.
+
+    unsigned int *patched; /// Pointer to the words replaced by the end of spill words.
+    unsigned int saved[2]; /// The original values of the replaced words.
+
+public:
+    MappedFile();
+
+    ~MappedFile();
+
+    /// Map a file into memory. Return false if the file could not be mapped.
+    bool open(const char *fname_);
+
+    /// Unmap the file.
+    void close();
+
+    bool is_open() const { return words != NULL; }
+
+    bool good() const { return words != NULL && !fail; }
+
+    bool eof() const { return words != NULL && pos >= length; }
+
+    /// Return the current position in the file (in bytes).
+    std::streampos tellg() const { return std::streampos(pos); }
+
+    /// Move to a position (in bytes) with respect to the start of the file.
+    void seekg(const std::streampos &pos_);
+
+    /** Return a pointer to the next nWords_ words of the file and move past
+      * them, or NULL if the file does not hold that many words. */
+    unsigned int *get(const size_t &nWords_);
+
+    /** Replace the two words at end_ with the end of spill words so that a
+      * spill ending at end_ may be unpacked in place. Return false if end_
+      * is not followed by two words of the file. */
+    bool terminate(unsigned int *end_, const unsigned int &word1_,
+                   const unsigned int &word2_);
+
+    /// Put back the words replaced by the last call to terminate.
+    void restore();
+};
+
 class BufferType {
 protected:
     unsigned int bufftype;
@@ -64,6 +118,9 @@ public:
 
     /// Return true if the first word of the current buffer is equal to this buffer type
     bool ReadHeader(std::ifstream *file_);
+
+    /// Return true if the first word of the current buffer is equal to this buffer type
+    bool ReadHeader(MappedFile *file_);
 };
 
 /// The pld header contains information about the run including the date/time, the title, and the run number.
@@ -151,6 +208,13 @@ public:
     virtual bool Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
                       unsigned int max_bytes_, bool dry_run_mode = false);
 
+    /** Read a data spill from a mapped file. spill_ is pointed at the spill in
+      * the mapping, followed by the two end of spill words. The spill is only
+      * copied into data_ if there is no room for those words at the end of the file. */
+    bool Read(MappedFile *file_, char *data_, unsigned int *&spill_,
+              unsigned int &nBytes, unsigned int max_bytes_,
+              bool dry_run_mode = false);
+
     /// Set initial values.
     virtual void Reset() {}
 };
@@ -258,12 +322,22 @@ private:
     unsigned int missing_chunks; /// Count of the number of missing spill chunks which were dropped.
 
     unsigned int buff_pos; /// The actual position in the current ldf buffer.
+    unsigned long spill_start; /// The word at which the last spill began, counted from the last call to Reset.
 
     /// DATA buffer (1 word buffer type, 1 word buffer size)
     bool open_(std::ofstream *file_);
 
     bool read_next_buffer(std::ifstream *f_, bool force_ = false);
 
+    /// Point the current and next ldf buffers into a mapped file.
+    bool read_next_buffer(MappedFile *f_, bool force_ = false);
+
+    /// Read a data spill from either an input stream or a mapped file.
+    template<typename File>
+    bool read_spill(File *file_, char *data_, unsigned int *&spill_,
+                    unsigned int &nBytes_, bool &full_spill, bool &bad_spill,
+                    bool dry_run_mode);
+
 public:
     DATA_buffer(); /// 0x41544144 "DATA"
 
@@ -292,6 +366,10 @@ public:
     /// Return the number of missing or dropped spill chunks.
     unsigned int GetNumMissing() { return missing_chunks; }
 
+    /** Return the word at which the first chunk of the last spill began. It is
+      * counted from the position in the file at the last call to Reset. */
+    unsigned long GetSpillStart() { return spill_start; }
+
     /// Write a data spill to file
     virtual bool Write(std::ofstream *file_, char *data_, unsigned int nWords_,
                        int &buffs_written);
@@ -301,6 +379,13 @@ public:
                       unsigned int max_bytes_, bool &full_spill,
                       bool &bad_spill, bool dry_run_mode = false);
 
+    /** Read a data spill from a mapped file. A spill held in a single chunk is
+      * left in place and spill_ is pointed at it in the mapping. Spills which
+      * span several chunks are stitched together in data_. */
+    bool Read(MappedFile *file_, char *data_, unsigned int *&spill_,
+              unsigned int &nBytes_, unsigned int max_bytes_,
+              bool &full_spill, bool &bad_spill, bool dry_run_mode = false);
+
     /// Set initial values.
     virtual void Reset();
 };
@@ -0,0 +1,168 @@
+/** \file poll2_shm_ring.h
+  *
+  * \brief Provides a shared-memory ring of spills for the online scanners
+  *
+  * \date October 17, 2026
+  *
+  * poll2 publishes every spill into a POSIX shared-memory segment with a
+  * SpillRingWriter. Any number of scanners on the same host attach with a
+  * SpillRingReader. Each reader keeps its own cursor, so the readers do not
+  * know about each other and the writer never waits for them. A reader that
+  * falls more than a ring behind is overrun. It then skips ahead to the
+  * newest spill and counts the spills that it missed.
+  *
+  * Every record is contiguous in the ring, so a reader can work on a spill
+  * where it lies with Peek() and ask Release() afterwards whether the writer
+  * overwrote it in the meantime.
+*/
+
+#ifndef POLL2_SHM_RING_H
+#define POLL2_SHM_RING_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#define POLL2_SHM_RING_VERSION "1.0.00"
+#define POLL2_SHM_RING_DATE "October 17th, 2026"
+
+/// The name of the shared-memory segment that poll2 and the scanners use when none is given.
+#define POLL2_SHM_RING_DEFAULT_NAME "/poll2_spills"
+
+namespace SpillRing {
+    /// The first word of the segment, "RING" in ASCII.
+    static const uint32_t magic = 0x52494E47;
+
+    /// The layout of the segment, increased when it changes.
+    static const uint32_t version = 1;
+
+    /// The header at the start of the segment. The positions count bytes
+    /// from the creation of the ring and never wrap, the position in the
+    /// data is the position modulo the capacity.
+    struct Header {
+        uint32_t magic; ///< Always SpillRing::magic
+        uint32_t version; ///< Always SpillRing::version
+        uint64_t capacity; ///< The number of bytes of data after the header
+        std::atomic<uint64_t> reserved; ///< The end of the bytes that the writer may be changing
+        std::atomic<uint64_t> written; ///< The end of the last complete record
+        std::atomic<uint64_t> latest; ///< The start of the last complete record
+        std::atomic<uint64_t> spills; ///< The number of spills published
+        std::atomic<uint32_t> open; ///< 1 while the writer publishes into this segment
+    };
+
+    /// The kinds of records in the data.
+    enum RecordType {
+        SPILL = 1, ///< A spill of pixie words
+        PAD = 2 ///< Unused bytes up to the end of the data, the next record is at the start
+    };
+
+    /// The header in front of every record. Records start on 8 byte boundaries.
+    struct Record {
+        uint32_t type; ///< One of the RecordType values
+        uint32_t nWords; ///< The number of 32 bit words that follow the header
+        uint64_t sequence; ///< The number of spills published before this one
+    };
+}
+
+class SpillRingWriter {
+public:
+    SpillRingWriter();
+
+    ~SpillRingWriter() { Close(); }
+
+    /** Create the shared-memory segment, replacing any segment with the same
+      * name. Returns false if it cannot be created or mapped.
+      * \param[in] name_ The name of the segment, starting with a '/'.
+      * \param[in] capacity_ The number of bytes of spill data that the ring holds. */
+    bool Init(const std::string &name_, const size_t &capacity_);
+
+    /** Copy a spill into the ring. Returns false if the object was not
+      * initialized or the spill is larger than half of the ring, in which
+      * case it is counted as dropped. */
+    bool Publish(const unsigned int *data_, const size_t &nWords_);
+
+    /// Tell the readers that we are done and remove the segment.
+    void Close();
+
+    const std::string &GetName() const { return name; }
+
+    size_t GetCapacity() const { return header ? header->capacity : 0; }
+
+    /// Return the number of spills published.
+    unsigned long GetNumSpills() const { return header ? header->spills.load() : 0; }
+
+    /// Return the number of spills too large for the ring.
+    unsigned long GetNumDropped() const { return num_dropped; }
+
+private:
+    std::string name;
+    size_t length;
+    SpillRing::Header *header;
+    char *data;
+    unsigned long num_dropped;
+};
+
+class SpillRingReader {
+public:
+    /// The result of waiting for a spill.
+    enum Status {
+        SPILL, ///< A spill was read
+        TIMEOUT, ///< No spill arrived before the timeout
+        DETACHED ///< There is no ring from poll2, we will try to attach again on the next read
+    };
+
+    SpillRingReader();
+
+    ~SpillRingReader() { Close(); }
+
+    /** Set the name of the segment and try to attach to it. Not finding
+      * the segment yet is not an error, we try again on every read. */
+    bool Init(const std::string &name_);
+
+    /** Wait at most timeout_ milliseconds for the next spill and copy it
+      * into spill_, which grows to fit. */
+    Status Read(std::vector<unsigned int> &spill_, const int &timeout_);
+
+    /** Wait at most timeout_ milliseconds for the next spill and point data_
+      * at it in the ring without copying it. The spill stays the current one
+      * until Release() is called. */
+    Status Peek(const unsigned int *&data_, size_t &nWords_, const int &timeout_);
+
+    /** Move past the current spill. Returns false if the writer overwrote it
+      * while it was being used, in which case it is counted as missed. */
+    bool Release();
+
+    /// Detach from the segment.
+    void Close();
+
+    bool IsAttached() const { return header != NULL; }
+
+    const std::string &GetName() const { return name; }
+
+    /// Return the number of spills that were read.
+    unsigned long GetNumSpills() const { return num_spills; }
+
+    /// Return the number of spills that were overwritten before we read them.
+    unsigned long GetNumMissed() const { return num_missed; }
+
+private:
+    /// Map the segment. Returns false if poll2 did not create it yet.
+    bool Attach();
+
+    /// Skip to the newest spill after the writer lapped us.
+    void Resync();
+
+    std::string name;
+    size_t length;
+    const SpillRing::Header *header;
+    const char *data;
+    uint64_t cursor; ///< The position of the next record to read
+    uint64_t current; ///< The position of the record handed out by Peek, or the cursor if there is none
+    uint64_t next_sequence; ///< The sequence of the spill we expect next
+    unsigned long num_spills;
+    unsigned long num_missed;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/** \file poll2_spill_pool.h
+  *
+  * \brief Hands spills from the poll2 readout to the threads that write and broadcast them
+  *
+  * \date October 17, 2026
+  *
+  * The pool owns a fixed number of spill buffers that are allocated once.
+  * The readout takes a free buffer with Acquire(), fills it from the FIFOs
+  * and passes it to any of the consumers with Submit(). Every consumer
+  * takes its spills in order with Next() and gives them back with Release().
+  * A buffer is free again once every consumer it was submitted to has
+  * released it, so the readout only waits when all of the buffers are still
+  * in use.
+  *
+  * A consumer may be given a depth limit. Spills for a consumer whose queue
+  * is at its limit are dropped for that consumer and counted, so a stalled
+  * consumer that can afford to lose spills does not use up the pool.
+*/
+
+#ifndef POLL2_SPILL_POOL_H
+#define POLL2_SPILL_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#define POLL2_SPILL_POOL_VERSION "1.0.00"
+#define POLL2_SPILL_POOL_DATE "October 17th, 2026"
+
+class SpillPool {
+public:
+    /// A preallocated spill buffer.
+    struct Buffer {
+        std::vector<unsigned int> data; ///< The words, the size never changes
+        size_t nWords; ///< The number of words in use
+        unsigned int pending; ///< The consumers that have not released the buffer, one bit each
+        std::chrono::steady_clock::time_point submitted; ///< When the buffer was submitted
+    };
+
+    /** Allocate the buffers.
+      * \param[in] nBuffers_ The number of buffers in the pool.
+      * \param[in] nWords_ The number of words that every buffer holds.
+      * \param[in] nConsumers_ The number of consumers, at most 32. */
+    SpillPool(const size_t &nBuffers_, const size_t &nWords_, const unsigned int &nConsumers_);
+
+    /** Wait for a free buffer. Returns NULL once the pool is stopped. The
+      * number of words in use is set to zero. */
+    Buffer *Acquire();
+
+    /** Queue the buffer for the consumers whose bits are set in consumers_.
+      * The buffer is free again at once if it goes to no consumer. */
+    void Submit(Buffer *buffer_, const unsigned int &consumers_);
+
+    /** Wait at most timeout_ milliseconds for the next buffer of the
+      * consumer. Returns NULL if none arrived. After Stop() the queued
+      * buffers are still handed out before NULL is returned. */
+    Buffer *Next(const unsigned int &consumer_, const int &timeout_);
+
+    /// Tell the pool that the consumer is done with the buffer.
+    void Release(const unsigned int &consumer_, Buffer *buffer_);
+
+    /// Wait until every submitted buffer was released by its consumers.
+    void Drain();
+
+    /// Wake every waiting thread, Acquire() returns NULL from now on.
+    void Stop();
+
+    bool IsStopped() const;
+
+    /// Set the number of queued buffers above which spills are dropped for the consumer, 0 for no limit.
+    void SetDepthLimit(const unsigned int &consumer_, const size_t &depth_);
+
+    size_t GetNumBuffers() const { return buffers.size(); }
+
+    size_t GetNumFree() const;
+
+    /// Return the number of times Acquire() had to wait for a free buffer.
+    unsigned long GetNumWaits() const;
+
+    /// Return the number of buffers queued or in use by the consumer.
+    size_t GetDepth(const unsigned int &consumer_) const;
+
+    /// Return the largest depth that the consumer reached.
+    size_t GetPeakDepth(const unsigned int &consumer_) const;
+
+    /// Return the time from Submit() to Release() of the last buffer of the consumer (in ms).
+    double GetLatency(const unsigned int &consumer_) const;
+
+    /// Return the longest time from Submit() to Release() of the consumer (in ms).
+    double GetPeakLatency(const unsigned int &consumer_) const;
+
+    /// Return the number of spills that the consumer released.
+    unsigned long GetNumSpills(const unsigned int &consumer_) const;
+
+    /// Return the number of spills dropped for the consumer because of its depth limit.
+    unsigned long GetNumDropped(const unsigned int &consumer_) const;
+
+private:
+    /// The queue and the statistics of one consumer.
+    struct Consumer {
+        std::deque<Buffer *> queue; ///< The buffers that were not handed out yet
+        size_t depth; ///< The buffers queued or handed out
+        size_t depth_limit; ///< The depth at which spills are dropped, 0 for no limit
+        size_t peak_depth;
+        double latency;
+        double peak_latency;
+        unsigned long spills;
+        unsigned long dropped;
+    };
+
+    std::vector<Buffer> buffers;
+    std::vector<Buffer *> free_buffers;
+    std::vector<Consumer> consumers;
+    size_t in_use; ///< The number of buffers that were submitted and are not free yet
+    unsigned long num_waits;
+    bool stopped;
+
+    mutable std::mutex lock;
+    std::condition_variable buffer_freed;
+    std::condition_variable buffer_queued;
+};
+
+#endif
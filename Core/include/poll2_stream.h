@@ -0,0 +1,201 @@
+/** \file poll2_stream.h
+  *
+  * \brief Provides a lossless spill stream between poll2 and the scanners
+  *
+  * \date October 17, 2026
+  *
+  * The UDP shm mode chops every spill into datagrams, so a scanner that falls
+  * behind loses chunks and throws away the whole spill. This stream sends
+  * each spill as a single frame over a Unix domain or a TCP stream socket.
+  * poll2 listens with a SpillSender and any number of scanners connect with a
+  * SpillReceiver. Every consumer has its own queue, when a consumer falls too
+  * far behind the newest spills are dropped for that consumer only and
+  * counted, or poll2 waits for it if the blocking policy is selected.
+  *
+  * An address that contains a '/' is the path of a Unix domain socket. Any
+  * other address is a TCP port, optionally preceded by a host and a colon.
+*/
+
+#ifndef POLL2_STREAM_H
+#define POLL2_STREAM_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#define POLL2_STREAM_VERSION "1.0.00"
+#define POLL2_STREAM_DATE "October 17th, 2026"
+
+/// The address that poll2 and the scanners use when none is given.
+#define POLL2_STREAM_DEFAULT_ADDRESS "/tmp/poll2.spill"
+
+namespace SpillStream {
+    /// The first word of every frame, "SPIL" in ASCII.
+    static const uint32_t magic = 0x5350494C;
+
+    /// The kinds of frames that go through the stream.
+    enum FrameType {
+        SPILL = 0, ///< A spill of pixie words
+        OPEN_FILE = 1, ///< poll2 opened an output file
+        CLOSE_FILE = 2, ///< poll2 closed the output file
+        KILL_SOCKET = 3 ///< poll2 is closing
+    };
+
+    /// The header in front of every frame, in the byte order of the host.
+    struct FrameHeader {
+        uint32_t magic; ///< Always SpillStream::magic
+        uint32_t type; ///< One of the FrameType values
+        uint32_t sequence; ///< The number of spills that were sent before this frame
+        uint32_t nWords; ///< The number of 32 bit words that follow the header
+    };
+}
+
+class SpillSender {
+public:
+    /// What to do with a spill for a consumer whose queue is full.
+    enum Policy {
+        DROP_NEWEST, ///< Drop the spill for that consumer and count it
+        BLOCK ///< Wait until the consumer has read enough of its queue
+    };
+
+    SpillSender();
+
+    ~SpillSender() { Close(); }
+
+    /** Listen for consumers on the address. Returns false if the socket
+      * fails to open, bind or listen. */
+    bool Init(const std::string &address_);
+
+    /** Queue a spill for every consumer and send as much as the sockets
+      * take without waiting, unless the policy is BLOCK. Returns false if
+      * the object was not initialized. */
+    bool SendSpill(const unsigned int *data_, const size_t &nWords_);
+
+    /** Queue a control frame for every consumer. Control frames are never
+      * dropped. */
+    bool SendControl(const SpillStream::FrameType &type_);
+
+    /// Accept new consumers and send the queued frames without waiting.
+    void Flush();
+
+    /// Close the socket and disconnect every consumer.
+    void Close();
+
+    void SetPolicy(const Policy &policy_) { policy = policy_; }
+
+    /// Set the number of bytes a consumer may have queued before spills are dropped.
+    void SetMaxQueued(const size_t &bytes_) { max_queued = bytes_; }
+
+    Policy GetPolicy() const { return policy; }
+
+    const std::string &GetAddress() const { return address; }
+
+    size_t GetNumConsumers() const { return consumers.size(); }
+
+    /// Return the number of spills handed to the sender.
+    unsigned long GetNumSpills() const { return num_spills; }
+
+    /// Return the number of spills that were dropped, summed over the consumers.
+    unsigned long GetNumDropped() const { return num_dropped; }
+
+    /// Return the number of bytes waiting in the queues of the consumers.
+    size_t GetNumQueued() const;
+
+private:
+    typedef std::shared_ptr<std::vector<char> > Frame;
+
+    /// A connected scanner and the frames that it has not received yet.
+    struct Consumer {
+        int sock; ///< The connected socket
+        std::deque<Frame> queue; ///< The frames waiting to be sent
+        size_t offset; ///< The bytes of the first frame that were already sent
+        size_t queued; ///< The bytes waiting to be sent
+        unsigned long dropped; ///< The spills dropped for this consumer
+    };
+
+    /// Accept all of the consumers waiting to connect.
+    void Accept();
+
+    /// Queue the frame for every consumer, dropping spills for those that are full.
+    void Queue(const Frame &frame_, const bool &isSpill_);
+
+    /** Send as much of the queue as the socket takes. Returns false if the
+      * consumer disconnected. */
+    bool Send(Consumer &consumer_);
+
+    /// Send the queues, waiting if the policy is BLOCK, and drop the consumers that disconnected.
+    void Deliver();
+
+    /// Build a frame holding the header and the words.
+    Frame MakeFrame(const SpillStream::FrameType &type_, const unsigned int *data_, const size_t &nWords_);
+
+    int sock;
+    bool init;
+    std::string address;
+    Policy policy;
+    size_t max_queued;
+    uint32_t sequence;
+    unsigned long num_spills;
+    unsigned long num_dropped;
+    std::vector<Consumer> consumers;
+};
+
+class SpillReceiver {
+public:
+    /// The result of reading a frame.
+    enum Status {
+        SPILL, ///< A spill was read
+        OPEN_FILE, ///< poll2 opened an output file
+        CLOSE_FILE, ///< poll2 closed the output file
+        KILL_SOCKET, ///< poll2 is closing
+        TIMEOUT, ///< Nothing arrived before the timeout
+        DISCONNECTED ///< There is no connection to poll2, we will try again on the next read
+    };
+
+    SpillReceiver();
+
+    ~SpillReceiver() { Close(); }
+
+    /** Set the address of poll2 and try to connect. Returns false if the
+      * address cannot be resolved. Not finding poll2 yet is not an error. */
+    bool Init(const std::string &address_);
+
+    /** Read the next frame. The words of a spill are put in spill_, which
+      * grows to fit. Returns TIMEOUT if no frame started within timeout_
+      * milliseconds. */
+    Status Read(std::vector<unsigned int> &spill_, const int &timeout_);
+
+    /// Close the connection.
+    void Close();
+
+    bool IsConnected() const { return sock >= 0; }
+
+    const std::string &GetAddress() const { return address; }
+
+    /// Return the number of spills that were read.
+    unsigned long GetNumSpills() const { return num_spills; }
+
+    /// Return the number of spills that poll2 sent but that we did not receive.
+    unsigned long GetNumMissed() const { return num_missed; }
+
+private:
+    /// Connect to poll2. Returns false if it is not listening.
+    bool Connect();
+
+    /** Read exactly length_ bytes, waiting at most timeout_ milliseconds for
+      * each part. Returns false and disconnects if they did not arrive. */
+    bool ReadBytes(char *buffer_, const size_t &length_, const int &timeout_);
+
+    int sock;
+    bool init;
+    std::string address;
+    bool have_sequence;
+    uint32_t next_sequence;
+    unsigned long num_spills;
+    unsigned long num_missed;
+};
+
+#endif
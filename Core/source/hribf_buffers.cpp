@@ -25,6 +25,10 @@
 #include <iomanip>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "hribf_buffers.h"
 #include "poll2_socket.h"
 
@@ -66,6 +70,110 @@ bool is_hribf_buffer(const unsigned int &input_) {
             input_ == ENDFILE);
 }
 
+/// Return the mapped file that a spill may be left in, if there is one.
+static MappedFile *mapping(std::ifstream *) { return NULL; }
+
+static MappedFile *mapping(MappedFile *file_) { return file_; }
+
+/// Default constructor.
+MappedFile::MappedFile() : words(NULL), length(0), pos(0), fail(false),
+                           patched(NULL) {
+    saved[0] = 0;
+    saved[1] = 0;
+}
+
+/// Destructor.
+MappedFile::~MappedFile() {
+    close();
+}
+
+/** Map the file into memory and tell the kernel that it will be read from
+  * front to back, so that pages are read ahead and dropped behind the scan.
+  */
+bool MappedFile::open(const char *fname_) {
+    close();
+
+    int fd = ::open(fname_, O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping is private, so writes are never carried back to the file.
+    void *map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) { return false; }
+
+    madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+    words = (unsigned int *) map;
+    length = info.st_size;
+    pos = 0;
+    fail = false;
+
+    return true;
+}
+
+/// Unmap the file.
+void MappedFile::close() {
+    if (!words) { return; }
+    restore();
+    munmap(words, length);
+    words = NULL;
+    length = 0;
+    pos = 0;
+    fail = false;
+}
+
+/// Move to a position (in bytes) with respect to the start of the file.
+void MappedFile::seekg(const std::streampos &pos_) {
+    restore();
+    if (pos_ < 0 || (size_t) pos_ > length) {
+        fail = true;
+        return;
+    }
+    pos = pos_;
+    fail = false;
+}
+
+/// Return a pointer to the next nWords_ words of the file and move past them.
+unsigned int *MappedFile::get(const size_t &nWords_) {
+    if (!good() || pos % 4 != 0 || pos + 4 * nWords_ > length) {
+        fail = true;
+        return NULL;
+    }
+    unsigned int *retval = &words[pos / 4];
+    pos += 4 * nWords_;
+    return retval;
+}
+
+/// Replace the two words at end_ with the end of spill words.
+bool MappedFile::terminate(unsigned int *end_, const unsigned int &word1_,
+                           const unsigned int &word2_) {
+    restore();
+    if (!words || end_ < words || end_ + 2 > words + length / 4) {
+        return false;
+    }
+    patched = end_;
+    saved[0] = end_[0];
+    saved[1] = end_[1];
+    end_[0] = word1_;
+    end_[1] = word2_;
+    return true;
+}
+
+/// Put back the words replaced by the last call to terminate.
+void MappedFile::restore() {
+    if (!patched) { return; }
+    patched[0] = saved[0];
+    patched[1] = saved[1];
+    patched = NULL;
+}
+
 /// Generic BufferType constructor.
 BufferType::BufferType(unsigned int bufftype_, unsigned int buffsize_,
                        unsigned int buffend_/*=0xFFFFFFFF*/) {
@@ -97,6 +205,15 @@ bool BufferType::ReadHeader(std::ifstream *file_) {
     return true;
 }
 
+/// Return true if the first word of the current buffer is equal to this buffer type
+bool BufferType::ReadHeader(MappedFile *file_) {
+    unsigned int *check_bufftype = file_->get(1);
+    if (!check_bufftype || *check_bufftype != bufftype) { // Not a valid buffer
+        return false;
+    }
+    return true;
+}
+
 /// Default constructor.
 PLD_header::PLD_header() : BufferType(HEAD, 0) { // 0x44414548 "HEAD"
     this->Reset();
@@ -350,6 +467,80 @@ bool PLD_data::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
     return true;
 }
 
+/// Read a pld style data buffer from a mapped file.
+bool PLD_data::Read(MappedFile *file_, char *data_, unsigned int *&spill_,
+                    unsigned int &nBytes, unsigned int max_bytes_,
+                    bool dry_run_mode/*=false*/) {
+    if (!file_ || !file_->is_open() || !file_->good()) { return false; }
+
+    // Put back the words following the previous spill before moving on.
+    file_->restore();
+
+    unsigned int *check_bufftype = file_->get(1);
+    if (!check_bufftype) { return false; }
+    if (*check_bufftype != bufftype) { // Not a valid DATA buffer
+        if (debug_mode) { std::cout << "debug: not a valid DATA buffer\n"; }
+
+        unsigned int countw = 0;
+        while (*check_bufftype != bufftype) {
+            check_bufftype = file_->get(1);
+            if (!check_bufftype) {
+                if (debug_mode) {
+                    std::cout
+                            << "debug: encountered physical end-of-file before start of spill!\n";
+                }
+                return false;
+            }
+            countw++;
+        }
+
+        if (debug_mode) {
+            std::cout << "debug: read an extra " << countw
+                      << " words to get to first DATA buffer!\n";
+        }
+    }
+
+    unsigned int *spill_size = file_->get(1);
+    if (!spill_size) { return false; }
+    nBytes = *spill_size * 4;
+
+    if (debug_mode) {
+        std::cout << "debug: reading spill of " << nBytes << " bytes\n";
+    }
+
+    if (nBytes > max_bytes_) {
+        if (debug_mode) {
+            std::cout
+                    << "debug: spill size is greater than size of data array!\n";
+        }
+        return false;
+    }
+
+    unsigned int *spill = file_->get(nBytes / 4);
+    unsigned int *end_buff_check = file_->get(1);
+    if (!spill || !end_buff_check || *end_buff_check != buffend) { // Buffer was not terminated properly
+        if (debug_mode) {
+            std::cout << "debug: buffer not terminated properly\n";
+        }
+        return false;
+    }
+
+    if (dry_run_mode) { return true; }
+
+    // The end of buffer word and the header of the next buffer are replaced
+    // by the end of spill words, so the spill can be unpacked where it is.
+    if (file_->terminate(end_buff_check, pacman_word1, pacman_word2)) {
+        spill_ = spill;
+    } else {
+        memcpy(data_, spill, nBytes);
+        memcpy(&data_[nBytes], &pacman_word1, 4);
+        memcpy(&data_[nBytes + 4], &pacman_word2, 4);
+        spill_ = (unsigned int *) data_;
+    }
+
+    return true;
+}
+
 /// Default constructor.
 DIR_buffer::DIR_buffer() : BufferType(DIR,
                                       NO_HEADER_SIZE) { // 0x20524944 "DIR "
@@ -635,6 +826,48 @@ bool DATA_buffer::read_next_buffer(std::ifstream *f_, bool force_/*=false*/) {
     return true;
 }
 
+/// Point the current ldf buffer at the next buffer in a mapped file.
+bool DATA_buffer::read_next_buffer(MappedFile *f_, bool force_/*=false*/) {
+    if (!f_ || !f_->good() || f_->eof()) { return false; }
+
+    if (bcount == 0) {
+        next_buffer = f_->get(ACTUAL_BUFF_SIZE);
+    } else if (buff_pos + 3 <= ACTUAL_BUFF_SIZE - 1 && !force_) {
+        // Don't need to scan a new buffer yet. There are still
+        // words remaining in the one currently in memory.
+
+        // Skip end of event delimiters.
+        while (curr_buffer[buff_pos] == ENDBUFF &&
+               buff_pos < ACTUAL_BUFF_SIZE - 1) {
+            buff_pos++;
+        }
+
+        // If we have more good words in this buffer, keep reading it.
+        if (buff_pos + 3 < ACTUAL_BUFF_SIZE - 1) {
+            return true;
+        }
+    }
+
+    // As with the stream, the next buffer is always looked at ahead of time.
+    curr_buffer = next_buffer;
+    if (!curr_buffer) { return false; }
+    next_buffer = f_->get(ACTUAL_BUFF_SIZE);
+
+    // Reset the buffer index.
+    buff_pos = 0;
+
+    // Increment the number of buffers read.
+    bcount++;
+
+    // Read the buffer header and length.
+    buff_head = curr_buffer[buff_pos++];
+    buff_size = curr_buffer[buff_pos++];
+
+    if (!next_buffer) { return false; }
+
+    return true;
+}
+
 /// Default constructor.
 DATA_buffer::DATA_buffer() : BufferType(DATA,
                                         NO_HEADER_SIZE) { // 0x41544144 "DATA"
@@ -788,15 +1021,24 @@ bool DATA_buffer::Write(std::ofstream *file_, char *data_, unsigned int nWords_,
     return true;
 }
 
-/// Read a ldf data spill from a file.
-bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
-                       unsigned int max_bytes_, bool &full_spill,
-                       bool &bad_spill, bool dry_run_mode/*=false*/) {
+/** Read a ldf data spill from either an input stream or a mapped file. When
+  * reading from a mapped file the first spill chunk is not copied right away.
+  * If the spill footer follows it, the spill is left in the mapping and only
+  * the end of spill words are written after it.
+  */
+template<typename File>
+bool DATA_buffer::read_spill(File *file_, char *data_, unsigned int *&spill_,
+                             unsigned int &nBytes, bool &full_spill,
+                             bool &bad_spill, bool dry_run_mode) {
     if (!file_ || !file_->is_open() || !file_->good()) {
         retval = 6;
         return false;
     }
 
+    // Put back the words following the previous spill before moving on.
+    MappedFile *map = mapping(file_);
+    if (map) { map->restore(); }
+
     bad_spill = false;
 
     bool first_chunk = true;
@@ -805,6 +1047,7 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
     unsigned int current_chunk_num = 0;
     unsigned int prev_chunk_num;
     unsigned int prev_num_chunks;
+    unsigned int *first_payload = NULL; // First spill chunk which has not been copied yet.
     nBytes = 0; // Set the number of output bytes to zero
 
     while (true) {
@@ -831,6 +1074,7 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
 
             // Check if this is a spill fragment.
             if (first_chunk) { // Check for starting read in middle of spill.
+                spill_start = (unsigned long) (bcount - 1) * ACTUAL_BUFF_SIZE + buff_pos - 3;
                 if (current_chunk_num != 0) {
                     if (debug_mode) {
                         std::cout
@@ -915,7 +1159,18 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
 
                 // Copy data into the output array.
                 if (!dry_run_mode) {
-                    memcpy(&data_[nBytes], &curr_buffer[buff_pos], 8);
+                    if (first_payload &&
+                        map->terminate(&first_payload[nBytes / 4],
+                                       curr_buffer[buff_pos],
+                                       curr_buffer[buff_pos + 1])) {
+                        spill_ = first_payload;
+                    } else {
+                        if (first_payload) {
+                            memcpy(data_, first_payload, nBytes);
+                        }
+                        memcpy(&data_[nBytes], &curr_buffer[buff_pos], 8);
+                        spill_ = (unsigned int *) data_;
+                    }
                 }
                 if (debug_mode) {
                     std::cout << "debug: spill footer words are "
@@ -949,8 +1204,16 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
 
                 copied_bytes = this_chunk_sizeB - 12;
                 if (!dry_run_mode) {
-                    memcpy(&data_[nBytes], &curr_buffer[buff_pos],
-                           copied_bytes);
+                    if (map && nBytes == 0) {
+                        first_payload = &curr_buffer[buff_pos];
+                    } else {
+                        if (first_payload) {
+                            memcpy(data_, first_payload, nBytes);
+                            first_payload = NULL;
+                        }
+                        memcpy(&data_[nBytes], &curr_buffer[buff_pos],
+                               copied_bytes);
+                    }
                 }
                 nBytes += copied_bytes;
                 buff_pos += copied_bytes / 4;
@@ -996,12 +1259,31 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
     return false;
 }
 
+/// Read a ldf data spill from a file.
+bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
+                       unsigned int max_bytes_, bool &full_spill,
+                       bool &bad_spill, bool dry_run_mode/*=false*/) {
+    unsigned int *spill = NULL;
+    return read_spill(file_, data_, spill, nBytes, full_spill, bad_spill,
+                      dry_run_mode);
+}
+
+/// Read a ldf data spill from a mapped file.
+bool DATA_buffer::Read(MappedFile *file_, char *data_, unsigned int *&spill_,
+                       unsigned int &nBytes, unsigned int max_bytes_,
+                       bool &full_spill, bool &bad_spill,
+                       bool dry_run_mode/*=false*/) {
+    return read_spill(file_, data_, spill_, nBytes, full_spill, bad_spill,
+                      dry_run_mode);
+}
+
 /// Set initial values.
 void DATA_buffer::Reset() {
     curr_buffer = buffer1;
     next_buffer = buffer2;
     buff_pos = 0;
     bcount = 0;
+    spill_start = 0;
     retval = 0;
     good_chunks = 0;
     missing_chunks = 0;
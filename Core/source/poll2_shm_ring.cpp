@@ -0,0 +1,271 @@
+/** \file poll2_shm_ring.cpp
+  *
+  * \brief Provides a shared-memory ring of spills for the online scanners
+  *
+  * \date October 17, 2026
+  *
+  * The writer never waits for the readers. It marks the bytes that it is
+  * about to change in the header before changing them, so a reader that
+  * copied a record can tell afterwards whether the copy is good, in the
+  * same way as a sequence lock.
+*/
+
+#include "poll2_shm_ring.h"
+
+#include <new>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared-memory ring needs lock free 64 bit atomics");
+
+namespace {
+    /// The data starts on a cache line after the header.
+    const size_t headerLength = (sizeof(SpillRing::Header) + 63) / 64 * 64;
+
+    /// The time a reader sleeps while it waits for a spill (in us).
+    const unsigned int pollInterval = 1000;
+
+    /// @return The number of bytes a record of nWords_ takes in the ring.
+    uint64_t RecordLength(const uint64_t &nWords_) {
+        return (sizeof(SpillRing::Record) + nWords_ * sizeof(unsigned int) + 7) / 8 * 8;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// class SpillRingWriter
+/////////////////////////////////////////////////////////////////////
+
+SpillRingWriter::SpillRingWriter() : length(0), header(NULL), data(NULL), num_dropped(0) {
+}
+
+bool SpillRingWriter::Init(const std::string &name_, const size_t &capacity_) {
+    if (header) { return false; }
+
+    // Tell the readers of a ring left behind by an earlier poll2 that it is gone.
+    int fd = shm_open(name_.c_str(), O_RDWR, 0);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(SpillRing::Header)) {
+            void *old = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (old != MAP_FAILED) {
+                ((SpillRing::Header *) old)->open.store(0);
+                munmap(old, info.st_size);
+            }
+        }
+        close(fd);
+        shm_unlink(name_.c_str());
+    }
+
+    const size_t capacity = (capacity_ + 7) / 8 * 8;
+    fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) { return false; }
+    if (ftruncate(fd, headerLength + capacity) < 0) {
+        close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    void *map = mmap(NULL, headerLength + capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    name = name_;
+    length = headerLength + capacity;
+    data = (char *) map + headerLength;
+    header = new(map) SpillRing::Header;
+    header->capacity = capacity;
+    header->reserved.store(0);
+    header->written.store(0);
+    header->latest.store(0);
+    header->spills.store(0);
+    header->version = SpillRing::version;
+    header->magic = SpillRing::magic;
+    header->open.store(1, std::memory_order_release);
+    return true;
+}
+
+bool SpillRingWriter::Publish(const unsigned int *data_, const size_t &nWords_) {
+    if (!header) { return false; }
+
+    const uint64_t capacity = header->capacity;
+    const uint64_t recordLength = RecordLength(nWords_);
+    if (recordLength > capacity / 2) {
+        num_dropped++;
+        return false;
+    }
+
+    // Records never wrap, a record that does not fit before the end of the data goes to its start.
+    const uint64_t position = header->written.load(std::memory_order_relaxed);
+    const uint64_t offset = position % capacity;
+    const uint64_t start = capacity - offset < recordLength ? position + capacity - offset : position;
+
+    header->reserved.store(start + recordLength, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (start != position && capacity - offset >= sizeof(SpillRing::Record)) {
+        SpillRing::Record pad = {SpillRing::PAD, 0, 0};
+        memcpy(data + offset, &pad, sizeof(pad));
+    }
+
+    SpillRing::Record record = {SpillRing::SPILL, (uint32_t) nWords_, header->spills.load(std::memory_order_relaxed)};
+    memcpy(data + start % capacity, &record, sizeof(record));
+    memcpy(data + start % capacity + sizeof(record), data_, nWords_ * sizeof(unsigned int));
+
+    header->latest.store(start, std::memory_order_release);
+    header->spills.store(record.sequence + 1, std::memory_order_release);
+    header->written.store(start + recordLength, std::memory_order_release);
+    return true;
+}
+
+void SpillRingWriter::Close() {
+    if (!header) { return; }
+
+    header->open.store(0, std::memory_order_release);
+    munmap(header, length);
+    shm_unlink(name.c_str());
+    header = NULL;
+    data = NULL;
+}
+
+/////////////////////////////////////////////////////////////////////
+// class SpillRingReader
+/////////////////////////////////////////////////////////////////////
+
+SpillRingReader::SpillRingReader() : length(0), header(NULL), data(NULL), cursor(0), current(0), next_sequence(0),
+                                     num_spills(0), num_missed(0) {
+}
+
+bool SpillRingReader::Init(const std::string &name_) {
+    if (!name.empty() || name_.empty()) { return false; }
+
+    name = name_;
+    Attach();
+    return true;
+}
+
+SpillRingReader::Status SpillRingReader::Read(std::vector<unsigned int> &spill_, const int &timeout_) {
+    const unsigned int *spill;
+    size_t nWords;
+    while (true) {
+        Status status = Peek(spill, nWords, timeout_);
+        if (status != SPILL) { return status; }
+
+        spill_.resize(nWords);
+        if (nWords > 0) { memcpy(&spill_[0], spill, nWords * sizeof(unsigned int)); }
+        if (Release()) { return SPILL; }
+    }
+}
+
+SpillRingReader::Status SpillRingReader::Peek(const unsigned int *&data_, size_t &nWords_, const int &timeout_) {
+    if (!header && !Attach()) {
+        usleep(timeout_ * 1000);
+        return DETACHED;
+    }
+    if (current != cursor) { Release(); }
+
+    const uint64_t capacity = header->capacity;
+    for (int waited = 0;; waited++) {
+        if (!header->open.load(std::memory_order_acquire)) { // poll2 closed the ring
+            Close();
+            return DETACHED;
+        }
+        if (cursor < header->written.load(std::memory_order_acquire)) { break; }
+        if (waited * (int) pollInterval >= timeout_ * 1000) { return TIMEOUT; }
+        usleep(pollInterval);
+    }
+
+    SpillRing::Record record;
+    while (true) {
+        if (header->reserved.load(std::memory_order_acquire) > cursor + capacity) { Resync(); }
+
+        const uint64_t offset = cursor % capacity;
+        if (capacity - offset < sizeof(record)) { // Too little room for a record, the next one is at the start.
+            cursor += capacity - offset;
+            continue;
+        }
+
+        memcpy(&record, data + offset, sizeof(record));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->reserved.load(std::memory_order_relaxed) > cursor + capacity) { continue; } // Overwritten
+        if (record.type == SpillRing::PAD) {
+            cursor += capacity - offset;
+            continue;
+        }
+        if (record.type != SpillRing::SPILL || RecordLength(record.nWords) > capacity - offset) {
+            Resync(); // This is not a record we know, start over from the newest spill.
+            continue;
+        }
+        break;
+    }
+
+    if (record.sequence > next_sequence) { num_missed += record.sequence - next_sequence; }
+    next_sequence = record.sequence + 1;
+
+    data_ = (const unsigned int *) (data + cursor % capacity + sizeof(record));
+    nWords_ = record.nWords;
+    current = cursor;
+    cursor += RecordLength(record.nWords);
+    return SPILL;
+}
+
+bool SpillRingReader::Release() {
+    if (!header || current == cursor) { return false; }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const bool intact = header->reserved.load(std::memory_order_relaxed) <= current + header->capacity;
+    current = cursor;
+    if (intact) { num_spills++; }
+    else { num_missed++; }
+    return intact;
+}
+
+void SpillRingReader::Close() {
+    if (!header) { return; }
+
+    munmap((void *) header, length);
+    header = NULL;
+    data = NULL;
+}
+
+bool SpillRingReader::Attach() {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) { return false; }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t) info.st_size < headerLength) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { return false; }
+
+    const SpillRing::Header *ring = (const SpillRing::Header *) map;
+    if (ring->magic != SpillRing::magic || ring->version != SpillRing::version ||
+        headerLength + ring->capacity > (size_t) info.st_size || !ring->open.load(std::memory_order_acquire)) {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    header = ring;
+    data = (const char *) map + headerLength;
+    length = info.st_size;
+
+    // We only read the spills published after we attached. The count of the
+    // spills is stored before the end of the records, so it is never behind it.
+    cursor = current = header->written.load(std::memory_order_acquire);
+    next_sequence = header->spills.load(std::memory_order_acquire);
+    return true;
+}
+
+void SpillRingReader::Resync() {
+    cursor = current = header->latest.load(std::memory_order_acquire);
+}
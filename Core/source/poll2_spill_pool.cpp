@@ -0,0 +1,174 @@
+/** \file poll2_spill_pool.cpp
+  *
+  * \brief Hands spills from the poll2 readout to the threads that write and broadcast them
+  *
+  * \date October 17, 2026
+*/
+
+#include "poll2_spill_pool.h"
+
+SpillPool::SpillPool(const size_t &nBuffers_, const size_t &nWords_, const unsigned int &nConsumers_) :
+        buffers(nBuffers_), consumers(nConsumers_ < 32 ? nConsumers_ : 32), in_use(0), num_waits(0),
+        stopped(false) {
+    for (std::vector<Buffer>::iterator iter = buffers.begin(); iter != buffers.end(); ++iter) {
+        iter->data.resize(nWords_);
+        iter->nWords = 0;
+        iter->pending = 0;
+        free_buffers.push_back(&(*iter));
+    }
+    for (std::vector<Consumer>::iterator iter = consumers.begin(); iter != consumers.end(); ++iter) {
+        iter->depth = 0;
+        iter->depth_limit = 0;
+        iter->peak_depth = 0;
+        iter->latency = 0;
+        iter->peak_latency = 0;
+        iter->spills = 0;
+        iter->dropped = 0;
+    }
+}
+
+SpillPool::Buffer *SpillPool::Acquire() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (free_buffers.empty() && !stopped) {
+        num_waits++;
+        buffer_freed.wait(guard, [this] { return !free_buffers.empty() || stopped; });
+    }
+    if (stopped) { return NULL; }
+
+    Buffer *buffer = free_buffers.back();
+    free_buffers.pop_back();
+    buffer->nWords = 0;
+    buffer->pending = 0;
+    return buffer;
+}
+
+void SpillPool::Submit(Buffer *buffer_, const unsigned int &consumers_) {
+    if (!buffer_) { return; }
+
+    std::lock_guard<std::mutex> guard(lock);
+    buffer_->submitted = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < consumers.size(); i++) {
+        if (!(consumers_ & (1u << i))) { continue; }
+        Consumer &consumer = consumers[i];
+        if (consumer.depth_limit > 0 && consumer.depth >= consumer.depth_limit) {
+            consumer.dropped++;
+            continue;
+        }
+        buffer_->pending |= 1u << i;
+        consumer.queue.push_back(buffer_);
+        if (++consumer.depth > consumer.peak_depth) { consumer.peak_depth = consumer.depth; }
+    }
+
+    if (buffer_->pending == 0) {
+        free_buffers.push_back(buffer_);
+        buffer_freed.notify_all();
+        return;
+    }
+    in_use++;
+    buffer_queued.notify_all();
+}
+
+SpillPool::Buffer *SpillPool::Next(const unsigned int &consumer_, const int &timeout_) {
+    if (consumer_ >= consumers.size()) { return NULL; }
+
+    std::unique_lock<std::mutex> guard(lock);
+    Consumer &consumer = consumers[consumer_];
+    buffer_queued.wait_for(guard, std::chrono::milliseconds(timeout_),
+                           [&consumer, this] { return !consumer.queue.empty() || stopped; });
+    if (consumer.queue.empty()) { return NULL; }
+
+    Buffer *buffer = consumer.queue.front();
+    consumer.queue.pop_front();
+    return buffer;
+}
+
+void SpillPool::Release(const unsigned int &consumer_, Buffer *buffer_) {
+    if (!buffer_ || consumer_ >= consumers.size()) { return; }
+
+    std::lock_guard<std::mutex> guard(lock);
+    const unsigned int bit = 1u << consumer_;
+    if (!(buffer_->pending & bit)) { return; }
+
+    Consumer &consumer = consumers[consumer_];
+    consumer.depth--;
+    consumer.spills++;
+    consumer.latency = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - buffer_->submitted).count();
+    if (consumer.latency > consumer.peak_latency) { consumer.peak_latency = consumer.latency; }
+
+    buffer_->pending &= ~bit;
+    if (buffer_->pending == 0) {
+        free_buffers.push_back(buffer_);
+        in_use--;
+        buffer_freed.notify_all();
+    }
+}
+
+void SpillPool::Drain() {
+    std::unique_lock<std::mutex> guard(lock);
+    buffer_freed.wait(guard, [this] { return in_use == 0; });
+}
+
+void SpillPool::Stop() {
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = true;
+    buffer_freed.notify_all();
+    buffer_queued.notify_all();
+}
+
+bool SpillPool::IsStopped() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return stopped;
+}
+
+void SpillPool::SetDepthLimit(const unsigned int &consumer_, const size_t &depth_) {
+    if (consumer_ >= consumers.size()) { return; }
+    std::lock_guard<std::mutex> guard(lock);
+    consumers[consumer_].depth_limit = depth_;
+}
+
+size_t SpillPool::GetNumFree() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return free_buffers.size();
+}
+
+unsigned long SpillPool::GetNumWaits() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return num_waits;
+}
+
+size_t SpillPool::GetDepth(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].depth;
+}
+
+size_t SpillPool::GetPeakDepth(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].peak_depth;
+}
+
+double SpillPool::GetLatency(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].latency;
+}
+
+double SpillPool::GetPeakLatency(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].peak_latency;
+}
+
+unsigned long SpillPool::GetNumSpills(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].spills;
+}
+
+unsigned long SpillPool::GetNumDropped(const unsigned int &consumer_) const {
+    if (consumer_ >= consumers.size()) { return 0; }
+    std::lock_guard<std::mutex> guard(lock);
+    return consumers[consumer_].dropped;
+}
@@ -0,0 +1,406 @@
+/** \file poll2_stream.cpp
+  *
+  * \brief Provides a lossless spill stream between poll2 and the scanners
+  *
+  * \date October 17, 2026
+  *
+  * See poll2_stream.h for the description of the stream and its addresses.
+*/
+
+#include "poll2_stream.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+    /// The time we wait for the rest of a frame once its header arrived (in ms).
+    const int frameTimeout = 5000;
+
+    /// The time the blocking policy waits between checks of the consumers (in ms).
+    const int blockInterval = 100;
+
+    bool IsUnixAddress(const std::string &address_) {
+        return address_.find('/') != std::string::npos;
+    }
+
+    /// Split a TCP address into its host and port. The host is empty if there is none.
+    bool SplitTcpAddress(const std::string &address_, std::string &host_, std::string &port_) {
+        size_t colon = address_.rfind(':');
+        host_ = colon == std::string::npos ? "" : address_.substr(0, colon);
+        port_ = colon == std::string::npos ? address_ : address_.substr(colon + 1);
+        return !port_.empty() && port_.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    bool FillUnixAddress(const std::string &path_, struct sockaddr_un &addr_) {
+        if (path_.size() >= sizeof(addr_.sun_path)) { return false; }
+        memset(&addr_, 0, sizeof(addr_));
+        addr_.sun_family = AF_UNIX;
+        strncpy(addr_.sun_path, path_.c_str(), sizeof(addr_.sun_path) - 1);
+        return true;
+    }
+
+    bool SetNonBlocking(const int &sock_) {
+        int flags = fcntl(sock_, F_GETFL, 0);
+        return flags >= 0 && fcntl(sock_, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// class SpillSender
+/////////////////////////////////////////////////////////////////////
+
+SpillSender::SpillSender() : sock(-1), init(false), policy(DROP_NEWEST), max_queued(64 * 1024 * 1024),
+                             sequence(0), num_spills(0), num_dropped(0) {
+}
+
+/**
+ *	\param[in] address_ The path of the Unix domain socket or the TCP port to listen on.
+ *	\return Returns false if the socket fails to open, bind or listen.
+ */
+bool SpillSender::Init(const std::string &address_) {
+    if (init) { return false; }
+
+    if (IsUnixAddress(address_)) {
+        struct sockaddr_un addr;
+        if (!FillUnixAddress(address_, addr)) { return false; }
+
+        // Remove the socket left behind by a poll2 that did not close cleanly.
+        struct stat info;
+        if (stat(address_.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) { unlink(address_.c_str()); }
+
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) { return false; }
+        if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+            close(sock);
+            sock = -1;
+            return false;
+        }
+    } else {
+        std::string host, port;
+        if (!SplitTcpAddress(address_, host, port)) { return false; }
+
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock < 0) { return false; }
+
+        int reuse = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(atoi(port.c_str()));
+        if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+            close(sock);
+            sock = -1;
+            return false;
+        }
+    }
+
+    if (listen(sock, 16) < 0 || !SetNonBlocking(sock)) {
+        close(sock);
+        sock = -1;
+        return false;
+    }
+
+    address = address_;
+    return init = true;
+}
+
+bool SpillSender::SendSpill(const unsigned int *data_, const size_t &nWords_) {
+    if (!init) { return false; }
+
+    Accept();
+    num_spills++;
+    // There is no need to build the frame if nobody is listening.
+    if (!consumers.empty()) { Queue(MakeFrame(SpillStream::SPILL, data_, nWords_), true); }
+    sequence++;
+    Deliver();
+    return true;
+}
+
+bool SpillSender::SendControl(const SpillStream::FrameType &type_) {
+    if (!init) { return false; }
+
+    Accept();
+    if (!consumers.empty()) { Queue(MakeFrame(type_, NULL, 0), false); }
+    Deliver();
+    return true;
+}
+
+void SpillSender::Flush() {
+    if (!init) { return; }
+
+    Accept();
+    for (std::vector<Consumer>::iterator it = consumers.begin(); it != consumers.end();) {
+        if (Send(*it)) { ++it; }
+        else {
+            close(it->sock);
+            it = consumers.erase(it);
+        }
+    }
+}
+
+void SpillSender::Close() {
+    if (!init) { return; }
+
+    for (std::vector<Consumer>::iterator it = consumers.begin(); it != consumers.end(); ++it) { close(it->sock); }
+    consumers.clear();
+
+    close(sock);
+    sock = -1;
+    if (IsUnixAddress(address)) { unlink(address.c_str()); }
+    init = false;
+}
+
+size_t SpillSender::GetNumQueued() const {
+    size_t queued = 0;
+    for (std::vector<Consumer>::const_iterator it = consumers.begin(); it != consumers.end(); ++it) {
+        queued += it->queued;
+    }
+    return queued;
+}
+
+void SpillSender::Accept() {
+    while (true) {
+        int client = accept(sock, NULL, NULL);
+        if (client < 0) { return; } // Nobody else is waiting
+        if (!SetNonBlocking(client)) {
+            close(client);
+            continue;
+        }
+
+        if (!IsUnixAddress(address)) {
+            int nodelay = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        }
+
+        Consumer consumer;
+        consumer.sock = client;
+        consumer.offset = 0;
+        consumer.queued = 0;
+        consumer.dropped = 0;
+        consumers.push_back(consumer);
+    }
+}
+
+void SpillSender::Queue(const Frame &frame_, const bool &isSpill_) {
+    for (std::vector<Consumer>::iterator it = consumers.begin(); it != consumers.end(); ++it) {
+        // A consumer with an empty queue always gets the spill, however large it is.
+        if (isSpill_ && policy == DROP_NEWEST && it->queued > 0 && it->queued + frame_->size() > max_queued) {
+            it->dropped++;
+            num_dropped++;
+            continue;
+        }
+        it->queue.push_back(frame_);
+        it->queued += frame_->size();
+    }
+}
+
+bool SpillSender::Send(Consumer &consumer_) {
+    while (!consumer_.queue.empty()) {
+        const std::vector<char> &frame = *consumer_.queue.front();
+        ssize_t nBytes = send(consumer_.sock, &frame[consumer_.offset], frame.size() - consumer_.offset,
+                              MSG_NOSIGNAL);
+        if (nBytes < 0) {
+            if (errno == EINTR) { continue; }
+            return errno == EAGAIN || errno == EWOULDBLOCK; // The socket is full, or the consumer is gone
+        }
+
+        consumer_.offset += nBytes;
+        consumer_.queued -= nBytes;
+        if (consumer_.offset == frame.size()) {
+            consumer_.queue.pop_front();
+            consumer_.offset = 0;
+        }
+    }
+    return true;
+}
+
+void SpillSender::Deliver() {
+    Flush();
+    if (policy != BLOCK) { return; }
+
+    // Wait for every consumer to get below the limit, dropping those that disconnect.
+    std::vector<struct pollfd> fds;
+    while (true) {
+        fds.clear();
+        for (std::vector<Consumer>::iterator it = consumers.begin(); it != consumers.end(); ++it) {
+            if (it->queued > max_queued) {
+                struct pollfd fd = {it->sock, POLLOUT, 0};
+                fds.push_back(fd);
+            }
+        }
+        if (fds.empty()) { return; }
+
+        poll(&fds[0], fds.size(), blockInterval);
+        Flush();
+    }
+}
+
+SpillSender::Frame SpillSender::MakeFrame(const SpillStream::FrameType &type_, const unsigned int *data_,
+                                          const size_t &nWords_) {
+    SpillStream::FrameHeader header;
+    header.magic = SpillStream::magic;
+    header.type = type_;
+    header.sequence = sequence;
+    header.nWords = nWords_;
+
+    Frame frame(new std::vector<char>(sizeof(header) + nWords_ * sizeof(unsigned int)));
+    memcpy(&(*frame)[0], &header, sizeof(header));
+    if (nWords_ > 0) { memcpy(&(*frame)[sizeof(header)], data_, nWords_ * sizeof(unsigned int)); }
+    return frame;
+}
+
+/////////////////////////////////////////////////////////////////////
+// class SpillReceiver
+/////////////////////////////////////////////////////////////////////
+
+SpillReceiver::SpillReceiver() : sock(-1), init(false), have_sequence(false), next_sequence(0), num_spills(0),
+                                 num_missed(0) {
+}
+
+/**
+ *	\param[in] address_ The path of the Unix domain socket or the TCP host and port of poll2.
+ *	\return Returns false if the address is invalid.
+ */
+bool SpillReceiver::Init(const std::string &address_) {
+    if (init) { return false; }
+
+    if (IsUnixAddress(address_)) {
+        struct sockaddr_un addr;
+        if (!FillUnixAddress(address_, addr)) { return false; }
+    } else {
+        std::string host, port;
+        if (!SplitTcpAddress(address_, host, port)) { return false; }
+    }
+
+    address = address_;
+    init = true;
+    Connect();
+    return true;
+}
+
+SpillReceiver::Status SpillReceiver::Read(std::vector<unsigned int> &spill_, const int &timeout_) {
+    if (!init) { return DISCONNECTED; }
+
+    if (sock < 0 && !Connect()) {
+        // poll2 is not listening, wait a bit before the caller tries again.
+        poll(NULL, 0, timeout_);
+        return DISCONNECTED;
+    }
+
+    struct pollfd fd = {sock, POLLIN, 0};
+    int retval = poll(&fd, 1, timeout_);
+    if (retval == 0 || (retval < 0 && errno == EINTR)) { return TIMEOUT; }
+
+    SpillStream::FrameHeader header;
+    if (!ReadBytes((char *) &header, sizeof(header), frameTimeout)) { return DISCONNECTED; }
+    if (header.magic != SpillStream::magic) { // We lost track of the frames, start over.
+        Close();
+        return DISCONNECTED;
+    }
+
+    if (header.type == SpillStream::SPILL) {
+        spill_.resize(header.nWords);
+        if (header.nWords > 0 &&
+            !ReadBytes((char *) &spill_[0], header.nWords * sizeof(unsigned int), frameTimeout)) {
+            return DISCONNECTED;
+        }
+    } else if (header.nWords > 0) { // No control frame has a payload yet, skip it.
+        std::vector<char> payload(header.nWords * sizeof(unsigned int));
+        if (!ReadBytes(&payload[0], payload.size(), frameTimeout)) { return DISCONNECTED; }
+    }
+
+    // The sequence counts the spills poll2 sent, so a gap is the number of spills dropped for us.
+    if (have_sequence && header.sequence > next_sequence) { num_missed += header.sequence - next_sequence; }
+    have_sequence = true;
+    next_sequence = header.sequence;
+
+    switch (header.type) {
+        case SpillStream::SPILL:
+            next_sequence++;
+            num_spills++;
+            return SPILL;
+        case SpillStream::OPEN_FILE:
+            return OPEN_FILE;
+        case SpillStream::CLOSE_FILE:
+            return CLOSE_FILE;
+        case SpillStream::KILL_SOCKET:
+            Close();
+            return KILL_SOCKET;
+        default:
+            return TIMEOUT;
+    }
+}
+
+void SpillReceiver::Close() {
+    if (sock >= 0) { close(sock); }
+    sock = -1;
+    // The sequence starts over when poll2 is restarted.
+    have_sequence = false;
+}
+
+bool SpillReceiver::Connect() {
+    if (IsUnixAddress(address)) {
+        struct sockaddr_un addr;
+        FillUnixAddress(address, addr);
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) { return false; }
+        if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    std::string host, port;
+    SplitTcpAddress(address, host, port);
+    if (host.empty()) { host = "127.0.0.1"; }
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) { return false; }
+
+    sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (sock >= 0 && connect(sock, result->ai_addr, result->ai_addrlen) < 0) { Close(); }
+    freeaddrinfo(result);
+    return sock >= 0;
+}
+
+bool SpillReceiver::ReadBytes(char *buffer_, const size_t &length_, const int &timeout_) {
+    size_t received = 0;
+    while (received < length_) {
+        struct pollfd fd = {sock, POLLIN, 0};
+        int retval = poll(&fd, 1, timeout_);
+        if (retval < 0 && errno == EINTR) { continue; }
+        if (retval <= 0) {
+            Close();
+            return false;
+        }
+
+        ssize_t nBytes = recv(sock, buffer_ + received, length_ - received, 0);
+        if (nBytes < 0 && errno == EINTR) { continue; }
+        if (nBytes <= 0) { // poll2 closed the connection
+            Close();
+            return false;
+        }
+        received += nBytes;
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+///@file unittest-poll2_shm_ring.cpp
+///@brief Program that will test the shared-memory ring of spills
+///@date October 17, 2026
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+#include <UnitTest++.h>
+
+#include "poll2_shm_ring.h"
+
+using namespace std;
+
+namespace {
+    ///@return A segment name that no other test program is using
+    string RingName() {
+        stringstream name;
+        name << "/unittest-poll2_shm_ring." << getpid();
+        return name.str();
+    }
+
+    ///@return A spill whose words count up from the first one
+    vector<unsigned int> MakeSpill(const unsigned int &first, const unsigned int &nWords) {
+        vector<unsigned int> spill(nWords);
+        for (unsigned int i = 0; i < nWords; i++)
+            spill[i] = first + i;
+        return spill;
+    }
+}
+
+///Testing that every reader gets every spill in order, across the end of the ring
+TEST (Test_ReadersGetEverySpill) {
+    SpillRingReader early;
+    CHECK(early.Init(RingName()));
+    CHECK(!early.IsAttached());
+
+    SpillRingWriter writer;
+    CHECK(writer.Init(RingName(), 4096));
+    SpillRingReader first, second;
+    CHECK(first.Init(RingName()));
+    CHECK(second.Init(RingName()));
+    CHECK(first.IsAttached());
+
+    vector<unsigned int> result;
+    CHECK_EQUAL(SpillRingReader::TIMEOUT, first.Read(result, 1));
+
+    //Every spill takes a bit more than a fifth of the ring, so the records wrap several times.
+    for (unsigned int i = 0; i < 20; i++) {
+        vector<unsigned int> spill = MakeSpill(i, 200 + i);
+        CHECK(writer.Publish(&spill[0], spill.size()));
+        CHECK_EQUAL(SpillRingReader::SPILL, first.Read(result, 1));
+        CHECK(spill == result);
+
+        const unsigned int *data;
+        size_t nWords;
+        CHECK_EQUAL(SpillRingReader::SPILL, second.Peek(data, nWords, 1));
+        CHECK(spill == vector<unsigned int>(data, data + nWords));
+        CHECK(second.Release());
+    }
+    CHECK_EQUAL((unsigned long) 20, first.GetNumSpills());
+    CHECK_EQUAL((unsigned long) 0, first.GetNumMissed());
+    CHECK_EQUAL((unsigned long) 20, writer.GetNumSpills());
+
+    //The reader that started before the ring existed attaches on its first read.
+    CHECK_EQUAL(SpillRingReader::TIMEOUT, early.Read(result, 1));
+    CHECK(early.IsAttached());
+
+    vector<unsigned int> large = MakeSpill(0, 1000);
+    CHECK(!writer.Publish(&large[0], large.size()));
+    CHECK_EQUAL((unsigned long) 1, writer.GetNumDropped());
+
+    writer.Close();
+    CHECK_EQUAL(SpillRingReader::DETACHED, first.Read(result, 1));
+    CHECK(!first.IsAttached());
+}
+
+///Testing that a reader that falls behind skips to the newest spill and counts what it missed
+TEST (Test_OverrunReaderResyncs) {
+    SpillRingWriter writer;
+    CHECK(writer.Init(RingName(), 4096));
+    SpillRingReader reader;
+    CHECK(reader.Init(RingName()));
+
+    vector<unsigned int> spill;
+    for (unsigned int i = 0; i < 10; i++) {
+        spill = MakeSpill(i, 300);
+        writer.Publish(&spill[0], spill.size());
+    }
+
+    vector<unsigned int> result;
+    CHECK_EQUAL(SpillRingReader::SPILL, reader.Read(result, 1));
+    CHECK(spill == result);
+    CHECK_EQUAL((unsigned long) 9, reader.GetNumMissed());
+
+    //A spill that is overwritten while we look at it is not released as good.
+    const unsigned int *data;
+    size_t nWords;
+    spill = MakeSpill(100, 300);
+    writer.Publish(&spill[0], spill.size());
+    CHECK_EQUAL(SpillRingReader::SPILL, reader.Peek(data, nWords, 1));
+    for (unsigned int i = 0; i < 4; i++)
+        writer.Publish(&spill[0], spill.size());
+    CHECK(!reader.Release());
+    CHECK_EQUAL((unsigned long) 10, reader.GetNumMissed());
+    CHECK_EQUAL((unsigned long) 1, reader.GetNumSpills());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
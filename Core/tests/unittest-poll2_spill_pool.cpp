@@ -0,0 +1,106 @@
+///@file unittest-poll2_spill_pool.cpp
+///@brief Program that will test the pool of spill buffers between the poll2 readout and its output threads
+///@date October 17, 2026
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "poll2_spill_pool.h"
+
+using namespace std;
+
+namespace {
+    const unsigned int writer = 0;
+    const unsigned int broadcaster = 1;
+}
+
+///Testing that a buffer is free again only after every consumer released it
+TEST (Test_BufferFreeAfterAllConsumers) {
+    SpillPool pool(2, 16, 2);
+    CHECK_EQUAL((size_t) 2, pool.GetNumFree());
+
+    SpillPool::Buffer *buffer = pool.Acquire();
+    CHECK(buffer != NULL);
+    CHECK_EQUAL((size_t) 16, buffer->data.size());
+    buffer->data[0] = 7;
+    buffer->nWords = 1;
+    pool.Submit(buffer, (1u << writer) | (1u << broadcaster));
+    CHECK_EQUAL((size_t) 1, pool.GetNumFree());
+    CHECK_EQUAL((size_t) 1, pool.GetDepth(writer));
+
+    CHECK(pool.Next(writer, 0) == buffer);
+    CHECK(pool.Next(writer, 0) == NULL);
+    pool.Release(writer, buffer);
+    CHECK_EQUAL((size_t) 1, pool.GetNumFree());
+    CHECK_EQUAL((size_t) 0, pool.GetDepth(writer));
+
+    CHECK(pool.Next(broadcaster, 0) == buffer);
+    CHECK_EQUAL((unsigned int) 7, buffer->data[0]);
+    pool.Release(broadcaster, buffer);
+    CHECK_EQUAL((size_t) 2, pool.GetNumFree());
+    CHECK_EQUAL((unsigned long) 1, pool.GetNumSpills(writer));
+    CHECK_EQUAL((unsigned long) 1, pool.GetNumSpills(broadcaster));
+
+    //A buffer for no consumer goes straight back to the pool
+    pool.Submit(pool.Acquire(), 0);
+    CHECK_EQUAL((size_t) 2, pool.GetNumFree());
+}
+
+///Testing that a consumer at its depth limit loses spills without holding up the others
+TEST (Test_DepthLimitDropsSpills) {
+    SpillPool pool(4, 1, 2);
+    pool.SetDepthLimit(broadcaster, 1);
+
+    for (unsigned int i = 0; i < 3; i++) {
+        SpillPool::Buffer *buffer = pool.Acquire();
+        buffer->data[0] = i;
+        pool.Submit(buffer, (1u << writer) | (1u << broadcaster));
+    }
+    CHECK_EQUAL((size_t) 3, pool.GetDepth(writer));
+    CHECK_EQUAL((size_t) 1, pool.GetDepth(broadcaster));
+    CHECK_EQUAL((unsigned long) 2, pool.GetNumDropped(broadcaster));
+    CHECK_EQUAL((unsigned long) 0, pool.GetNumDropped(writer));
+
+    for (unsigned int i = 0; i < 3; i++) {
+        SpillPool::Buffer *buffer = pool.Next(writer, 0);
+        CHECK_EQUAL(i, buffer->data[0]);
+        pool.Release(writer, buffer);
+    }
+    CHECK_EQUAL((size_t) 3, pool.GetNumFree());
+    CHECK_EQUAL((size_t) 3, pool.GetPeakDepth(writer));
+}
+
+///Testing that the readout waits for a consumer and that Drain and Stop let the threads finish
+TEST (Test_ReadoutWaitsForConsumer) {
+    SpillPool pool(2, 1, 1);
+    unsigned int sum = 0;
+
+    std::thread consumer([&pool, &sum] {
+        SpillPool::Buffer *buffer;
+        while ((buffer = pool.Next(writer, 10)) || !pool.IsStopped()) {
+            if (!buffer) continue;
+            sum += buffer->data[0];
+            pool.Release(writer, buffer);
+        }
+    });
+
+    for (unsigned int i = 1; i <= 100; i++) {
+        SpillPool::Buffer *buffer = pool.Acquire();
+        buffer->data[0] = i;
+        buffer->nWords = 1;
+        pool.Submit(buffer, 1u << writer);
+    }
+    pool.Drain();
+    CHECK_EQUAL((unsigned int) 5050, sum);
+    CHECK_EQUAL((size_t) 2, pool.GetNumFree());
+
+    pool.Stop();
+    consumer.join();
+    CHECK(pool.Acquire() == NULL);
+    CHECK_EQUAL((unsigned long) 100, pool.GetNumSpills(writer));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
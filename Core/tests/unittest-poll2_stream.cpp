@@ -0,0 +1,94 @@
+///@file unittest-poll2_stream.cpp
+///@brief Program that will test the spill stream between poll2 and the scanners
+///@date October 17, 2026
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <UnitTest++.h>
+
+#include "poll2_stream.h"
+
+using namespace std;
+
+namespace {
+    ///@return A Unix socket path that no other test program is using
+    string SocketPath() {
+        stringstream path;
+        path << "/tmp/unittest-poll2_stream." << getpid();
+        return path.str();
+    }
+
+    ///@return A spill whose words count up from the first one
+    vector<unsigned int> MakeSpill(const unsigned int &first, const unsigned int &nWords) {
+        vector<unsigned int> spill(nWords);
+        for (unsigned int i = 0; i < nWords; i++)
+            spill[i] = first + i;
+        return spill;
+    }
+}
+
+///Testing that spills and control frames arrive whole and in order
+TEST (Test_SpillsArriveWhole) {
+    SpillSender sender;
+    SpillReceiver receiver;
+    CHECK(!sender.SendSpill(NULL, 0));
+    CHECK(sender.Init(SocketPath()));
+    CHECK(receiver.Init(SocketPath()));
+    CHECK(receiver.IsConnected());
+
+    vector<unsigned int> spill = MakeSpill(7, 1000), result;
+    CHECK(sender.SendControl(SpillStream::OPEN_FILE));
+    CHECK(sender.SendSpill(&spill[0], spill.size()));
+    CHECK_EQUAL((unsigned int) 1, sender.GetNumConsumers());
+
+    CHECK_EQUAL(SpillReceiver::OPEN_FILE, receiver.Read(result, 1000));
+    CHECK_EQUAL(SpillReceiver::SPILL, receiver.Read(result, 1000));
+    CHECK(spill == result);
+    CHECK_EQUAL(SpillReceiver::TIMEOUT, receiver.Read(result, 10));
+
+    sender.Close();
+    CHECK_EQUAL(SpillReceiver::DISCONNECTED, receiver.Read(result, 10));
+    CHECK_EQUAL((unsigned long) 1, receiver.GetNumSpills());
+    CHECK_EQUAL((unsigned long) 0, receiver.GetNumMissed());
+}
+
+///Testing that a consumer that falls behind loses whole spills and that both ends count them
+TEST (Test_DropNewestWhenFull) {
+    SpillSender sender;
+    SpillReceiver receiver;
+    CHECK(sender.Init(SocketPath()));
+    CHECK(receiver.Init(SocketPath()));
+    sender.SetMaxQueued(1);
+
+    //The spills are larger than the socket buffer, so the first one stays in the queue.
+    vector<unsigned int> first = MakeSpill(0, 1000000), second = MakeSpill(1, 1000000), third = MakeSpill(2, 10);
+    sender.SendSpill(&first[0], first.size());
+    CHECK(sender.GetNumQueued() > 0);
+    sender.SendSpill(&second[0], second.size());
+    CHECK_EQUAL((unsigned long) 1, sender.GetNumDropped());
+
+    vector<vector<unsigned int> > results(2);
+    thread reader([&receiver, &results]() {
+        for (unsigned int i = 0; i < results.size(); i++)
+            while (receiver.Read(results[i], 1000) != SpillReceiver::SPILL);
+    });
+
+    while (sender.GetNumQueued() > 0)
+        sender.Flush();
+    sender.SendSpill(&third[0], third.size());
+    while (sender.GetNumQueued() > 0)
+        sender.Flush();
+    reader.join();
+
+    CHECK(first == results[0]);
+    CHECK(third == results[1]);
+    CHECK_EQUAL((unsigned long) 1, receiver.GetNumMissed());
+    CHECK_EQUAL((unsigned long) 3, sender.GetNumSpills());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -11,7 +11,9 @@
 /// An  of numbers using Mersenne twister - Singleton Class
 class RandomInterface {
 public:
-    /** \return The only instance to the random pool */
+    /** \return The instance of the random pool for the calling thread. Each
+     * thread has its own generator so that they can be used at the same
+     * time. */
     static RandomInterface *get();
 
     /** \return a random number in the specified range [0, range]
@@ -21,7 +23,7 @@ private:
     RandomInterface(); //!<Default constructor
     RandomInterface(const RandomInterface &);  //!< Overload of the constructor
     RandomInterface &operator=(RandomInterface const &);//!< the copy constructor
-    static RandomInterface *instance;//!< static instance of the class
+    static thread_local RandomInterface *instance;//!< The instance for the calling thread
 
     std::mt19937_64 engine_;
     std::uniform_real_distribution<double> distribution_;
@@ -0,0 +1,159 @@
+///@file TraceKernels.hpp
+///@brief Vectorized versions of the trace functions that are run on every
+/// trace. The instruction set is chosen at run time.
+///@date October 17, 2026
+#ifndef PIXIESUITE_TRACEKERNELS_HPP
+#define PIXIESUITE_TRACEKERNELS_HPP
+
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "HelperFunctions.hpp"
+
+///@brief The baseline, maximum and integrals of the TraceFunctions computed
+/// with SSE4.1 or AVX2 when the processor has them. The samples are summed as
+/// integers, so the results agree with the TraceFunctions to the rounding of
+/// a double. Samples are assumed to hold at most 16 bits, which is the case
+/// for every Pixie-16 revision.
+namespace TraceKernels {
+    ///The instruction sets that the kernels are written for.
+    enum InstructionSet {
+        SCALAR, SSE41, AVX2
+    };
+
+    ///@return The best instruction set that this processor supports.
+    InstructionSet GetSupportedInstructionSet();
+
+    ///@return The instruction set that the kernels use.
+    InstructionSet GetInstructionSet();
+
+    ///@brief Selects the instruction set of the kernels. The best supported
+    /// instruction set is used if the requested one is not available.
+    ///@param[in] set : The requested instruction set.
+    ///@return The instruction set that will be used.
+    InstructionSet SetInstructionSet(const InstructionSet &set);
+
+    ///@brief Computes the average and the standard deviation of the samples
+    /// in [low, high) in a single pass.
+    ///@param[in] data : The samples
+    ///@param[in] low : The first sample
+    ///@param[in] high : One past the last sample
+    ///@return A pair with the average and the standard deviation
+    std::pair<double, double> Baseline(const unsigned int *data, const size_t &low, const size_t &high);
+
+    ///@copydoc Baseline(const unsigned int *, const size_t &, const size_t &)
+    std::pair<double, double> Baseline(const unsigned short *data, const size_t &low, const size_t &high);
+
+    ///@brief Finds the first of the largest samples in [low, high).
+    ///@param[in] data : The samples
+    ///@param[in] low : The first sample
+    ///@param[in] high : One past the last sample, larger than low
+    ///@return A pair with the position and the value of the maximum
+    std::pair<unsigned int, double> Maximum(const unsigned int *data, const size_t &low, const size_t &high);
+
+    ///@copydoc Maximum(const unsigned int *, const size_t &, const size_t &)
+    std::pair<unsigned int, double> Maximum(const unsigned short *data, const size_t &low, const size_t &high);
+
+    ///@brief Integrates the samples in [low, high) with the trapezoidal
+    /// rule after subtracting an offset from them.
+    ///@param[in] data : The samples
+    ///@param[in] low : The first sample
+    ///@param[in] high : One past the last sample, at least low + 2
+    ///@param[in] offset : The value subtracted from every sample
+    ///@return The integral
+    double Integral(const unsigned int *data, const size_t &low, const size_t &high, const double &offset);
+
+    ///@copydoc Integral(const unsigned int *, const size_t &, const size_t &, const double &)
+    double Integral(const unsigned short *data, const size_t &low, const size_t &high, const double &offset);
+
+    ///@brief The TraceFunctions::CalculateBaseline of a trace using the
+    /// samples in [range.first, range.second).
+    ///@param[in] data : The trace
+    ///@param[in] range : The samples that hold the baseline
+    ///@return A pair with the average of the baseline and its standard
+    /// deviation
+    template<class T>
+    inline std::pair<double, double> CalculateBaseline(const std::vector<T> &data,
+                                                       const std::pair<unsigned int, unsigned int> &range) {
+        if (data.size() == 0)
+            throw std::range_error("TraceKernels::CalculateBaseline - Data vector sized 0");
+        if (range.second < range.first)
+            throw std::range_error("TraceKernels::CalculateBaseline - Bad range : High > Low");
+        if (data.size() < range.second)
+            throw std::range_error("TraceKernels::CalculateBaseline - Data vector size is smaller than requested "
+                                           "range.");
+        if (range.second - range.first < (unsigned int) TraceFunctions::minimum_baseline_length)
+            throw std::range_error("TraceKernels::CalculateBaseline - The range specified is smaller than the "
+                                           "minimum necessary range.");
+        return Baseline(&data[0], range.first, range.second);
+    }
+
+    ///@brief The TraceFunctions::FindMaximum of a trace. The search starts
+    /// after the minimum baseline length and stops at the trace delay.
+    ///@param[in] data : The trace
+    ///@param[in] traceDelayInBins : The trace delay of the channel
+    ///@return A pair with the position and the value of the maximum
+    template<class T>
+    inline std::pair<unsigned int, double> FindMaximum(const std::vector<T> &data,
+                                                       const unsigned int &traceDelayInBins) {
+        std::stringstream msg;
+        if (data.size() == 0)
+            throw std::range_error("TraceKernels::FindMaximum - The data was of size 0.");
+        if (traceDelayInBins > data.size()) {
+            msg << "TraceKernels::FindMaximum - The requested trace delay (" << traceDelayInBins
+                << ") was larger than the size of the data vector(" << data.size() << ".";
+            throw std::range_error(msg.str());
+        }
+        if (traceDelayInBins <= (unsigned int) TraceFunctions::minimum_baseline_length) {
+            msg << "TraceKernels::FindMaximum - The provided traceDelayInBins(" << traceDelayInBins
+                << ") was too small it must be greater than " << TraceFunctions::minimum_baseline_length;
+            throw std::range_error(msg.str());
+        }
+        return Maximum(&data[0], TraceFunctions::minimum_baseline_length, traceDelayInBins);
+    }
+
+    ///@brief The TraceFunctions::CalculateQdc of a trace after subtracting
+    /// the baseline, without building the baseline subtracted trace.
+    ///@param[in] data : The trace
+    ///@param[in] range : The samples to integrate
+    ///@param[in] baseline : The baseline to subtract
+    ///@return The integral of the baseline subtracted samples
+    template<class T>
+    inline double CalculateQdc(const std::vector<T> &data, const std::pair<unsigned int, unsigned int> &range,
+                               const double &baseline) {
+        std::stringstream msg;
+        if (data.size() == 0)
+            throw std::range_error("TraceKernels::CalculateQdc - The size of the data vector was zero.");
+        if (data.size() < range.second) {
+            msg << "TraceKernels::CalculateQdc - The specified range was larger than the range : ["
+                << range.first << "," << range.second << "].";
+            throw std::range_error(msg.str());
+        }
+        if (range.first > range.second)
+            throw std::range_error("TraceKernels::CalculateQdc - The specified range was inverted.");
+        if (range.second - range.first < 2)
+            throw std::range_error("TraceKernels::CalculateQdc - The range was too small to integrate. We need "
+                                           "at least a size of 2.");
+        return Integral(&data[0], range.first, range.second, baseline);
+    }
+
+    ///@brief The TraceFunctions::CalculateTailRatio of a trace after
+    /// subtracting the baseline.
+    ///@param[in] data : The trace
+    ///@param[in] range : The samples that hold the tail
+    ///@param[in] baseline : The baseline to subtract
+    ///@param[in] qdc : The QDC of the waveform
+    ///@return The integral of the tail divided by the QDC
+    template<class T>
+    inline double CalculateTailRatio(const std::vector<T> &data, const std::pair<unsigned int, unsigned int> &range,
+                                     const double &baseline, const double &qdc) {
+        if (qdc == 0)
+            throw std::range_error("TraceKernels::CalculateTailRatio - The QDC had a value of zero. This will "
+                                           "cause issues.");
+        return CalculateQdc(data, range, baseline) / qdc;
+    }
+}
+
+#endif //PIXIESUITE_TRACEKERNELS_HPP
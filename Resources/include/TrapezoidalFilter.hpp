@@ -0,0 +1,89 @@
+///@file TrapezoidalFilter.hpp
+///@brief The running sum form of the Pixie-16 trapezoidal trigger and energy
+/// filters
+///@date October 17, 2026
+#ifndef PIXIESUITE_TRAPEZOIDALFILTER_HPP
+#define PIXIESUITE_TRAPEZOIDALFILTER_HPP
+
+#include <vector>
+
+///Computes the trapezoidal filters the way the Pixie-16 firmware does, with
+/// running sums instead of re-summing the windows for every sample. The
+/// running sums of the trace are built once, after which every window sum
+/// is a single difference. Filtering a whole trace is then O(N) no matter
+/// how long the filters are. This is based off of the IGOR macro energy.ipf
+/// written by H. Tan of XIA LLC.
+class TrapezoidalFilter {
+public:
+    ///Default constructor
+    TrapezoidalFilter() {}
+
+    ///Builds the running sums of a trace.
+    ///@param[in] data : The samples of the trace
+    ///@param[in] length : The number of samples
+    template<class T>
+    void SetTrace(const T *data, const size_t &length) {
+        sums_.resize(length + 1);
+        sums_[0] = 0;
+        for (size_t i = 0; i < length; i++)
+            sums_[i + 1] = sums_[i] + data[i];
+    }
+
+    ///Builds the running sums of a trace.
+    ///@param[in] data : The trace
+    template<class T>
+    void SetTrace(const std::vector<T> &data) { SetTrace(data.empty() ? (const T *) 0 : &data[0], data.size()); }
+
+    ///@return The number of samples in the trace
+    size_t GetLength() const { return sums_.empty() ? 0 : sums_.size() - 1; }
+
+    ///@return The sum of the samples in [low, high)
+    double Sum(const size_t &low, const size_t &high) const { return sums_[high] - sums_[low]; }
+
+    ///@brief Calculates the trigger filter at every sample. The filter at
+    /// sample i is the sum of the risetime samples ending at i minus the
+    /// sum of the risetime samples that end flattop samples earlier, divided
+    /// by the risetime. Samples without a full filter in front of them are 0.
+    ///@param[in] risetime : The risetime of the filter in samples
+    ///@param[in] flattop : The flattop of the filter in samples
+    ///@param[out] filter : The filter, which has the length of the trace
+    void CalculateTriggerFilter(const unsigned int &risetime, const unsigned int &flattop,
+                                std::vector<double> &filter) const;
+
+    ///@brief Calculates the energy filter with the pole-zero correction at
+    /// every sample. The filter at sample i weights the risetime samples
+    /// before the gap, the flattop samples of the gap and the risetime
+    /// samples ending at i with the coefficients of CalculateEnergyCoefficients.
+    /// Samples without a full filter in front of them are 0.
+    ///@param[in] risetime : The risetime of the filter in samples
+    ///@param[in] flattop : The flattop of the filter in samples
+    ///@param[in] tau : The decay constant of the signal in samples
+    ///@param[out] filter : The filter, which has the length of the trace
+    void CalculateEnergyFilter(const unsigned int &risetime, const unsigned int &flattop, const double &tau,
+                               std::vector<double> &filter) const;
+
+    ///@brief Calculates the coefficients that weight the rise sum, the gap
+    /// sum and the fall sum of the energy filter to undo the exponential
+    /// decay of the signal.
+    ///@param[in] risetime : The risetime of the filter in samples
+    ///@param[in] tau : The decay constant of the signal in samples
+    ///@return The coefficients of the rise, gap and fall sums. They are nan
+    /// if the tau does not give a valid correction.
+    static std::vector<double> CalculateEnergyCoefficients(const double &risetime, const double &tau);
+
+    ///@brief Finds the triggers in a trigger filter. The first trigger is
+    /// the first sample at or above the threshold. Every later trigger needs
+    /// the filter to drop below the threshold and cross it again, so more
+    /// than one trigger flags a pileup.
+    ///@param[in] filter : The trigger filter
+    ///@param[in] threshold : The trigger threshold
+    ///@param[in] first : The first sample that has a full filter
+    ///@return The positions of the triggers
+    static std::vector<unsigned int> FindTriggers(const std::vector<double> &filter, const double &threshold,
+                                                  const size_t &first = 0);
+
+private:
+    std::vector<double> sums_; ///< The running sums, sums_[i] is the sum of the first i samples.
+};
+
+#endif //PIXIESUITE_TRAPEZOIDALFILTER_HPP
@@ -4,10 +4,12 @@
  * @date May 2017
  */
 #include <chrono>
+#include <functional>
+#include <thread>
 
 #include "RandomInterface.hpp"
 
-RandomInterface *RandomInterface::instance = NULL;
+thread_local RandomInterface *RandomInterface::instance = NULL;
 
 RandomInterface *RandomInterface::get() {
     if (!instance)
@@ -16,7 +18,9 @@ RandomInterface *RandomInterface::get() {
 }
 
 RandomInterface::RandomInterface() {
-    engine_ = std::mt19937_64(std::chrono::system_clock::now().time_since_epoch().count());
+    //Threads are usually started at the same time, so the thread id keeps their seeds apart.
+    engine_ = std::mt19937_64(std::chrono::system_clock::now().time_since_epoch().count() ^
+                              std::hash<std::thread::id>()(std::this_thread::get_id()));
     distribution_ = std::uniform_real_distribution<double>(0.0, 1.0);
 }
 
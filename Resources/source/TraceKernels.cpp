@@ -0,0 +1,232 @@
+///@file TraceKernels.cpp
+///@brief Vectorized versions of the trace functions that are run on every
+/// trace. The instruction set is chosen at run time.
+///@date October 17, 2026
+#include <cmath>
+
+#include "TraceKernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRACEKERNELS_X86
+#include <immintrin.h>
+#define TRACEKERNELS_SSE41 __attribute__((target("sse4.1")))
+#define TRACEKERNELS_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+namespace {
+    ///The sum and the sum of squares of a range of samples.
+    struct Sums {
+        unsigned long long sum;
+        unsigned long long squares;
+    };
+
+    TraceKernels::InstructionSet DetectInstructionSet() {
+#ifdef TRACEKERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return TraceKernels::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return TraceKernels::SSE41;
+#endif
+        return TraceKernels::SCALAR;
+    }
+
+    const TraceKernels::InstructionSet supported = DetectInstructionSet();
+    TraceKernels::InstructionSet selected = supported;
+
+    template<class T>
+    Sums ScalarSums(const T *data, size_t low, const size_t &high) {
+        Sums result = {0, 0};
+        for (; low < high; low++) {
+            result.sum += data[low];
+            result.squares += (unsigned long long) data[low] * data[low];
+        }
+        return result;
+    }
+
+    template<class T>
+    unsigned int ScalarMaximum(const T *data, size_t low, const size_t &high) {
+        unsigned int maximum = 0;
+        for (; low < high; low++)
+            if (data[low] > maximum)
+                maximum = data[low];
+        return maximum;
+    }
+
+#ifdef TRACEKERNELS_X86
+    TRACEKERNELS_SSE41 inline __m128i LoadSse41(const unsigned int *data) {
+        return _mm_loadu_si128((const __m128i *) data);
+    }
+
+    TRACEKERNELS_SSE41 inline __m128i LoadSse41(const unsigned short *data) {
+        return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) data));
+    }
+
+    TRACEKERNELS_AVX2 inline __m256i LoadAvx2(const unsigned int *data) {
+        return _mm256_loadu_si256((const __m256i *) data);
+    }
+
+    TRACEKERNELS_AVX2 inline __m256i LoadAvx2(const unsigned short *data) {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) data));
+    }
+
+    ///Four samples at a time. Each sample is widened to 64 bits before it is
+    /// summed and squared so that the sums cannot overflow.
+    template<class T>
+    TRACEKERNELS_SSE41 Sums Sse41Sums(const T *data, size_t low, const size_t &high) {
+        __m128i sum = _mm_setzero_si128(), squares = _mm_setzero_si128();
+        for (; low + 4 <= high; low += 4) {
+            __m128i samples = LoadSse41(data + low);
+            __m128i lo = _mm_cvtepu32_epi64(samples);
+            __m128i hi = _mm_cvtepu32_epi64(_mm_srli_si128(samples, 8));
+            sum = _mm_add_epi64(sum, _mm_add_epi64(lo, hi));
+            squares = _mm_add_epi64(squares, _mm_add_epi64(_mm_mul_epu32(lo, lo), _mm_mul_epu32(hi, hi)));
+        }
+        unsigned long long lanes[2][2];
+        _mm_storeu_si128((__m128i *) lanes[0], sum);
+        _mm_storeu_si128((__m128i *) lanes[1], squares);
+        Sums result = ScalarSums(data, low, high);
+        result.sum += lanes[0][0] + lanes[0][1];
+        result.squares += lanes[1][0] + lanes[1][1];
+        return result;
+    }
+
+    template<class T>
+    TRACEKERNELS_SSE41 unsigned int Sse41Maximum(const T *data, size_t low, const size_t &high) {
+        __m128i maximum = _mm_setzero_si128();
+        for (; low + 4 <= high; low += 4)
+            maximum = _mm_max_epu32(maximum, LoadSse41(data + low));
+        maximum = _mm_max_epu32(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+        maximum = _mm_max_epu32(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+        unsigned int result = (unsigned int) _mm_cvtsi128_si32(maximum);
+        unsigned int tail = ScalarMaximum(data, low, high);
+        return tail > result ? tail : result;
+    }
+
+    ///Eight samples at a time, otherwise the same as the SSE4.1 version.
+    template<class T>
+    TRACEKERNELS_AVX2 Sums Avx2Sums(const T *data, size_t low, const size_t &high) {
+        __m256i sum = _mm256_setzero_si256(), squares = _mm256_setzero_si256();
+        for (; low + 8 <= high; low += 8) {
+            __m256i samples = LoadAvx2(data + low);
+            __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(samples));
+            __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(samples, 1));
+            sum = _mm256_add_epi64(sum, _mm256_add_epi64(lo, hi));
+            squares = _mm256_add_epi64(squares, _mm256_add_epi64(_mm256_mul_epu32(lo, lo),
+                                                                 _mm256_mul_epu32(hi, hi)));
+        }
+        unsigned long long lanes[2][4];
+        _mm256_storeu_si256((__m256i *) lanes[0], sum);
+        _mm256_storeu_si256((__m256i *) lanes[1], squares);
+        Sums result = ScalarSums(data, low, high);
+        result.sum += lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3];
+        result.squares += lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3];
+        return result;
+    }
+
+    template<class T>
+    TRACEKERNELS_AVX2 unsigned int Avx2Maximum(const T *data, size_t low, const size_t &high) {
+        __m256i maximum = _mm256_setzero_si256();
+        for (; low + 8 <= high; low += 8)
+            maximum = _mm256_max_epu32(maximum, LoadAvx2(data + low));
+        __m128i half = _mm_max_epu32(_mm256_castsi256_si128(maximum), _mm256_extracti128_si256(maximum, 1));
+        half = _mm_max_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_max_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        unsigned int result = (unsigned int) _mm_cvtsi128_si32(half);
+        unsigned int tail = ScalarMaximum(data, low, high);
+        return tail > result ? tail : result;
+    }
+#endif
+
+    template<class T>
+    Sums CalculateSums(const T *data, const size_t &low, const size_t &high) {
+#ifdef TRACEKERNELS_X86
+        if (selected == TraceKernels::AVX2)
+            return Avx2Sums(data, low, high);
+        if (selected == TraceKernels::SSE41)
+            return Sse41Sums(data, low, high);
+#endif
+        return ScalarSums(data, low, high);
+    }
+
+    template<class T>
+    pair<double, double> ComputeBaseline(const T *data, const size_t &low, const size_t &high) {
+        Sums sums = CalculateSums(data, low, high);
+        unsigned long long n = high - low;
+        //The variance n * squares - sum^2 is exact in integers as long as n * squares fits, which it does for
+        // 16 bit samples and traces shorter than 2^16 samples.
+        double variance;
+        if (n < 65536)
+            variance = (double) (n * sums.squares - sums.sum * sums.sum) / ((double) n * n);
+        else {
+            double mean = (double) sums.sum / n;
+            variance = max(0., (double) sums.squares / n - mean * mean);
+        }
+        return make_pair((double) sums.sum / n, sqrt(variance));
+    }
+
+    template<class T>
+    pair<unsigned int, double> ComputeMaximum(const T *data, const size_t &low, const size_t &high) {
+        unsigned int maximum;
+#ifdef TRACEKERNELS_X86
+        if (selected == TraceKernels::AVX2)
+            maximum = Avx2Maximum(data, low, high);
+        else if (selected == TraceKernels::SSE41)
+            maximum = Sse41Maximum(data, low, high);
+        else
+#endif
+            maximum = ScalarMaximum(data, low, high);
+
+        size_t position = low;
+        while (data[position] != maximum)
+            position++;
+        return make_pair((unsigned int) position, (double) maximum);
+    }
+
+    ///The trapezoidal rule counts every sample once except for the two ends, which count half.
+    template<class T>
+    double ComputeIntegral(const T *data, const size_t &low, const size_t &high, const double &offset) {
+        Sums sums = CalculateSums(data, low, high);
+        return sums.sum - 0.5 * ((double) data[low] + data[high - 1]) - (high - low - 1) * offset;
+    }
+}
+
+TraceKernels::InstructionSet TraceKernels::GetSupportedInstructionSet() {
+    return supported;
+}
+
+TraceKernels::InstructionSet TraceKernels::GetInstructionSet() {
+    return selected;
+}
+
+TraceKernels::InstructionSet TraceKernels::SetInstructionSet(const InstructionSet &set) {
+    selected = set > supported ? supported : set;
+    return selected;
+}
+
+pair<double, double> TraceKernels::Baseline(const unsigned int *data, const size_t &low, const size_t &high) {
+    return ComputeBaseline(data, low, high);
+}
+
+pair<double, double> TraceKernels::Baseline(const unsigned short *data, const size_t &low, const size_t &high) {
+    return ComputeBaseline(data, low, high);
+}
+
+pair<unsigned int, double> TraceKernels::Maximum(const unsigned int *data, const size_t &low, const size_t &high) {
+    return ComputeMaximum(data, low, high);
+}
+
+pair<unsigned int, double> TraceKernels::Maximum(const unsigned short *data, const size_t &low, const size_t &high) {
+    return ComputeMaximum(data, low, high);
+}
+
+double TraceKernels::Integral(const unsigned int *data, const size_t &low, const size_t &high, const double &offset) {
+    return ComputeIntegral(data, low, high, offset);
+}
+
+double TraceKernels::Integral(const unsigned short *data, const size_t &low, const size_t &high,
+                              const double &offset) {
+    return ComputeIntegral(data, low, high, offset);
+}
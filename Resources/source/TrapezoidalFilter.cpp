@@ -0,0 +1,61 @@
+///@file TrapezoidalFilter.cpp
+///@brief The running sum form of the Pixie-16 trapezoidal trigger and energy
+/// filters
+///@date October 17, 2026
+#include <cmath>
+
+#include "TrapezoidalFilter.hpp"
+
+using namespace std;
+
+void TrapezoidalFilter::CalculateTriggerFilter(const unsigned int &risetime, const unsigned int &flattop,
+                                               vector<double> &filter) const {
+    const size_t length = GetLength(), size = 2 * risetime + flattop;
+    filter.assign(length, 0.0);
+    if (risetime == 0)
+        return;
+
+    for (size_t i = size - 1; i < length; i++)
+        filter[i] = (Sum(i + 1 - risetime, i + 1) - Sum(i + 1 - size, i + 1 - risetime - flattop)) / risetime;
+}
+
+void TrapezoidalFilter::CalculateEnergyFilter(const unsigned int &risetime, const unsigned int &flattop,
+                                              const double &tau, vector<double> &filter) const {
+    const size_t length = GetLength(), size = 2 * risetime + flattop;
+    filter.assign(length, 0.0);
+    if (risetime == 0)
+        return;
+
+    vector<double> coeffs = CalculateEnergyCoefficients(risetime, tau);
+    for (size_t i = size - 1; i < length; i++)
+        filter[i] = coeffs[0] * Sum(i + 1 - size, i + 1 - risetime - flattop)
+                    + coeffs[1] * Sum(i + 1 - risetime - flattop, i + 1 - risetime)
+                    + coeffs[2] * Sum(i + 1 - risetime, i + 1);
+}
+
+vector<double> TrapezoidalFilter::CalculateEnergyCoefficients(const double &risetime, const double &tau) {
+    double beta = exp(-1.0 / tau);
+    double cg = 1 - beta;
+    double ctmp = 1 - pow(beta, risetime);
+
+    vector<double> coeffs(3);
+    coeffs[0] = -(cg / ctmp) * pow(beta, risetime);
+    coeffs[1] = cg;
+    coeffs[2] = cg / ctmp;
+    return coeffs;
+}
+
+vector<unsigned int> TrapezoidalFilter::FindTriggers(const vector<double> &filter, const double &threshold,
+                                                     const size_t &first) {
+    vector<unsigned int> triggers;
+    bool hasRecrossed = false;
+    for (size_t i = first; i < filter.size(); i++) {
+        if (filter[i] >= threshold) {
+            if (triggers.empty() || hasRecrossed)
+                triggers.push_back((unsigned int) i);
+            hasRecrossed = false;
+        } else if (!triggers.empty())
+            hasRecrossed = true;
+    }
+    return triggers;
+}
@@ -0,0 +1,117 @@
+///@file unittest-TraceKernels.cpp
+///@brief A program that will execute unit tests on the TraceKernels by
+/// comparing them to the TraceFunctions with every supported instruction set.
+///@date October 17, 2026
+#include <UnitTest++.h>
+
+#include "HelperFunctions.hpp"
+#include "TraceKernels.hpp"
+#include "UnitTestSampleData.hpp"
+
+using namespace std;
+using namespace unittest_trace_variables;
+
+namespace {
+    ///@return The instruction sets that can be tested on this processor
+    vector<TraceKernels::InstructionSet> GetInstructionSets() {
+        vector<TraceKernels::InstructionSet> sets;
+        for (int set = TraceKernels::SCALAR; set <= TraceKernels::GetSupportedInstructionSet(); set++)
+            sets.push_back((TraceKernels::InstructionSet) set);
+        return sets;
+    }
+
+    ///@return A longer trace built from the sample trace, so that the lengths
+    /// are not multiples of the vector width and the values are 16 bits.
+    vector<unsigned int> GetLongTrace() {
+        vector<unsigned int> result;
+        for (unsigned int i = 0; i < 997; i++)
+            result.push_back((trace[i % trace.size()] * 17 + i * 31) % 65536);
+        return result;
+    }
+}
+
+TEST(Test_Baseline) {
+    vector<unsigned int> longTrace = GetLongTrace();
+    vector<unsigned short> shortTrace(longTrace.begin(), longTrace.end());
+    vector<TraceKernels::InstructionSet> sets = GetInstructionSets();
+    for (unsigned int i = 0; i < sets.size(); i++) {
+        TraceKernels::SetInstructionSet(sets[i]);
+
+        pair<double, double> result = TraceKernels::CalculateBaseline(trace, make_pair(0, 70));
+        CHECK_CLOSE(baseline, result.first, 1e-7);
+        CHECK_CLOSE(TraceFunctions::CalculateBaseline(trace, make_pair(0, 70)).second, result.second, 1e-9);
+
+        for (unsigned int length = 10; length < longTrace.size(); length += 37) {
+            pair<double, double> expected = TraceFunctions::CalculateBaseline(longTrace, make_pair(0, length));
+            pair<double, double> wide = TraceKernels::CalculateBaseline(longTrace, make_pair(0, length));
+            pair<double, double> narrow = TraceKernels::CalculateBaseline(shortTrace, make_pair(0, length));
+            CHECK_CLOSE(expected.first, wide.first, 1e-9 * expected.first);
+            CHECK_CLOSE(expected.second, wide.second, 1e-9 * expected.second);
+            CHECK_EQUAL(wide.first, narrow.first);
+            CHECK_EQUAL(wide.second, narrow.second);
+        }
+    }
+
+    CHECK_THROW(TraceKernels::CalculateBaseline(trace, make_pair(0, 1)), range_error);
+    CHECK_THROW(TraceKernels::CalculateBaseline(trace, make_pair(17, 1)), range_error);
+    CHECK_THROW(TraceKernels::CalculateBaseline(trace, make_pair(0, trace.size() + 100)), range_error);
+}
+
+TEST(Test_FindMaximum) {
+    vector<unsigned int> longTrace = GetLongTrace();
+    vector<unsigned short> shortTrace(longTrace.begin(), longTrace.end());
+    vector<TraceKernels::InstructionSet> sets = GetInstructionSets();
+    for (unsigned int i = 0; i < sets.size(); i++) {
+        TraceKernels::SetInstructionSet(sets[i]);
+
+        CHECK_EQUAL(max_pair.first, TraceKernels::FindMaximum(trace, trace_delay).first);
+        CHECK_EQUAL(max_pair.second, TraceKernels::FindMaximum(trace, trace_delay).second);
+
+        for (unsigned int delay = 11; delay < longTrace.size(); delay += 29) {
+            pair<unsigned int, double> expected = TraceFunctions::FindMaximum(longTrace, delay);
+            pair<unsigned int, double> wide = TraceKernels::FindMaximum(longTrace, delay);
+            CHECK_EQUAL(expected.first, wide.first);
+            CHECK_EQUAL(expected.second, wide.second);
+            CHECK_EQUAL(wide.first, TraceKernels::FindMaximum(shortTrace, delay).first);
+        }
+    }
+
+    CHECK_THROW(TraceKernels::FindMaximum(vector<unsigned int>(), trace_delay), range_error);
+    CHECK_THROW(TraceKernels::FindMaximum(trace, trace.size() + 100), range_error);
+    CHECK_THROW(TraceKernels::FindMaximum(trace, 2), range_error);
+}
+
+TEST(Test_QdcAndTailRatio) {
+    vector<unsigned int> longTrace = GetLongTrace();
+    vector<TraceKernels::InstructionSet> sets = GetInstructionSets();
+    for (unsigned int i = 0; i < sets.size(); i++) {
+        TraceKernels::SetInstructionSet(sets[i]);
+
+        //This is how the WaveformAnalyzer calculated the QDC before the kernels.
+        vector<double> sansBaseline;
+        for (unsigned int j = 0; j < trace.size(); j++)
+            sansBaseline.push_back(trace[j] - baseline);
+        CHECK_CLOSE(TraceFunctions::CalculateQdc(sansBaseline, waveform_range),
+                    TraceKernels::CalculateQdc(trace, waveform_range, baseline), 1e-8);
+
+        double qdc = TraceFunctions::CalculateQdc(trace, make_pair(70, 91));
+        CHECK_CLOSE(tail_ratio, TraceKernels::CalculateTailRatio(trace, make_pair(80, 91), 0, qdc), 1e-6);
+
+        for (unsigned int low = 0; low + 2 < longTrace.size(); low += 53) {
+            pair<unsigned int, unsigned int> range(low, low + 2 + low % 61);
+            if (range.second > longTrace.size())
+                break;
+            double expected = TraceFunctions::CalculateQdc(longTrace, range) - (range.second - range.first - 1) * 12.5;
+            CHECK_CLOSE(expected, TraceKernels::CalculateQdc(longTrace, range, 12.5), 1e-9 * fabs(expected));
+        }
+    }
+
+    CHECK_THROW(TraceKernels::CalculateQdc(vector<unsigned int>(), make_pair(0, 4), 0), range_error);
+    CHECK_THROW(TraceKernels::CalculateQdc(trace, make_pair(0, trace.size() + 10), 0), range_error);
+    CHECK_THROW(TraceKernels::CalculateQdc(trace, make_pair(1000, 0), 0), range_error);
+    CHECK_THROW(TraceKernels::CalculateTailRatio(trace, make_pair(0, 4), 0, 0.0), range_error);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,104 @@
+///@file unittest-TrapezoidalFilter.cpp
+///@brief A program that will execute unit tests on the TrapezoidalFilter by
+/// comparing it to filters that sum every window.
+///@date October 17, 2026
+#include <cmath>
+
+#include <UnitTest++.h>
+
+#include "TrapezoidalFilter.hpp"
+#include "UnitTestSampleData.hpp"
+
+using namespace std;
+using namespace unittest_trace_variables;
+
+namespace {
+    ///@return The sum of the samples of the trace in [low, high)
+    double Sum(const vector<unsigned int> &data, const unsigned int &low, const unsigned int &high) {
+        double sum = 0;
+        for (unsigned int i = low; i < high; i++)
+            sum += data[i];
+        return sum;
+    }
+
+    ///@return A trace with two pulses that are close enough to pile up
+    vector<unsigned int> GetPileupTrace() {
+        vector<unsigned int> result(trace);
+        for (unsigned int i = 0; i < trace.size() - 40; i++)
+            result[i + 40] += trace[i] - trace[0];
+        return result;
+    }
+}
+
+TEST(Test_TriggerFilter) {
+    TrapezoidalFilter filter;
+    filter.SetTrace(trace);
+    CHECK_EQUAL(trace.size(), filter.GetLength());
+    CHECK_CLOSE(Sum(trace, 10, 40), filter.Sum(10, 40), 1e-9);
+
+    unsigned int l = 6, g = 3;
+    vector<double> result;
+    filter.CalculateTriggerFilter(l, g, result);
+    CHECK_EQUAL(trace.size(), result.size());
+
+    for (unsigned int i = 0; i < trace.size(); i++) {
+        double expected = 0;
+        if (i >= 2 * l + g - 1)
+            expected = (Sum(trace, i + 1 - l, i + 1) - Sum(trace, i + 1 - 2 * l - g, i + 1 - l - g)) / l;
+        CHECK_CLOSE(expected, result[i], 1e-9);
+    }
+
+    filter.CalculateTriggerFilter(0, g, result);
+    CHECK_EQUAL(0.0, result.back());
+}
+
+TEST(Test_EnergyFilter) {
+    TrapezoidalFilter filter;
+    filter.SetTrace(trace);
+
+    unsigned int l = 10, g = 5;
+    double tau = 20;
+    vector<double> coeffs = TrapezoidalFilter::CalculateEnergyCoefficients(l, tau);
+    double beta = exp(-1.0 / tau);
+    CHECK_CLOSE(1 - beta, coeffs[1], 1e-12);
+    CHECK_CLOSE(-(1 - beta) / (1 - pow(beta, l)) * pow(beta, l), coeffs[0], 1e-12);
+    CHECK_CLOSE((1 - beta) / (1 - pow(beta, l)), coeffs[2], 1e-12);
+
+    vector<double> result;
+    filter.CalculateEnergyFilter(l, g, tau, result);
+    CHECK_EQUAL(trace.size(), result.size());
+
+    for (unsigned int i = 2 * l + g - 1; i < trace.size(); i++) {
+        double expected = coeffs[0] * Sum(trace, i + 1 - 2 * l - g, i + 1 - l - g)
+                          + coeffs[1] * Sum(trace, i + 1 - l - g, i + 1 - l)
+                          + coeffs[2] * Sum(trace, i + 1 - l, i + 1);
+        CHECK_CLOSE(expected, result[i], 1e-9 * fabs(expected) + 1e-9);
+    }
+    CHECK_EQUAL(0.0, result[2 * l + g - 2]);
+}
+
+TEST(Test_FindTriggers) {
+    TrapezoidalFilter filter;
+    vector<double> result;
+    unsigned int l = 4, g = 0;
+    double threshold = 100;
+
+    filter.SetTrace(trace);
+    filter.CalculateTriggerFilter(l, g, result);
+    vector<unsigned int> triggers = TrapezoidalFilter::FindTriggers(result, threshold, 2 * l + g - 1);
+    CHECK_EQUAL((unsigned int) 1, triggers.size());
+
+    vector<unsigned int> pileup = GetPileupTrace();
+    filter.SetTrace(pileup);
+    filter.CalculateTriggerFilter(l, g, result);
+    vector<unsigned int> pileupTriggers = TrapezoidalFilter::FindTriggers(result, threshold, 2 * l + g - 1);
+    CHECK_EQUAL((unsigned int) 2, pileupTriggers.size());
+    CHECK_EQUAL(triggers[0], pileupTriggers[0]);
+    CHECK_EQUAL(triggers[0] + 40, pileupTriggers[1]);
+
+    CHECK(TrapezoidalFilter::FindTriggers(result, 1e9).empty());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}